@@ -0,0 +1,137 @@
+/*
+ * Host benchmark of byte-wise versus bulk ring buffer copies.
+ *
+ * Moves the same data through a byte ring buffer, once with one
+ * ring_buffer_u8_push/ring_buffer_u8_pop call per byte and once with
+ * ring_buffer_u8_push_bulk/ring_buffer_u8_pop_bulk. The chunk size is not a
+ * divisor of the capacity, so the bulk copies regularly split at the wrap
+ * point. The host numbers only show the relative cost; run the "bench"
+ * terminal command for target numbers.
+ */
+
+// =============================================================================
+// Include statements
+// =============================================================================
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "../ring_buffer.h"
+
+#include "bench_ring_buffer.h"
+
+// =============================================================================
+// Private constants
+// =============================================================================
+
+#define BENCH_CAPACITY          1024
+#define BENCH_CHUNK_SIZE        100
+#define BENCH_TOTAL_BYTES       (64UL * 1024UL * 1024UL)
+
+// =============================================================================
+// Private variables
+// =============================================================================
+
+static uint8_t storage[BENCH_CAPACITY];
+static uint8_t source[BENCH_CHUNK_SIZE];
+static uint8_t sink[BENCH_CHUNK_SIZE];
+
+static ring_buffer_u8_t rb;
+
+// Keeps the compiler from optimizing the copies away
+static volatile uint32_t checksum;
+
+// =============================================================================
+// Private function declarations
+// =============================================================================
+
+static double run_bytewise(void);
+static double run_bulk(void);
+static double seconds_since(clock_t start);
+
+// =============================================================================
+// Public function definitions
+// =============================================================================
+
+void bench_ring_buffer(void)
+{
+    double bytewise_s;
+    double bulk_s;
+    uint32_t i;
+
+    for (i = 0; i < BENCH_CHUNK_SIZE; i++)
+    {
+        source[i] = (uint8_t)(i * 7);
+    }
+
+    bytewise_s = run_bytewise();
+    bulk_s = run_bulk();
+
+    printf("\nring buffer, %lu MiB in chunks of %d bytes:\n",
+           BENCH_TOTAL_BYTES / (1024UL * 1024UL),
+           BENCH_CHUNK_SIZE);
+    printf("  byte-wise push/pop: %8.3f s %8.1f MiB/s\n",
+           bytewise_s,
+           (BENCH_TOTAL_BYTES / (1024.0 * 1024.0)) / bytewise_s);
+    printf("  bulk push/pop:      %8.3f s %8.1f MiB/s\n",
+           bulk_s,
+           (BENCH_TOTAL_BYTES / (1024.0 * 1024.0)) / bulk_s);
+    if (bulk_s > 0.0)
+    {
+        printf("  speedup:            %8.1f x\n", bytewise_s / bulk_s);
+    }
+}
+
+// =============================================================================
+// Private function definitions
+// =============================================================================
+
+static double run_bytewise(void)
+{
+    clock_t start;
+    uint32_t moved;
+    uint32_t i;
+
+    ring_buffer_u8_init(&rb, storage, BENCH_CAPACITY);
+    start = clock();
+
+    for (moved = 0; moved < BENCH_TOTAL_BYTES; moved += BENCH_CHUNK_SIZE)
+    {
+        for (i = 0; i < BENCH_CHUNK_SIZE; i++)
+        {
+            ring_buffer_u8_push(&rb, source[i]);
+        }
+        for (i = 0; i < BENCH_CHUNK_SIZE; i++)
+        {
+            ring_buffer_u8_pop(&rb, &sink[i]);
+        }
+        checksum += sink[moved % BENCH_CHUNK_SIZE];
+    }
+
+    return seconds_since(start);
+}
+
+static double run_bulk(void)
+{
+    clock_t start;
+    uint32_t moved;
+
+    ring_buffer_u8_init(&rb, storage, BENCH_CAPACITY);
+    start = clock();
+
+    for (moved = 0; moved < BENCH_TOTAL_BYTES; moved += BENCH_CHUNK_SIZE)
+    {
+        ring_buffer_u8_push_bulk(&rb, source, BENCH_CHUNK_SIZE);
+        ring_buffer_u8_pop_bulk(&rb, sink, BENCH_CHUNK_SIZE);
+        checksum += sink[moved % BENCH_CHUNK_SIZE];
+    }
+
+    return seconds_since(start);
+}
+
+static double seconds_since(clock_t start)
+{
+    return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
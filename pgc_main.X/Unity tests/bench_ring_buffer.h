@@ -0,0 +1,25 @@
+/*
+ * Host benchmark of byte-wise versus bulk ring buffer copies.
+ */
+
+#ifndef BENCH_RING_BUFFER_H
+#define	BENCH_RING_BUFFER_H
+
+#ifdef	__cplusplus
+//extern "C" {
+#endif
+
+// =============================================================================
+// Public function declarations
+// =============================================================================
+
+/**
+ * @brief Times byte-wise and bulk push/pop and prints the results.
+ */
+void bench_ring_buffer(void);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* BENCH_RING_BUFFER_H */
@@ -0,0 +1,225 @@
+/*
+ * Host benchmark of the old and new uart transmit buffer write paths.
+ *
+ * uart.c can not be built on the host, so the buffer updates done by
+ * uart_write_string and uart_write_array are reproduced here. The old path
+ * is the byte-by-byte circular buffer update with first/last/size
+ * bookkeeping which uart.c used before the ring buffer. The new path is
+ * strlen followed by ring_buffer_u8_push_bulk, which is what uart.c does
+ * now. start_tx and the tx ISR are modelled by emptying the buffer after
+ * each write, so only the cost of getting the bytes into the buffer is
+ * measured.
+ */
+
+// =============================================================================
+// Include statements
+// =============================================================================
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "../ring_buffer.h"
+
+#include "bench_uart.h"
+
+// =============================================================================
+// Private constants
+// =============================================================================
+
+#define BUFFER_SIZE             ((uint16_t)1024)
+#define BENCH_ITERATIONS        (1000000UL)
+
+// A typical line written by the terminal
+static const char BENCH_STRING[] = "sd profile: read 512 B, 1234 us, 415 kB/s\r\n";
+
+// =============================================================================
+// Private variables
+// =============================================================================
+
+// Old uart.c transmit buffer
+static volatile uint8_t tx_buff[BUFFER_SIZE];
+static volatile uint16_t tx_buff_first = 0;
+static volatile uint16_t tx_buff_last = 0;
+static volatile uint16_t tx_buff_size = 0;
+
+// New uart.c transmit buffer
+static uint8_t tx_storage[BUFFER_SIZE];
+static ring_buffer_u8_t tx_ring;
+
+// Keeps the compiler from optimizing the writes away
+static volatile uint32_t checksum;
+
+// =============================================================================
+// Private function declarations
+// =============================================================================
+
+static void old_write_string(const char* data);
+static void old_write_array(uint16_t nbr_of_bytes, const uint8_t* data);
+static void old_drain(void);
+
+static uint16_t new_write_string(const char* data);
+static uint16_t new_write_array(uint16_t nbr_of_bytes, const uint8_t* data);
+static void new_drain(void);
+
+static double seconds_since(clock_t start);
+static void print_result(const char* name, double old_s, double new_s);
+
+// =============================================================================
+// Public function definitions
+// =============================================================================
+
+void bench_uart(void)
+{
+    const uint16_t length = (uint16_t)strlen(BENCH_STRING);
+    clock_t start;
+    double old_string_s;
+    double old_array_s;
+    double new_string_s;
+    double new_array_s;
+    uint32_t i;
+
+    ring_buffer_u8_init(&tx_ring, tx_storage, BUFFER_SIZE);
+
+    start = clock();
+    for (i = 0; i < BENCH_ITERATIONS; i++)
+    {
+        old_write_string(BENCH_STRING);
+        old_drain();
+    }
+    old_string_s = seconds_since(start);
+
+    start = clock();
+    for (i = 0; i < BENCH_ITERATIONS; i++)
+    {
+        old_write_array(length, (const uint8_t*)BENCH_STRING);
+        old_drain();
+    }
+    old_array_s = seconds_since(start);
+
+    start = clock();
+    for (i = 0; i < BENCH_ITERATIONS; i++)
+    {
+        new_write_string(BENCH_STRING);
+        new_drain();
+    }
+    new_string_s = seconds_since(start);
+
+    start = clock();
+    for (i = 0; i < BENCH_ITERATIONS; i++)
+    {
+        new_write_array(length, (const uint8_t*)BENCH_STRING);
+        new_drain();
+    }
+    new_array_s = seconds_since(start);
+
+    printf("\nuart tx buffer, %lu writes of %u bytes:\n",
+           BENCH_ITERATIONS,
+           length);
+    print_result("uart_write_string", old_string_s, new_string_s);
+    print_result("uart_write_array", old_array_s, new_array_s);
+}
+
+// =============================================================================
+// Private function definitions
+// =============================================================================
+
+static void old_write_string(const char* data)
+{
+    const uint8_t* p = (const uint8_t*)data;
+
+    // Update the tx buffer.
+    while (*p && (tx_buff_size < BUFFER_SIZE))
+    {
+        if (0 != tx_buff_size)
+        {
+            ++tx_buff_last;
+
+            if (tx_buff_last >= BUFFER_SIZE)
+            {
+                tx_buff_last = 0;
+            }
+        }
+
+        tx_buff[tx_buff_last] = *(p++);
+
+        ++tx_buff_size;
+    }
+}
+
+static void old_write_array(uint16_t nbr_of_bytes, const uint8_t* data)
+{
+    uint16_t i;
+
+    // Update the tx buffer.
+    for (i = 0; i != nbr_of_bytes; ++i)
+    {
+        if (tx_buff_size < BUFFER_SIZE)
+        {
+            if (0 != tx_buff_size)
+            {
+                ++tx_buff_last;
+
+                if (tx_buff_last >= BUFFER_SIZE)
+                {
+                    tx_buff_last = 0;
+                }
+            }
+
+            tx_buff[tx_buff_last] = *(data++);
+
+            if (tx_buff_size < BUFFER_SIZE)
+            {
+                ++tx_buff_size;
+            }
+        }
+    }
+}
+
+static void old_drain(void)
+{
+    checksum += tx_buff[tx_buff_last];
+
+    tx_buff_first = tx_buff_last;
+    tx_buff_size = 0;
+}
+
+static uint16_t new_write_string(const char* data)
+{
+    size_t length = strlen(data);
+
+    if (length > UINT16_MAX)
+    {
+        length = UINT16_MAX;
+    }
+
+    return new_write_array((uint16_t)length, (const uint8_t*)data);
+}
+
+static uint16_t new_write_array(uint16_t nbr_of_bytes, const uint8_t* data)
+{
+    return ring_buffer_u8_push_bulk(&tx_ring, data, nbr_of_bytes);
+}
+
+static void new_drain(void)
+{
+    checksum += ring_buffer_u8_peek(&tx_ring, 0);
+
+    ring_buffer_clear(&tx_ring.ring);
+}
+
+static double seconds_since(clock_t start)
+{
+    return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+static void print_result(const char* name, double old_s, double new_s)
+{
+    printf("  %-18s old: %7.3f s  new: %7.3f s", name, old_s, new_s);
+    if (new_s > 0.0)
+    {
+        printf("  speedup: %5.1f x", old_s / new_s);
+    }
+    printf("\n");
+}
@@ -0,0 +1,25 @@
+/*
+ * Host benchmark of the old and new uart transmit buffer write paths.
+ */
+
+#ifndef BENCH_UART_H
+#define	BENCH_UART_H
+
+#ifdef	__cplusplus
+//extern "C" {
+#endif
+
+// =============================================================================
+// Public function declarations
+// =============================================================================
+
+/**
+ * @brief Times the uart_write_string/uart_write_array buffer updates.
+ */
+void bench_uart(void);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* BENCH_UART_H */
@@ -0,0 +1,282 @@
+/*
+ * Host stand-in for the audio DSP end of the DSP link.
+ *
+ * The receiver looks for the frame sync in the top byte of a word, skipping
+ * anything else such as the idle words clocked out while a status reply is
+ * read. A frame with a bad CRC is dropped and reported with
+ * DSP_LINK_FLAG_CRC_ERROR in the next status. A good status poll queues the
+ * four reply words, which are returned by the following
+ * spi_dword_tranceive_blocking calls.
+ */
+
+// =============================================================================
+// Include statements
+// =============================================================================
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "../spi.h"
+#include "../crc.h"
+#include "../dsp_link.h"
+
+#include "fake_dsp.h"
+
+// =============================================================================
+// Private type definitions
+// =============================================================================
+
+typedef enum receiver_state_t
+{
+    RECEIVER_WAITING_FOR_HEADER,
+    RECEIVER_PAYLOAD,
+    RECEIVER_TRAILER
+} receiver_state_t;
+
+// =============================================================================
+// Private constants
+// =============================================================================
+#define CRC_INITIAL_VALUE       (0xFFFFu)
+#define REPLY_WORDS             (4u)
+
+// =============================================================================
+// Private variables
+// =============================================================================
+
+static receiver_state_t receiver_state = RECEIVER_WAITING_FOR_HEADER;
+
+// The frame being received, header first
+static uint32_t frame[DSP_LINK_MAX_PAYLOAD_WORDS + 1];
+static uint32_t frame_words = 0;
+static uint32_t payload_length = 0;
+
+static uint32_t frames_received = 0;
+static uint32_t frames_dropped = 0;
+static uint8_t last_sequence = 0;
+static uint8_t fill_level = 0;
+static uint8_t flags = 0;
+static uint32_t block = 0;
+
+static bool corrupt_next_frame = false;
+static bool corrupt_next_reply = false;
+
+static uint32_t reply[REPLY_WORDS];
+static uint32_t reply_words_left = 0;
+
+static fake_dsp_frame_t last_frame;
+static bool last_frame_valid = false;
+
+// =============================================================================
+// Private function declarations
+// =============================================================================
+
+/**
+ * @brief Feeds one word sent by the MCU to the receiver.
+ */
+static void receive_word(uint32_t word);
+
+/**
+ * @brief Checks and handles a completely received frame.
+ */
+static void frame_done(uint32_t trailer);
+
+/**
+ * @brief Queues the status reply.
+ */
+static void prepare_reply(void);
+
+// =============================================================================
+// Public function definitions
+// =============================================================================
+
+void fake_dsp_reset(void)
+{
+    receiver_state = RECEIVER_WAITING_FOR_HEADER;
+    frame_words = 0;
+    payload_length = 0;
+    frames_received = 0;
+    frames_dropped = 0;
+    last_sequence = 0;
+    fill_level = 0;
+    flags = 0;
+    block = 0;
+    corrupt_next_frame = false;
+    corrupt_next_reply = false;
+    reply_words_left = 0;
+    last_frame_valid = false;
+}
+
+void fake_dsp_set_fill_level(uint8_t new_fill_level)
+{
+    fill_level = new_fill_level;
+}
+
+void fake_dsp_set_block(uint32_t new_block)
+{
+    block = new_block;
+}
+
+void fake_dsp_corrupt_next_frame(void)
+{
+    corrupt_next_frame = true;
+}
+
+void fake_dsp_corrupt_next_reply(void)
+{
+    corrupt_next_reply = true;
+}
+
+uint32_t fake_dsp_frames_received(void)
+{
+    return frames_received;
+}
+
+uint32_t fake_dsp_frames_dropped(void)
+{
+    return frames_dropped;
+}
+
+const fake_dsp_frame_t* fake_dsp_last_frame(void)
+{
+    return last_frame_valid ? &last_frame : NULL;
+}
+
+//
+// SPI3 as seen by dsp_link.c
+//
+
+void spi_write_dword_vect(spi_device_t spi_device,
+                          uint32_t data[],
+                          uint32_t number_of_elements)
+{
+    uint32_t i;
+
+    (void)spi_device;
+
+    for (i = 0; i != number_of_elements; ++i)
+    {
+        receive_word(data[i]);
+    }
+}
+
+void spi_flush(spi_device_t spi_device)
+{
+    (void)spi_device;
+}
+
+uint32_t spi_dword_tranceive_blocking(spi_device_t spi_device,
+                                      uint32_t data_to_send)
+{
+    uint32_t received = 0;
+
+    (void)spi_device;
+
+    if (0 != reply_words_left)
+    {
+        received = reply[REPLY_WORDS - reply_words_left];
+        --reply_words_left;
+    }
+    else
+    {
+        receive_word(data_to_send);
+    }
+
+    return received;
+}
+
+// =============================================================================
+// Private function definitions
+// =============================================================================
+
+static void receive_word(uint32_t word)
+{
+    switch (receiver_state)
+    {
+    case RECEIVER_WAITING_FOR_HEADER:
+        if (DSP_LINK_FRAME_SYNC == (word >> 24))
+        {
+            frame[0] = word;
+            frame_words = 1;
+            payload_length = word & 0xFF;
+            receiver_state = (0 == payload_length) ?
+                             RECEIVER_TRAILER : RECEIVER_PAYLOAD;
+        }
+        break;
+
+    case RECEIVER_PAYLOAD:
+        frame[frame_words] = word;
+        ++frame_words;
+
+        if (frame_words == payload_length + 1)
+        {
+            receiver_state = RECEIVER_TRAILER;
+        }
+        break;
+
+    case RECEIVER_TRAILER:
+    default:
+        frame_done(word);
+        receiver_state = RECEIVER_WAITING_FOR_HEADER;
+        break;
+    }
+}
+
+static void frame_done(uint32_t trailer)
+{
+    dsp_msg_type_t type = (dsp_msg_type_t)((frame[0] >> 16) & 0xFF);
+
+    if (corrupt_next_frame)
+    {
+        frame[frame_words - 1] ^= 0x00000100;
+        corrupt_next_frame = false;
+    }
+
+    if ((trailer & 0xFFFF) !=
+        crc16_ccitt_update_words(CRC_INITIAL_VALUE, frame, frame_words))
+    {
+        ++frames_dropped;
+        flags |= DSP_LINK_FLAG_CRC_ERROR;
+        return;
+    }
+
+    ++frames_received;
+    last_sequence = (uint8_t)(frame[0] >> 8);
+
+    if (DSP_MSG_STATUS_POLL == type)
+    {
+        prepare_reply();
+    }
+    else
+    {
+        last_frame.type = type;
+        last_frame.sequence = last_sequence;
+        last_frame.length = payload_length;
+        memcpy(last_frame.payload,
+               &frame[1],
+               payload_length * sizeof(uint32_t));
+        last_frame_valid = true;
+    }
+}
+
+static void prepare_reply(void)
+{
+    reply[0] = ((uint32_t)DSP_LINK_STATUS_SYNC << 24) |
+               ((uint32_t)last_sequence << 16) |
+               ((uint32_t)fill_level << 8) |
+               flags;
+    reply[1] = frames_received;
+    reply[2] = block;
+    reply[3] = crc16_ccitt_update_words(CRC_INITIAL_VALUE, reply, 3);
+
+    if (corrupt_next_reply)
+    {
+        reply[1] ^= 0x00000001;
+        corrupt_next_reply = false;
+    }
+
+    // Reported once
+    flags = 0;
+
+    reply_words_left = REPLY_WORDS;
+}
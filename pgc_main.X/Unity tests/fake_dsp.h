@@ -0,0 +1,86 @@
+/*
+ * Host stand-in for the audio DSP end of the DSP link.
+ *
+ * Replaces the SPI3 functions used by dsp_link.c. Every word the MCU sends
+ * is fed to a model of the DSP receiver, which checks the frames and
+ * answers status polls the way the DSP firmware does, so dsp_link can be
+ * tested in a loopback on the host.
+ */
+
+#ifndef FAKE_DSP_H
+#define	FAKE_DSP_H
+
+#ifdef	__cplusplus
+//extern "C" {
+#endif
+
+// =============================================================================
+// Include statements
+// =============================================================================
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "../dsp_link.h"
+
+// =============================================================================
+// Public type definitions
+// =============================================================================
+
+typedef struct fake_dsp_frame_t
+{
+    dsp_msg_type_t type;
+    uint8_t sequence;
+    uint32_t length;
+    uint32_t payload[DSP_LINK_MAX_PAYLOAD_WORDS];
+} fake_dsp_frame_t;
+
+// =============================================================================
+// Public function declarations
+// =============================================================================
+
+/**
+ * @brief Restarts the DSP, clearing its counters and its receiver.
+ */
+void fake_dsp_reset(void);
+
+/**
+ * @brief Sets the input buffer fill level reported by the next status.
+ */
+void fake_dsp_set_fill_level(uint8_t fill_level);
+
+/**
+ * @brief Sets the audio block number reported by the next status.
+ */
+void fake_dsp_set_block(uint32_t block);
+
+/**
+ * @brief Corrupts one word of the next frame sent to the DSP.
+ */
+void fake_dsp_corrupt_next_frame(void);
+
+/**
+ * @brief Corrupts the next status reply from the DSP.
+ */
+void fake_dsp_corrupt_next_reply(void);
+
+/**
+ * @brief Gets the number of good frames the DSP has received.
+ */
+uint32_t fake_dsp_frames_received(void);
+
+/**
+ * @brief Gets the number of frames the DSP dropped because of a bad CRC.
+ */
+uint32_t fake_dsp_frames_dropped(void);
+
+/**
+ * @brief Gets the last good message frame, status polls not included.
+ * @return NULL if no message frame has been received.
+ */
+const fake_dsp_frame_t* fake_dsp_last_frame(void);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* FAKE_DSP_H */
@@ -0,0 +1,53 @@
+/*
+ * Host replacements for the target drivers used by the tested modules.
+ *
+ * The uart output is counted and dropped, tunables are accepted without a
+ * registry and the wait timer returns at once.
+ */
+
+// =============================================================================
+// Include statements
+// =============================================================================
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "../uart.h"
+#include "../tunables.h"
+#include "../wait_timer.h"
+
+#include "host_stubs.h"
+
+// =============================================================================
+// Private variables
+// =============================================================================
+
+static uint32_t uart_bytes_written = 0;
+
+// =============================================================================
+// Public function definitions
+// =============================================================================
+
+uint32_t host_stubs_uart_bytes_written(void)
+{
+    return uart_bytes_written;
+}
+
+uint16_t uart_write_string(const char* data)
+{
+    uint16_t length = (uint16_t)strlen(data);
+
+    uart_bytes_written += length;
+
+    return length;
+}
+
+bool tunables_register(const tunable_t* tunable)
+{
+    return (NULL != tunable);
+}
+
+void wait_timer_us(uint16_t us_to_wait)
+{
+    (void)us_to_wait;
+}
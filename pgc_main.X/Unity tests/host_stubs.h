@@ -0,0 +1,30 @@
+/*
+ * Host replacements for the target drivers used by the tested modules.
+ */
+
+#ifndef HOST_STUBS_H
+#define	HOST_STUBS_H
+
+#ifdef	__cplusplus
+//extern "C" {
+#endif
+
+// =============================================================================
+// Include statements
+// =============================================================================
+#include <stdint.h>
+
+// =============================================================================
+// Public function declarations
+// =============================================================================
+
+/**
+ * @brief Gets the number of bytes written with uart_write_string.
+ */
+uint32_t host_stubs_uart_bytes_written(void);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* HOST_STUBS_H */
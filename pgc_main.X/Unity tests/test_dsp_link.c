@@ -0,0 +1,232 @@
+/*
+ * Unity tests for the DSP link, run in a loopback with the DSP stand-in.
+ */
+
+// =============================================================================
+// Include statements
+// =============================================================================
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "../unity.h"
+#include "../dsp_link.h"
+
+#include "fake_dsp.h"
+#include "test_dsp_link.h"
+
+// =============================================================================
+// Private constants
+// =============================================================================
+
+// The defaults of dsp.high_water and dsp.poll_interval
+#define HIGH_WATER      192u
+#define POLL_INTERVAL   16u
+
+// =============================================================================
+// Private function declarations
+// =============================================================================
+
+static void start(void);
+static void send_note_events(uint32_t number_of_frames);
+
+static void test_frame_reaches_dsp(void);
+static void test_poll_reports_dsp_status(void);
+static void test_lost_frame_is_counted(void);
+static void test_busy_above_high_water(void);
+static void test_bad_reply_is_counted(void);
+static void test_dsp_restart_keeps_lost_count(void);
+static void test_too_long_payload_is_refused(void);
+static void test_poll_is_sent_every_poll_interval(void);
+
+// =============================================================================
+// Public function definitions
+// =============================================================================
+
+void test_dsp_link(void)
+{
+    RUN_TEST(test_frame_reaches_dsp);
+    RUN_TEST(test_poll_reports_dsp_status);
+    RUN_TEST(test_lost_frame_is_counted);
+    RUN_TEST(test_busy_above_high_water);
+    RUN_TEST(test_bad_reply_is_counted);
+    RUN_TEST(test_dsp_restart_keeps_lost_count);
+    RUN_TEST(test_too_long_payload_is_refused);
+    RUN_TEST(test_poll_is_sent_every_poll_interval);
+}
+
+// =============================================================================
+// Private function definitions
+// =============================================================================
+
+static void start(void)
+{
+    fake_dsp_reset();
+    dsp_link_init();
+}
+
+static void send_note_events(uint32_t number_of_frames)
+{
+    uint32_t payload[2] = {0x12345678, 0x9ABCDEF0};
+    uint32_t i;
+
+    for (i = 0; i != number_of_frames; ++i)
+    {
+        TEST_ASSERT_EQUAL(DSP_LINK_OK,
+                          dsp_link_send(DSP_MSG_NOTE_EVENTS, payload, 2));
+    }
+}
+
+static void test_frame_reaches_dsp(void)
+{
+    uint32_t payload[3] = {1, 0xFFFFFFFF, 0xD5000000};
+    const fake_dsp_frame_t* frame;
+
+    start();
+    send_note_events(1);
+    TEST_ASSERT_EQUAL(DSP_LINK_OK,
+                      dsp_link_send(DSP_MSG_PARAMETERS, payload, 3));
+
+    frame = fake_dsp_last_frame();
+    TEST_ASSERT_NOT_NULL(frame);
+    TEST_ASSERT_EQUAL(DSP_MSG_PARAMETERS, frame->type);
+    TEST_ASSERT_EQUAL_UINT8(1, frame->sequence);
+    TEST_ASSERT_EQUAL_UINT32(3, frame->length);
+    TEST_ASSERT_EQUAL_UINT32_ARRAY(payload, frame->payload, 3);
+    TEST_ASSERT_EQUAL_UINT32(2, fake_dsp_frames_received());
+}
+
+static void test_poll_reports_dsp_status(void)
+{
+    dsp_link_status_t status;
+
+    start();
+    send_note_events(3);
+    fake_dsp_set_fill_level(42);
+    fake_dsp_set_block(123456);
+
+    TEST_ASSERT_TRUE(dsp_link_poll_status(&status));
+    TEST_ASSERT_TRUE(status.valid);
+    TEST_ASSERT_EQUAL_UINT8(3, status.last_sequence);
+    TEST_ASSERT_EQUAL_UINT8(42, status.fill_level);
+    TEST_ASSERT_EQUAL_UINT8(0, status.flags);
+    TEST_ASSERT_EQUAL_UINT32(4, status.frames_received);
+    TEST_ASSERT_EQUAL_UINT32(123456, status.block);
+    TEST_ASSERT_EQUAL_UINT32(0, dsp_link_get_statistics()->lost_frames);
+}
+
+static void test_lost_frame_is_counted(void)
+{
+    dsp_link_status_t status;
+
+    start();
+    TEST_ASSERT_TRUE(dsp_link_poll_status(NULL));
+
+    fake_dsp_corrupt_next_frame();
+    send_note_events(3);
+
+    TEST_ASSERT_TRUE(dsp_link_poll_status(&status));
+    TEST_ASSERT_EQUAL_UINT8(DSP_LINK_FLAG_CRC_ERROR, status.flags);
+    TEST_ASSERT_EQUAL_UINT32(1, fake_dsp_frames_dropped());
+    TEST_ASSERT_EQUAL_UINT32(1, dsp_link_get_statistics()->lost_frames);
+
+    // The flag is reported once, the count is kept
+    send_note_events(1);
+    TEST_ASSERT_TRUE(dsp_link_poll_status(&status));
+    TEST_ASSERT_EQUAL_UINT8(0, status.flags);
+    TEST_ASSERT_EQUAL_UINT32(1, dsp_link_get_statistics()->lost_frames);
+}
+
+static void test_busy_above_high_water(void)
+{
+    uint32_t received;
+
+    start();
+    fake_dsp_set_fill_level(HIGH_WATER);
+    TEST_ASSERT_TRUE(dsp_link_poll_status(NULL));
+
+    received = fake_dsp_frames_received();
+    TEST_ASSERT_EQUAL(DSP_LINK_BUSY,
+                      dsp_link_send(DSP_MSG_NOTE_EVENTS, NULL, 0));
+    TEST_ASSERT_EQUAL_UINT32(1, dsp_link_get_statistics()->frames_refused);
+
+    // Only the poll got through
+    TEST_ASSERT_EQUAL_UINT32(received + 1, fake_dsp_frames_received());
+
+    fake_dsp_set_fill_level(HIGH_WATER - 1);
+    TEST_ASSERT_EQUAL(DSP_LINK_OK,
+                      dsp_link_send(DSP_MSG_NOTE_EVENTS, NULL, 0));
+    TEST_ASSERT_EQUAL_UINT32(received + 3, fake_dsp_frames_received());
+}
+
+static void test_bad_reply_is_counted(void)
+{
+    dsp_link_status_t status;
+
+    start();
+    send_note_events(2);
+    fake_dsp_set_fill_level(7);
+    TEST_ASSERT_TRUE(dsp_link_poll_status(NULL));
+
+    fake_dsp_set_fill_level(HIGH_WATER);
+    fake_dsp_corrupt_next_reply();
+    TEST_ASSERT_FALSE(dsp_link_poll_status(&status));
+    TEST_ASSERT_EQUAL_UINT32(1, dsp_link_get_statistics()->bad_replies);
+
+    // The last good status is kept
+    TEST_ASSERT_EQUAL_UINT8(7, dsp_link_get_status()->fill_level);
+    TEST_ASSERT_EQUAL_UINT32(0, dsp_link_get_statistics()->lost_frames);
+}
+
+static void test_dsp_restart_keeps_lost_count(void)
+{
+    start();
+
+    // The first reply sets the baseline
+    TEST_ASSERT_TRUE(dsp_link_poll_status(NULL));
+
+    fake_dsp_corrupt_next_frame();
+    send_note_events(5);
+    TEST_ASSERT_TRUE(dsp_link_poll_status(NULL));
+    TEST_ASSERT_EQUAL_UINT32(1, dsp_link_get_statistics()->lost_frames);
+
+    fake_dsp_reset();
+    send_note_events(2);
+    TEST_ASSERT_TRUE(dsp_link_poll_status(NULL));
+    TEST_ASSERT_EQUAL_UINT32(1, dsp_link_get_statistics()->lost_frames);
+
+    fake_dsp_corrupt_next_frame();
+    send_note_events(1);
+    TEST_ASSERT_TRUE(dsp_link_poll_status(NULL));
+    TEST_ASSERT_EQUAL_UINT32(2, dsp_link_get_statistics()->lost_frames);
+}
+
+static void test_too_long_payload_is_refused(void)
+{
+    static uint32_t payload[DSP_LINK_MAX_PAYLOAD_WORDS + 1];
+
+    start();
+    TEST_ASSERT_EQUAL(DSP_LINK_ERROR,
+                      dsp_link_send(DSP_MSG_PARAMETERS,
+                                    payload,
+                                    DSP_LINK_MAX_PAYLOAD_WORDS + 1));
+    TEST_ASSERT_EQUAL(DSP_LINK_OK,
+                      dsp_link_send(DSP_MSG_PARAMETERS,
+                                    payload,
+                                    DSP_LINK_MAX_PAYLOAD_WORDS));
+    TEST_ASSERT_EQUAL_UINT32(1, fake_dsp_frames_received());
+    TEST_ASSERT_EQUAL_UINT32(DSP_LINK_MAX_PAYLOAD_WORDS,
+                             fake_dsp_last_frame()->length);
+}
+
+static void test_poll_is_sent_every_poll_interval(void)
+{
+    start();
+    send_note_events(POLL_INTERVAL);
+    TEST_ASSERT_EQUAL_UINT32(0, dsp_link_get_statistics()->polls);
+
+    send_note_events(1);
+    TEST_ASSERT_EQUAL_UINT32(1, dsp_link_get_statistics()->polls);
+    TEST_ASSERT_TRUE(dsp_link_get_status()->valid);
+    TEST_ASSERT_EQUAL_UINT32(POLL_INTERVAL + 2, fake_dsp_frames_received());
+}
@@ -0,0 +1,25 @@
+/*
+ * Unity tests for the DSP link, run in a loopback with the DSP stand-in.
+ */
+
+#ifndef TEST_DSP_LINK_H
+#define	TEST_DSP_LINK_H
+
+#ifdef	__cplusplus
+//extern "C" {
+#endif
+
+// =============================================================================
+// Public function declarations
+// =============================================================================
+
+/**
+ * @brief Runs all DSP link tests.
+ */
+void test_dsp_link(void);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* TEST_DSP_LINK_H */
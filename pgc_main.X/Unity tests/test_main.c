@@ -1 +1,45 @@
+/*
+ * Runs the Unity tests and the host benchmarks.
+ *
+ * Modules which only depend on the C library are compiled directly from the
+ * parent directory, so the host build runs the same code as the target.
+ */
 
+// =============================================================================
+// Include statements
+// =============================================================================
+#include <stdio.h>
+
+#include "../unity.h"
+
+#include "test_ring_buffer.h"
+#include "test_dsp_link.h"
+#include "bench_ring_buffer.h"
+#include "bench_uart.h"
+
+// =============================================================================
+// Public function definitions
+// =============================================================================
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+int main(void)
+{
+    int failures;
+
+    UNITY_BEGIN();
+    test_ring_buffer();
+    test_dsp_link();
+    failures = UNITY_END();
+
+    bench_ring_buffer();
+    bench_uart();
+
+    return failures;
+}
@@ -0,0 +1,420 @@
+/*
+ * Unity tests for the single producer, single consumer ring buffers.
+ */
+
+// =============================================================================
+// Include statements
+// =============================================================================
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "../unity.h"
+#include "../ring_buffer.h"
+
+#include "test_ring_buffer.h"
+
+// =============================================================================
+// Private constants
+// =============================================================================
+
+#define TEST_CAPACITY   16
+
+// =============================================================================
+// Private variables
+// =============================================================================
+
+static uint8_t storage_u8[TEST_CAPACITY];
+static uint32_t storage_u32[TEST_CAPACITY];
+
+static ring_buffer_u8_t rb_u8;
+static ring_buffer_u32_t rb_u32;
+
+// =============================================================================
+// Private function declarations
+// =============================================================================
+
+static void setup_buffers(void);
+static void move_indices(uint32_t count);
+
+static void test_init_rejects_non_power_of_two(void);
+static void test_empty_and_full(void);
+static void test_push_pop_wraparound(void);
+static void test_free_running_index_overflow(void);
+static void test_push_bulk_across_wrap(void);
+static void test_pop_bulk_across_wrap(void);
+static void test_bulk_partial(void);
+static void test_spans(void);
+static void test_retract_and_clear(void);
+static void test_u32_bulk_across_wrap(void);
+
+// =============================================================================
+// Public function definitions
+// =============================================================================
+
+void test_ring_buffer(void)
+{
+    RUN_TEST(test_init_rejects_non_power_of_two);
+    RUN_TEST(test_empty_and_full);
+    RUN_TEST(test_push_pop_wraparound);
+    RUN_TEST(test_free_running_index_overflow);
+    RUN_TEST(test_push_bulk_across_wrap);
+    RUN_TEST(test_pop_bulk_across_wrap);
+    RUN_TEST(test_bulk_partial);
+    RUN_TEST(test_spans);
+    RUN_TEST(test_retract_and_clear);
+    RUN_TEST(test_u32_bulk_across_wrap);
+}
+
+// =============================================================================
+// Private function definitions
+// =============================================================================
+
+static void setup_buffers(void)
+{
+    memset(storage_u8, 0, sizeof(storage_u8));
+    memset(storage_u32, 0, sizeof(storage_u32));
+    TEST_ASSERT_TRUE(ring_buffer_u8_init(&rb_u8, storage_u8, TEST_CAPACITY));
+    TEST_ASSERT_TRUE(ring_buffer_u32_init(&rb_u32, storage_u32, TEST_CAPACITY));
+}
+
+/**
+ * @brief Moves the empty byte buffer so the next push starts at count.
+ */
+static void move_indices(uint32_t count)
+{
+    uint32_t i;
+    uint8_t data;
+
+    for (i = 0; i < count; i++)
+    {
+        TEST_ASSERT_TRUE(ring_buffer_u8_push(&rb_u8, 0xFF));
+        TEST_ASSERT_TRUE(ring_buffer_u8_pop(&rb_u8, &data));
+    }
+    TEST_ASSERT_TRUE(ring_buffer_is_empty(&rb_u8.ring));
+}
+
+static void test_init_rejects_non_power_of_two(void)
+{
+    ring_buffer_t ring;
+
+    TEST_ASSERT_FALSE(ring_buffer_init(&ring, 0));
+    TEST_ASSERT_FALSE(ring_buffer_init(&ring, 3));
+    TEST_ASSERT_FALSE(ring_buffer_init(&ring, 12));
+    TEST_ASSERT_FALSE(ring_buffer_init(&ring, 1000));
+    TEST_ASSERT_FALSE(ring_buffer_u8_init(&rb_u8, storage_u8, 10));
+    TEST_ASSERT_FALSE(ring_buffer_u32_init(&rb_u32, storage_u32, 15));
+
+    TEST_ASSERT_TRUE(ring_buffer_init(&ring, 1));
+    TEST_ASSERT_TRUE(ring_buffer_init(&ring, 2));
+    TEST_ASSERT_TRUE(ring_buffer_init(&ring, 1024));
+    TEST_ASSERT_EQUAL_UINT32(1024, ring_buffer_capacity(&ring));
+}
+
+static void test_empty_and_full(void)
+{
+    uint32_t i;
+    uint8_t data;
+
+    setup_buffers();
+
+    TEST_ASSERT_TRUE(ring_buffer_is_empty(&rb_u8.ring));
+    TEST_ASSERT_FALSE(ring_buffer_is_full(&rb_u8.ring));
+    TEST_ASSERT_FALSE(ring_buffer_u8_pop(&rb_u8, &data));
+    TEST_ASSERT_EQUAL_UINT32(TEST_CAPACITY, ring_buffer_free(&rb_u8.ring));
+
+    // Every slot is usable
+    for (i = 0; i < TEST_CAPACITY; i++)
+    {
+        TEST_ASSERT_TRUE(ring_buffer_u8_push(&rb_u8, (uint8_t)i));
+        TEST_ASSERT_EQUAL_UINT32(i + 1, ring_buffer_size(&rb_u8.ring));
+    }
+
+    TEST_ASSERT_TRUE(ring_buffer_is_full(&rb_u8.ring));
+    TEST_ASSERT_FALSE(ring_buffer_is_empty(&rb_u8.ring));
+    TEST_ASSERT_FALSE(ring_buffer_u8_push(&rb_u8, 0xAA));
+    TEST_ASSERT_EQUAL_UINT32(0, ring_buffer_free(&rb_u8.ring));
+
+    for (i = 0; i < TEST_CAPACITY; i++)
+    {
+        TEST_ASSERT_EQUAL_UINT8(i, ring_buffer_u8_peek(&rb_u8, i));
+    }
+
+    for (i = 0; i < TEST_CAPACITY; i++)
+    {
+        TEST_ASSERT_TRUE(ring_buffer_u8_pop(&rb_u8, &data));
+        TEST_ASSERT_EQUAL_UINT8(i, data);
+    }
+
+    TEST_ASSERT_TRUE(ring_buffer_is_empty(&rb_u8.ring));
+    TEST_ASSERT_FALSE(ring_buffer_u8_pop(&rb_u8, &data));
+}
+
+static void test_push_pop_wraparound(void)
+{
+    uint32_t i;
+    uint8_t data;
+    uint8_t expected = 0;
+    uint8_t next = 0;
+
+    setup_buffers();
+
+    // Keep a few bytes stored while the indices go around several laps
+    for (i = 0; i < 5; i++)
+    {
+        TEST_ASSERT_TRUE(ring_buffer_u8_push(&rb_u8, next++));
+    }
+
+    for (i = 0; i < 10 * TEST_CAPACITY; i++)
+    {
+        TEST_ASSERT_TRUE(ring_buffer_u8_push(&rb_u8, next++));
+        if (0 == (i % 7))
+        {
+            TEST_ASSERT_TRUE(ring_buffer_u8_push(&rb_u8, next++));
+        }
+        TEST_ASSERT_TRUE(ring_buffer_u8_pop(&rb_u8, &data));
+        TEST_ASSERT_EQUAL_UINT8(expected++, data);
+        if (0 == (i % 7))
+        {
+            TEST_ASSERT_TRUE(ring_buffer_u8_pop(&rb_u8, &data));
+            TEST_ASSERT_EQUAL_UINT8(expected++, data);
+        }
+    }
+
+    while (ring_buffer_u8_pop(&rb_u8, &data))
+    {
+        TEST_ASSERT_EQUAL_UINT8(expected++, data);
+    }
+    TEST_ASSERT_EQUAL_UINT8(next, expected);
+    TEST_ASSERT_TRUE(ring_buffer_head_index(&rb_u8.ring) ==
+                     ring_buffer_tail_index(&rb_u8.ring));
+}
+
+static void test_free_running_index_overflow(void)
+{
+    uint32_t i;
+    uint32_t data;
+
+    setup_buffers();
+
+    // Start just below the point where the free running indices overflow
+    rb_u32.ring.head = UINT32_MAX - 5;
+    rb_u32.ring.tail = UINT32_MAX - 5;
+
+    for (i = 0; i < TEST_CAPACITY; i++)
+    {
+        TEST_ASSERT_TRUE(ring_buffer_u32_push(&rb_u32, i));
+    }
+    TEST_ASSERT_TRUE(ring_buffer_is_full(&rb_u32.ring));
+    TEST_ASSERT_EQUAL_UINT32(TEST_CAPACITY, ring_buffer_size(&rb_u32.ring));
+    TEST_ASSERT_FALSE(ring_buffer_u32_push(&rb_u32, 0xDEAD));
+
+    for (i = 0; i < TEST_CAPACITY; i++)
+    {
+        TEST_ASSERT_EQUAL_UINT32(i, ring_buffer_u32_peek(&rb_u32, i));
+    }
+
+    for (i = 0; i < TEST_CAPACITY; i++)
+    {
+        TEST_ASSERT_TRUE(ring_buffer_u32_pop(&rb_u32, &data));
+        TEST_ASSERT_EQUAL_UINT32(i, data);
+    }
+    TEST_ASSERT_TRUE(ring_buffer_is_empty(&rb_u32.ring));
+}
+
+static void test_push_bulk_across_wrap(void)
+{
+    uint8_t data[TEST_CAPACITY];
+    uint8_t result[TEST_CAPACITY];
+    uint32_t i;
+
+    setup_buffers();
+    move_indices(TEST_CAPACITY - 4);
+
+    for (i = 0; i < TEST_CAPACITY; i++)
+    {
+        data[i] = (uint8_t)(0x40 + i);
+    }
+
+    // 4 bytes before the wrap point and 6 after it
+    TEST_ASSERT_EQUAL_UINT32(10, ring_buffer_u8_push_bulk(&rb_u8, data, 10));
+    TEST_ASSERT_EQUAL_UINT32(10, ring_buffer_size(&rb_u8.ring));
+    TEST_ASSERT_EQUAL_UINT8(0x40, storage_u8[TEST_CAPACITY - 4]);
+    TEST_ASSERT_EQUAL_UINT8(0x43, storage_u8[TEST_CAPACITY - 1]);
+    TEST_ASSERT_EQUAL_UINT8(0x44, storage_u8[0]);
+    TEST_ASSERT_EQUAL_UINT8(0x49, storage_u8[5]);
+
+    for (i = 0; i < 10; i++)
+    {
+        TEST_ASSERT_TRUE(ring_buffer_u8_pop(&rb_u8, &result[i]));
+    }
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(data, result, 10);
+}
+
+static void test_pop_bulk_across_wrap(void)
+{
+    uint8_t result[TEST_CAPACITY];
+    uint32_t i;
+
+    setup_buffers();
+    move_indices(TEST_CAPACITY - 3);
+
+    for (i = 0; i < 9; i++)
+    {
+        TEST_ASSERT_TRUE(ring_buffer_u8_push(&rb_u8, (uint8_t)(0x80 + i)));
+    }
+
+    // Ask for more than is stored, 3 bytes come from before the wrap point
+    memset(result, 0, sizeof(result));
+    TEST_ASSERT_EQUAL_UINT32(9, ring_buffer_u8_pop_bulk(&rb_u8,
+                                                        result,
+                                                        TEST_CAPACITY));
+    for (i = 0; i < 9; i++)
+    {
+        TEST_ASSERT_EQUAL_UINT8(0x80 + i, result[i]);
+    }
+    TEST_ASSERT_EQUAL_UINT8(0, result[9]);
+    TEST_ASSERT_TRUE(ring_buffer_is_empty(&rb_u8.ring));
+    TEST_ASSERT_EQUAL_UINT32(0, ring_buffer_u8_pop_bulk(&rb_u8, result, 1));
+}
+
+static void test_bulk_partial(void)
+{
+    uint8_t data[2 * TEST_CAPACITY];
+    uint8_t result[2 * TEST_CAPACITY];
+    uint32_t i;
+
+    setup_buffers();
+    move_indices(7);
+
+    for (i = 0; i < sizeof(data); i++)
+    {
+        data[i] = (uint8_t)i;
+    }
+
+    // Only what fits is accepted
+    TEST_ASSERT_EQUAL_UINT32(5, ring_buffer_u8_push_bulk(&rb_u8, data, 5));
+    TEST_ASSERT_EQUAL_UINT32(TEST_CAPACITY - 5,
+                             ring_buffer_u8_push_bulk(&rb_u8,
+                                                      &data[5],
+                                                      sizeof(data) - 5));
+    TEST_ASSERT_TRUE(ring_buffer_is_full(&rb_u8.ring));
+    TEST_ASSERT_EQUAL_UINT32(0, ring_buffer_u8_push_bulk(&rb_u8, data, 1));
+    TEST_ASSERT_EQUAL_UINT32(0, ring_buffer_u8_push_bulk(&rb_u8, data, 0));
+
+    TEST_ASSERT_EQUAL_UINT32(6, ring_buffer_u8_pop_bulk(&rb_u8, result, 6));
+    TEST_ASSERT_EQUAL_UINT32(TEST_CAPACITY - 6,
+                             ring_buffer_u8_pop_bulk(&rb_u8,
+                                                     &result[6],
+                                                     sizeof(result) - 6));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(data, result, TEST_CAPACITY);
+    TEST_ASSERT_TRUE(ring_buffer_is_empty(&rb_u8.ring));
+}
+
+static void test_spans(void)
+{
+    uint32_t index;
+    uint32_t count;
+
+    setup_buffers();
+
+    // Empty buffer at the start of the array, one span covers everything
+    TEST_ASSERT_EQUAL_UINT32(0, ring_buffer_read_span(&rb_u8.ring, &index));
+    TEST_ASSERT_EQUAL_UINT32(TEST_CAPACITY,
+                             ring_buffer_write_span(&rb_u8.ring, &index));
+    TEST_ASSERT_EQUAL_UINT32(0, index);
+
+    move_indices(TEST_CAPACITY - 6);
+
+    // The free area is split by the wrap point
+    count = ring_buffer_write_span(&rb_u8.ring, &index);
+    TEST_ASSERT_EQUAL_UINT32(6, count);
+    TEST_ASSERT_EQUAL_UINT32(TEST_CAPACITY - 6, index);
+    memset(&storage_u8[index], 0x11, count);
+    ring_buffer_produce(&rb_u8.ring, count);
+
+    count = ring_buffer_write_span(&rb_u8.ring, &index);
+    TEST_ASSERT_EQUAL_UINT32(TEST_CAPACITY - 6, count);
+    TEST_ASSERT_EQUAL_UINT32(0, index);
+    memset(&storage_u8[index], 0x22, 4);
+    ring_buffer_produce(&rb_u8.ring, 4);
+
+    TEST_ASSERT_EQUAL_UINT32(10, ring_buffer_size(&rb_u8.ring));
+    TEST_ASSERT_EQUAL_UINT32(TEST_CAPACITY - 10,
+                             ring_buffer_write_span(&rb_u8.ring, &index));
+    TEST_ASSERT_EQUAL_UINT32(4, index);
+
+    // The stored area is split the same way
+    count = ring_buffer_read_span(&rb_u8.ring, &index);
+    TEST_ASSERT_EQUAL_UINT32(6, count);
+    TEST_ASSERT_EQUAL_UINT32(TEST_CAPACITY - 6, index);
+    TEST_ASSERT_EQUAL_UINT8(0x11, storage_u8[index]);
+    ring_buffer_consume(&rb_u8.ring, count);
+
+    count = ring_buffer_read_span(&rb_u8.ring, &index);
+    TEST_ASSERT_EQUAL_UINT32(4, count);
+    TEST_ASSERT_EQUAL_UINT32(0, index);
+    TEST_ASSERT_EQUAL_UINT8(0x22, storage_u8[index]);
+    ring_buffer_consume(&rb_u8.ring, count);
+
+    TEST_ASSERT_TRUE(ring_buffer_is_empty(&rb_u8.ring));
+    TEST_ASSERT_EQUAL_UINT32(0, ring_buffer_read_span(&rb_u8.ring, &index));
+}
+
+static void test_retract_and_clear(void)
+{
+    uint8_t data;
+
+    setup_buffers();
+
+    TEST_ASSERT_TRUE(ring_buffer_u8_push(&rb_u8, 1));
+    TEST_ASSERT_TRUE(ring_buffer_u8_push(&rb_u8, 2));
+    TEST_ASSERT_TRUE(ring_buffer_u8_push(&rb_u8, 3));
+
+    // Retract takes back the newest element
+    ring_buffer_retract(&rb_u8.ring, 1);
+    TEST_ASSERT_EQUAL_UINT32(2, ring_buffer_size(&rb_u8.ring));
+    TEST_ASSERT_TRUE(ring_buffer_u8_push(&rb_u8, 4));
+    TEST_ASSERT_TRUE(ring_buffer_u8_pop(&rb_u8, &data));
+    TEST_ASSERT_EQUAL_UINT8(1, data);
+    TEST_ASSERT_TRUE(ring_buffer_u8_pop(&rb_u8, &data));
+    TEST_ASSERT_EQUAL_UINT8(2, data);
+    TEST_ASSERT_TRUE(ring_buffer_u8_pop(&rb_u8, &data));
+    TEST_ASSERT_EQUAL_UINT8(4, data);
+
+    TEST_ASSERT_TRUE(ring_buffer_u8_push(&rb_u8, 5));
+    TEST_ASSERT_TRUE(ring_buffer_u8_push(&rb_u8, 6));
+    ring_buffer_clear(&rb_u8.ring);
+    TEST_ASSERT_TRUE(ring_buffer_is_empty(&rb_u8.ring));
+    TEST_ASSERT_FALSE(ring_buffer_u8_pop(&rb_u8, &data));
+}
+
+static void test_u32_bulk_across_wrap(void)
+{
+    uint32_t data[TEST_CAPACITY];
+    uint32_t result[TEST_CAPACITY];
+    uint32_t i;
+
+    setup_buffers();
+
+    for (i = 0; i < TEST_CAPACITY; i++)
+    {
+        data[i] = 0x10000000 * (i & 0x0F) + i;
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(11, ring_buffer_u32_push_bulk(&rb_u32, data, 11));
+    TEST_ASSERT_EQUAL_UINT32(11, ring_buffer_u32_pop_bulk(&rb_u32, result, 11));
+
+    // Head and tail now sit 5 words before the wrap point
+    TEST_ASSERT_EQUAL_UINT32(TEST_CAPACITY,
+                             ring_buffer_u32_push_bulk(&rb_u32,
+                                                       data,
+                                                       TEST_CAPACITY));
+    TEST_ASSERT_EQUAL_UINT32(data[0], storage_u32[11]);
+    TEST_ASSERT_EQUAL_UINT32(data[5], storage_u32[0]);
+    TEST_ASSERT_EQUAL_UINT32(TEST_CAPACITY,
+                             ring_buffer_u32_pop_bulk(&rb_u32,
+                                                      result,
+                                                      TEST_CAPACITY));
+    TEST_ASSERT_EQUAL_UINT32_ARRAY(data, result, TEST_CAPACITY);
+}
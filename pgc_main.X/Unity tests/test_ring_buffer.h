@@ -0,0 +1,25 @@
+/*
+ * Unity tests for the single producer, single consumer ring buffers.
+ */
+
+#ifndef TEST_RING_BUFFER_H
+#define	TEST_RING_BUFFER_H
+
+#ifdef	__cplusplus
+//extern "C" {
+#endif
+
+// =============================================================================
+// Public function declarations
+// =============================================================================
+
+/**
+ * @brief Runs all ring buffer tests.
+ */
+void test_ring_buffer(void);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* TEST_RING_BUFFER_H */
@@ -0,0 +1,18 @@
+/*
+ * Host stand-in for the XC32 device header.
+ *
+ * Lets modules which include <xc.h> for register definitions in their
+ * headers be compiled on the host. The registers are only declared, so the
+ * tested code must not access them.
+ */
+
+#ifndef XC_H
+#define	XC_H
+
+#ifndef __LANGUAGE_C__
+#define __LANGUAGE_C__
+#endif
+
+#include "p32mz1024ecg064.h"
+
+#endif	/* XC_H */
@@ -26,6 +26,7 @@
 
 #include "fat_standard.h"
 #include "sdcard.h"
+#include "tunables.h"
 
 #ifdef AFATFS_DEBUG
     #define ONLY_EXPOSE_FOR_TESTING
@@ -33,7 +34,40 @@
     #define ONLY_EXPOSE_FOR_TESTING static
 #endif
 
-#define AFATFS_NUM_CACHE_SECTORS 8
+/*
+ * The cache holds 2^AFATFS_CACHE_SECTORS_LOG2 sectors, 64 sectors (32 kB) by default. Directory heavy work benefits from
+ * a large cache, lookups and evictions don't get slower as it grows. The build may set it from 3 (8 sectors) to 7.
+ */
+#ifndef AFATFS_CACHE_SECTORS_LOG2
+#define AFATFS_CACHE_SECTORS_LOG2 6
+#endif
+
+#if AFATFS_CACHE_SECTORS_LOG2 < 3 || AFATFS_CACHE_SECTORS_LOG2 > 7
+#error "AFATFS_CACHE_SECTORS_LOG2 must be between 3 and 7"
+#endif
+
+#define AFATFS_NUM_CACHE_SECTORS (1 << AFATFS_CACHE_SECTORS_LOG2)
+
+// The open-addressed hash from sector index to cache descriptor is kept at most half full
+#define AFATFS_CACHE_HASH_LOG2 (AFATFS_CACHE_SECTORS_LOG2 + 1)
+#define AFATFS_CACHE_HASH_SIZE (1 << AFATFS_CACHE_HASH_LOG2)
+
+// Cache descriptor index for "no descriptor", used to terminate the LRU list
+#define AFATFS_CACHE_NONE (-1)
+
+/*
+ * Read-ahead of files which are read sequentially. It starts after AFATFS_READ_AHEAD_TRIGGER sectors have been read in
+ * order, with a window of AFATFS_READ_AHEAD_MIN_SECTORS beyond the cursor. The window doubles whenever the reader has
+ * to wait for a sector, and shrinks by one after the reader has consumed AFATFS_READ_AHEAD_SHRINK_FACTOR windows
+ * without waiting.
+ */
+#define AFATFS_READ_AHEAD_TRIGGER       2
+#define AFATFS_READ_AHEAD_MIN_SECTORS   2
+#define AFATFS_READ_AHEAD_MAX_SECTORS   (AFATFS_NUM_CACHE_SECTORS / 4)
+#define AFATFS_READ_AHEAD_SHRINK_FACTOR 4
+
+// Runs of consecutive clusters remembered per open file to speed up seeks, a contiguous file only needs one
+#define AFATFS_FILE_MAX_EXTENTS         8
 
 // FAT filesystems are allowed to differ from these parameters, but we choose not to support those weird filesystems:
 #define AFATFS_SECTOR_SIZE  512
@@ -88,6 +122,34 @@
 // Filename in 8.3 format:
 #define AFATFS_FREESPACE_FILENAME "FREESPAC.E"
 
+// Index the names in the current directory, so that opening a file doesn't have to search the directory for it
+#define AFATFS_USE_DIRECTORY_INDEX
+
+#ifdef AFATFS_USE_DIRECTORY_INDEX
+// The index has 2^AFATFS_DIRECTORY_INDEX_SIZE_LOG2 slots (6 bytes each) and holds up to 3/4 of that many entries
+#ifndef AFATFS_DIRECTORY_INDEX_SIZE_LOG2
+#define AFATFS_DIRECTORY_INDEX_SIZE_LOG2 12
+#endif
+
+#if AFATFS_DIRECTORY_INDEX_SIZE_LOG2 < 4 || AFATFS_DIRECTORY_INDEX_SIZE_LOG2 > 16
+#error "AFATFS_DIRECTORY_INDEX_SIZE_LOG2 must be in the range 4..16"
+#endif
+
+#define AFATFS_DIRECTORY_INDEX_SIZE        (1 << AFATFS_DIRECTORY_INDEX_SIZE_LOG2)
+#define AFATFS_DIRECTORY_INDEX_MAX_ENTRIES (AFATFS_DIRECTORY_INDEX_SIZE / 4 * 3)
+
+// Position of a removed entry (entry 1 of sector 0, which is never a directory sector)
+#define AFATFS_DIRECTORY_INDEX_REMOVED     1
+#endif
+
+// Long filenames which were opened recently, remembered with the position of their short directory entries
+#define AFATFS_LONG_NAME_CACHE_ENTRIES 8
+
+#define AFATFS_LONG_NAME_BUFFER_SIZE (FAT_LONG_NAME_MAX_ENTRIES * FAT_LONG_NAME_CHARS_PER_ENTRY + 1)
+
+// Number of recently mounted cards whose volume geometry is remembered for a fast remount
+#define AFATFS_VOLUME_CACHE_ENTRIES 4
+
 #define AFATFS_INTROSPEC_LOG_FILENAME "ASYNCFAT.LOG"
 
 #define MIN(a, b) ((a) < (b) ? (a) : (b))
@@ -126,6 +188,7 @@ enum {
     AFATFS_CREATEFILE_PHASE_CREATE_NEW_FILE,
     AFATFS_CREATEFILE_PHASE_SUCCESS,
     AFATFS_CREATEFILE_PHASE_FAILURE,
+    AFATFS_CREATEFILE_PHASE_CHECK_HINT,
 };
 
 typedef enum {
@@ -154,8 +217,12 @@ typedef struct afatfsCacheBlockDescriptor_t {
     // This is the timestamp that this sector was first marked dirty at (so we can flush sectors in write-order).
     uint32_t writeTimestamp;
 
-    // This is the last time the sector was accessed
-    uint32_t accessTimestamp;
+    /*
+     * Neighbours in the list of all cache descriptors ordered by last access, most recent first. Discardable sectors
+     * are kept at the least recently used end so that they are evicted first.
+     */
+    int8_t lruPrev;
+    int8_t lruNext;
 
     /* This is set to non-zero when we expect to write a consecutive series of this many blocks (including this block),
      * so we will tell the SD-card to pre-erase those blocks.
@@ -189,6 +256,9 @@ typedef struct afatfsCacheBlockDescriptor_t {
      * is overridden by the locked and retainCount flags.
      */
     unsigned discardable:1;
+
+    // The sectorIndex of this block is in the cache hash
+    unsigned hashed:1;
 } afatfsCacheBlockDescriptor_t;
 
 typedef enum {
@@ -215,11 +285,38 @@ typedef struct afatfsFreeSpaceFAT_t {
     uint32_t endCluster;
 } afatfsFreeSpaceFAT_t;
 
+/*
+ * The long filename read by a directory search from the entries preceding the short directory entry at `position`.
+ */
+typedef struct afatfsLongName_t {
+    // The search which the entries were read by
+    const afatfsFinder_t *finder;
+
+    // Order of the long filename entry expected next, 0 for the short entry it belongs to, -1 for none
+    int8_t nextOrder;
+    uint8_t checksum;
+
+    // `name` is the long filename of the short entry at `position`
+    bool valid;
+    afatfsDirEntryPointer_t position;
+
+    char name[AFATFS_LONG_NAME_BUFFER_SIZE];
+} afatfsLongName_t;
+
 typedef struct afatfsCreateFile_t {
     afatfsFileCallback_t callback;
 
     uint8_t phase;
     uint8_t filename[FAT_FILENAME_LENGTH];
+
+    // A hint pointed at another file, search the directory without the directory index and long filename cache
+    bool skipIndex;
+
+    // The name to open if it isn't a short filename, otherwise empty
+    char longName[FAT_LONG_NAME_MAX_LENGTH + 1];
+
+    // The long filenames read by this search, so that other searches can't reset them halfway
+    afatfsLongName_t foundLongName;
 } afatfsCreateFile_t;
 
 typedef struct afatfsSeek_t {
@@ -338,6 +435,45 @@ typedef struct afatfsFileOperation_t {
     } state;
 } afatfsFileOperation_t;
 
+typedef struct afatfsReadAhead_t {
+    // File offset of the sector after the one last read by fread(), to detect sequential reads
+    uint32_t nextSectorOffset;
+    uint8_t sequentialSectors;
+
+    // Sectors to keep read ahead of the cursor, or 0 if read-ahead isn't running
+    uint8_t window;
+
+    // Sectors consumed without waiting since the window last changed
+    uint16_t streak;
+
+    // File offset of the next sector to prefetch
+    uint32_t offset;
+
+    // The cluster holding `offset`, or 0 if it must be looked up in the FAT as the cluster after `previousCluster`
+    uint32_t cluster;
+    uint32_t previousCluster;
+
+    // The sector at the cursor was not in the cache when fread() first asked for it
+    bool waited;
+} afatfsReadAhead_t;
+
+typedef struct afatfsFileExtent_t {
+    uint32_t firstCluster;
+
+    // Index of firstCluster among the clusters of the file (i.e. its file offset divided by the cluster size)
+    uint32_t clusterIndex;
+} afatfsFileExtent_t;
+
+/*
+ * The start of the file's cluster chain as it has been walked by seeks so far. Each extent runs until the clusterIndex
+ * of the next one, the last one until mappedClusters.
+ */
+typedef struct afatfsFileExtents_t {
+    afatfsFileExtent_t extent[AFATFS_FILE_MAX_EXTENTS];
+    uint32_t mappedClusters;
+    uint8_t count;
+} afatfsFileExtents_t;
+
 typedef struct afatfsFile_t {
     afatfsFileType_e type;
 
@@ -396,6 +532,10 @@ typedef struct afatfsFile_t {
     // The first cluster number of the file, or 0 if this file is empty
     uint32_t firstCluster;
 
+    afatfsReadAhead_t readAhead;
+
+    afatfsFileExtents_t extents;
+
     // State for a queued operation on the file
     struct afatfsFileOperation_t operation;
 } afatfsFile_t;
@@ -421,6 +561,66 @@ typedef enum {
     AFATFS_INITIALIZATION_DONE
 } afatfsInitializationPhase_e;
 
+/*
+ * The geometry of a volume on a card we have mounted before, so that a remount of the same card can skip reading the
+ * MBR, searching the root directory for the freefile and, if the freefile was found to be empty, the FAT search for
+ * free space. Cards are identified by their CID, the volume by the serial number written when it was formatted.
+ */
+typedef struct afatfsVolumeCacheEntry_t {
+    bool valid;
+    uint32_t lastUsed; // Value of afatfs_volumeCacheTimer when the entry was last mounted, the oldest is replaced
+
+    uint8_t manufacturerID;
+    uint16_t oemID;
+    uint32_t productSerial;
+
+    uint32_t volumeSerial;
+    fatFilesystemType_e filesystemType;
+    uint32_t partitionStartSector;
+    uint32_t fatStartSector;
+    uint32_t fatSectors;
+    uint32_t numClusters;
+    uint32_t clusterStartSector;
+    uint32_t sectorsPerCluster;
+    uint32_t rootDirectoryCluster;
+    uint32_t rootDirectorySectors;
+
+    afatfsDirEntryPointer_t freeFileEntryPos;
+    bool freeFileSearchFruitless; // The FAT search found no gap large enough for a freefile
+} afatfsVolumeCacheEntry_t;
+
+#ifdef AFATFS_USE_DIRECTORY_INDEX
+/*
+ * Open addressed hash table from the 8.3 names in a directory to the position of their directory entries. A slot holds
+ * the top half of the hash of the name and the position packed as (physical sector << 4 | entry index), 0 if unused
+ * or AFATFS_DIRECTORY_INDEX_REMOVED.
+ */
+typedef struct afatfsDirectoryIndex_t {
+    uint32_t position[AFATFS_DIRECTORY_INDEX_SIZE];
+    uint16_t tag[AFATFS_DIRECTORY_INDEX_SIZE];
+
+    // The directory which is indexed (see afatfs_directoryKey()), 0 for none
+    uint32_t directory;
+    uint16_t count;
+
+    // Every entry in the directory is in the index, so a name which isn't in the index isn't in the directory either
+    bool complete;
+
+    // The directory has more entries than fit in the index
+    bool overflowed;
+} afatfsDirectoryIndex_t;
+#endif
+
+typedef struct afatfsLongNameCacheEntry_t {
+    // See afatfs_directoryKey(), 0 if the entry is unused
+    uint32_t directory;
+
+    afatfsDirEntryPointer_t position;
+    uint8_t filename[FAT_FILENAME_LENGTH];
+
+    char name[FAT_LONG_NAME_MAX_LENGTH + 1];
+} afatfsLongNameCacheEntry_t;
+
 typedef struct afatfs_t {
     fatFilesystemType_e filesystemType;
 
@@ -435,10 +635,18 @@ typedef struct afatfs_t {
     } initState;
 #endif
 
-    uint8_t cache[AFATFS_SECTOR_SIZE * AFATFS_NUM_CACHE_SECTORS];
+    // Cache line aligned, the SD card driver moves the sectors with DMA
+    uint8_t cache[AFATFS_SECTOR_SIZE * AFATFS_NUM_CACHE_SECTORS] __attribute__((aligned(16)));
     afatfsCacheBlockDescriptor_t cacheDescriptor[AFATFS_NUM_CACHE_SECTORS];
     uint32_t cacheTimer;
 
+    // Descriptor index + 1 of the sector hashed to each slot, 0 for a free slot. Collisions probe the following slots.
+    uint8_t cacheHash[AFATFS_CACHE_HASH_SIZE];
+
+    // Most and least recently used cache descriptors
+    int8_t cacheLruHead;
+    int8_t cacheLruTail;
+
     int cacheDirtyEntries; // The number of cache entries in the AFATFS_CACHE_STATE_DIRTY state
     bool cacheFlushInProgress;
 
@@ -459,6 +667,16 @@ typedef struct afatfs_t {
     // The current working directory:
     afatfsFile_t currentDirectory;
 
+#ifdef AFATFS_USE_DIRECTORY_INDEX
+    afatfsDirectoryIndex_t directoryIndex;
+#endif
+
+    // For the searches of afatfs_findNext(), file opens keep their own
+    afatfsLongName_t longName;
+
+    afatfsLongNameCacheEntry_t longNameCache[AFATFS_LONG_NAME_CACHE_ENTRIES];
+    uint8_t longNameCacheNext; // The entry to replace next
+
     uint32_t partitionStartSector; // The physical sector that the first partition on the device begins at
 
     uint32_t fatStartSector; // The first sector of the first FAT
@@ -483,11 +701,47 @@ typedef struct afatfs_t {
 
     uint32_t rootDirectoryCluster; // Present on FAT32 and set to zero for FAT16
     uint32_t rootDirectorySectors; // Zero on FAT32, for FAT16 the number of sectors that the root directory occupies
+
+    uint32_t volumeSerial; // Volume ID from the boot sector, changes when the card is formatted
+
+    // Cached geometry of the card being mounted, or NULL if the card wasn't recently seen or its volume has changed
+    afatfsVolumeCacheEntry_t *volumeCache;
+    bool fastMount;
+    bool freeFileSearchFruitless;
 } afatfs_t;
 
 static afatfs_t afatfs;
 
+// Kept outside of afatfs so that the statistics cover remounts
+static afatfsCacheStatistics_t afatfs_cacheStatistics;
+static afatfsReadAheadStatistics_t afatfs_readAheadStatistics;
+
+// Kept outside of afatfs so that it survives afatfs_destroy()
+static afatfsVolumeCacheEntry_t afatfs_volumeCache[AFATFS_VOLUME_CACHE_ENTRIES];
+static uint32_t afatfs_volumeCacheTimer = 0;
+
+#ifdef AFATFS_MIN_MULTIPLE_BLOCK_WRITE_COUNT
+// Runtime copy of AFATFS_MIN_MULTIPLE_BLOCK_WRITE_COUNT, exposed as a tunable
+static uint32_t afatfs_minMultipleBlockWriteCount = AFATFS_MIN_MULTIPLE_BLOCK_WRITE_COUNT;
+
+static const tunable_t afatfs_minMultipleBlockWriteCountTunable = {
+    "afatfs.min_multi_block",
+    TUNABLE_TYPE_UINT32,
+    &afatfs_minMultipleBlockWriteCount,
+    1,
+    UINT16_MAX,
+    NULL,
+    NULL
+};
+#endif
+
 static void afatfs_fileOperationContinue(afatfsFile_t *file);
+static afatfsFilePtr_t afatfs_createFileWithHint(afatfsFilePtr_t file, const char *name, uint8_t attrib,
+        uint8_t fileMode, const afatfsDirEntryPointer_t *hint, afatfsFileCallback_t callback);
+#ifdef AFATFS_USE_DIRECTORY_INDEX
+static void afatfs_directoryIndexRemove(const uint8_t *filename, const afatfsDirEntryPointer_t *pos);
+#endif
+static void afatfs_longNameCacheRemove(const afatfsDirEntryPointer_t *position);
 static uint8_t* afatfs_fileLockCursorSectorForWrite(afatfsFilePtr_t file);
 static uint8_t* afatfs_fileRetainCursorSectorForRead(afatfsFilePtr_t file);
 
@@ -604,7 +858,7 @@ static void afatfs_cacheSectorInit(afatfsCacheBlockDescriptor_t *descriptor, uin
 {
     descriptor->sectorIndex = sectorIndex;
 
-    descriptor->accessTimestamp = descriptor->writeTimestamp = ++afatfs.cacheTimer;
+    descriptor->writeTimestamp = ++afatfs.cacheTimer;
 
     descriptor->consecutiveEraseBlockCount = 0;
 
@@ -615,6 +869,159 @@ static void afatfs_cacheSectorInit(afatfsCacheBlockDescriptor_t *descriptor, uin
     descriptor->discardable = 0;
 }
 
+/**
+ * Get the cache hash slot where the search for the given sector begins. Fibonacci hashing spreads consecutive sectors
+ * over the table.
+ */
+static uint32_t afatfs_cacheHashSlot(uint32_t sectorIndex)
+{
+    return (sectorIndex * 2654435769u) >> (32 - AFATFS_CACHE_HASH_LOG2);
+}
+
+/**
+ * Get the index of the cache descriptor assigned to the given sector, or AFATFS_CACHE_NONE. The descriptor may be in
+ * any state including empty.
+ */
+static int afatfs_cacheHashFind(uint32_t sectorIndex)
+{
+    uint32_t slot = afatfs_cacheHashSlot(sectorIndex);
+
+    // The table is never more than half full so there is always a free slot to stop at
+    while (afatfs.cacheHash[slot] != 0) {
+        int index = afatfs.cacheHash[slot] - 1;
+
+        if (afatfs.cacheDescriptor[index].sectorIndex == sectorIndex) {
+            return index;
+        }
+
+        slot = (slot + 1) & (AFATFS_CACHE_HASH_SIZE - 1);
+    }
+
+    return AFATFS_CACHE_NONE;
+}
+
+static void afatfs_cacheHashInsert(int index)
+{
+    uint32_t slot = afatfs_cacheHashSlot(afatfs.cacheDescriptor[index].sectorIndex);
+
+    while (afatfs.cacheHash[slot] != 0) {
+        slot = (slot + 1) & (AFATFS_CACHE_HASH_SIZE - 1);
+    }
+
+    afatfs.cacheHash[slot] = index + 1;
+    afatfs.cacheDescriptor[index].hashed = 1;
+}
+
+/**
+ * Remove the descriptor from the hash. The entries after it in the probe sequence are shifted back so that no
+ * tombstones are needed.
+ */
+static void afatfs_cacheHashRemove(int index)
+{
+    uint32_t hole = afatfs_cacheHashSlot(afatfs.cacheDescriptor[index].sectorIndex);
+    uint32_t slot, home;
+
+    while (afatfs.cacheHash[hole] != index + 1) {
+        hole = (hole + 1) & (AFATFS_CACHE_HASH_SIZE - 1);
+    }
+
+    afatfs.cacheHash[hole] = 0;
+    afatfs.cacheDescriptor[index].hashed = 0;
+
+    for (slot = (hole + 1) & (AFATFS_CACHE_HASH_SIZE - 1); afatfs.cacheHash[slot] != 0; slot = (slot + 1) & (AFATFS_CACHE_HASH_SIZE - 1)) {
+        home = afatfs_cacheHashSlot(afatfs.cacheDescriptor[afatfs.cacheHash[slot] - 1].sectorIndex);
+
+        // Entries whose home slot lies cyclically after the hole can't be found from there if moved, leave them
+        if (((slot - home) & (AFATFS_CACHE_HASH_SIZE - 1)) >= ((slot - hole) & (AFATFS_CACHE_HASH_SIZE - 1))) {
+            afatfs.cacheHash[hole] = afatfs.cacheHash[slot];
+            afatfs.cacheHash[slot] = 0;
+            hole = slot;
+        }
+    }
+}
+
+static void afatfs_cacheLruUnlink(int index)
+{
+    afatfsCacheBlockDescriptor_t *descriptor = &afatfs.cacheDescriptor[index];
+
+    if (descriptor->lruPrev == AFATFS_CACHE_NONE) {
+        afatfs.cacheLruHead = descriptor->lruNext;
+    } else {
+        afatfs.cacheDescriptor[descriptor->lruPrev].lruNext = descriptor->lruNext;
+    }
+
+    if (descriptor->lruNext == AFATFS_CACHE_NONE) {
+        afatfs.cacheLruTail = descriptor->lruPrev;
+    } else {
+        afatfs.cacheDescriptor[descriptor->lruNext].lruPrev = descriptor->lruPrev;
+    }
+}
+
+static void afatfs_cacheLruPushHead(int index)
+{
+    afatfsCacheBlockDescriptor_t *descriptor = &afatfs.cacheDescriptor[index];
+
+    descriptor->lruPrev = AFATFS_CACHE_NONE;
+    descriptor->lruNext = afatfs.cacheLruHead;
+
+    if (afatfs.cacheLruHead == AFATFS_CACHE_NONE) {
+        afatfs.cacheLruTail = index;
+    } else {
+        afatfs.cacheDescriptor[afatfs.cacheLruHead].lruPrev = index;
+    }
+
+    afatfs.cacheLruHead = index;
+}
+
+static void afatfs_cacheLruPushTail(int index)
+{
+    afatfsCacheBlockDescriptor_t *descriptor = &afatfs.cacheDescriptor[index];
+
+    descriptor->lruNext = AFATFS_CACHE_NONE;
+    descriptor->lruPrev = afatfs.cacheLruTail;
+
+    if (afatfs.cacheLruTail == AFATFS_CACHE_NONE) {
+        afatfs.cacheLruHead = index;
+    } else {
+        afatfs.cacheDescriptor[afatfs.cacheLruTail].lruNext = index;
+    }
+
+    afatfs.cacheLruTail = index;
+}
+
+/**
+ * Record an access to the cache sector, moving it to the most recently used end of the LRU list (or the least
+ * recently used end for discardable sectors).
+ */
+static void afatfs_cacheLruTouch(int index)
+{
+    afatfs_cacheLruUnlink(index);
+
+    if (afatfs.cacheDescriptor[index].discardable) {
+        afatfs_cacheLruPushTail(index);
+    } else {
+        afatfs_cacheLruPushHead(index);
+    }
+}
+
+/**
+ * Empty the cache hash and put every (empty) cache descriptor in the LRU list.
+ */
+static void afatfs_cacheInit()
+{
+    int i;
+
+    memset(afatfs.cacheHash, 0, sizeof(afatfs.cacheHash));
+
+    afatfs.cacheLruHead = AFATFS_CACHE_NONE;
+    afatfs.cacheLruTail = AFATFS_CACHE_NONE;
+
+    for (i = 0; i < AFATFS_NUM_CACHE_SECTORS; i++) {
+        afatfs.cacheDescriptor[i].hashed = 0;
+        afatfs_cacheLruPushTail(i);
+    }
+}
+
 /**
  * Called by the SD card driver when one of our read operations completes.
  */
@@ -622,22 +1029,20 @@ static void afatfs_sdcardReadComplete(sdcardBlockOperation_e operation, uint32_t
 {
     (void) operation;
     (void) callbackData;
-    int i;
+    int i = afatfs_cacheHashFind(sectorIndex);
 
-    for (i = 0; i < AFATFS_NUM_CACHE_SECTORS; i++) {
-        if (afatfs.cacheDescriptor[i].state != AFATFS_CACHE_STATE_EMPTY
-            && afatfs.cacheDescriptor[i].sectorIndex == sectorIndex
-        ) {
-            if (buffer == NULL) {
-                // Read failed, mark the sector as empty and whoever asked for it will ask for it again later to retry
-                afatfs.cacheDescriptor[i].state = AFATFS_CACHE_STATE_EMPTY;
-            } else {
-                afatfs_assert(afatfs_cacheSectorGetMemory(i) == buffer && afatfs.cacheDescriptor[i].state == AFATFS_CACHE_STATE_READING);
+    if (i != AFATFS_CACHE_NONE && afatfs.cacheDescriptor[i].state != AFATFS_CACHE_STATE_EMPTY) {
+        if (buffer == NULL) {
+            // Read failed, mark the sector as empty and whoever asked for it will ask for it again later to retry
+            afatfs.cacheDescriptor[i].state = AFATFS_CACHE_STATE_EMPTY;
 
-                afatfs.cacheDescriptor[i].state = AFATFS_CACHE_STATE_IN_SYNC;
-            }
+            // Reuse it before any sector which holds data
+            afatfs_cacheLruUnlink(i);
+            afatfs_cacheLruPushTail(i);
+        } else {
+            afatfs_assert(afatfs_cacheSectorGetMemory(i) == buffer && afatfs.cacheDescriptor[i].state == AFATFS_CACHE_STATE_READING);
 
-            break;
+            afatfs.cacheDescriptor[i].state = AFATFS_CACHE_STATE_IN_SYNC;
         }
     }
 }
@@ -649,27 +1054,22 @@ static void afatfs_sdcardWriteComplete(sdcardBlockOperation_e operation, uint32_
 {
     (void) operation;
     (void) callbackData;
-    int i;
+    int i = afatfs_cacheHashFind(sectorIndex);
 
     afatfs.cacheFlushInProgress = false;
 
-    for (i = 0; i < AFATFS_NUM_CACHE_SECTORS; i++) {
-        /* Keep in mind that someone may have marked the sector as dirty after writing had already begun. In this case we must leave
-         * it marked as dirty because those modifications may have been made too late to make it to the disk!
-         */
-        if (afatfs.cacheDescriptor[i].sectorIndex == sectorIndex
-            && afatfs.cacheDescriptor[i].state == AFATFS_CACHE_STATE_WRITING
-        ) {
-            if (buffer == NULL) {
-                // Write failed, remark the sector as dirty
-                afatfs.cacheDescriptor[i].state = AFATFS_CACHE_STATE_DIRTY;
-                afatfs.cacheDirtyEntries++;
-            } else {
-                afatfs_assert(afatfs_cacheSectorGetMemory(i) == buffer);
+    /* Keep in mind that someone may have marked the sector as dirty after writing had already begun. In this case we must leave
+     * it marked as dirty because those modifications may have been made too late to make it to the disk!
+     */
+    if (i != AFATFS_CACHE_NONE && afatfs.cacheDescriptor[i].state == AFATFS_CACHE_STATE_WRITING) {
+        if (buffer == NULL) {
+            // Write failed, remark the sector as dirty
+            afatfs.cacheDescriptor[i].state = AFATFS_CACHE_STATE_DIRTY;
+            afatfs.cacheDirtyEntries++;
+        } else {
+            afatfs_assert(afatfs_cacheSectorGetMemory(i) == buffer);
 
-                afatfs.cacheDescriptor[i].state = AFATFS_CACHE_STATE_IN_SYNC;
-            }
-            break;
+            afatfs.cacheDescriptor[i].state = AFATFS_CACHE_STATE_IN_SYNC;
         }
     }
 }
@@ -714,11 +1114,10 @@ static void afatfs_cacheFlushSector(int cacheIndex)
  */
 static afatfsCacheBlockDescriptor_t* afatfs_findCacheSector(uint32_t sectorIndex)
 {
-    int i;
-    for (i = 0; i < AFATFS_NUM_CACHE_SECTORS; i++) {
-        if (afatfs.cacheDescriptor[i].sectorIndex == sectorIndex) {
-            return &afatfs.cacheDescriptor[i];
-        }
+    int i = afatfs_cacheHashFind(sectorIndex);
+
+    if (i != AFATFS_CACHE_NONE) {
+        return &afatfs.cacheDescriptor[i];
     }
 
     return NULL;
@@ -729,20 +1128,15 @@ static afatfsCacheBlockDescriptor_t* afatfs_findCacheSector(uint32_t sectorIndex
  * conditions (in descending order of preference):
  *
  * - The requested sector that already exists in the cache
- * - The index of an empty sector
- * - The index of a synced discardable sector
- * - The index of the oldest synced sector
+ * - The least recently used sector which is empty, or synced and neither locked nor retained. Empty and discardable
+ *   sectors are kept at the least recently used end of the list so they are chosen first.
  *
  * Otherwise it returns -1 to signal failure (cache is full!)
  */
 static int afatfs_allocateCacheSector(uint32_t sectorIndex)
 {
+    afatfsCacheBlockDescriptor_t *descriptor;
     int allocateIndex;
-    int emptyIndex = -1, discardableIndex = -1;
-    int i;
-
-    uint32_t oldestSyncedSectorLastUse = 0xFFFFFFFF;
-    int oldestSyncedSectorIndex = -1;
 
     if (
         !afatfs_assert(
@@ -753,57 +1147,59 @@ static int afatfs_allocateCacheSector(uint32_t sectorIndex)
         return -1;
     }
 
-    for (i = 0; i < AFATFS_NUM_CACHE_SECTORS; i++) {
-        if (afatfs.cacheDescriptor[i].sectorIndex == sectorIndex) {
-            /*
-             * If the sector is actually empty then do a complete re-init of it just like the standard
-             * empty case. (Sectors marked as empty should be treated as if they don't have a block index assigned)
-             */
-            if (afatfs.cacheDescriptor[i].state == AFATFS_CACHE_STATE_EMPTY) {
-                emptyIndex = i;
+    allocateIndex = afatfs_cacheHashFind(sectorIndex);
+
+    if (allocateIndex != AFATFS_CACHE_NONE) {
+        /*
+         * If the sector is actually empty then do a complete re-init of it just like the standard
+         * empty case. (Sectors marked as empty should be treated as if they don't have a block index assigned)
+         */
+        if (afatfs.cacheDescriptor[allocateIndex].state != AFATFS_CACHE_STATE_EMPTY) {
+            // Don't count the polls while the sector is being read
+            if (afatfs.cacheDescriptor[allocateIndex].state != AFATFS_CACHE_STATE_READING) {
+                afatfs_cacheStatistics.hits++;
+            }
+            afatfs_cacheLruTouch(allocateIndex);
+            return allocateIndex;
+        }
+    } else {
+        /*
+         * Sectors which are being read, written, are dirty, locked or retained can't be evicted. Walking from the
+         * least recently used end, there are only as many of those to skip as are currently busy.
+         */
+        for (allocateIndex = afatfs.cacheLruTail; allocateIndex != AFATFS_CACHE_NONE; allocateIndex = descriptor->lruPrev) {
+            descriptor = &afatfs.cacheDescriptor[allocateIndex];
+
+            if (descriptor->state == AFATFS_CACHE_STATE_EMPTY
+                || (descriptor->state == AFATFS_CACHE_STATE_IN_SYNC && !descriptor->locked && descriptor->retainCount == 0)) {
                 break;
             }
+        }
 
-            // Bump the last access time
-            afatfs.cacheDescriptor[i].accessTimestamp = ++afatfs.cacheTimer;
-            return i;
+        if (allocateIndex == AFATFS_CACHE_NONE) {
+            afatfs_cacheStatistics.stalls++;
+            return -1;
         }
 
-        switch (afatfs.cacheDescriptor[i].state) {
-            case AFATFS_CACHE_STATE_EMPTY:
-                emptyIndex = i;
-            break;
-            case AFATFS_CACHE_STATE_IN_SYNC:
-                // Is this a synced sector that we could evict from the cache?
-                if (!afatfs.cacheDescriptor[i].locked && afatfs.cacheDescriptor[i].retainCount == 0) {
-                    if (afatfs.cacheDescriptor[i].discardable) {
-                        discardableIndex = i;
-                    } else if (afatfs.cacheDescriptor[i].accessTimestamp < oldestSyncedSectorLastUse) {
-                        // This is older than last block we decided to evict, so evict this one in preference
-                        oldestSyncedSectorLastUse = afatfs.cacheDescriptor[i].accessTimestamp;
-                        oldestSyncedSectorIndex = i;
-                    }
-                }
-            break;
-            default:
-                ;
+        if (descriptor->state == AFATFS_CACHE_STATE_IN_SYNC) {
+            afatfs_cacheStatistics.evictions++;
         }
-    }
 
-    if (emptyIndex > -1) {
-        allocateIndex = emptyIndex;
-    } else if (discardableIndex > -1) {
-        allocateIndex = discardableIndex;
-    } else if (oldestSyncedSectorIndex > -1) {
-        allocateIndex = oldestSyncedSectorIndex;
-    } else {
-        allocateIndex = -1;
+        if (descriptor->hashed) {
+            afatfs_cacheHashRemove(allocateIndex);
+        }
     }
 
-    if (allocateIndex > -1) {
-        afatfs_cacheSectorInit(&afatfs.cacheDescriptor[allocateIndex], sectorIndex, false);
+    afatfs_cacheStatistics.misses++;
+
+    afatfs_cacheSectorInit(&afatfs.cacheDescriptor[allocateIndex], sectorIndex, false);
+
+    if (!afatfs.cacheDescriptor[allocateIndex].hashed) {
+        afatfs_cacheHashInsert(allocateIndex);
     }
 
+    afatfs_cacheLruTouch(allocateIndex);
+
     return allocateIndex;
 }
 
@@ -928,10 +1324,11 @@ static afatfsOperationStatus_e afatfs_cacheSector(uint32_t physicalSectorIndex,
 
             // We only get to decide these fields if we're the first ones to cache the sector:
             afatfs.cacheDescriptor[cacheSectorIndex].discardable = (sectorFlags & AFATFS_CACHE_DISCARDABLE) != 0 ? 1 : 0;
+            afatfs_cacheLruTouch(cacheSectorIndex);
 
 #ifdef AFATFS_MIN_MULTIPLE_BLOCK_WRITE_COUNT
             // Don't bother pre-erasing for small block sequences
-            if (eraseCount < AFATFS_MIN_MULTIPLE_BLOCK_WRITE_COUNT) {
+            if (eraseCount < afatfs_minMultipleBlockWriteCount) {
                 eraseCount = 0;
             } else {
                 eraseCount = MIN(eraseCount, UINT16_MAX); // If caller asked for a longer chain of sectors we silently truncate that here
@@ -1042,9 +1439,11 @@ static bool afatfs_parseVolumeID(const uint8_t *sector)
 
     if (afatfs.filesystemType == FAT_FILESYSTEM_TYPE_FAT32) {
         afatfs.rootDirectoryCluster = volume->fatDescriptor.fat32.rootCluster;
+        afatfs.volumeSerial = volume->fatDescriptor.fat32.volumeID;
     } else {
         // FAT16 doesn't store the root directory in clusters
         afatfs.rootDirectoryCluster = 0;
+        afatfs.volumeSerial = volume->fatDescriptor.fat16.volumeID;
     }
 
     uint32_t endOfFATs = afatfs.fatStartSector + AFATFS_NUM_FATS * afatfs.fatSectors;
@@ -1463,6 +1862,10 @@ static afatfsOperationStatus_e afatfs_saveDirectoryEntry(afatfsFilePtr_t file, a
                    entry->fileSize = file->physicalSize;
                break;
                case AFATFS_SAVE_DIRECTORY_DELETED:
+#ifdef AFATFS_USE_DIRECTORY_INDEX
+                   afatfs_directoryIndexRemove((const uint8_t *) entry->filename, &file->directoryEntryPos);
+#endif
+                   afatfs_longNameCacheRemove(&file->directoryEntryPos);
                    entry->filename[0] = FAT_DELETED_FILE_MARKER;
                    //Fall through
 
@@ -1911,49 +2314,292 @@ static uint8_t* afatfs_fileLockCursorSectorForWrite(afatfsFilePtr_t file)
 }
 
 /**
- * Attempt to seek the file pointer by the offset, relative to the current position.
- *
- * Returns true if the seek was completed, or false if you should try again later by calling this routine again (the
- * cursor is not moved and no seek operation is queued on the file for you).
- *
- * You can only seek forwards by the size of a cluster or less, or backwards to stay within the same cluster. Otherwise
- * false will always be returned (calling this routine again will never make progress on the seek).
- *
- * This amount of seek is special because we will have to wait on at most one read operation, so it's easy to make
- * the seek atomic.
+ * Stop the read-ahead of the file, counting the prefetched sectors which will now not be read.
  */
-static bool afatfs_fseekAtomic(afatfsFilePtr_t file, int32_t offset)
+static void afatfs_fileReadAheadStop(afatfsFilePtr_t file)
 {
-    // Seeks within a sector
-    uint32_t newSectorOffset = offset + file->cursorOffset % AFATFS_SECTOR_SIZE;
+    afatfsReadAhead_t *readAhead = &file->readAhead;
 
-    // i.e. newSectorOffset is non-negative and smaller than AFATFS_SECTOR_SIZE, we're staying within the same sector
-    if (newSectorOffset < AFATFS_SECTOR_SIZE) {
-        file->cursorOffset += offset;
-        return true;
+    // Sectors from the one after the last sector read up to the read-ahead position are in the cache unread
+    if (readAhead->window != 0 && readAhead->offset > readAhead->nextSectorOffset) {
+        afatfs_readAheadStatistics.wasted += (readAhead->offset - readAhead->nextSectorOffset) / AFATFS_SECTOR_SIZE;
     }
 
-    // We're seeking outside the sector so unlock it if we were holding it
-    afatfs_fileUnlockCacheSector(file);
+    readAhead->window = 0;
+    readAhead->sequentialSectors = 0;
+}
 
-    // FAT16 root directories are made up of contiguous sectors rather than clusters
-    if (file->type == AFATFS_FILE_TYPE_FAT16_ROOT_DIRECTORY) {
-        file->cursorOffset += offset;
+/**
+ * Point the read-ahead at the sector following the one at the cursor.
+ */
+static void afatfs_fileReadAheadRestart(afatfsFilePtr_t file)
+{
+    afatfsReadAhead_t *readAhead = &file->readAhead;
 
-        return true;
+    readAhead->offset = (file->cursorOffset & ~(AFATFS_SECTOR_SIZE - 1)) + AFATFS_SECTOR_SIZE;
+
+    if ((readAhead->offset & afatfs.byteInClusterMask) == 0) {
+        readAhead->cluster = 0;
+        readAhead->previousCluster = file->cursorCluster;
+    } else {
+        readAhead->cluster = file->cursorCluster;
     }
+}
 
-    uint32_t clusterSizeBytes = afatfs_clusterSize();
-    uint32_t offsetInCluster = afatfs_byteIndexInCluster(file->cursorOffset);
-    uint32_t newOffsetInCluster = offsetInCluster + offset;
+/**
+ * Called by fread() when the cursor has moved to a new sector. Detects sequential reading and starts, stops or
+ * re-targets the read-ahead of the file.
+ */
+static void afatfs_fileReadAheadNoteSector(afatfsFilePtr_t file)
+{
+    afatfsReadAhead_t *readAhead = &file->readAhead;
+    uint32_t sectorOffset = file->cursorOffset & ~(AFATFS_SECTOR_SIZE - 1);
 
-    afatfsOperationStatus_e status;
+    if (sectorOffset == readAhead->nextSectorOffset) {
+        if (readAhead->sequentialSectors < UINT8_MAX) {
+            readAhead->sequentialSectors++;
+        }
 
-    if (offset > (int32_t) clusterSizeBytes || offset < -(int32_t) offsetInCluster) {
-        return false;
+        if (readAhead->window == 0) {
+            if (readAhead->sequentialSectors >= AFATFS_READ_AHEAD_TRIGGER && file->type == AFATFS_FILE_TYPE_NORMAL) {
+                readAhead->window = AFATFS_READ_AHEAD_MIN_SECTORS;
+                readAhead->streak = 0;
+                afatfs_fileReadAheadRestart(file);
+            }
+        } else if (readAhead->offset <= sectorOffset) {
+            // The reader has overtaken the read-ahead
+            afatfs_fileReadAheadRestart(file);
+        } else {
+            afatfs_readAheadStatistics.hits++;
+        }
+    } else if (sectorOffset + AFATFS_SECTOR_SIZE != readAhead->nextSectorOffset) {
+        // Not the same sector as last time either, so the file was seeked
+        afatfs_fileReadAheadStop(file);
     }
 
-    // Are we seeking outside the cluster? If so we'll need to find out the next cluster number
+    readAhead->nextSectorOffset = sectorOffset + AFATFS_SECTOR_SIZE;
+}
+
+/**
+ * Called by fread() when the sector at the cursor has been found in the cache. Adapts the read-ahead window to how
+ * fast the file is being consumed compared to how fast the card delivers.
+ */
+static void afatfs_fileReadAheadAdapt(afatfsFilePtr_t file)
+{
+    afatfsReadAhead_t *readAhead = &file->readAhead;
+
+    if (readAhead->window != 0) {
+        if (readAhead->waited) {
+            afatfs_readAheadStatistics.late++;
+
+            readAhead->window = MIN(readAhead->window * 2, AFATFS_READ_AHEAD_MAX_SECTORS);
+            readAhead->streak = 0;
+        } else if (++readAhead->streak >= readAhead->window * AFATFS_READ_AHEAD_SHRINK_FACTOR) {
+            readAhead->window = MAX(readAhead->window - 1, AFATFS_READ_AHEAD_MIN_SECTORS);
+            readAhead->streak = 0;
+        }
+    }
+
+    readAhead->waited = false;
+}
+
+/**
+ * Queue reads of the sectors in the read-ahead window of the file that aren't in the cache yet. Only one read is
+ * started per call since the card handles one operation at a time, call again to continue.
+ */
+static void afatfs_fileReadAheadContinue(afatfsFilePtr_t file)
+{
+    afatfsReadAhead_t *readAhead = &file->readAhead;
+    uint32_t limit, nextCluster;
+    uint8_t *sector;
+
+    if (readAhead->window == 0 || afatfs_fileIsBusy(file)) {
+        return;
+    }
+
+    limit = MIN(
+        roundUpTo(file->logicalSize, AFATFS_SECTOR_SIZE),
+        (file->cursorOffset & ~(AFATFS_SECTOR_SIZE - 1)) + (readAhead->window + 1) * AFATFS_SECTOR_SIZE
+    );
+
+    while (readAhead->offset < limit) {
+        if (readAhead->cluster == 0) {
+            switch (afatfs_FATGetNextCluster(0, readAhead->previousCluster, &nextCluster)) {
+                case AFATFS_OPERATION_SUCCESS:
+                    if (nextCluster < FAT_SMALLEST_LEGAL_CLUSTER_NUMBER || afatfs_FATIsEndOfChainMarker(nextCluster)) {
+                        // The chain is shorter than the file size claims, leave it to fread() to find out
+                        afatfs_fileReadAheadStop(file);
+                        return;
+                    }
+
+                    readAhead->cluster = nextCluster;
+                break;
+                case AFATFS_OPERATION_IN_PROGRESS:
+                    return;
+                case AFATFS_OPERATION_FAILURE:
+                default:
+                    afatfs_fileReadAheadStop(file);
+                    return;
+            }
+        }
+
+        switch (afatfs_cacheSector(afatfs_fileClusterToPhysical(readAhead->cluster, afatfs_sectorIndexInCluster(readAhead->offset)),
+                &sector, AFATFS_CACHE_READ, 0)) {
+            case AFATFS_OPERATION_SUCCESS:
+                afatfs_readAheadStatistics.prefetched++;
+            break;
+            case AFATFS_OPERATION_IN_PROGRESS:
+                // The read has been queued, or the card or cache is busy
+                return;
+            case AFATFS_OPERATION_FAILURE:
+            default:
+                afatfs_fileReadAheadStop(file);
+                return;
+        }
+
+        readAhead->offset += AFATFS_SECTOR_SIZE;
+
+        if ((readAhead->offset & afatfs.byteInClusterMask) == 0) {
+            readAhead->previousCluster = readAhead->cluster;
+            readAhead->cluster = 0;
+        }
+    }
+}
+
+/**
+ * Record in the extent map of the file that the cluster at index `clusterIndex` of the file, `cluster`, is followed by
+ * `nextCluster`. Only extends the map when it reaches as far as `clusterIndex`, and until the extents run out.
+ */
+static void afatfs_fileExtentsRecord(afatfsFilePtr_t file, uint32_t clusterIndex, uint32_t cluster, uint32_t nextCluster)
+{
+    afatfsFileExtents_t *extents = &file->extents;
+    afatfsFileExtent_t *last;
+
+    if (nextCluster < FAT_SMALLEST_LEGAL_CLUSTER_NUMBER || afatfs_FATIsEndOfChainMarker(nextCluster)) {
+        return;
+    }
+
+    // The map is dropped when the file gets a new cluster chain
+    if (extents->count == 0 || extents->extent[0].firstCluster != file->firstCluster) {
+        if (file->firstCluster == 0) {
+            return;
+        }
+
+        extents->extent[0].firstCluster = file->firstCluster;
+        extents->extent[0].clusterIndex = 0;
+        extents->mappedClusters = 1;
+        extents->count = 1;
+    }
+
+    last = &extents->extent[extents->count - 1];
+
+    if (clusterIndex + 1 != extents->mappedClusters || last->firstCluster + (clusterIndex - last->clusterIndex) != cluster) {
+        return;
+    }
+
+    if (nextCluster == cluster + 1) {
+        extents->mappedClusters++;
+    } else if (extents->count < AFATFS_FILE_MAX_EXTENTS) {
+        extents->extent[extents->count].firstCluster = nextCluster;
+        extents->extent[extents->count].clusterIndex = extents->mappedClusters;
+        extents->count++;
+        extents->mappedClusters++;
+    }
+}
+
+/**
+ * Find the mapped cluster of the file which is nearest to, but not after, the cluster with index `clusterIndex`.
+ *
+ * Returns the index of the cluster found, and sets *cluster to it and *previousCluster to the cluster before it in the
+ * chain (0 for the first cluster). Without a map that is the first cluster of the file.
+ */
+static uint32_t afatfs_fileExtentsLookup(afatfsFilePtr_t file, uint32_t clusterIndex, uint32_t *cluster, uint32_t *previousCluster)
+{
+    const afatfsFileExtents_t *extents = &file->extents;
+    const afatfsFileExtent_t *extent;
+    int low, high;
+
+    if (extents->count == 0 || extents->extent[0].firstCluster != file->firstCluster) {
+        *cluster = file->firstCluster;
+        *previousCluster = 0;
+        return 0;
+    }
+
+    clusterIndex = MIN(clusterIndex, extents->mappedClusters - 1);
+
+    // Binary search for the last extent which starts at or before clusterIndex
+    low = 0;
+    high = extents->count - 1;
+
+    while (low < high) {
+        int middle = (low + high + 1) / 2;
+
+        if (extents->extent[middle].clusterIndex <= clusterIndex) {
+            low = middle;
+        } else {
+            high = middle - 1;
+        }
+    }
+
+    extent = &extents->extent[low];
+
+    *cluster = extent->firstCluster + (clusterIndex - extent->clusterIndex);
+
+    if (clusterIndex > extent->clusterIndex) {
+        *previousCluster = *cluster - 1;
+    } else if (low > 0) {
+        *previousCluster = extent[-1].firstCluster + (extent->clusterIndex - extent[-1].clusterIndex - 1);
+    } else {
+        *previousCluster = 0;
+    }
+
+    return clusterIndex;
+}
+
+/**
+ * Attempt to seek the file pointer by the offset, relative to the current position.
+ *
+ * Returns true if the seek was completed, or false if you should try again later by calling this routine again (the
+ * cursor is not moved and no seek operation is queued on the file for you).
+ *
+ * You can only seek forwards by the size of a cluster or less, or backwards to stay within the same cluster. Otherwise
+ * false will always be returned (calling this routine again will never make progress on the seek).
+ *
+ * This amount of seek is special because we will have to wait on at most one read operation, so it's easy to make
+ * the seek atomic.
+ */
+static bool afatfs_fseekAtomic(afatfsFilePtr_t file, int32_t offset)
+{
+    // Seeks within a sector
+    uint32_t newSectorOffset = offset + file->cursorOffset % AFATFS_SECTOR_SIZE;
+
+    // i.e. newSectorOffset is non-negative and smaller than AFATFS_SECTOR_SIZE, we're staying within the same sector
+    if (newSectorOffset < AFATFS_SECTOR_SIZE) {
+        file->cursorOffset += offset;
+        return true;
+    }
+
+    // We're seeking outside the sector so unlock it if we were holding it
+    afatfs_fileUnlockCacheSector(file);
+
+    // FAT16 root directories are made up of contiguous sectors rather than clusters
+    if (file->type == AFATFS_FILE_TYPE_FAT16_ROOT_DIRECTORY) {
+        file->cursorOffset += offset;
+
+        return true;
+    }
+
+    uint32_t clusterSizeBytes = afatfs_clusterSize();
+    uint32_t offsetInCluster = afatfs_byteIndexInCluster(file->cursorOffset);
+    uint32_t newOffsetInCluster = offsetInCluster + offset;
+
+    afatfsOperationStatus_e status;
+
+    if (offset > (int32_t) clusterSizeBytes || offset < -(int32_t) offsetInCluster) {
+        return false;
+    }
+
+    // Are we seeking outside the cluster? If so we'll need to find out the next cluster number
     if (newOffsetInCluster >= clusterSizeBytes) {
         uint32_t nextCluster;
 
@@ -1963,6 +2609,8 @@ static bool afatfs_fseekAtomic(afatfsFilePtr_t file, int32_t offset)
             // Seek to the beginning of the next cluster
             uint32_t bytesToSeek = clusterSizeBytes - offsetInCluster;
 
+            afatfs_fileExtentsRecord(file, file->cursorOffset / clusterSizeBytes, file->cursorCluster, nextCluster);
+
             file->cursorPreviousCluster = file->cursorCluster;
             file->cursorCluster = nextCluster;
             file->cursorOffset += bytesToSeek;
@@ -2003,6 +2651,8 @@ static bool afatfs_fseekInternalContinue(afatfsFile_t *file)
             // Seek to the beginning of the next cluster
             uint32_t bytesToSeek = clusterSizeBytes - offsetInCluster;
 
+            afatfs_fileExtentsRecord(file, file->cursorOffset / clusterSizeBytes, file->cursorCluster, nextCluster);
+
             file->cursorPreviousCluster = file->cursorCluster;
             file->cursorCluster = nextCluster;
 
@@ -2081,17 +2731,14 @@ static afatfsOperationStatus_e afatfs_fseekInternal(afatfsFilePtr_t file, uint32
  */
 afatfsOperationStatus_e afatfs_fseek(afatfsFilePtr_t file, int32_t offset, afatfsSeek_e whence)
 {
+    uint32_t targetOffset, clusterSizeBytes, clusterIndex, cluster, previousCluster;
+
     // We need an up-to-date logical filesize so we can clamp seeks to the EOF
     afatfs_fileUpdateFilesize(file);
 
     switch (whence) {
         case AFATFS_SEEK_CUR:
-            if (offset >= 0) {
-                // Only forwards seeks are supported by this routine:
-                return afatfs_fseekInternal(file, MIN(file->cursorOffset + offset, file->logicalSize), NULL);
-            }
-
-            // Convert a backwards relative seek into a SEEK_SET. TODO considerable room for improvement if within the same cluster
+            // Convert into a SEEK_SET, which will seek forwards from the cursor when that is quickest
             offset += file->cursorOffset;
         break;
 
@@ -2110,15 +2757,38 @@ afatfsOperationStatus_e afatfs_fseek(afatfsFilePtr_t file, int32_t offset, afatf
             // Fall through
     }
 
-    // Now we have a SEEK_SET with a positive offset. Begin by seeking to the start of the file
+    // Now we have a SEEK_SET with a positive offset
+    targetOffset = MIN((uint32_t) offset, file->logicalSize);
+
+    if (file->type == AFATFS_FILE_TYPE_FAT16_ROOT_DIRECTORY) {
+        // Contiguous sectors rather than a cluster chain, begin by seeking to the start of the file
+        afatfs_fileUnlockCacheSector(file);
+
+        file->cursorPreviousCluster = 0;
+        file->cursorCluster = file->firstCluster;
+        file->cursorOffset = 0;
+
+        return afatfs_fseekInternal(file, targetOffset, NULL);
+    }
+
+    clusterSizeBytes = afatfs_clusterSize();
+    clusterIndex = afatfs_fileExtentsLookup(file, targetOffset / clusterSizeBytes, &cluster, &previousCluster);
+
+    // Seek forwards from the cursor if it's at least as close to the target as the nearest cluster we have mapped
+    if (file->cursorOffset < targetOffset && file->cursorOffset / clusterSizeBytes >= clusterIndex
+            && !afatfs_isEndOfAllocatedFile(file)) {
+        return afatfs_fseekInternal(file, targetOffset - file->cursorOffset, NULL);
+    }
+
+    // Otherwise begin at the start of the mapped cluster
     afatfs_fileUnlockCacheSector(file);
 
-    file->cursorPreviousCluster = 0;
-    file->cursorCluster = file->firstCluster;
-    file->cursorOffset = 0;
+    file->cursorPreviousCluster = previousCluster;
+    file->cursorCluster = cluster;
+    file->cursorOffset = clusterIndex * clusterSizeBytes;
 
-    // Then seek forwards by the offset
-    return afatfs_fseekInternal(file, MIN((uint32_t) offset, file->logicalSize), NULL);
+    // Then seek forwards by the remaining offset
+    return afatfs_fseekInternal(file, targetOffset - file->cursorOffset, NULL);
 }
 
 /**
@@ -2137,14 +2807,213 @@ bool afatfs_ftell(afatfsFilePtr_t file, uint32_t *position)
 }
 
 /**
- * Attempt to advance the directory pointer `finder` to the next entry in the directory.
+ * Get the value which identifies the given directory in the directory index and the long filename cache, or 0 if the
+ * directory can't be told apart from others (it has no clusters yet).
+ */
+static uint32_t afatfs_directoryKey(afatfsFilePtr_t directory)
+{
+    if (directory->type == AFATFS_FILE_TYPE_FAT16_ROOT_DIRECTORY) {
+        return UINT32_MAX;
+    }
+
+    return directory->firstCluster;
+}
+
+/**
+ * Copy the characters of a long filename entry into their place in the long filename being assembled.
+ */
+static void afatfs_longNameCopyCharacters(char *name, const uint8_t *characters, int count)
+{
+    int i;
+
+    for (i = 0; i < count; i++) {
+        // Little endian UCS-2, which may be unaligned
+        uint16_t character = characters[i * 2] | (characters[i * 2 + 1] << 8);
+
+        // The name is terminated with a 0 and padded with 0xFFFF. Characters outside latin-1 can't be represented
+        if (character == 0x0000 || character == 0xFFFF) {
+            name[i] = '\0';
+        } else if (character > 0xFF) {
+            name[i] = '_';
+        } else {
+            name[i] = (char) character;
+        }
+    }
+}
+
+/**
+ * Feed the directory entry which `finder` has just read to the assembly of long filenames in `longName`.
+ */
+static void afatfs_longNameAddEntry(afatfsLongName_t *longName, const afatfsFinder_t *finder, fatDirectoryEntry_t *entry)
+{
+    if (longName->finder != finder) {
+        longName->finder = finder;
+        longName->nextOrder = -1;
+    }
+
+    longName->valid = false;
+
+    if (fat_isDirectoryEntryTerminator(entry) || fat_isDirectoryEntryEmpty(entry)) {
+        longName->nextOrder = -1;
+    } else if (fat_isDirectoryEntryLongName(entry)) {
+        const fatLongNameEntry_t *part = (const fatLongNameEntry_t *) entry;
+        int order = part->order & FAT_LONG_NAME_ORDER_MASK;
+        char *name;
+
+        if ((part->order & FAT_LONG_NAME_LAST_ENTRY) != 0) {
+            if (order == 0 || order > FAT_LONG_NAME_MAX_ENTRIES) {
+                longName->nextOrder = -1;
+                return;
+            }
+
+            longName->checksum = part->checksum;
+            longName->name[order * FAT_LONG_NAME_CHARS_PER_ENTRY] = '\0';
+        } else if (order != longName->nextOrder || order == 0 || part->checksum != longName->checksum) {
+            // Orphaned or out of order
+            longName->nextOrder = -1;
+            return;
+        }
+
+        name = longName->name + (order - 1) * FAT_LONG_NAME_CHARS_PER_ENTRY;
+
+        afatfs_longNameCopyCharacters(name, (const uint8_t *) part->name1, 5);
+        afatfs_longNameCopyCharacters(name + 5, (const uint8_t *) part->name2, 6);
+        afatfs_longNameCopyCharacters(name + 11, (const uint8_t *) part->name3, 2);
+
+        longName->nextOrder = order - 1;
+    } else {
+        // A short entry, which the long filename belongs to if it wasn't modified by a driver that doesn't know them
+        if (longName->nextOrder == 0 && longName->checksum == fat_shortFilenameChecksum((const uint8_t *) entry->filename)
+                && longName->name[0] != '\0' && strlen(longName->name) <= FAT_LONG_NAME_MAX_LENGTH) {
+            longName->valid = true;
+            longName->position = *finder;
+        }
+
+        longName->nextOrder = -1;
+    }
+}
+
+/**
+ * Forget the long filename assembled in `longName`, before a new search starts.
+ */
+static void afatfs_longNameReset(afatfsLongName_t *longName)
+{
+    longName->finder = NULL;
+    longName->nextOrder = -1;
+    longName->valid = false;
+}
+
+/**
+ * Get the long filename assembled in `longName` of the directory entry which was last read by `finder`.
  *
- * Returns:
- *     AFATFS_OPERATION_SUCCESS -     A pointer to the next directory entry has been loaded into *dirEntry. If the
- *                                    directory was exhausted then *dirEntry will be set to NULL.
- *     AFATFS_OPERATION_IN_PROGRESS - The disk is busy. The pointer is not advanced, call again later to retry.
+ * Returns NULL if the entry only has a short filename.
  */
-afatfsOperationStatus_e afatfs_findNext(afatfsFilePtr_t directory, afatfsFinder_t *finder, fatDirectoryEntry_t **dirEntry)
+static const char* afatfs_longNameGet(const afatfsLongName_t *longName, const afatfsFinder_t *finder)
+{
+    if (longName->valid && longName->finder == finder && longName->position.sectorNumberPhysical == finder->sectorNumberPhysical
+            && longName->position.entryIndex == finder->entryIndex) {
+        return longName->name;
+    }
+
+    return NULL;
+}
+
+/**
+ * Get the long filename of the directory entry which was last returned by afatfs_findNext() for `finder`.
+ *
+ * Characters outside of latin-1 are replaced by '_'. Returns NULL if the entry only has a short filename.
+ */
+const char* afatfs_findLongName(const afatfsFinder_t *finder)
+{
+    return afatfs_longNameGet(&afatfs.longName, finder);
+}
+
+/**
+ * Compare two filenames, ignoring the case of ASCII letters like Windows does.
+ */
+static bool afatfs_longNameEquals(const char *a, const char *b)
+{
+    for (;; a++, b++) {
+        char upperA = (*a >= 'a' && *a <= 'z') ? *a - 'a' + 'A' : *a;
+        char upperB = (*b >= 'a' && *b <= 'z') ? *b - 'a' + 'A' : *b;
+
+        if (upperA != upperB) {
+            return false;
+        }
+        if (upperA == '\0') {
+            return true;
+        }
+    }
+}
+
+/**
+ * Find the long filename `name` in the current directory in the long filename cache.
+ */
+static afatfsLongNameCacheEntry_t* afatfs_longNameCacheFind(const char *name)
+{
+    uint32_t directory = afatfs_directoryKey(&afatfs.currentDirectory);
+    int i;
+
+    if (directory == 0) {
+        return NULL;
+    }
+
+    for (i = 0; i < AFATFS_LONG_NAME_CACHE_ENTRIES; i++) {
+        afatfsLongNameCacheEntry_t *entry = &afatfs.longNameCache[i];
+
+        if (entry->directory == directory && afatfs_longNameEquals(entry->name, name)) {
+            return entry;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Remember that the long filename `name` in the current directory belongs to the short directory entry `entry` at
+ * `position`.
+ */
+static void afatfs_longNameCacheAdd(const char *name, const fatDirectoryEntry_t *entry, const afatfsDirEntryPointer_t *position)
+{
+    afatfsLongNameCacheEntry_t *cacheEntry = afatfs_longNameCacheFind(name);
+    uint32_t directory = afatfs_directoryKey(&afatfs.currentDirectory);
+
+    if (directory == 0) {
+        return;
+    }
+
+    if (!cacheEntry) {
+        cacheEntry = &afatfs.longNameCache[afatfs.longNameCacheNext];
+        afatfs.longNameCacheNext = (afatfs.longNameCacheNext + 1) % AFATFS_LONG_NAME_CACHE_ENTRIES;
+    }
+
+    cacheEntry->directory = directory;
+    cacheEntry->position = *position;
+    memcpy(cacheEntry->filename, entry->filename, FAT_FILENAME_LENGTH);
+    strcpy(cacheEntry->name, name);
+}
+
+/**
+ * Forget the long filename of the directory entry at `position`.
+ */
+static void afatfs_longNameCacheRemove(const afatfsDirEntryPointer_t *position)
+{
+    int i;
+
+    for (i = 0; i < AFATFS_LONG_NAME_CACHE_ENTRIES; i++) {
+        afatfsLongNameCacheEntry_t *entry = &afatfs.longNameCache[i];
+
+        if (entry->position.sectorNumberPhysical == position->sectorNumberPhysical && entry->position.entryIndex == position->entryIndex) {
+            entry->directory = 0;
+        }
+    }
+}
+
+/**
+ * Like afatfs_findNext(), but assembles the long filenames in `longName`, or not at all if it is NULL.
+ */
+static afatfsOperationStatus_e afatfs_findNextEntry(afatfsFilePtr_t directory, afatfsFinder_t *finder,
+        afatfsLongName_t *longName, fatDirectoryEntry_t **dirEntry)
 {
     uint8_t *sector;
 
@@ -2166,6 +3035,10 @@ afatfsOperationStatus_e afatfs_findNext(afatfsFilePtr_t directory, afatfsFinder_
 
         finder->sectorNumberPhysical = afatfs_fileGetCursorPhysicalSector(directory);
 
+        if (longName) {
+            afatfs_longNameAddEntry(longName, finder, *dirEntry);
+        }
+
         return AFATFS_OPERATION_SUCCESS;
     } else {
         if (afatfs_isEndOfAllocatedFile(directory)) {
@@ -2178,6 +3051,21 @@ afatfsOperationStatus_e afatfs_findNext(afatfsFilePtr_t directory, afatfsFinder_
     }
 }
 
+/**
+ * Attempt to advance the directory pointer `finder` to the next entry in the directory.
+ *
+ * Returns:
+ *     AFATFS_OPERATION_SUCCESS -     A pointer to the next directory entry has been loaded into *dirEntry. If the
+ *                                    directory was exhausted then *dirEntry will be set to NULL.
+ *     AFATFS_OPERATION_IN_PROGRESS - The disk is busy. The pointer is not advanced, call again later to retry.
+ *
+ * The long filenames are assembled for one search at a time, see afatfs_findLongName().
+ */
+afatfsOperationStatus_e afatfs_findNext(afatfsFilePtr_t directory, afatfsFinder_t *finder, fatDirectoryEntry_t **dirEntry)
+{
+    return afatfs_findNextEntry(directory, finder, &afatfs.longName, dirEntry);
+}
+
 /**
  * Release resources associated with a find operation. Calling this more than once is harmless.
  */
@@ -2194,6 +3082,11 @@ void afatfs_findFirst(afatfsFilePtr_t directory, afatfsFinder_t *finder)
 {
     afatfs_fseek(directory, 0, AFATFS_SEEK_SET);
     finder->entryIndex = -1;
+
+    // Don't carry a long filename over from an earlier search
+    if (afatfs.longName.finder == finder) {
+        afatfs_longNameReset(&afatfs.longName);
+    }
 }
 
 static afatfsOperationStatus_e afatfs_extendSubdirectoryContinue(afatfsFile_t *directory)
@@ -2344,7 +3237,8 @@ static afatfsOperationStatus_e afatfs_allocateDirectoryEntry(afatfsFilePtr_t dir
         return AFATFS_OPERATION_IN_PROGRESS;
     }
 
-    while ((result = afatfs_findNext(directory, finder, dirEntry)) == AFATFS_OPERATION_SUCCESS) {
+    // Only looks for a free entry, without disturbing the long filenames of other searches
+    while ((result = afatfs_findNextEntry(directory, finder, NULL, dirEntry)) == AFATFS_OPERATION_SUCCESS) {
         if (*dirEntry) {
             if (fat_isDirectoryEntryEmpty(*dirEntry) || fat_isDirectoryEntryTerminator(*dirEntry)) {
                 afatfs_cacheSectorMarkDirty(afatfs_getCacheDescriptorForBuffer((uint8_t*) *dirEntry));
@@ -2525,16 +3419,144 @@ bool afatfs_ftruncate(afatfsFilePtr_t file, afatfsFileCallback_t callback)
         opState->endCluster = 0;
     }
 
-    // We'll drop the cluster chain from the directory entry immediately
-    file->firstCluster = 0;
-    file->logicalSize = 0;
-    file->physicalSize = 0;
+    // We'll drop the cluster chain from the directory entry immediately
+    file->firstCluster = 0;
+    file->logicalSize = 0;
+    file->physicalSize = 0;
+
+    // The first cluster may be allocated to the file again, so don't leave it to afatfs_fileExtentsRecord() to notice
+    file->extents.count = 0;
+
+    afatfs_fseek(file, 0, AFATFS_SEEK_SET);
+
+    return true;
+}
+
+#ifdef AFATFS_USE_DIRECTORY_INDEX
+
+/**
+ * Empty the directory index and start indexing the given directory.
+ */
+static void afatfs_directoryIndexReset(afatfsFilePtr_t directory)
+{
+    afatfsDirectoryIndex_t *index = &afatfs.directoryIndex;
+
+    memset(index->position, 0, sizeof(index->position));
+
+    index->directory = afatfs_directoryKey(directory);
+    index->count = 0;
+    index->complete = false;
+    index->overflowed = false;
+}
+
+/**
+ * Returns true if the directory index holds the entries of the given directory.
+ */
+static bool afatfs_directoryIndexIsFor(afatfsFilePtr_t directory)
+{
+    return afatfs.directoryIndex.directory != 0 && afatfs.directoryIndex.directory == afatfs_directoryKey(directory);
+}
+
+/**
+ * FNV-1a hash of an 8.3 filename.
+ */
+static uint32_t afatfs_directoryIndexHash(const uint8_t *filename)
+{
+    uint32_t hash = 2166136261u;
+    int i;
+
+    for (i = 0; i < FAT_FILENAME_LENGTH; i++) {
+        hash = (hash ^ filename[i]) * 16777619u;
+    }
+
+    return hash;
+}
+
+/**
+ * Add the directory entry at `pos` to the index, unless it is already there.
+ */
+static void afatfs_directoryIndexInsert(const fatDirectoryEntry_t *entry, const afatfsDirEntryPointer_t *pos)
+{
+    afatfsDirectoryIndex_t *index = &afatfs.directoryIndex;
+    uint32_t hash = afatfs_directoryIndexHash((const uint8_t *) entry->filename);
+    uint32_t position = (pos->sectorNumberPhysical << 4) | pos->entryIndex;
+    unsigned slot = hash & (AFATFS_DIRECTORY_INDEX_SIZE - 1);
+
+    // Deleted entries and long filename fragments can't be opened
+    if ((uint8_t) entry->filename[0] == FAT_DELETED_FILE_MARKER || (entry->attrib & FAT_FILE_ATTRIBUTE_VOLUME_ID) != 0) {
+        return;
+    }
+
+    // Sectors that don't leave room for the entry index in the position are beyond 128GB
+    if ((pos->sectorNumberPhysical >> 28) != 0) {
+        index->overflowed = true;
+        return;
+    }
+
+    while (index->position[slot] != 0) {
+        if (index->position[slot] == position) {
+            return;
+        }
+        slot = (slot + 1) & (AFATFS_DIRECTORY_INDEX_SIZE - 1);
+    }
+
+    if (index->count >= AFATFS_DIRECTORY_INDEX_MAX_ENTRIES) {
+        index->overflowed = true;
+        return;
+    }
 
-    afatfs_fseek(file, 0, AFATFS_SEEK_SET);
+    index->position[slot] = position;
+    index->tag[slot] = hash >> 16;
+    index->count++;
+}
 
-    return true;
+/**
+ * Remove the directory entry at `pos`, which holds `filename`, from the index.
+ */
+static void afatfs_directoryIndexRemove(const uint8_t *filename, const afatfsDirEntryPointer_t *pos)
+{
+    afatfsDirectoryIndex_t *index = &afatfs.directoryIndex;
+    uint32_t position = (pos->sectorNumberPhysical << 4) | pos->entryIndex;
+    unsigned slot = afatfs_directoryIndexHash(filename) & (AFATFS_DIRECTORY_INDEX_SIZE - 1);
+
+    while (index->position[slot] != 0) {
+        if (index->position[slot] == position) {
+            /*
+             * Leave a tombstone so that lookups carry on past the slot. It still counts towards the entries in the index
+             * so the table can't fill up with tombstones.
+             */
+            index->position[slot] = AFATFS_DIRECTORY_INDEX_REMOVED;
+            return;
+        }
+        slot = (slot + 1) & (AFATFS_DIRECTORY_INDEX_SIZE - 1);
+    }
+}
+
+/**
+ * Look up the position of the directory entry for `filename`.
+ *
+ * Returns true if it was found. The entry must be checked because distinct names can share a hash.
+ */
+static bool afatfs_directoryIndexFind(const uint8_t *filename, afatfsDirEntryPointer_t *pos)
+{
+    afatfsDirectoryIndex_t *index = &afatfs.directoryIndex;
+    uint32_t hash = afatfs_directoryIndexHash(filename);
+    unsigned slot = hash & (AFATFS_DIRECTORY_INDEX_SIZE - 1);
+
+    while (index->position[slot] != 0) {
+        if (index->tag[slot] == (uint16_t) (hash >> 16) && index->position[slot] != AFATFS_DIRECTORY_INDEX_REMOVED) {
+            pos->sectorNumberPhysical = index->position[slot] >> 4;
+            pos->entryIndex = index->position[slot] & 0x0F;
+            return true;
+        }
+        slot = (slot + 1) & (AFATFS_DIRECTORY_INDEX_SIZE - 1);
+    }
+
+    return false;
 }
 
+#endif
+
 /**
  * Load details from the given FAT directory entry into the file.
  */
@@ -2546,23 +3568,70 @@ static void afatfs_fileLoadDirectoryEntry(afatfsFile_t *file, fatDirectoryEntry_
     file->attrib = entry->attrib;
 }
 
+#ifdef AFATFS_USE_DIRECTORY_INDEX
+/**
+ * Returns true if the file being created may be looked up in, and added to, the directory index.
+ */
+static bool afatfs_createFileUsesIndex(const afatfsCreateFile_t *opState)
+{
+    // The directory index only holds short filenames
+    return !opState->skipIndex && opState->longName[0] == '\0';
+}
+#endif
+
 static void afatfs_createFileContinue(afatfsFile_t *file)
 {
     afatfsCreateFile_t *opState = &file->operation.state.createFile;
     fatDirectoryEntry_t *entry;
     afatfsOperationStatus_e status;
+    bool found;
 
     doMore:
 
     switch (opState->phase) {
         case AFATFS_CREATEFILE_PHASE_INITIAL:
+            if (!opState->skipIndex && opState->longName[0] != '\0') {
+                afatfsLongNameCacheEntry_t *cacheEntry = afatfs_longNameCacheFind(opState->longName);
+
+                if (cacheEntry) {
+                    // Check the short entry that the long filename belonged to before
+                    memcpy(opState->filename, cacheEntry->filename, FAT_FILENAME_LENGTH);
+                    file->directoryEntryPos = cacheEntry->position;
+
+                    opState->phase = AFATFS_CREATEFILE_PHASE_CHECK_HINT;
+                    goto doMore;
+                }
+            }
+#ifdef AFATFS_USE_DIRECTORY_INDEX
+            if (!afatfs_createFileUsesIndex(opState)) {
+                // Search the directory
+            } else if (afatfs_directoryIndexIsFor(&afatfs.currentDirectory)) {
+                if (afatfs_directoryIndexFind(opState->filename, &file->directoryEntryPos)) {
+                    opState->phase = AFATFS_CREATEFILE_PHASE_CHECK_HINT;
+                    goto doMore;
+                } else if (afatfs.directoryIndex.complete) {
+                    // The file isn't in the directory
+                    if ((file->mode & AFATFS_FILE_MODE_CREATE) != 0) {
+                        afatfs_findFirst(&afatfs.currentDirectory, &file->directoryEntryPos);
+                        opState->phase = AFATFS_CREATEFILE_PHASE_CREATE_NEW_FILE;
+                    } else {
+                        opState->phase = AFATFS_CREATEFILE_PHASE_FAILURE;
+                    }
+                    goto doMore;
+                }
+            } else {
+                // The search will index the directory as it goes
+                afatfs_directoryIndexReset(&afatfs.currentDirectory);
+            }
+#endif
             afatfs_findFirst(&afatfs.currentDirectory, &file->directoryEntryPos);
+            afatfs_longNameReset(&opState->foundLongName);
             opState->phase = AFATFS_CREATEFILE_PHASE_FIND_FILE;
             goto doMore;
         break;
         case AFATFS_CREATEFILE_PHASE_FIND_FILE:
             do {
-                status = afatfs_findNext(&afatfs.currentDirectory, &file->directoryEntryPos, &entry);
+                status = afatfs_findNextEntry(&afatfs.currentDirectory, &file->directoryEntryPos, &opState->foundLongName, &entry);
 
                 switch (status) {
                     case AFATFS_OPERATION_SUCCESS:
@@ -2570,7 +3639,26 @@ static void afatfs_createFileContinue(afatfsFile_t *file)
                         if (entry == NULL || fat_isDirectoryEntryTerminator(entry)) {
                             afatfs_findLast(&afatfs.currentDirectory);
 
-                            if ((file->mode & AFATFS_FILE_MODE_CREATE) != 0) {
+#ifdef AFATFS_USE_DIRECTORY_INDEX
+                            if (afatfs_createFileUsesIndex(opState) && afatfs_directoryIndexIsFor(&afatfs.currentDirectory)) {
+                                afatfs.directoryIndex.complete = !afatfs.directoryIndex.overflowed;
+
+                                // If the file was passed while the directory was being indexed, open it from there
+                                if (afatfs_directoryIndexFind(opState->filename, &file->directoryEntryPos)) {
+                                    opState->phase = AFATFS_CREATEFILE_PHASE_CHECK_HINT;
+                                    goto doMore;
+                                }
+                            }
+#endif
+
+                            if ((file->mode & AFATFS_FILE_MODE_CREATE) != 0 && opState->longName[0] != '\0') {
+                                /*
+                                 * Long filename entries aren't written, and a file created under the lossy short
+                                 * filename could neither be found by its name again nor be told apart from others.
+                                 */
+                                opState->phase = AFATFS_CREATEFILE_PHASE_FAILURE;
+                                goto doMore;
+                            } else if ((file->mode & AFATFS_FILE_MODE_CREATE) != 0) {
                                 // The file didn't already exist, so we can create it. Allocate a new directory entry
                                 afatfs_findFirst(&afatfs.currentDirectory, &file->directoryEntryPos);
 
@@ -2582,7 +3670,36 @@ static void afatfs_createFileContinue(afatfsFile_t *file)
                                 opState->phase = AFATFS_CREATEFILE_PHASE_FAILURE;
                                 goto doMore;
                             }
-                        } else if (strncmp(entry->filename, (char*) opState->filename, FAT_FILENAME_LENGTH) == 0) {
+                        }
+
+#ifdef AFATFS_USE_DIRECTORY_INDEX
+                        if (afatfs_createFileUsesIndex(opState) && afatfs_directoryIndexIsFor(&afatfs.currentDirectory)) {
+                            afatfs_directoryIndexInsert(entry, &file->directoryEntryPos);
+
+                            // Search the rest of the directory too, so that the index is complete
+                            if (!afatfs.directoryIndex.overflowed) {
+                                continue;
+                            }
+                        }
+#endif
+
+                        if (opState->longName[0] != '\0') {
+                            // The short filename made from a long one is lossy, only the long filename may match
+                            const char *longName = afatfs_longNameGet(&opState->foundLongName, &file->directoryEntryPos);
+
+                            found = longName && afatfs_longNameEquals(longName, opState->longName);
+
+                            if (found) {
+                                afatfs_longNameCacheAdd(longName, entry, &file->directoryEntryPos);
+
+                                // The short filename stands in for the long one from here on
+                                memcpy(opState->filename, entry->filename, FAT_FILENAME_LENGTH);
+                            }
+                        } else {
+                            found = strncmp(entry->filename, (char*) opState->filename, FAT_FILENAME_LENGTH) == 0;
+                        }
+
+                        if (found) {
                             // We found a file with this name!
                             afatfs_fileLoadDirectoryEntry(file, entry);
 
@@ -2602,6 +3719,36 @@ static void afatfs_createFileContinue(afatfsFile_t *file)
                 }
             } while (status == AFATFS_OPERATION_SUCCESS);
         break;
+        case AFATFS_CREATEFILE_PHASE_CHECK_HINT:
+        {
+            // Try the directory entry where the file was last seen before searching the directory for it
+            uint8_t *hintSector;
+
+            status = afatfs_cacheSector(file->directoryEntryPos.sectorNumberPhysical, &hintSector, AFATFS_CACHE_READ, 0);
+
+            if (status == AFATFS_OPERATION_SUCCESS) {
+                entry = (fatDirectoryEntry_t *) hintSector + file->directoryEntryPos.entryIndex;
+
+                if (strncmp(entry->filename, (char*) opState->filename, FAT_FILENAME_LENGTH) == 0) {
+                    afatfs_fileLoadDirectoryEntry(file, entry);
+                    opState->phase = AFATFS_CREATEFILE_PHASE_SUCCESS;
+                } else {
+                    // A stale hint, or another name with the same hash in the directory index
+                    opState->skipIndex = true;
+                    opState->phase = AFATFS_CREATEFILE_PHASE_INITIAL;
+
+                    if (opState->longName[0] != '\0') {
+                        afatfs_longNameCacheRemove(&file->directoryEntryPos);
+                        fat_convertFilenameToFATStyle(opState->longName, opState->filename);
+                    }
+                }
+                goto doMore;
+            } else if (status == AFATFS_OPERATION_FAILURE) {
+                opState->phase = AFATFS_CREATEFILE_PHASE_INITIAL;
+                goto doMore;
+            }
+        }
+        break;
         case AFATFS_CREATEFILE_PHASE_CREATE_NEW_FILE:
             status = afatfs_allocateDirectoryEntry(&afatfs.currentDirectory, &entry, &file->directoryEntryPos);
 
@@ -2615,6 +3762,12 @@ static void afatfs_createFileContinue(afatfsFile_t *file)
                 entry->lastWriteDate = AFATFS_DEFAULT_FILE_DATE;
                 entry->lastWriteTime = AFATFS_DEFAULT_FILE_TIME;
 
+#ifdef AFATFS_USE_DIRECTORY_INDEX
+                if (afatfs_directoryIndexIsFor(&afatfs.currentDirectory)) {
+                    afatfs_directoryIndexInsert(entry, &file->directoryEntryPos);
+                }
+#endif
+
 #ifdef AFATFS_DEBUG_VERBOSE
                 fprintf(stderr, "Adding directory entry for %.*s to sector %u\n", FAT_FILENAME_LENGTH, opState->filename, file->directoryEntryPos.sectorNumberPhysical);
 #endif
@@ -2763,8 +3916,19 @@ bool afatfs_funlink(afatfsFilePtr_t file, afatfsCallback_t callback)
  */
 static afatfsFilePtr_t afatfs_createFile(afatfsFilePtr_t file, const char *name, uint8_t attrib, uint8_t fileMode,
         afatfsFileCallback_t callback)
+{
+    return afatfs_createFileWithHint(file, name, attrib, fileMode, NULL, callback);
+}
+
+/**
+ * As afatfs_createFile(), but first check the directory entry at `hint` (e.g. where the file was found on an earlier
+ * mount) and only search the current directory if the file isn't there. The hint is not required to be valid.
+ */
+static afatfsFilePtr_t afatfs_createFileWithHint(afatfsFilePtr_t file, const char *name, uint8_t attrib,
+        uint8_t fileMode, const afatfsDirEntryPointer_t *hint, afatfsFileCallback_t callback)
 {
     afatfsCreateFile_t *opState = &file->operation.state.createFile;
+    bool nameUsable = true;
 
     afatfs_initFileHandle(file);
 
@@ -2783,6 +3947,15 @@ static afatfsFilePtr_t afatfs_createFile(afatfsFilePtr_t file, const char *name,
         fat_convertFilenameToFATStyle(name, opState->filename);
         file->attrib = attrib;
 
+        // Other names are only looked up by their long filename, and can't be created
+        if (!fat_isShortFilename(name)) {
+            nameUsable = strlen(name) <= FAT_LONG_NAME_MAX_LENGTH;
+
+            if (nameUsable) {
+                strcpy(opState->longName, name);
+            }
+        }
+
         if ((attrib & FAT_FILE_ATTRIBUTE_DIRECTORY) != 0) {
             file->type = AFATFS_FILE_TYPE_DIRECTORY;
         } else {
@@ -2795,6 +3968,12 @@ static afatfsFilePtr_t afatfs_createFile(afatfsFilePtr_t file, const char *name,
     if (strcmp(name, ".") == 0) {
         // Since we already have the directory entry details, we can skip straight to the final operations requried
         opState->phase = AFATFS_CREATEFILE_PHASE_SUCCESS;
+    } else if (!nameUsable) {
+        opState->phase = AFATFS_CREATEFILE_PHASE_FAILURE;
+    } else if (hint != NULL && hint->sectorNumberPhysical != 0 && opState->longName[0] == '\0') {
+        // A hint is checked by its short filename, which is lossy for a long filename
+        file->directoryEntryPos = *hint;
+        opState->phase = AFATFS_CREATEFILE_PHASE_CHECK_HINT;
     } else {
         opState->phase = AFATFS_CREATEFILE_PHASE_INITIAL;
     }
@@ -2868,6 +4047,7 @@ bool afatfs_fclose(afatfsFilePtr_t file, afatfsCallback_t callback)
         return false;
     } else {
         afatfs_fileUpdateFilesize(file);
+        afatfs_fileReadAheadStop(file);
 
         file->operation.operation = AFATFS_FILE_OPERATION_CLOSE;
         file->operation.state.closeFile.callback = callback;
@@ -2944,6 +4124,9 @@ bool afatfs_chdir(afatfsFilePtr_t directory)
  *
  * To open the current working directory, pass "." for filename.
  *
+ * A filename which doesn't fit the 8.3 format only opens the existing file with that long filename, it can't be
+ * created.
+ *
  * The complete() callback is called when finished with either a file handle (file was opened) or NULL upon failure.
  *
  * Supported file mode strings:
@@ -3097,18 +4280,12 @@ uint32_t afatfs_fwrite(afatfsFilePtr_t file, const uint8_t *buffer, uint32_t len
 }
 
 /**
- * Attempt to read `len` bytes from `file` into the `buffer`.
- *
- * Returns the number of bytes actually read.
+ * Check that `file` can be read from at its cursor, and return the number of bytes left between the cursor and the
+ * end of the file.
  *
- * 0 will be returned when:
- *     The filesystem is busy (try again later)
- *     EOF was reached (check afatfs_isEof())
- *
- * Fewer bytes than requested will be read when:
- *     The read spans a AFATFS_SECTOR_SIZE boundary and the following sector was not available in the cache yet.
+ * Returns 0 when the file isn't open for reading, is busy or is at EOF.
  */
-uint32_t afatfs_fread(afatfsFilePtr_t file, uint8_t *buffer, uint32_t len)
+static uint32_t afatfs_fileBytesReadable(afatfsFilePtr_t file)
 {
     if ((file->mode & AFATFS_FILE_MODE_READ) == 0) {
         return 0;
@@ -3127,7 +4304,80 @@ uint32_t afatfs_fread(afatfsFilePtr_t file, uint8_t *buffer, uint32_t len)
     if (file->cursorOffset >= file->logicalSize)
         return 0;
 
-    len = MIN(file->logicalSize - file->cursorOffset, len);
+    return file->logicalSize - file->cursorOffset;
+}
+
+/**
+ * Retain the sector at the file's cursor for reading, keeping the read-ahead of the file informed.
+ *
+ * Returns a pointer to the sector buffer, or NULL if the sector isn't in the cache yet (read-ahead is continued so
+ * that it will be soon).
+ */
+static uint8_t* afatfs_fileAcquireCursorSectorForRead(afatfsFilePtr_t file)
+{
+    bool newSector = file->readRetainCacheIndex == -1;
+    uint8_t *sectorBuffer;
+
+    if (newSector) {
+        afatfs_fileReadAheadNoteSector(file);
+    }
+
+    sectorBuffer = afatfs_fileRetainCursorSectorForRead(file);
+
+    if (!sectorBuffer) {
+        // Cache is currently busy
+        file->readAhead.waited = true;
+        afatfs_fileReadAheadContinue(file);
+    } else if (newSector) {
+        afatfs_fileReadAheadAdapt(file);
+    }
+
+    return sectorBuffer;
+}
+
+/**
+ * Advance the cursor of the file by `len` bytes which have been read from its retained cursor sector.
+ *
+ * Returns AFATFS_OPERATION_IN_PROGRESS if the advance queued a seek which will complete later (the file is busy until
+ * then).
+ */
+static afatfsOperationStatus_e afatfs_fileAdvanceReadCursor(afatfsFilePtr_t file, uint32_t len)
+{
+    int retainedCacheIndex = file->readRetainCacheIndex;
+    afatfsOperationStatus_e status;
+
+    /*
+     * A seek operation should always be able to queue on the file since the callers have checked that the file wasn't
+     * busy (fseek will never return AFATFS_OPERATION_FAILURE).
+     */
+    status = afatfs_fseekInternal(file, len, NULL);
+
+    if (status == AFATFS_OPERATION_SUCCESS) {
+        // A sector which has been read to the end by a sequential reader won't be needed again, evict it first
+        if (file->readAhead.window != 0 && file->readRetainCacheIndex == -1 && retainedCacheIndex != -1) {
+            afatfs.cacheDescriptor[retainedCacheIndex].discardable = 1;
+            afatfs_cacheLruTouch(retainedCacheIndex);
+        }
+    }
+
+    return status;
+}
+
+/**
+ * Attempt to read `len` bytes from `file` into the `buffer`.
+ *
+ * Returns the number of bytes actually read.
+ *
+ * 0 will be returned when:
+ *     The filesystem is busy (try again later)
+ *     EOF was reached (check afatfs_isEof())
+ *
+ * Fewer bytes than requested will be read when:
+ *     The read spans a AFATFS_SECTOR_SIZE boundary and the following sector was not available in the cache yet.
+ */
+uint32_t afatfs_fread(afatfsFilePtr_t file, uint8_t *buffer, uint32_t len)
+{
+    len = MIN(afatfs_fileBytesReadable(file), len);
 
     uint32_t readBytes = 0;
     uint32_t cursorOffsetInSector = file->cursorOffset % AFATFS_SECTOR_SIZE;
@@ -3136,9 +4386,8 @@ uint32_t afatfs_fread(afatfsFilePtr_t file, uint8_t *buffer, uint32_t len)
         uint32_t bytesToReadThisSector = MIN(AFATFS_SECTOR_SIZE - cursorOffsetInSector, len);
         uint8_t *sectorBuffer;
 
-        sectorBuffer = afatfs_fileRetainCursorSectorForRead(file);
+        sectorBuffer = afatfs_fileAcquireCursorSectorForRead(file);
         if (!sectorBuffer) {
-            // Cache is currently busy
             return readBytes;
         }
 
@@ -3149,11 +4398,8 @@ uint32_t afatfs_fread(afatfsFilePtr_t file, uint8_t *buffer, uint32_t len)
         /*
          * If the seek doesn't complete immediately then we'll break and wait for that seek to complete by waiting for
          * the file to be non-busy on entry again.
-         *
-         * A seek operation should always be able to queue on the file since we have checked that the file wasn't busy
-         * on entry (fseek will never return AFATFS_OPERATION_FAILURE).
          */
-        if (afatfs_fseekInternal(file, bytesToReadThisSector, NULL) == AFATFS_OPERATION_IN_PROGRESS) {
+        if (afatfs_fileAdvanceReadCursor(file, bytesToReadThisSector) == AFATFS_OPERATION_IN_PROGRESS) {
             break;
         }
 
@@ -3162,9 +4408,59 @@ uint32_t afatfs_fread(afatfsFilePtr_t file, uint8_t *buffer, uint32_t len)
         cursorOffsetInSector = 0;
     }
 
+    afatfs_fileReadAheadContinue(file);
+
     return readBytes;
 }
 
+/**
+ * Borrow the bytes at the cursor of `file` straight from the cache, instead of having them copied by afatfs_fread().
+ *
+ * `*buffer` is set to point at the cursor inside the cached sector, and the number of bytes which may be read from
+ * there is returned. That is up to the end of the sector or the end of the file, whichever comes first. The sector is
+ * retained so it stays in the cache until the cursor leaves it, the borrowed bytes must not be used after calling
+ * afatfs_freturn() or any other operation on the file.
+ *
+ * 0 will be returned when:
+ *     The filesystem is busy (try again later)
+ *     EOF was reached (check afatfs_isEof())
+ */
+uint32_t afatfs_fborrow(afatfsFilePtr_t file, const uint8_t **buffer)
+{
+    uint32_t len = afatfs_fileBytesReadable(file);
+    uint32_t cursorOffsetInSector = file->cursorOffset % AFATFS_SECTOR_SIZE;
+    uint8_t *sectorBuffer;
+
+    if (len == 0) {
+        return 0;
+    }
+
+    sectorBuffer = afatfs_fileAcquireCursorSectorForRead(file);
+    if (!sectorBuffer) {
+        return 0;
+    }
+
+    *buffer = sectorBuffer + cursorOffsetInSector;
+
+    return MIN(AFATFS_SECTOR_SIZE - cursorOffsetInSector, len);
+}
+
+/**
+ * Give back the bytes borrowed with afatfs_fborrow(), advancing the cursor of `file` past the first `len` of them.
+ * `len` may be less than was borrowed, the remainder will be borrowed again by the next call to afatfs_fborrow().
+ */
+void afatfs_freturn(afatfsFilePtr_t file, uint32_t len)
+{
+    if (len == 0 || !afatfs_assert(file->readRetainCacheIndex != -1
+            && len <= AFATFS_SECTOR_SIZE - file->cursorOffset % AFATFS_SECTOR_SIZE)) {
+        return;
+    }
+
+    afatfs_fileAdvanceReadCursor(file, len);
+
+    afatfs_fileReadAheadContinue(file);
+}
+
 /**
  * Returns true if the file's pointer position currently lies at the end-of-file point (i.e. one byte beyond the last
  * byte in the file).
@@ -3232,6 +4528,7 @@ static void afatfs_fileOperationsPoll()
 
     for (i = 0; i < AFATFS_MAX_OPEN_FILES; i++) {
         afatfs_fileOperationContinue(&afatfs.openFiles[i]);
+        afatfs_fileReadAheadContinue(&afatfs.openFiles[i]);
     }
 }
 
@@ -3344,6 +4641,10 @@ static void afatfs_freeFileCreated(afatfsFile_t *file)
         if (file->logicalSize > 0) {
             // We've completed freefile init, move on to the next init phase
             afatfs.initPhase = AFATFS_INITIALIZATION_FREEFILE_LAST + 1;
+        } else if (afatfs.volumeCache != NULL && afatfs.volumeCache->freeFileSearchFruitless) {
+            // The search came up empty the last time this volume was mounted, don't scan the whole FAT again
+            afatfs.freeFileSearchFruitless = true;
+            afatfs.initPhase = AFATFS_INITIALIZATION_FREEFILE_LAST + 1;
         } else {
             // Allocate clusters for the freefile
             afatfs_findLargestContiguousFreeBlockBegin();
@@ -3372,6 +4673,93 @@ static void afatfs_introspecLogCreated(afatfsFile_t *file)
 
 #endif
 
+/**
+ * Find the cached geometry of the card in the slot, or NULL if it hasn't been mounted recently.
+ */
+static afatfsVolumeCacheEntry_t* afatfs_findVolumeCacheEntry()
+{
+    const sdcardMetadata_t *card = sdcard_getMetadata();
+    int i;
+
+    for (i = 0; i < AFATFS_VOLUME_CACHE_ENTRIES; i++) {
+        afatfsVolumeCacheEntry_t *entry = &afatfs_volumeCache[i];
+
+        if (entry->valid && entry->manufacturerID == card->manufacturerID && entry->oemID == card->oemID
+                && entry->productSerial == card->productSerial) {
+            return entry;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Check that the volume ID just parsed describes the same volume as the cache entry.
+ */
+static bool afatfs_volumeMatchesCache(const afatfsVolumeCacheEntry_t *entry)
+{
+    return entry->volumeSerial == afatfs.volumeSerial
+        && entry->filesystemType == afatfs.filesystemType
+        && entry->fatStartSector == afatfs.fatStartSector
+        && entry->fatSectors == afatfs.fatSectors
+        && entry->numClusters == afatfs.numClusters
+        && entry->clusterStartSector == afatfs.clusterStartSector
+        && entry->sectorsPerCluster == afatfs.sectorsPerCluster
+        && entry->rootDirectoryCluster == afatfs.rootDirectoryCluster
+        && entry->rootDirectorySectors == afatfs.rootDirectorySectors;
+}
+
+/**
+ * Remember the geometry of the volume that has just been mounted, replacing the least recently mounted card if the
+ * card is new.
+ */
+static void afatfs_saveVolumeCacheEntry()
+{
+    const sdcardMetadata_t *card = sdcard_getMetadata();
+    afatfsVolumeCacheEntry_t *entry = afatfs.volumeCache;
+    int i;
+
+    for (i = 0; entry == NULL && i < AFATFS_VOLUME_CACHE_ENTRIES; i++) {
+        if (!afatfs_volumeCache[i].valid) {
+            entry = &afatfs_volumeCache[i];
+        }
+    }
+
+    if (entry == NULL) {
+        // Replace the least recently mounted card
+        entry = &afatfs_volumeCache[0];
+
+        for (i = 1; i < AFATFS_VOLUME_CACHE_ENTRIES; i++) {
+            if ((int32_t) (afatfs_volumeCache[i].lastUsed - entry->lastUsed) < 0) {
+                entry = &afatfs_volumeCache[i];
+            }
+        }
+    }
+
+    entry->valid = true;
+    entry->lastUsed = ++afatfs_volumeCacheTimer;
+
+    entry->manufacturerID = card->manufacturerID;
+    entry->oemID = card->oemID;
+    entry->productSerial = card->productSerial;
+
+    entry->volumeSerial = afatfs.volumeSerial;
+    entry->filesystemType = afatfs.filesystemType;
+    entry->partitionStartSector = afatfs.partitionStartSector;
+    entry->fatStartSector = afatfs.fatStartSector;
+    entry->fatSectors = afatfs.fatSectors;
+    entry->numClusters = afatfs.numClusters;
+    entry->clusterStartSector = afatfs.clusterStartSector;
+    entry->sectorsPerCluster = afatfs.sectorsPerCluster;
+    entry->rootDirectoryCluster = afatfs.rootDirectoryCluster;
+    entry->rootDirectorySectors = afatfs.rootDirectorySectors;
+
+#ifdef AFATFS_USE_FREEFILE
+    entry->freeFileEntryPos = afatfs.freeFile.directoryEntryPos;
+#endif
+    entry->freeFileSearchFruitless = afatfs.freeFileSearchFruitless;
+}
+
 static void afatfs_initContinue()
 {
 #ifdef AFATFS_USE_FREEFILE
@@ -3384,6 +4772,13 @@ static void afatfs_initContinue()
 
     switch (afatfs.initPhase) {
         case AFATFS_INITIALIZATION_READ_MBR:
+            if (afatfs.volumeCache != NULL) {
+                // Go straight to the partition we found last time, the volume ID will tell if it is still there
+                afatfs.partitionStartSector = afatfs.volumeCache->partitionStartSector;
+                afatfs.initPhase = AFATFS_INITIALIZATION_READ_VOLUME_ID;
+                goto doMore;
+            }
+
             if (afatfs_cacheSector(0, &sector, AFATFS_CACHE_READ | AFATFS_CACHE_DISCARDABLE, 0) == AFATFS_OPERATION_SUCCESS) {
                 if (afatfs_parseMBR(sector)) {
                     afatfs.initPhase = AFATFS_INITIALIZATION_READ_VOLUME_ID;
@@ -3396,6 +4791,15 @@ static void afatfs_initContinue()
         break;
         case AFATFS_INITIALIZATION_READ_VOLUME_ID:
             if (afatfs_cacheSector(afatfs.partitionStartSector, &sector, AFATFS_CACHE_READ | AFATFS_CACHE_DISCARDABLE, 0) == AFATFS_OPERATION_SUCCESS) {
+                if (afatfs.volumeCache != NULL && !(afatfs_parseVolumeID(sector) && afatfs_volumeMatchesCache(afatfs.volumeCache))) {
+                    // The card has been repartitioned or reformatted since we last saw it, mount it from scratch
+                    afatfs.volumeCache->valid = false;
+                    afatfs.volumeCache = NULL;
+                    afatfs.fastMount = false;
+                    afatfs.initPhase = AFATFS_INITIALIZATION_READ_MBR;
+                    goto doMore;
+                }
+
                 if (afatfs_parseVolumeID(sector)) {
                     // Open the root directory
                     afatfs_chdir(NULL);
@@ -3412,8 +4816,9 @@ static void afatfs_initContinue()
         case AFATFS_INITIALIZATION_FREEFILE_CREATE:
             afatfs.initPhase = AFATFS_INITIALIZATION_FREEFILE_CREATING;
 
-            afatfs_createFile(&afatfs.freeFile, AFATFS_FREESPACE_FILENAME, FAT_FILE_ATTRIBUTE_SYSTEM | FAT_FILE_ATTRIBUTE_READ_ONLY,
-                AFATFS_FILE_MODE_CREATE | AFATFS_FILE_MODE_RETAIN_DIRECTORY, afatfs_freeFileCreated);
+            afatfs_createFileWithHint(&afatfs.freeFile, AFATFS_FREESPACE_FILENAME, FAT_FILE_ATTRIBUTE_SYSTEM | FAT_FILE_ATTRIBUTE_READ_ONLY,
+                AFATFS_FILE_MODE_CREATE | AFATFS_FILE_MODE_RETAIN_DIRECTORY,
+                afatfs.volumeCache != NULL ? &afatfs.volumeCache->freeFileEntryPos : NULL, afatfs_freeFileCreated);
         break;
         case AFATFS_INITIALIZATION_FREEFILE_CREATING:
             afatfs_fileOperationContinue(&afatfs.freeFile);
@@ -3452,6 +4857,8 @@ static void afatfs_initContinue()
                     } // Else the freefile's FAT chain and filesize remains the default (empty)
                 }
 
+                afatfs.freeFileSearchFruitless = afatfs.initPhase != AFATFS_INITIALIZATION_FREEFILE_UPDATE_FAT;
+
                 goto doMore;
             }
         break;
@@ -3493,6 +4900,7 @@ static void afatfs_initContinue()
 #endif
 
         case AFATFS_INITIALIZATION_DONE:
+            afatfs_saveVolumeCacheEntry();
             afatfs.filesystemState = AFATFS_FILESYSTEM_STATE_READY;
         break;
     }
@@ -3575,11 +4983,49 @@ afatfsError_e afatfs_getLastError()
     return afatfs.lastError;
 }
 
+/**
+ * Get the hit, miss and eviction counts of the sector cache since the last reset.
+ */
+void afatfs_getCacheStatistics(afatfsCacheStatistics_t *statistics)
+{
+    *statistics = afatfs_cacheStatistics;
+    statistics->sectors = AFATFS_NUM_CACHE_SECTORS;
+}
+
+void afatfs_resetCacheStatistics()
+{
+    memset(&afatfs_cacheStatistics, 0, sizeof(afatfs_cacheStatistics));
+    memset(&afatfs_readAheadStatistics, 0, sizeof(afatfs_readAheadStatistics));
+}
+
+/**
+ * Get the read-ahead counts since the last afatfs_resetCacheStatistics().
+ */
+void afatfs_getReadAheadStatistics(afatfsReadAheadStatistics_t *statistics)
+{
+    *statistics = afatfs_readAheadStatistics;
+}
+
+/**
+ * True if the current mount was started from the cached geometry of a card that has been mounted before.
+ */
+bool afatfs_isFastMount()
+{
+    return afatfs.fastMount;
+}
+
 void afatfs_init()
 {
     afatfs.filesystemState = AFATFS_FILESYSTEM_STATE_INITIALIZATION;
     afatfs.initPhase = AFATFS_INITIALIZATION_READ_MBR;
     afatfs.lastClusterAllocated = FAT_SMALLEST_LEGAL_CLUSTER_NUMBER;
+    afatfs_cacheInit();
+    afatfs.volumeCache = afatfs_findVolumeCacheEntry();
+    afatfs.fastMount = afatfs.volumeCache != NULL;
+
+#ifdef AFATFS_MIN_MULTIPLE_BLOCK_WRITE_COUNT
+    tunables_register(&afatfs_minMultipleBlockWriteCountTunable);
+#endif
 
 #ifdef AFATFS_USE_INTROSPECTIVE_LOGGING
     sdcard_setProfilerCallback(afatfs_sdcardProfilerCallback);
@@ -34,6 +34,21 @@ typedef struct afatfsDirEntryPointer_t {
 
 typedef afatfsDirEntryPointer_t afatfsFinder_t;
 
+typedef struct afatfsCacheStatistics_t {
+    uint32_t hits;      // The sector was in the cache
+    uint32_t misses;    // The sector had to be read, or a new sector was allocated for writing
+    uint32_t evictions; // Misses which replaced a synced sector
+    uint32_t stalls;    // Requests which had to wait because no sector could be replaced
+    uint32_t sectors;   // Size of the cache
+} afatfsCacheStatistics_t;
+
+typedef struct afatfsReadAheadStatistics_t {
+    uint32_t prefetched; // Sectors brought into the cache ahead of a sequential reader
+    uint32_t hits;       // Sectors the reader reached after they had been prefetched
+    uint32_t late;       // Sectors the reader had to wait for while read-ahead was running
+    uint32_t wasted;     // Prefetched sectors never read because the file was seeked or closed
+} afatfsReadAheadStatistics_t;
+
 typedef enum {
     AFATFS_SEEK_SET,
     AFATFS_SEEK_CUR,
@@ -52,6 +67,8 @@ bool afatfs_feof(afatfsFilePtr_t file);
 void afatfs_fputc(afatfsFilePtr_t file, uint8_t c);
 uint32_t afatfs_fwrite(afatfsFilePtr_t file, const uint8_t *buffer, uint32_t len);
 uint32_t afatfs_fread(afatfsFilePtr_t file, uint8_t *buffer, uint32_t len);
+uint32_t afatfs_fborrow(afatfsFilePtr_t file, const uint8_t **buffer);
+void afatfs_freturn(afatfsFilePtr_t file, uint32_t len);
 afatfsOperationStatus_e afatfs_fseek(afatfsFilePtr_t file, int32_t offset, afatfsSeek_e whence);
 bool afatfs_ftell(afatfsFilePtr_t file, uint32_t *position);
 
@@ -60,6 +77,7 @@ bool afatfs_chdir(afatfsFilePtr_t dirHandle);
 
 void afatfs_findFirst(afatfsFilePtr_t directory, afatfsFinder_t *finder);
 afatfsOperationStatus_e afatfs_findNext(afatfsFilePtr_t directory, afatfsFinder_t *finder, fatDirectoryEntry_t **dirEntry);
+const char* afatfs_findLongName(const afatfsFinder_t *finder);
 void afatfs_findLast(afatfsFilePtr_t directory);
 
 bool afatfs_flush();
@@ -73,3 +91,7 @@ bool afatfs_isFull();
 
 afatfsFilesystemState_e afatfs_getFilesystemState();
 afatfsError_e afatfs_getLastError();
+bool afatfs_isFastMount();
+void afatfs_getCacheStatistics(afatfsCacheStatistics_t *statistics);
+void afatfs_resetCacheStatistics();
+void afatfs_getReadAheadStatistics(afatfsReadAheadStatistics_t *statistics);
@@ -0,0 +1,1049 @@
+
+// =============================================================================
+// Include statements
+// =============================================================================
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <xc.h>
+
+#include "bench.h"
+#include "mcu.h"
+#include "spi.h"
+#include "uart.h"
+#include "event_queue.h"
+#include "sdcard.h"
+#include "sdcard_mount.h"
+#include "pinmap.h"
+#include "asyncfatfs.h"
+#include "debug_util.h"
+
+// =============================================================================
+// Private type definitions
+// =============================================================================
+
+typedef struct benchmark_t
+{
+    const char* name;
+    uint32_t default_iterations;
+    bool uses_sd_card;      // Not run by "bench all"
+    void (*run)(uint32_t iterations, uint32_t first_block);
+} benchmark_t;
+
+// =============================================================================
+// Global variables
+// =============================================================================
+
+// =============================================================================
+// Private constants
+// =============================================================================
+
+// The core timer is incremented every other system clock cycle
+#define CORE_TIMER_FREQ_HZ      (SYSCLK_FREQ_HZ / 2)
+
+#define BLOCK_SIZE              (512u)
+
+// Number of consecutive SD card blocks used by the SD card benchmarks
+#define SD_WINDOW_BLOCKS        (8u)
+
+#define SPI3_CHUNK_WORDS        (64u)
+
+// Less than the event queue size, so a batch always fits
+#define EVENT_BATCH_SIZE        (8u)
+
+#define UART_CHUNK_SIZE         (64u)
+
+// Give up waiting for the SD card after this long without progress
+#define TIMEOUT_TICKS           (CORE_TIMER_FREQ_HZ / 2)
+
+static const char BENCH_FILE_NAME[] = "BENCH.BIN";
+
+// =============================================================================
+// Private variables
+// =============================================================================
+
+// Shared data buffer of all benchmarks, cache line aligned for DMA
+static uint8_t __attribute__((aligned(16)))
+    bench_buffer[SD_WINDOW_BLOCKS * BLOCK_SIZE];
+
+static volatile bool sd_operation_done;
+static volatile bool sd_operation_ok;
+
+static volatile bool fs_operation_done;
+static afatfsFilePtr_t bench_file;
+
+// =============================================================================
+// Private function declarations
+// =============================================================================
+
+static void bench_spi3_dword(uint32_t iterations, uint32_t first_block);
+static void bench_spi3_dma(uint32_t iterations, uint32_t first_block);
+static void bench_spi4_byte(uint32_t iterations, uint32_t first_block);
+static void bench_spi4_word(uint32_t iterations, uint32_t first_block);
+static void bench_spi4_dma(uint32_t iterations, uint32_t first_block);
+static void bench_event_queue(uint32_t iterations, uint32_t first_block);
+static void bench_uart_tx(uint32_t iterations, uint32_t first_block);
+static void bench_sd_read(uint32_t iterations, uint32_t first_block);
+static void bench_sd_write(uint32_t iterations, uint32_t first_block);
+static void bench_sd_write_multi(uint32_t iterations, uint32_t first_block);
+static void bench_fs(uint32_t iterations, uint32_t first_block);
+
+/**
+ * @brief Event which does nothing, used by the event queue benchmark.
+ */
+static int32_t nop_event(int32_t arg);
+
+// In the order they are listed and run by "bench all"
+static const benchmark_t benchmarks[] =
+{
+    {"spi3_dword",      4096,   false,  &bench_spi3_dword},
+    {"spi3_dma",        4096,   false,  &bench_spi3_dma},
+    {"spi4_byte",       4096,   false,  &bench_spi4_byte},
+    {"spi4_word",       64,     false,  &bench_spi4_word},
+    {"spi4_dma",        64,     false,  &bench_spi4_dma},
+    {"event_queue",     1024,   false,  &bench_event_queue},
+    {"uart_tx",         1024,   false,  &bench_uart_tx},
+    {"sd_read",         16,     true,   &bench_sd_read},
+    {"sd_write",        4,      true,   &bench_sd_write},
+    {"sd_write_multi",  4,      true,   &bench_sd_write_multi},
+    {"fs",              128,    true,   &bench_fs}
+};
+
+#define NBR_OF_BENCHMARKS (sizeof(benchmarks) / sizeof(benchmarks[0]))
+
+/**
+ * @brief Prints the result of a benchmark.
+ * @param name - the name of the result.
+ * @param ops - number of operations timed.
+ * @param bytes - number of bytes transferred, or 0.
+ * @param cycles - core timer ticks spent on the operations.
+ */
+static void print_result(const char* name,
+                         uint32_t ops,
+                         uint32_t bytes,
+                         uint32_t cycles);
+
+/**
+ * @brief Prints a benchmark failure.
+ */
+static void print_error(const char* name, const char* error);
+
+/**
+ * @brief Makes the SD card ignore the SPI4 benchmark transfers.
+ * @details With a card in use, waits for the SD card driver to become idle
+ *          and ends its open multiple block read or write, which the
+ *          benchmark clocks would otherwise corrupt. The card is then
+ *          deselected.
+ * @param name - the name of the benchmark, for the error message.
+ * @return false if the SD card driver did not become idle in time.
+ */
+static bool spi4_release_sd_card(const char* name);
+
+/**
+ * @brief Called by the SD card driver when a block operation is done.
+ */
+static void sd_operation_complete(sdcardBlockOperation_e operation,
+                                  uint32_t block_index,
+                                  uint8_t* buffer,
+                                  uint32_t callback_data);
+
+/**
+ * @brief Polls the SD card driver until the current block operation is done.
+ * @return false on a failed operation or a timeout.
+ */
+static bool sd_wait(void);
+
+/**
+ * @brief Reads one block from the SD card and waits for the result.
+ * @return false on failure or timeout.
+ */
+static bool sd_read_block(uint32_t block_index, uint8_t* buffer);
+
+/**
+ * @brief Writes one block to the SD card and waits for the result.
+ * @return false on failure or timeout.
+ */
+static bool sd_write_block(uint32_t block_index, uint8_t* buffer);
+
+/**
+ * @brief Gets the first block of the SD card window.
+ * @return the last SD_WINDOW_BLOCKS blocks of the card for
+ *         BENCH_SCRATCH_BLOCK, otherwise first_block.
+ */
+static uint32_t sd_window_start(uint32_t first_block);
+
+/**
+ * @brief Writes back the blocks in bench_buffer over the SD card window.
+ * @details Refuses to write block 0 or a card with a mounted filesystem,
+ *          which caches blocks the benchmark would write behind its back.
+ * @param name - the name of the result.
+ * @param passes - number of times to write the window.
+ * @param first_block - first block of the window.
+ * @param multi_block - announce each pass as a multiple block write.
+ */
+static void sd_write_window(const char* name,
+                            uint32_t passes,
+                            uint32_t first_block,
+                            bool multi_block);
+
+/**
+ * @brief Called by afatfs when the bench file has been opened.
+ */
+static void fs_file_opened(afatfsFilePtr_t file);
+
+/**
+ * @brief Called by afatfs when the bench file has been closed or deleted.
+ */
+static void fs_file_closed(void);
+
+/**
+ * @brief Polls afatfs until fs_operation_done is set.
+ * @return false on timeout.
+ */
+static bool fs_wait(void);
+
+/**
+ * @brief Opens the bench file, setting bench_file to NULL on failure.
+ * @param mode - the afatfs_fopen mode.
+ * @return false if the file could not be opened.
+ */
+static bool fs_open(const char* mode);
+
+/**
+ * @brief Closes and deletes the bench file after a failed benchmark.
+ * @details Opens the file again if it has already been closed, so no file
+ *          handle is leaked and no bench file is left on the card.
+ */
+static void fs_remove(void);
+
+/**
+ * @brief Checks if more than TIMEOUT_TICKS has passed since the given count.
+ */
+static inline bool timed_out(uint32_t start)
+{
+    return (_CP0_GET_COUNT() - start) > TIMEOUT_TICKS;
+}
+
+// =============================================================================
+// Public function definitions
+// =============================================================================
+
+bool bench_run(const char* name, uint32_t iterations, uint32_t first_block)
+{
+    bool run_all = (0 == strcmp(name, "all"));
+    bool found = run_all;
+    uint32_t i;
+
+    for (i = 0; i != NBR_OF_BENCHMARKS; ++i)
+    {
+        if ((run_all && !benchmarks[i].uses_sd_card) ||
+            (0 == strcmp(name, benchmarks[i].name)))
+        {
+            found = true;
+            benchmarks[i].run((BENCH_DEFAULT_ITERATIONS == iterations) ?
+                                  benchmarks[i].default_iterations :
+                                  iterations,
+                              first_block);
+        }
+    }
+
+    return found;
+}
+
+void bench_list(void)
+{
+    uint32_t i;
+
+    uart_write_string("\tBenchmark (default iterations):");
+    uart_write_string(NEWLINE);
+
+    for (i = 0; i != NBR_OF_BENCHMARKS; ++i)
+    {
+        sprintf(g_debug_util_char_buffer,
+                "\t%s (%u)%s",
+                benchmarks[i].name,
+                (unsigned int)benchmarks[i].default_iterations,
+                NEWLINE);
+        uart_write_string(g_debug_util_char_buffer);
+        uart_flush();
+    }
+}
+
+// =============================================================================
+// Private function definitions
+// =============================================================================
+
+/*
+ * Throughput of spi_write_dword_vect, including the time it takes for the
+ * ISR to shift out the last queued words.
+ */
+static void bench_spi3_dword(uint32_t iterations, uint32_t first_block)
+{
+    uint32_t* words = (uint32_t*)bench_buffer;
+    uint32_t words_left = iterations;
+    uint32_t chunk;
+    uint32_t start;
+    uint32_t cycles;
+
+    spi_init(SPI_DEVICE_DSP);
+    spi_flush(SPI_DEVICE_DSP);
+
+    memset(bench_buffer, 0xA5, SPI3_CHUNK_WORDS * sizeof(uint32_t));
+
+    start = _CP0_GET_COUNT();
+
+    while (0 != words_left)
+    {
+        chunk = (words_left < SPI3_CHUNK_WORDS) ? words_left : SPI3_CHUNK_WORDS;
+        spi_write_dword_vect(SPI_DEVICE_DSP, words, chunk);
+        words_left -= chunk;
+    }
+
+    spi_flush(SPI_DEVICE_DSP);
+
+    cycles = _CP0_GET_COUNT() - start;
+
+    print_result("spi3_dword", iterations, iterations * sizeof(uint32_t), cycles);
+}
+
+/*
+ * Throughput of spi_write_dword_vect_async, which streams the caller buffer
+ * without copying it.
+ */
+static void bench_spi3_dma(uint32_t iterations, uint32_t first_block)
+{
+    const uint32_t* words = (const uint32_t*)bench_buffer;
+    const uint32_t max_chunk = sizeof(bench_buffer) / sizeof(uint32_t);
+    uint32_t words_left = iterations;
+    uint32_t chunk;
+    uint32_t start;
+    uint32_t cycles;
+
+    spi_init(SPI_DEVICE_DSP);
+    spi_flush(SPI_DEVICE_DSP);
+
+    memset(bench_buffer, 0xA5, sizeof(bench_buffer));
+
+    start = _CP0_GET_COUNT();
+
+    while (0 != words_left)
+    {
+        chunk = (words_left < max_chunk) ? words_left : max_chunk;
+
+        if (spi_write_dword_vect_async(SPI_DEVICE_DSP, words, chunk, NULL, 0))
+        {
+            words_left -= chunk;
+        }
+    }
+
+    spi_flush(SPI_DEVICE_DSP);
+
+    cycles = _CP0_GET_COUNT() - start;
+
+    print_result("spi3_dma", iterations, iterations * sizeof(uint32_t), cycles);
+}
+
+/*
+ * Rate of blocking single byte transfers on the SD card bus, with the card
+ * deselected. Any open SD card stream is ended first.
+ */
+static void bench_spi4_byte(uint32_t iterations, uint32_t first_block)
+{
+    uint32_t i;
+    uint32_t start;
+    uint32_t cycles;
+
+    if (!spi4_release_sd_card("spi4_byte"))
+    {
+        return;
+    }
+
+    spi_init(SPI_DEVICE_SDCARD);
+
+    start = _CP0_GET_COUNT();
+
+    for (i = 0; i != iterations; ++i)
+    {
+        (void)spi_byte_tranceive_blocking(SPI_DEVICE_SDCARD, 0xFF);
+    }
+
+    cycles = _CP0_GET_COUNT() - start;
+
+    print_result("spi4_byte", iterations, iterations, cycles);
+}
+
+/*
+ * Rate of 512 byte block reads in 32 bit mode without DMA on the SD card bus,
+ * with the card deselected. One operation is one block, compare the byte rate
+ * with spi4_byte.
+ */
+static void bench_spi4_word(uint32_t iterations, uint32_t first_block)
+{
+    uint32_t i;
+    uint32_t start;
+    uint32_t cycles;
+
+    if (!spi4_release_sd_card("spi4_word"))
+    {
+        return;
+    }
+
+    spi_init(SPI_DEVICE_SDCARD);
+
+    start = _CP0_GET_COUNT();
+
+    for (i = 0; i != iterations; ++i)
+    {
+        spi_block_tranceive_blocking(SPI_DEVICE_SDCARD,
+                                     NULL,
+                                     bench_buffer,
+                                     BLOCK_SIZE);
+    }
+
+    cycles = _CP0_GET_COUNT() - start;
+
+    print_result("spi4_word", iterations, iterations * BLOCK_SIZE, cycles);
+}
+
+/*
+ * Rate of 512 byte DMA block reads on the SD card bus, with the card
+ * deselected. One operation is one block.
+ */
+static void bench_spi4_dma(uint32_t iterations, uint32_t first_block)
+{
+    uint32_t i;
+    uint32_t start;
+    uint32_t cycles;
+
+    if (!spi4_release_sd_card("spi4_dma"))
+    {
+        return;
+    }
+
+    spi_init(SPI_DEVICE_SDCARD);
+
+    start = _CP0_GET_COUNT();
+
+    for (i = 0; i != iterations; ++i)
+    {
+        while (!spi_block_transfer_async(SPI_DEVICE_SDCARD,
+                                         NULL,
+                                         bench_buffer,
+                                         BLOCK_SIZE,
+                                         NULL,
+                                         0))
+        {
+            ;   // Wait for the previous block
+        }
+    }
+
+    spi_flush(SPI_DEVICE_SDCARD);
+
+    cycles = _CP0_GET_COUNT() - start;
+
+    print_result("spi4_dma", iterations, iterations * BLOCK_SIZE, cycles);
+}
+
+static int32_t nop_event(int32_t arg)
+{
+    return arg;
+}
+
+/*
+ * Push and run latency of the event queue, measured separately in batches
+ * small enough to never fill the queue.
+ */
+static void bench_event_queue(uint32_t iterations, uint32_t first_block)
+{
+    uint32_t done = 0;
+    uint32_t batch;
+    uint32_t i;
+    uint32_t start;
+    uint32_t push_cycles = 0;
+    uint32_t run_cycles = 0;
+
+    while (done != iterations)
+    {
+        batch = iterations - done;
+
+        if (batch > EVENT_BATCH_SIZE)
+        {
+            batch = EVENT_BATCH_SIZE;
+        }
+
+        start = _CP0_GET_COUNT();
+
+        for (i = 0; i != batch; ++i)
+        {
+            event_queue_push_callback(&nop_event,
+                                      EVENT_QUEUE_NO_ARG,
+                                      EVENT_PRIO_HIGH);
+        }
+
+        push_cycles += _CP0_GET_COUNT() - start;
+
+        start = _CP0_GET_COUNT();
+
+        for (i = 0; i != batch; ++i)
+        {
+            (void)event_queue_run_next();
+        }
+
+        run_cycles += _CP0_GET_COUNT() - start;
+
+        done += batch;
+    }
+
+    print_result("event_queue_push", iterations, 0, push_cycles);
+    print_result("event_queue_run", iterations, 0, run_cycles);
+}
+
+/*
+ * UART transmit throughput. Prints iterations bytes of filler lines, so the
+ * result line comes after them.
+ */
+static void bench_uart_tx(uint32_t iterations, uint32_t first_block)
+{
+    uint32_t bytes_left = iterations;
+    uint32_t chunk;
+    uint32_t start;
+    uint32_t cycles;
+
+    memset(bench_buffer, 'U', UART_CHUNK_SIZE - 2);
+    bench_buffer[UART_CHUNK_SIZE - 2] = '\r';
+    bench_buffer[UART_CHUNK_SIZE - 1] = '\n';
+
+    uart_flush();
+
+    start = _CP0_GET_COUNT();
+
+    while (0 != bytes_left)
+    {
+        chunk = (bytes_left < UART_CHUNK_SIZE) ? bytes_left : UART_CHUNK_SIZE;
+        bytes_left -= uart_write_array(chunk,
+                                       &bench_buffer[UART_CHUNK_SIZE - chunk]);
+    }
+
+    uart_flush();
+
+    cycles = _CP0_GET_COUNT() - start;
+
+    print_result("uart_tx", iterations, iterations, cycles);
+}
+
+/*
+ * Single block reads, iterations passes over the SD card window.
+ */
+static void bench_sd_read(uint32_t iterations, uint32_t first_block)
+{
+    uint32_t pass;
+    uint32_t i;
+    uint32_t start;
+    uint32_t cycles;
+    bool ok = true;
+
+    first_block = sd_window_start(first_block);
+    start = _CP0_GET_COUNT();
+
+    for (pass = 0; (pass != iterations) && ok; ++pass)
+    {
+        for (i = 0; (i != SD_WINDOW_BLOCKS) && ok; ++i)
+        {
+            ok = sd_read_block(first_block + i, &bench_buffer[i * BLOCK_SIZE]);
+        }
+    }
+
+    cycles = _CP0_GET_COUNT() - start;
+
+    if (ok)
+    {
+        print_result("sd_read",
+                     iterations * SD_WINDOW_BLOCKS,
+                     iterations * SD_WINDOW_BLOCKS * BLOCK_SIZE,
+                     cycles);
+    }
+    else
+    {
+        print_error("sd_read", "read_failed");
+    }
+}
+
+/*
+ * Single block writes. The window is read first and written back unchanged,
+ * so the benchmark does not destroy the contents of the card.
+ */
+static void bench_sd_write(uint32_t iterations, uint32_t first_block)
+{
+    sd_write_window("sd_write", iterations, first_block, false);
+}
+
+/*
+ * As bench_sd_write, but every pass is announced as a multiple block write.
+ */
+static void bench_sd_write_multi(uint32_t iterations, uint32_t first_block)
+{
+    sd_write_window("sd_write_multi", iterations, first_block, true);
+}
+
+/*
+ * Sequential afatfs write and read of a file of iterations blocks, and a
+ * second read which borrows the bytes from the cache instead of copying
+ * them. The file is deleted afterwards.
+ */
+static void bench_fs(uint32_t iterations, uint32_t first_block)
+{
+    uint32_t file_size = iterations * BLOCK_SIZE;
+    uint32_t transferred = 0;
+    uint32_t chunk;
+    uint32_t start;
+    uint32_t last_progress;
+    uint32_t cycles;
+    bool ok;
+
+    if (AFATFS_FILESYSTEM_STATE_READY != afatfs_getFilesystemState())
+    {
+        print_error("fs", "filesystem_not_ready");
+        return;
+    }
+
+    memset(bench_buffer, 0x5A, BLOCK_SIZE);
+
+    //
+    // Write, including the flush when the file is closed
+    //
+    ok = fs_open("w");
+
+    start = _CP0_GET_COUNT();
+    last_progress = start;
+
+    while (ok && (transferred != file_size))
+    {
+        chunk = file_size - transferred;
+
+        if (chunk > BLOCK_SIZE)
+        {
+            chunk = BLOCK_SIZE;
+        }
+
+        chunk = afatfs_fwrite(bench_file, bench_buffer, chunk);
+
+        if (0 != chunk)
+        {
+            transferred += chunk;
+            last_progress = _CP0_GET_COUNT();
+        }
+        else
+        {
+            ok = !timed_out(last_progress) && !afatfs_isFull();
+        }
+
+        afatfs_poll();
+    }
+
+    if (ok)
+    {
+        fs_operation_done = false;
+        ok = afatfs_fclose(bench_file, &fs_file_closed);
+
+        if (ok)
+        {
+            bench_file = NULL;
+            ok = fs_wait();
+        }
+    }
+
+    cycles = _CP0_GET_COUNT() - start;
+
+    if (!ok)
+    {
+        print_error("fs_write", "write_failed");
+        fs_remove();
+        return;
+    }
+
+    print_result("fs_write", iterations, file_size, cycles);
+
+    //
+    // Read
+    //
+    transferred = 0;
+
+    ok = fs_open("r");
+
+    start = _CP0_GET_COUNT();
+    last_progress = start;
+
+    while (ok && !afatfs_feof(bench_file))
+    {
+        chunk = afatfs_fread(bench_file, bench_buffer, BLOCK_SIZE);
+
+        if (0 != chunk)
+        {
+            transferred += chunk;
+            last_progress = _CP0_GET_COUNT();
+        }
+        else
+        {
+            ok = !timed_out(last_progress);
+        }
+
+        afatfs_poll();
+    }
+
+    cycles = _CP0_GET_COUNT() - start;
+
+    if (!ok)
+    {
+        print_error("fs_read", "read_failed");
+        fs_remove();
+        return;
+    }
+
+    print_result("fs_read", iterations, transferred, cycles);
+
+    //
+    // Read again, borrowing the bytes from the filesystem cache
+    //
+    transferred = 0;
+
+    ok = (AFATFS_OPERATION_SUCCESS ==
+          afatfs_fseek(bench_file, 0, AFATFS_SEEK_SET));
+
+    start = _CP0_GET_COUNT();
+    last_progress = start;
+
+    while (ok && !afatfs_feof(bench_file))
+    {
+        const uint8_t* borrowed;
+
+        chunk = afatfs_fborrow(bench_file, &borrowed);
+
+        if (0 != chunk)
+        {
+            afatfs_freturn(bench_file, chunk);
+
+            transferred += chunk;
+            last_progress = _CP0_GET_COUNT();
+        }
+        else
+        {
+            ok = !timed_out(last_progress);
+        }
+
+        afatfs_poll();
+    }
+
+    cycles = _CP0_GET_COUNT() - start;
+
+    if (ok)
+    {
+        print_result("fs_borrow", iterations, transferred, cycles);
+    }
+    else
+    {
+        print_error("fs_borrow", "read_failed");
+    }
+
+    fs_remove();
+}
+
+static void print_result(const char* name,
+                         uint32_t ops,
+                         uint32_t bytes,
+                         uint32_t cycles)
+{
+    uint32_t ops_per_s = 0;
+    uint32_t bytes_per_s = 0;
+
+    if (0 != cycles)
+    {
+        ops_per_s = (uint32_t)(((uint64_t)ops * CORE_TIMER_FREQ_HZ) / cycles);
+        bytes_per_s = (uint32_t)(((uint64_t)bytes * CORE_TIMER_FREQ_HZ) / cycles);
+    }
+
+    sprintf(g_debug_util_char_buffer,
+            "BENCH name=%s ops=%u bytes=%u cycles=%u us=%u "
+            "ops_per_s=%u bytes_per_s=%u%s",
+            name,
+            (unsigned int)ops,
+            (unsigned int)bytes,
+            (unsigned int)cycles,
+            (unsigned int)(cycles / (CORE_TIMER_FREQ_HZ / 1000000)),
+            (unsigned int)ops_per_s,
+            (unsigned int)bytes_per_s,
+            NEWLINE);
+    uart_write_string(g_debug_util_char_buffer);
+    uart_flush();
+}
+
+static void print_error(const char* name, const char* error)
+{
+    sprintf(g_debug_util_char_buffer,
+            "BENCH name=%s error=%s%s",
+            name,
+            error,
+            NEWLINE);
+    uart_write_string(g_debug_util_char_buffer);
+    uart_flush();
+}
+
+static bool spi4_release_sd_card(const char* name)
+{
+    sdcard_mount_state_t mount_state = sdcard_mount_get_state();
+    uint32_t start = _CP0_GET_COUNT();
+    bool idle = true;
+
+    if ((SDCARD_MOUNT_NO_CARD != mount_state) &&
+        (SDCARD_MOUNT_FAILED != mount_state))
+    {
+        // Stopping a stream keeps the driver busy until the card is done, so
+        // poll until it is idle with no stream open.
+        do
+        {
+            idle = sdcard_poll() &&
+                   (SDCARD_OPERATION_SUCCESS == sdcard_endReadBlocks()) &&
+                   (SDCARD_OPERATION_SUCCESS == sdcard_endWriteBlocks()) &&
+                   sdcard_poll();
+        } while (!idle && !timed_out(start));
+    }
+
+    if (idle)
+    {
+        SD_CARD_SS_OFF;
+    }
+    else
+    {
+        print_error(name, "sd_card_busy");
+    }
+
+    return idle;
+}
+
+static void sd_operation_complete(sdcardBlockOperation_e operation,
+                                  uint32_t block_index,
+                                  uint8_t* buffer,
+                                  uint32_t callback_data)
+{
+    sd_operation_ok = (NULL != buffer);
+    sd_operation_done = true;
+}
+
+static bool sd_wait(void)
+{
+    uint32_t start = _CP0_GET_COUNT();
+
+    while (!sd_operation_done && !timed_out(start))
+    {
+        (void)sdcard_poll();
+    }
+
+    return sd_operation_done && sd_operation_ok;
+}
+
+static bool sd_read_block(uint32_t block_index, uint8_t* buffer)
+{
+    uint32_t start = _CP0_GET_COUNT();
+    bool started = false;
+
+    sd_operation_done = false;
+
+    while (!started && !timed_out(start))
+    {
+        started = sdcard_readBlock(block_index,
+                                   buffer,
+                                   &sd_operation_complete,
+                                   0);
+
+        if (!started)
+        {
+            (void)sdcard_poll();
+        }
+    }
+
+    return started && sd_wait();
+}
+
+static bool sd_write_block(uint32_t block_index, uint8_t* buffer)
+{
+    uint32_t start = _CP0_GET_COUNT();
+    sdcardOperationStatus_e status = SDCARD_OPERATION_BUSY;
+
+    sd_operation_done = false;
+
+    while ((SDCARD_OPERATION_BUSY == status) && !timed_out(start))
+    {
+        status = sdcard_writeBlock(block_index,
+                                   buffer,
+                                   &sd_operation_complete,
+                                   0);
+
+        if (SDCARD_OPERATION_BUSY == status)
+        {
+            (void)sdcard_poll();
+        }
+    }
+
+    return (SDCARD_OPERATION_SUCCESS == status) ||
+           ((SDCARD_OPERATION_IN_PROGRESS == status) && sd_wait());
+}
+
+static uint32_t sd_window_start(uint32_t first_block)
+{
+    const sdcardMetadata_t* metadata = sdcard_getMetadata();
+
+    if (BENCH_SCRATCH_BLOCK == first_block)
+    {
+        // Stays 0 and is refused if the card is unknown or too small
+        if (metadata->numBlocks > SD_WINDOW_BLOCKS)
+        {
+            first_block = metadata->numBlocks - SD_WINDOW_BLOCKS;
+        }
+    }
+
+    return first_block;
+}
+
+static void sd_write_window(const char* name,
+                            uint32_t passes,
+                            uint32_t first_block,
+                            bool multi_block)
+{
+    sdcard_mount_state_t mount_state = sdcard_mount_get_state();
+    uint32_t pass;
+    uint32_t i;
+    uint32_t start;
+    uint32_t busy_start;
+    uint32_t cycles;
+    sdcardOperationStatus_e status;
+    bool ok = true;
+
+    first_block = sd_window_start(first_block);
+
+    if ((SDCARD_MOUNT_MOUNTING == mount_state) ||
+        (SDCARD_MOUNT_MOUNTED == mount_state))
+    {
+        print_error(name, "filesystem_mounted");
+        return;
+    }
+
+    if (0 == first_block)
+    {
+        print_error(name, "block_0");
+        return;
+    }
+
+    for (i = 0; (i != SD_WINDOW_BLOCKS) && ok; ++i)
+    {
+        ok = sd_read_block(first_block + i, &bench_buffer[i * BLOCK_SIZE]);
+    }
+
+    if (!ok)
+    {
+        print_error(name, "read_failed");
+        return;
+    }
+
+    start = _CP0_GET_COUNT();
+
+    for (pass = 0; (pass != passes) && ok; ++pass)
+    {
+        if (multi_block)
+        {
+            busy_start = _CP0_GET_COUNT();
+
+            do
+            {
+                status = sdcard_beginWriteBlocks(first_block, SD_WINDOW_BLOCKS);
+
+                if (SDCARD_OPERATION_BUSY == status)
+                {
+                    (void)sdcard_poll();
+                }
+            } while ((SDCARD_OPERATION_BUSY == status) &&
+                     !timed_out(busy_start));
+
+            ok = (SDCARD_OPERATION_SUCCESS == status);
+        }
+
+        for (i = 0; (i != SD_WINDOW_BLOCKS) && ok; ++i)
+        {
+            ok = sd_write_block(first_block + i, &bench_buffer[i * BLOCK_SIZE]);
+        }
+    }
+
+    // Wait for the card to finish programming the last block
+    busy_start = _CP0_GET_COUNT();
+
+    while (ok && !sdcard_poll())
+    {
+        ok = !timed_out(busy_start);
+    }
+
+    cycles = _CP0_GET_COUNT() - start;
+
+    if (ok)
+    {
+        print_result(name,
+                     passes * SD_WINDOW_BLOCKS,
+                     passes * SD_WINDOW_BLOCKS * BLOCK_SIZE,
+                     cycles);
+    }
+    else
+    {
+        print_error(name, "write_failed");
+    }
+}
+
+static void fs_file_opened(afatfsFilePtr_t file)
+{
+    bench_file = file;
+    fs_operation_done = true;
+}
+
+static void fs_file_closed(void)
+{
+    fs_operation_done = true;
+}
+
+static bool fs_wait(void)
+{
+    uint32_t start = _CP0_GET_COUNT();
+
+    while (!fs_operation_done && !timed_out(start))
+    {
+        afatfs_poll();
+    }
+
+    return fs_operation_done;
+}
+
+static bool fs_open(const char* mode)
+{
+    bench_file = NULL;
+    fs_operation_done = false;
+
+    if (!afatfs_fopen(BENCH_FILE_NAME, mode, &fs_file_opened) || !fs_wait())
+    {
+        bench_file = NULL;
+    }
+
+    return (NULL != bench_file);
+}
+
+static void fs_remove(void)
+{
+    if ((NULL != bench_file) || fs_open("r"))
+    {
+        fs_operation_done = false;
+
+        if (afatfs_funlink(bench_file, &fs_file_closed) && !fs_wait())
+        {
+            print_error("fs", "delete_timeout");
+        }
+
+        bench_file = NULL;
+    }
+}
@@ -0,0 +1,70 @@
+/*
+ * On-device benchmarks, run from the terminal with the "bench" command.
+ *
+ * Time is measured with the CP0 core timer, which counts at half the system
+ * clock. Every result is printed on one line of space separated key=value
+ * pairs starting with "BENCH", for example:
+ *
+ * BENCH name=spi3_dword ops=4096 bytes=16384 cycles=1316014 us=13160
+ *       ops_per_s=311242 bytes_per_s=1244970
+ *
+ * (on one line). A failed benchmark prints "BENCH name=<name> error=<text>".
+ */
+
+#ifndef BENCH_H
+#define	BENCH_H
+
+#ifdef	__cplusplus
+//extern "C" {
+#endif
+
+// =============================================================================
+// Include statements
+// =============================================================================
+#include <stdint.h>
+#include <stdbool.h>
+
+// =============================================================================
+// Public type definitions
+// =============================================================================
+
+// =============================================================================
+// Global constatants
+// =============================================================================
+
+// Use the default number of iterations of the benchmark
+#define BENCH_DEFAULT_ITERATIONS    (0u)
+
+// Use the last blocks of the SD card, block 0 holds the MBR and is never used
+#define BENCH_SCRATCH_BLOCK         (0u)
+
+// =============================================================================
+// Global variable declarations
+// =============================================================================
+
+// =============================================================================
+// Public function declarations
+// =============================================================================
+
+/**
+ * @brief Runs one benchmark, or all benchmarks which do not touch the SD card.
+ * @details Blocks until the benchmark is done.
+ * @param name - the name of the benchmark, or "all".
+ * @param iterations - number of iterations, or BENCH_DEFAULT_ITERATIONS.
+ * @param first_block - first SD card block used by the SD card benchmarks,
+ *                      or BENCH_SCRATCH_BLOCK.
+ * @return false if there is no benchmark with that name.
+ */
+bool bench_run(const char* name, uint32_t iterations, uint32_t first_block);
+
+/**
+ * @brief Prints the names and the default iterations of all benchmarks.
+ */
+void bench_list(void);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* BENCH_H */
+
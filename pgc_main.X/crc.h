@@ -0,0 +1,79 @@
+/*
+ * Cyclic redundancy checks.
+ *
+ * CRC-16/CCITT: polynomial x^16 + x^12 + x^5 + 1 (0x1021), not reflected.
+ * With an initial value of 0x0000 this is the CRC used for SD card data
+ * blocks, with 0xFFFF it is the CRC of the DSP link frames. Four bytes are
+ * added per step with four lookup tables.
+ *
+ * CRC-7: polynomial x^7 + x^3 + 1 (0x09), initial value 0, not reflected.
+ * The CRC of SD card command frames.
+ */
+
+#ifndef CRC_H
+#define	CRC_H
+
+#ifdef	__cplusplus
+//extern "C" {
+#endif
+
+// =============================================================================
+// Include statements
+// =============================================================================
+#include <stdint.h>
+
+// =============================================================================
+// Public type definitions
+// =============================================================================
+
+// =============================================================================
+// Global constatants
+// =============================================================================
+
+// =============================================================================
+// Global variable declarations
+// =============================================================================
+
+// =============================================================================
+// Public function declarations
+// =============================================================================
+
+/**
+ * @brief Adds bytes to a CRC-16/CCITT.
+ * @param crc - the CRC of the preceding data, or the initial value.
+ * @param data - the bytes to add.
+ * @param number_of_bytes - number of bytes in data.
+ * @return The CRC including data.
+ */
+uint16_t crc16_ccitt_update(uint16_t crc,
+                            const uint8_t* data,
+                            uint32_t number_of_bytes);
+
+/**
+ * @brief Adds 32 bit words to a CRC-16/CCITT, most significant byte first.
+ * @details The byte order is the order the words are shifted out on a 32 bit
+ *          spi bus.
+ * @param crc - the CRC of the preceding data, or the initial value.
+ * @param data - the words to add.
+ * @param number_of_words - number of words in data.
+ * @return The CRC including data.
+ */
+uint16_t crc16_ccitt_update_words(uint16_t crc,
+                                  const uint32_t* data,
+                                  uint32_t number_of_words);
+
+/**
+ * @brief Adds bytes to a CRC-7.
+ * @param crc - the CRC of the preceding data, or 0.
+ * @param data - the bytes to add.
+ * @param number_of_bytes - number of bytes in data.
+ * @return The 7 bit CRC including data, in the lower bits.
+ */
+uint8_t crc7_update(uint8_t crc, const uint8_t* data, uint32_t number_of_bytes);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* CRC_H */
+
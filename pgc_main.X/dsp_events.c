@@ -0,0 +1,605 @@
+
+// =============================================================================
+// Include statements
+// =============================================================================
+#include <xc.h>
+#include <sys/attribs.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "dsp_events.h"
+#include "dsp_link.h"
+#include "ring_buffer.h"
+#include "event_queue.h"
+#include "tunables.h"
+#include "mcu.h"
+#include "uart.h"
+#include "debug_util.h"
+
+// =============================================================================
+// Private type definitions
+// =============================================================================
+
+typedef struct scheduled_event_t
+{
+    uint32_t sample_time;
+    uint32_t event;         // Packed as sent, without the sample offset
+} scheduled_event_t;
+
+typedef struct dsp_events_statistics_t
+{
+    uint32_t batches_sent;
+    uint32_t events_sent;
+    uint32_t late_events;       // Sent at the start of a later block
+    uint32_t dropped_events;    // Not scheduled because the queue was full
+    uint32_t busy_retries;      // Batches held back because the DSP was full
+    uint32_t clock_syncs;       // Sample time corrections from the DSP
+    int32_t last_drift;         // Blocks corrected by the last sync
+} dsp_events_statistics_t;
+
+// =============================================================================
+// Global variables
+// =============================================================================
+
+// =============================================================================
+// Private constants
+// =============================================================================
+#define CORE_TIMER_FREQ_HZ      (SYSCLK_FREQ_HZ / 2)
+
+// Must be a power of two
+#define EVENT_QUEUE_SIZE        (256u)
+
+// The first payload word holds the block number
+#define MAX_EVENTS_PER_BATCH    (DSP_LINK_MAX_PAYLOAD_WORDS - 1)
+
+#define DEFAULT_SAMPLE_RATE     (48000u)
+#define DEFAULT_BLOCK_SIZE      (64u)
+#define DEFAULT_LOOKAHEAD       (2u)
+
+// The core timer wraps after 2^32 / CORE_TIMER_FREQ_HZ = 42.9 s, the sample
+// clock is advanced by the core timer interrupt well before that
+#define TICK_INTERVAL_TICKS     (CORE_TIMER_FREQ_HZ / 10)
+#define SYNC_INTERVAL_TICKS     (CORE_TIMER_FREQ_HZ)
+
+// Longest time send_event is put to sleep for, the wake up must stay within
+// half the core timer period to be compared
+#define MAX_WAKE_TICKS          (CORE_TIMER_FREQ_HZ)
+
+// A compare value closer than this may already have passed when it is set
+#define MIN_COMPARE_TICKS       (100u)
+
+// =============================================================================
+// Private variables
+// =============================================================================
+static scheduled_event_t scheduled_events[EVENT_QUEUE_SIZE];
+static ring_buffer_t scheduled_ring;
+static uint32_t last_scheduled_time = 0;
+
+// First block which has not been sent yet
+static uint32_t next_block = 0;
+
+// send_event is queued or waiting for wake_count
+static bool send_event_pending = false;
+static volatile bool wake_armed = false;
+static volatile uint32_t wake_count = 0;
+
+static volatile bool sync_pending = false;
+static uint32_t last_sync_count = 0;
+
+static uint32_t batch[DSP_LINK_MAX_PAYLOAD_WORDS];
+
+// Sample clock, only accessed with interrupts disabled
+static uint32_t clock_last_count = 0;
+static uint64_t clock_cycles = 0;
+static uint32_t clock_offset = 0;   // Samples added by the DSP syncs
+
+static dsp_events_statistics_t statistics;
+
+// Tunables
+static uint32_t sample_rate = DEFAULT_SAMPLE_RATE;
+static uint32_t block_size = DEFAULT_BLOCK_SIZE;
+static uint32_t lookahead_blocks = DEFAULT_LOOKAHEAD;
+
+static const tunable_t sample_rate_tunable =
+{
+    "dsp.sample_rate",
+    TUNABLE_TYPE_UINT32,
+    &sample_rate,
+    8000,
+    192000,
+    NULL,
+    &dsp_events_reset
+};
+
+static const tunable_t block_size_tunable =
+{
+    "dsp.block_size",
+    TUNABLE_TYPE_UINT32,
+    &block_size,
+    1,
+    DSP_EVENTS_MAX_BLOCK_SIZE,
+    NULL,
+    &dsp_events_reset
+};
+
+static const tunable_t lookahead_tunable =
+{
+    "dsp.lookahead_blocks",
+    TUNABLE_TYPE_UINT32,
+    &lookahead_blocks,
+    1,
+    32,
+    NULL,
+    NULL
+};
+
+// =============================================================================
+// Private function declarations
+// =============================================================================
+
+/**
+ * @brief Sends the scheduled events of all blocks which are due.
+ * @details Schedules itself again for when the next block is due as long as
+ *          there are scheduled events.
+ * @param arg - not used.
+ * @return always 0.
+ */
+static int32_t send_event(int32_t arg);
+
+/**
+ * @brief Adjusts the sample time to the block the DSP is rendering.
+ * @param arg - not used.
+ * @return always 0.
+ */
+static int32_t sync_clock(int32_t arg);
+
+/**
+ * @brief Lets the core timer interrupt run send_event at a sample time.
+ */
+static void schedule_send_event(uint32_t sample_time);
+
+/**
+ * @brief Lets the next core timer tick queue a send_event which was dropped
+ *        by the full event queue.
+ * @details Interrupts must be disabled.
+ * @param count - the core timer count when the event was dropped.
+ */
+static void retry_send_event(uint32_t count);
+
+/**
+ * @brief Adds the core timer cycles since the last call to the sample clock.
+ * @details Interrupts must be disabled.
+ */
+static void advance_clock(void);
+
+/**
+ * @brief Gets the sample time of the sample clock.
+ * @details Interrupts must be disabled.
+ */
+static uint32_t clock_sample_time(void);
+
+/**
+ * @brief Sets the core timer compare to the next tick or wake up.
+ * @details Interrupts must be disabled.
+ * @param count - the core timer count to start the tick interval from.
+ */
+static void set_compare(uint32_t count);
+
+/**
+ * @brief Packs the scheduled events of one block into the batch buffer.
+ * @param block - the block number.
+ * @param nbr_of_late - set to the number of events which are late.
+ * @return Number of events packed.
+ */
+static uint32_t build_batch(uint32_t block, uint32_t* nbr_of_late);
+
+// =============================================================================
+// Public function definitions
+// =============================================================================
+
+void dsp_events_init(void)
+{
+    uint32_t int_status;
+
+    ring_buffer_init(&scheduled_ring, EVENT_QUEUE_SIZE);
+
+    dsp_events_reset();
+
+    tunables_register(&sample_rate_tunable);
+    tunables_register(&block_size_tunable);
+    tunables_register(&lookahead_tunable);
+
+    // The core timer interrupt ticks the sample clock and wakes send_event
+    IPC0bits.CTIP = 2;      // Interrupt priority
+    IPC0bits.CTIS = 0;
+
+    int_status = __builtin_disable_interrupts();
+    set_compare(_CP0_GET_COUNT());
+    IFS0CLR = _IFS0_CTIF_MASK;
+    IEC0bits.CTIE = 1;
+    __builtin_mtc0(_CP0_STATUS, _CP0_STATUS_SELECT, int_status);
+}
+
+void dsp_events_reset(void)
+{
+    uint32_t int_status;
+
+    ring_buffer_clear(&scheduled_ring);
+    last_scheduled_time = 0;
+    next_block = 0;
+
+    int_status = __builtin_disable_interrupts();
+
+    // A queued send_event finds the queue empty
+    if (wake_armed)
+    {
+        wake_armed = false;
+        send_event_pending = false;
+    }
+
+    clock_last_count = _CP0_GET_COUNT();
+    clock_cycles = 0;
+    clock_offset = 0;
+
+    __builtin_mtc0(_CP0_STATUS, _CP0_STATUS_SELECT, int_status);
+
+    memset(&statistics, 0, sizeof(statistics));
+}
+
+uint32_t dsp_events_now(void)
+{
+    uint32_t int_status = __builtin_disable_interrupts();
+    uint32_t now;
+
+    advance_clock();
+    now = clock_sample_time();
+
+    __builtin_mtc0(_CP0_STATUS, _CP0_STATUS_SELECT, int_status);
+
+    return now;
+}
+
+bool dsp_events_schedule(uint32_t sample_time,
+                         uint8_t status,
+                         uint8_t data1,
+                         uint8_t data2)
+{
+    bool scheduled = !ring_buffer_is_full(&scheduled_ring);
+    uint32_t int_status;
+    uint32_t index;
+
+    if (scheduled)
+    {
+        // Keep the queue in time order
+        if (!ring_buffer_is_empty(&scheduled_ring) &&
+            ((int32_t)(sample_time - last_scheduled_time) < 0))
+        {
+            sample_time = last_scheduled_time;
+        }
+
+        index = ring_buffer_tail_index(&scheduled_ring);
+        scheduled_events[index].sample_time = sample_time;
+        scheduled_events[index].event = ((uint32_t)status << 16) |
+                                        ((uint32_t)data1 << 8) |
+                                        data2;
+        ring_buffer_produce(&scheduled_ring, 1);
+
+        last_scheduled_time = sample_time;
+
+        if (!send_event_pending)
+        {
+            send_event_pending = true;
+
+            if (!event_queue_push_callback(&send_event,
+                                           EVENT_QUEUE_NO_ARG,
+                                           EVENT_PRIO_LOW))
+            {
+                int_status = __builtin_disable_interrupts();
+                retry_send_event(_CP0_GET_COUNT());
+                __builtin_mtc0(_CP0_STATUS, _CP0_STATUS_SELECT, int_status);
+            }
+        }
+    }
+    else
+    {
+        ++statistics.dropped_events;
+    }
+
+    return scheduled;
+}
+
+void dsp_events_print_status(void)
+{
+    uint32_t now = dsp_events_now();
+
+    sprintf(g_debug_util_char_buffer,
+            "\tSample time %u, block %u of %u samples, next block to send %u%s",
+            (unsigned int)now,
+            (unsigned int)(now / block_size),
+            (unsigned int)block_size,
+            (unsigned int)next_block,
+            NEWLINE);
+    uart_write_string(g_debug_util_char_buffer);
+
+    sprintf(g_debug_util_char_buffer,
+            "\tScheduled %u, sent %u in %u batches, late %u, dropped %u, "
+            "busy retries %u%s",
+            (unsigned int)ring_buffer_size(&scheduled_ring),
+            (unsigned int)statistics.events_sent,
+            (unsigned int)statistics.batches_sent,
+            (unsigned int)statistics.late_events,
+            (unsigned int)statistics.dropped_events,
+            (unsigned int)statistics.busy_retries,
+            NEWLINE);
+    uart_write_string(g_debug_util_char_buffer);
+
+    sprintf(g_debug_util_char_buffer,
+            "\tSynced to the DSP block counter %u times, last by %d blocks%s",
+            (unsigned int)statistics.clock_syncs,
+            (int)statistics.last_drift,
+            NEWLINE);
+    uart_write_string(g_debug_util_char_buffer);
+}
+
+// =============================================================================
+// Private function definitions
+// =============================================================================
+
+void __ISR(_CORE_TIMER_VECTOR, ipl2) dsp_events_tick_isr(void)
+{
+    const uint32_t count = _CP0_GET_COUNT();
+
+    advance_clock();
+
+    if (wake_armed && ((int32_t)(count - wake_count) >= 0))
+    {
+        wake_armed = false;
+
+        if (!event_queue_push_callback(&send_event,
+                                       EVENT_QUEUE_NO_ARG,
+                                       EVENT_PRIO_LOW))
+        {
+            retry_send_event(count);
+        }
+    }
+
+    if ((count - last_sync_count) >= SYNC_INTERVAL_TICKS)
+    {
+        last_sync_count = count;
+
+        // A dropped sync is tried again after the next interval
+        if (!sync_pending)
+        {
+            sync_pending = event_queue_push_callback(&sync_clock,
+                                                     EVENT_QUEUE_NO_ARG,
+                                                     EVENT_PRIO_LOW);
+        }
+    }
+
+    // Setting the compare clears the core timer interrupt
+    set_compare(count);
+    IFS0CLR = _IFS0_CTIF_MASK;
+}
+
+static int32_t send_event(int32_t arg)
+{
+    uint32_t now_block = dsp_events_now() / block_size;
+    uint32_t last_block = now_block + lookahead_blocks;
+    uint32_t event_block;
+    uint32_t nbr_of_events;
+    uint32_t nbr_of_late;
+    bool dsp_busy = false;
+
+    send_event_pending = false;
+
+    // The DSP is already rendering the current block
+    if ((int32_t)(next_block - (now_block + 1)) < 0)
+    {
+        next_block = now_block + 1;
+    }
+
+    while (!dsp_busy && !ring_buffer_is_empty(&scheduled_ring))
+    {
+        // Skip blocks without events
+        event_block =
+            scheduled_events[ring_buffer_head_index(&scheduled_ring)].sample_time
+            / block_size;
+
+        if ((int32_t)(event_block - next_block) > 0)
+        {
+            next_block = event_block;
+        }
+
+        if ((int32_t)(next_block - last_block) > 0)
+        {
+            break;
+        }
+
+        nbr_of_events = build_batch(next_block, &nbr_of_late);
+
+        if (DSP_LINK_OK == dsp_link_send(DSP_MSG_NOTE_EVENTS,
+                                         batch,
+                                         nbr_of_events + 1))
+        {
+            ring_buffer_consume(&scheduled_ring, nbr_of_events);
+
+            ++statistics.batches_sent;
+            statistics.events_sent += nbr_of_events;
+            statistics.late_events += nbr_of_late;
+
+            // A full batch may have left events of the same block
+            if (nbr_of_events < MAX_EVENTS_PER_BATCH)
+            {
+                ++next_block;
+            }
+        }
+        else
+        {
+            ++statistics.busy_retries;
+            dsp_busy = true;
+        }
+    }
+
+    if (dsp_busy)
+    {
+        // Try again when the DSP has rendered a block
+        schedule_send_event((now_block + 1) * block_size);
+    }
+    else if (!ring_buffer_is_empty(&scheduled_ring))
+    {
+        // The first block which is too far ahead
+        schedule_send_event((next_block - lookahead_blocks) * block_size);
+    }
+
+    return 0;
+}
+
+static int32_t sync_clock(int32_t arg)
+{
+    dsp_link_status_t status;
+    uint32_t int_status;
+    int32_t drift;
+
+    sync_pending = false;
+
+    if (dsp_link_poll_status(&status))
+    {
+        int_status = __builtin_disable_interrupts();
+
+        advance_clock();
+        drift = (int32_t)(status.block - clock_sample_time() / block_size);
+
+        if (0 != drift)
+        {
+            clock_offset += (uint32_t)drift * block_size;
+        }
+
+        __builtin_mtc0(_CP0_STATUS, _CP0_STATUS_SELECT, int_status);
+
+        if (0 != drift)
+        {
+            ++statistics.clock_syncs;
+            statistics.last_drift = drift;
+        }
+    }
+
+    return 0;
+}
+
+static void schedule_send_event(uint32_t sample_time)
+{
+    uint32_t int_status = __builtin_disable_interrupts();
+    int32_t samples_left;
+    uint64_t ticks;
+
+    send_event_pending = true;
+
+    advance_clock();
+    samples_left = (int32_t)(sample_time - clock_sample_time());
+
+    if (samples_left <= 0)
+    {
+        if (!event_queue_push_callback(&send_event,
+                                       EVENT_QUEUE_NO_ARG,
+                                       EVENT_PRIO_LOW))
+        {
+            retry_send_event(clock_last_count);
+        }
+    }
+    else
+    {
+        ticks = ((uint64_t)samples_left * CORE_TIMER_FREQ_HZ +
+                 sample_rate - 1) / sample_rate;
+
+        if (ticks > MAX_WAKE_TICKS)
+        {
+            ticks = MAX_WAKE_TICKS;
+        }
+
+        wake_count = clock_last_count + (uint32_t)ticks;
+        wake_armed = true;
+
+        if ((int32_t)(wake_count - _CP0_GET_COMPARE()) < 0)
+        {
+            set_compare(clock_last_count);
+        }
+    }
+
+    __builtin_mtc0(_CP0_STATUS, _CP0_STATUS_SELECT, int_status);
+}
+
+static void retry_send_event(uint32_t count)
+{
+    // send_event_pending stays set, the wake up belongs to it
+    wake_count = count + TICK_INTERVAL_TICKS;
+    wake_armed = true;
+}
+
+static void advance_clock(void)
+{
+    const uint32_t count = _CP0_GET_COUNT();
+
+    clock_cycles += (uint32_t)(count - clock_last_count);
+    clock_last_count = count;
+}
+
+static uint32_t clock_sample_time(void)
+{
+    return (uint32_t)((clock_cycles * sample_rate) / CORE_TIMER_FREQ_HZ) +
+           clock_offset;
+}
+
+static void set_compare(uint32_t count)
+{
+    uint32_t compare = count + TICK_INTERVAL_TICKS;
+
+    if (wake_armed && ((int32_t)(wake_count - compare) < 0))
+    {
+        compare = wake_count;
+    }
+
+    // A compare which has passed would only match after a full wrap
+    if ((int32_t)(compare - (_CP0_GET_COUNT() + MIN_COMPARE_TICKS)) < 0)
+    {
+        compare = _CP0_GET_COUNT() + MIN_COMPARE_TICKS;
+    }
+
+    _CP0_SET_COMPARE(compare);
+}
+
+static uint32_t build_batch(uint32_t block, uint32_t* nbr_of_late)
+{
+    uint32_t block_start = block * block_size;
+    uint32_t head = ring_buffer_head_index(&scheduled_ring);
+    uint32_t size = ring_buffer_size(&scheduled_ring);
+    const scheduled_event_t* scheduled;
+    uint32_t offset;
+    uint32_t i;
+
+    *nbr_of_late = 0;
+    batch[0] = block;
+
+    for (i = 0; (i < size) && (i < MAX_EVENTS_PER_BATCH); ++i)
+    {
+        scheduled = &scheduled_events[(head + i) & (EVENT_QUEUE_SIZE - 1)];
+        offset = scheduled->sample_time - block_start;
+
+        if ((int32_t)offset < 0)
+        {
+            offset = 0;
+            ++(*nbr_of_late);
+        }
+        else if (offset >= block_size)
+        {
+            break;
+        }
+
+        batch[i + 1] = (offset << 24) | scheduled->event;
+    }
+
+    return i;
+}
@@ -0,0 +1,106 @@
+/*
+ * Sample accurate note events to the DSP.
+ *
+ * Events are scheduled at an absolute sample time and sent to the DSP ahead of
+ * time, packed into one DSP_MSG_NOTE_EVENTS frame per audio block:
+ *
+ *   word 0    number of the audio block the events belong to
+ *   word 1..  one event per word
+ *             [31:24] sample offset from the start of the block
+ *             [23:16] midi status byte
+ *             [15:8]  first midi data byte
+ *             [7:0]   second midi data byte
+ *
+ * The DSP applies every event at its sample offset when it renders the block,
+ * so neither the SPI transfer nor the MCU scheduling shows up in the audio
+ * timing. A block is sent dsp.lookahead_blocks blocks before it is due and
+ * blocks without events are not sent at all. A block with more events than
+ * fit in one frame is sent as several frames with the same block number.
+ *
+ * The sample time is estimated from the core timer using dsp.sample_rate and
+ * starts at 0 when dsp_events_reset() is called. It wraps after 2^32 samples.
+ * Once a second the DSP status is polled and the sample time is moved by
+ * whole blocks to the block the DSP reports it is rendering, so the block
+ * numbers sent match the block counter of the DSP.
+ *
+ * The core timer interrupt is used to advance the sample time before the
+ * core timer wraps and to send the next block when it is due.
+ */
+
+#ifndef DSP_EVENTS_H
+#define	DSP_EVENTS_H
+
+#ifdef	__cplusplus
+//extern "C" {
+#endif
+
+// =============================================================================
+// Include statements
+// =============================================================================
+#include <stdint.h>
+#include <stdbool.h>
+
+// =============================================================================
+// Public type definitions
+// =============================================================================
+
+// =============================================================================
+// Global constatants
+// =============================================================================
+
+// Largest audio block, limited by the 8 bit sample offset of an event
+#define DSP_EVENTS_MAX_BLOCK_SIZE   (256u)
+
+// =============================================================================
+// Global variable declarations
+// =============================================================================
+
+// =============================================================================
+// Public function declarations
+// =============================================================================
+
+/**
+ * @brief Initializes the event scheduler and registers its tunables.
+ * @details dsp_link_init() must have been called. Enables the core timer
+ *          interrupt.
+ */
+void dsp_events_init(void);
+
+/**
+ * @brief Discards all scheduled events and restarts the sample time at 0.
+ */
+void dsp_events_reset(void);
+
+/**
+ * @brief Gets the current sample time.
+ */
+uint32_t dsp_events_now(void);
+
+/**
+ * @brief Schedules a midi event.
+ * @details Events must be scheduled in time order. An event scheduled before
+ *          the previous one is sent together with it. An event whose block
+ *          has already been sent or rendered is sent at the start of the
+ *          first block which can still be sent, and is counted as late.
+ * @param sample_time - the sample time at which the DSP shall apply the event.
+ * @param status - midi status byte.
+ * @param data1 - first midi data byte.
+ * @param data2 - second midi data byte, 0 if the event has only one.
+ * @return false if the event queue was full and the event was dropped.
+ */
+bool dsp_events_schedule(uint32_t sample_time,
+                         uint8_t status,
+                         uint8_t data1,
+                         uint8_t data2);
+
+/**
+ * @brief Prints the scheduler state and statistics over the uart.
+ */
+void dsp_events_print_status(void);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* DSP_EVENTS_H */
+
@@ -0,0 +1,295 @@
+
+// =============================================================================
+// Include statements
+// =============================================================================
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "dsp_link.h"
+#include "spi.h"
+#include "crc.h"
+#include "wait_timer.h"
+#include "tunables.h"
+#include "uart.h"
+#include "debug_util.h"
+
+// =============================================================================
+// Private type definitions
+// =============================================================================
+
+// =============================================================================
+// Global variables
+// =============================================================================
+
+// =============================================================================
+// Private constants
+// =============================================================================
+#define CRC_INITIAL_VALUE       (0xFFFFu)
+
+// Clocked out by the MCU while it reads the status reply
+#define IDLE_WORD               (0x00000000u)
+
+#define FRAME_OVERHEAD_WORDS    (2u)
+
+#define DEFAULT_HIGH_WATER      (192u)
+#define DEFAULT_POLL_INTERVAL   (16u)
+#define DEFAULT_REPLY_DELAY_US  (10u)
+
+// =============================================================================
+// Private variables
+// =============================================================================
+static uint8_t next_sequence = 0;
+static uint32_t frames_since_poll = 0;
+
+// Every frame sent, including the status polls
+static uint32_t frames_transmitted = 0;
+
+// frames_transmitted - frames_received at the first good status reply, the
+// DSP may have been started before or after the MCU
+static uint32_t frame_count_offset = 0;
+
+static dsp_link_status_t dsp_status = {false, 0, 0, 0, 0, 0};
+static dsp_link_statistics_t statistics;
+
+static uint32_t frame[DSP_LINK_MAX_PAYLOAD_WORDS + FRAME_OVERHEAD_WORDS];
+
+// Tunables
+static uint32_t high_water = DEFAULT_HIGH_WATER;
+static uint32_t poll_interval = DEFAULT_POLL_INTERVAL;
+static uint32_t reply_delay_us = DEFAULT_REPLY_DELAY_US;
+
+static const tunable_t high_water_tunable =
+{
+    "dsp.high_water",
+    TUNABLE_TYPE_UINT32,
+    &high_water,
+    1,
+    255,
+    NULL,
+    NULL
+};
+
+static const tunable_t poll_interval_tunable =
+{
+    "dsp.poll_interval",
+    TUNABLE_TYPE_UINT32,
+    &poll_interval,
+    1,
+    1000,
+    NULL,
+    NULL
+};
+
+static const tunable_t reply_delay_tunable =
+{
+    "dsp.reply_delay_us",
+    TUNABLE_TYPE_UINT32,
+    &reply_delay_us,
+    0,
+    1000,
+    NULL,
+    NULL
+};
+
+// =============================================================================
+// Private function declarations
+// =============================================================================
+
+/**
+ * @brief Builds a frame in the frame buffer.
+ * @return Number of words in the frame.
+ */
+static uint32_t build_frame(dsp_msg_type_t type,
+                            const uint32_t payload[],
+                            uint32_t length);
+
+// =============================================================================
+// Public function definitions
+// =============================================================================
+
+void dsp_link_init(void)
+{
+    next_sequence = 0;
+    frames_since_poll = 0;
+    frames_transmitted = 0;
+    frame_count_offset = 0;
+
+    memset(&dsp_status, 0, sizeof(dsp_status));
+    memset(&statistics, 0, sizeof(statistics));
+
+    tunables_register(&high_water_tunable);
+    tunables_register(&poll_interval_tunable);
+    tunables_register(&reply_delay_tunable);
+}
+
+dsp_link_result_t dsp_link_send(dsp_msg_type_t type,
+                                const uint32_t payload[],
+                                uint32_t length)
+{
+    dsp_link_result_t result = DSP_LINK_OK;
+    uint32_t frame_length;
+
+    if (length > DSP_LINK_MAX_PAYLOAD_WORDS)
+    {
+        result = DSP_LINK_ERROR;
+    }
+    else
+    {
+        if ((frames_since_poll >= poll_interval) ||
+            (dsp_status.valid && (dsp_status.fill_level >= high_water)))
+        {
+            (void)dsp_link_poll_status(NULL);
+        }
+
+        if (dsp_status.valid && (dsp_status.fill_level >= high_water))
+        {
+            ++statistics.frames_refused;
+            result = DSP_LINK_BUSY;
+        }
+    }
+
+    if (DSP_LINK_OK == result)
+    {
+        frame_length = build_frame(type, payload, length);
+        spi_write_dword_vect(SPI_DEVICE_DSP, frame, frame_length);
+
+        ++frames_since_poll;
+        ++statistics.frames_sent;
+    }
+
+    return result;
+}
+
+bool dsp_link_poll_status(dsp_link_status_t* status)
+{
+    uint32_t frame_length;
+    uint32_t reply[3];
+    uint32_t check_word;
+    bool reply_ok;
+
+    frame_length = build_frame(DSP_MSG_STATUS_POLL, NULL, 0);
+    spi_write_dword_vect(SPI_DEVICE_DSP, frame, frame_length);
+
+    // Let the DSP prepare the reply
+    spi_flush(SPI_DEVICE_DSP);
+    wait_timer_us((uint16_t)reply_delay_us);
+
+    reply[0] = spi_dword_tranceive_blocking(SPI_DEVICE_DSP, IDLE_WORD);
+    reply[1] = spi_dword_tranceive_blocking(SPI_DEVICE_DSP, IDLE_WORD);
+    reply[2] = spi_dword_tranceive_blocking(SPI_DEVICE_DSP, IDLE_WORD);
+    check_word = spi_dword_tranceive_blocking(SPI_DEVICE_DSP, IDLE_WORD);
+
+    ++statistics.polls;
+    frames_since_poll = 0;
+
+    reply_ok = (DSP_LINK_STATUS_SYNC == (reply[0] >> 24)) &&
+               ((check_word & 0xFFFF) ==
+                crc16_ccitt_update_words(CRC_INITIAL_VALUE, reply, 3));
+
+    if (reply_ok)
+    {
+        if (!dsp_status.valid)
+        {
+            frame_count_offset = frames_transmitted - reply[1];
+        }
+        else if (reply[1] < dsp_status.frames_received)
+        {
+            // The DSP has been restarted, keep the losses counted so far
+            frame_count_offset = frames_transmitted - reply[1] -
+                                 statistics.lost_frames;
+        }
+
+        dsp_status.valid = true;
+        dsp_status.last_sequence = (uint8_t)(reply[0] >> 16);
+        dsp_status.fill_level = (uint8_t)(reply[0] >> 8);
+        dsp_status.flags = (uint8_t)reply[0];
+        dsp_status.frames_received = reply[1];
+        dsp_status.block = reply[2];
+
+        statistics.lost_frames = frames_transmitted - reply[1] -
+                                 frame_count_offset;
+
+        if (NULL != status)
+        {
+            *status = dsp_status;
+        }
+    }
+    else
+    {
+        ++statistics.bad_replies;
+    }
+
+    return reply_ok;
+}
+
+const dsp_link_status_t* dsp_link_get_status(void)
+{
+    return &dsp_status;
+}
+
+const dsp_link_statistics_t* dsp_link_get_statistics(void)
+{
+    return &statistics;
+}
+
+void dsp_link_print_status(void)
+{
+    sprintf(g_debug_util_char_buffer,
+            "\tDSP status: %s, block %u, last sequence %u, received %u, "
+            "fill level %u/255, flags 0x%02X%s",
+            dsp_status.valid ? "valid" : "unknown",
+            (unsigned int)dsp_status.block,
+            (unsigned int)dsp_status.last_sequence,
+            (unsigned int)dsp_status.frames_received,
+            (unsigned int)dsp_status.fill_level,
+            (unsigned int)dsp_status.flags,
+            NEWLINE);
+    uart_write_string(g_debug_util_char_buffer);
+
+    sprintf(g_debug_util_char_buffer,
+            "\tFrames sent %u, refused %u, lost %u%s",
+            (unsigned int)statistics.frames_sent,
+            (unsigned int)statistics.frames_refused,
+            (unsigned int)statistics.lost_frames,
+            NEWLINE);
+    uart_write_string(g_debug_util_char_buffer);
+
+    sprintf(g_debug_util_char_buffer,
+            "\tStatus polls %u, bad replies %u%s",
+            (unsigned int)statistics.polls,
+            (unsigned int)statistics.bad_replies,
+            NEWLINE);
+    uart_write_string(g_debug_util_char_buffer);
+}
+
+// =============================================================================
+// Private function definitions
+// =============================================================================
+
+static uint32_t build_frame(dsp_msg_type_t type,
+                            const uint32_t payload[],
+                            uint32_t length)
+{
+    uint16_t crc;
+
+    frame[0] = ((uint32_t)DSP_LINK_FRAME_SYNC << 24) |
+               ((uint32_t)(type & 0xFF) << 16) |
+               ((uint32_t)next_sequence << 8) |
+               length;
+
+    if (0 != length)
+    {
+        memcpy(&frame[1], payload, length * sizeof(uint32_t));
+    }
+
+    crc = crc16_ccitt_update_words(CRC_INITIAL_VALUE, frame, length + 1);
+    frame[length + 1] = crc;
+
+    ++next_sequence;
+    ++frames_transmitted;
+
+    return length + FRAME_OVERHEAD_WORDS;
+}
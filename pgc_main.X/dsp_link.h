@@ -0,0 +1,154 @@
+/*
+ * Framed message protocol to the audio DSP over SPI3.
+ *
+ * Every message is sent as one frame of 32 bit words:
+ *
+ *   header    [31:24] DSP_LINK_FRAME_SYNC
+ *             [23:16] message type, dsp_msg_type_t
+ *             [15:8]  sequence number, incremented for every frame
+ *             [7:0]   number of payload words
+ *   payload   0 to DSP_LINK_MAX_PAYLOAD_WORDS words
+ *   trailer   [15:0]  CRC-16/CCITT (initial value 0xFFFF) of the header and
+ *                     the payload, most significant byte of each word first
+ *
+ * The DSP answers a DSP_MSG_STATUS_POLL frame during the four words the MCU
+ * clocks out after it:
+ *
+ *   status    [31:24] DSP_LINK_STATUS_SYNC
+ *             [23:16] sequence number of the last good frame received
+ *             [15:8]  fill level of the DSP input buffer, 0 (empty) to 255
+ *             [7:0]   flags, DSP_LINK_FLAG_*
+ *   received  [31:0]  number of good frames received since the DSP started,
+ *                     including the poll frame
+ *   block     [31:0]  number of the audio block the DSP is rendering
+ *   check     [15:0]  CRC-16/CCITT (initial value 0xFFFF) of the status,
+ *                     received and block words
+ *
+ * Every frame the MCU sends is counted, so the difference between the
+ * frames sent and the frames the DSP has received is the number of frames
+ * lost on the way. The first good reply sets the baseline, frames lost
+ * before it are not counted.
+ *
+ * The status is polled every dsp.poll_interval frames and while the fill
+ * level is at or above dsp.high_water. dsp_link_send refuses new frames while
+ * the DSP is that full, so the caller can hold them back or batch them.
+ */
+
+#ifndef DSP_LINK_H
+#define	DSP_LINK_H
+
+#ifdef	__cplusplus
+//extern "C" {
+#endif
+
+// =============================================================================
+// Include statements
+// =============================================================================
+#include <stdint.h>
+#include <stdbool.h>
+
+// =============================================================================
+// Public type definitions
+// =============================================================================
+
+typedef enum dsp_msg_type_t
+{
+    DSP_MSG_STATUS_POLL = 0x00,
+    DSP_MSG_PARAMETERS  = 0x01,
+    DSP_MSG_NOTE_EVENTS = 0x02
+} dsp_msg_type_t;
+
+typedef enum dsp_link_result_t
+{
+    DSP_LINK_OK,        // The frame has been queued for sending
+    DSP_LINK_BUSY,      // The DSP buffer is too full, try again later
+    DSP_LINK_ERROR      // The frame is too long
+} dsp_link_result_t;
+
+typedef struct dsp_link_status_t
+{
+    bool valid;                 // false until the first good status reply
+    uint8_t last_sequence;      // Last good frame received by the DSP
+    uint8_t fill_level;         // 0 (empty) to 255 (full)
+    uint8_t flags;              // DSP_LINK_FLAG_*
+    uint32_t frames_received;   // Good frames received by the DSP
+    uint32_t block;             // Audio block the DSP is rendering
+} dsp_link_status_t;
+
+typedef struct dsp_link_statistics_t
+{
+    uint32_t frames_sent;       // Message frames, status polls not included
+    uint32_t frames_refused;    // Not sent because the DSP was too full
+    uint32_t polls;
+    uint32_t bad_replies;       // Status replies with a bad sync or CRC
+    uint32_t lost_frames;       // Frames and polls the DSP did not receive
+} dsp_link_statistics_t;
+
+// =============================================================================
+// Global constatants
+// =============================================================================
+#define DSP_LINK_FRAME_SYNC         (0xD5u)
+#define DSP_LINK_STATUS_SYNC        (0x5Du)
+#define DSP_LINK_MAX_PAYLOAD_WORDS  (255u)
+
+// Status flags set by the DSP
+#define DSP_LINK_FLAG_CRC_ERROR     (0x01u) // A frame with a bad CRC was dropped
+#define DSP_LINK_FLAG_OVERRUN       (0x02u) // A frame did not fit in the buffer
+
+// =============================================================================
+// Global variable declarations
+// =============================================================================
+
+// =============================================================================
+// Public function declarations
+// =============================================================================
+
+/**
+ * @brief Initializes the DSP link and registers its tunables.
+ * @details spi_init(SPI_DEVICE_DSP) must have been called.
+ */
+void dsp_link_init(void);
+
+/**
+ * @brief Sends a message to the DSP.
+ * @details The payload is copied, so it can be reused when this returns.
+ *          Polls the DSP status first when a poll is due.
+ * @param type - the message type.
+ * @param payload - the payload words, may be NULL if length is 0.
+ * @param length - number of payload words.
+ * @return DSP_LINK_OK if the frame was queued.
+ */
+dsp_link_result_t dsp_link_send(dsp_msg_type_t type,
+                                const uint32_t payload[],
+                                uint32_t length);
+
+/**
+ * @brief Reads the status of the DSP.
+ * @details Blocks until all queued frames have been sent.
+ * @param status - where to store the status, or NULL.
+ * @return false if the reply was missing or corrupt.
+ */
+bool dsp_link_poll_status(dsp_link_status_t* status);
+
+/**
+ * @brief Gets the most recently polled DSP status.
+ */
+const dsp_link_status_t* dsp_link_get_status(void);
+
+/**
+ * @brief Gets the link statistics.
+ * @details lost_frames is updated by every good status reply.
+ */
+const dsp_link_statistics_t* dsp_link_get_statistics(void);
+
+/**
+ * @brief Prints the DSP status and the link statistics over the uart.
+ */
+void dsp_link_print_status(void);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* DSP_LINK_H */
+
@@ -5,13 +5,24 @@
 #include <stdbool.h>
 #include <stddef.h>
 
+#include <xc.h>
+
 #include "event_queue.h"
 #include "pinmap.h"
+#include "ring_buffer.h"
+#include "tunables.h"
 
 // =============================================================================
 // Private type definitions
 // =============================================================================
 
+// What to do when an event is pushed onto a full queue
+typedef enum overflow_policy_t
+{
+    OVERFLOW_POLICY_HALT,   // Turn on the red LED and stop, to catch it in a debugger
+    OVERFLOW_POLICY_DROP    // Drop the new event and carry on
+} overflow_policy_t;
+
 // =============================================================================
 // Global variables
 // =============================================================================
@@ -21,19 +32,41 @@
 // =============================================================================
 #define QUEUE_SIZE (32u)
 
+#ifndef NDEBUG
+#define DEFAULT_OVERFLOW_POLICY OVERFLOW_POLICY_HALT
+#else
+#define DEFAULT_OVERFLOW_POLICY OVERFLOW_POLICY_DROP
+#endif
+
+// Indexed by overflow_policy_t
+static const char* const OVERFLOW_POLICY_NAMES[] =
+{
+    "halt",
+    "drop",
+    NULL
+};
+
 // =============================================================================
 // Private variables
 // =============================================================================
 static event_t low_prio_queue[QUEUE_SIZE];
 static event_t high_prio_queue[QUEUE_SIZE];
 
-static uint32_t low_prio_first = 0;
-static uint32_t low_prio_last = 0;
-static uint32_t low_prio_size = 0;
+static ring_buffer_t low_prio_ring = {0, 0, QUEUE_SIZE - 1};
+static ring_buffer_t high_prio_ring = {0, 0, QUEUE_SIZE - 1};
 
-static uint32_t high_prio_first = 0;
-static uint32_t high_prio_last = 0;
-static uint32_t high_prio_size = 0;
+static uint32_t overflow_policy = DEFAULT_OVERFLOW_POLICY;
+
+static const tunable_t overflow_policy_tunable =
+{
+    "event_queue.overflow",
+    TUNABLE_TYPE_ENUM,
+    &overflow_policy,
+    0,
+    0,
+    OVERFLOW_POLICY_NAMES,
+    NULL
+};
 
 // =============================================================================
 // Private function declarations
@@ -43,194 +76,78 @@ static uint32_t high_prio_size = 0;
 // Public function definitions
 // =============================================================================
 
-void event_queue_push_event(event_t* e)
+void event_queue_init(void)
 {
-    switch (e->priority)
-    {
-    case EVENT_PRIO_LOW:
-#ifndef NDEBUG
-        if (QUEUE_SIZE == low_prio_size)
-        {
-            RED_LED_ON;
-
-            while (1);
-        }
-#endif
-
-        if (low_prio_size++)
-        {
-            ++low_prio_last;
-        }
-
-        if (QUEUE_SIZE == low_prio_last)
-        {
-            low_prio_last = 0;
-        }
-
-        low_prio_queue[low_prio_last].callback = e->callback;
-        low_prio_queue[low_prio_last].argument = e->argument;
-        break;
-
-    case EVENT_PRIO_HIGH:
-#ifndef NDEBUG
-        if (QUEUE_SIZE == high_prio_size)
-        {
-            RED_LED_ON;
-
-            while (1);
-        }
-#endif
-
-        if (high_prio_size++)
-        {
-            ++high_prio_last;
-        }
-
-        if (QUEUE_SIZE == high_prio_last)
-        {
-            high_prio_last = 0;
-        }
-
-        high_prio_queue[high_prio_last].callback = e->callback;
-        high_prio_queue[high_prio_last].argument = e->argument;
-        break;
-
-    default:
-        // If no priority was given, assume low priority.
-#ifndef NDEBUG
-        if (QUEUE_SIZE == low_prio_size)
-        {
-            RED_LED_ON;
-
-            while (1);
-        }
-#endif
-        ++low_prio_last;
-        ++low_prio_size;
-
-        if (QUEUE_SIZE == low_prio_last)
-        {
-            low_prio_last = 0;
-        }
+    tunables_register(&overflow_policy_tunable);
+}
 
-        low_prio_queue[low_prio_last].callback = e->callback;
-        low_prio_queue[low_prio_last].argument = e->argument;
-        break;
-    }
+bool event_queue_push_event(event_t* e)
+{
+    return event_queue_push_callback(e->callback, e->argument, e->priority);
 }
 
-void event_queue_push_callback(event_callback_t callback,
+bool event_queue_push_callback(event_callback_t callback,
                       int32_t arg,
                       event_priority_t priority)
 {
-    switch (priority)
-    {
-    case EVENT_PRIO_LOW:
-#ifndef NDEBUG
-        if (QUEUE_SIZE == low_prio_size)
-        {
-            RED_LED_ON;
-
-            while (1);
-        }
-#endif
-
-        if (low_prio_size++)
-        {
-            ++low_prio_last;
-        }
+    ring_buffer_t* ring;
+    event_t* queue;
+    uint32_t int_status;
+    bool pushed;
 
-        if (QUEUE_SIZE == low_prio_last)
-        {
-            low_prio_last = 0;
-        }
-
-        low_prio_queue[low_prio_last].callback = callback;
-        low_prio_queue[low_prio_last].argument = arg;
-        break;
-
-    case EVENT_PRIO_HIGH:
-#ifndef NDEBUG
-        if (QUEUE_SIZE == high_prio_size)
-        {
-            RED_LED_ON;
-
-            while (1);
-        }
-#endif
-
-        if (high_prio_size++)
-        {
-            ++high_prio_last;
-        }
+    if (EVENT_PRIO_HIGH == priority)
+    {
+        ring = &high_prio_ring;
+        queue = high_prio_queue;
+    }
+    else
+    {
+        // If no priority was given, assume low priority.
+        ring = &low_prio_ring;
+        queue = low_prio_queue;
+    }
 
-        if (QUEUE_SIZE == high_prio_last)
-        {
-            high_prio_last = 0;
-        }
+    // Events are pushed both from ISRs and from the main loop,
+    // so the producer side must be serialized.
+    int_status = __builtin_disable_interrupts();
 
-        high_prio_queue[high_prio_last].callback = callback;
-        high_prio_queue[high_prio_last].argument = arg;
-        break;
+    pushed = !ring_buffer_is_full(ring);
 
-    default:
-        // If no priority was given, assume low priority.
-#ifndef NDEBUG
-        if (QUEUE_SIZE == low_prio_size)
-        {
-            RED_LED_ON;
+    if (pushed)
+    {
+        queue[ring_buffer_tail_index(ring)].callback = callback;
+        queue[ring_buffer_tail_index(ring)].priority = priority;
+        queue[ring_buffer_tail_index(ring)].argument = arg;
+        ring_buffer_produce(ring, 1);
+    }
+    else if (OVERFLOW_POLICY_HALT == overflow_policy)
+    {
+        RED_LED_ON;
 
-            while (1);
-        }
-#endif
-        ++low_prio_last;
-        ++low_prio_size;
+        while (1);
+    }
 
-        if (QUEUE_SIZE == low_prio_last)
-        {
-            low_prio_last = 0;
-        }
+    __builtin_mtc0(_CP0_STATUS, _CP0_STATUS_SELECT, int_status);
 
-        low_prio_queue[low_prio_last].callback = callback;
-        low_prio_queue[low_prio_last].argument = arg;
-        break;
-    }
+    return pushed;
 }
 
 int32_t event_queue_run_next(void)
 {
-    int32_t arg;
+    event_t e;
     int32_t ret_val = 0;
 
-    if (high_prio_size)
+    if (!ring_buffer_is_empty(&high_prio_ring))
     {
-        arg = high_prio_queue[high_prio_first].argument;
-        ret_val = high_prio_queue[high_prio_first].callback(arg);
-
-        if (0 != --high_prio_size)
-        {
-            ++high_prio_first;
-        }
-
-        if (QUEUE_SIZE == high_prio_first)
-        {
-            high_prio_first = 0;
-        }
+        e = high_prio_queue[ring_buffer_head_index(&high_prio_ring)];
+        ring_buffer_consume(&high_prio_ring, 1);
+        ret_val = e.callback(e.argument);
     }
-    else if (low_prio_size)
+    else if (!ring_buffer_is_empty(&low_prio_ring))
     {
-        arg = low_prio_queue[low_prio_first].argument;
-        ret_val = low_prio_queue[low_prio_first].callback(arg);
-
-        if (0 != --low_prio_size)
-        {
-            ++low_prio_first;
-        }
-
-        if (QUEUE_SIZE == low_prio_first)
-        {
-            low_prio_first = 0;
-        }
+        e = low_prio_queue[ring_buffer_head_index(&low_prio_ring)];
+        ring_buffer_consume(&low_prio_ring, 1);
+        ret_val = e.callback(e.argument);
     }
 
     return ret_val;
@@ -240,13 +157,13 @@ event_t* event_queue_peek(void)
 {
     event_t* e = NULL;
 
-    if (high_prio_size)
+    if (!ring_buffer_is_empty(&high_prio_ring))
     {
-        e = &high_prio_queue[high_prio_first];
+        e = &high_prio_queue[ring_buffer_head_index(&high_prio_ring)];
     }
-    else if (low_prio_size)
+    else if (!ring_buffer_is_empty(&low_prio_ring))
     {
-        e = &low_prio_queue[low_prio_first];
+        e = &low_prio_queue[ring_buffer_head_index(&low_prio_ring)];
     }
 
     return e;
@@ -254,17 +171,16 @@ event_t* event_queue_peek(void)
 
 bool event_queue_is_empty(void)
 {
-    return (0 == (low_prio_size | high_prio_size));
+    return ring_buffer_is_empty(&low_prio_ring) &&
+           ring_buffer_is_empty(&high_prio_ring);
 }
 
 uint32_t event_queue_size(void)
 {
-    return low_prio_size + high_prio_size;
+    return ring_buffer_size(&low_prio_ring) + ring_buffer_size(&high_prio_ring);
 }
 
 // =============================================================================
 // Private function definitions
 // =============================================================================
 
-
-
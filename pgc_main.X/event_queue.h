@@ -52,21 +52,31 @@ typedef struct event_t
 // Public function declarations
 // =============================================================================
 
+/**
+ * @brief Initializes the event queue.
+ * @details Registers the overflow policy tunable. Events may be pushed
+ *          before this is called.
+ * @param void
+ * @return void
+ */
+void event_queue_init(void);
+
 /**
  * @brief Pushes an event into the event queue.
  * @param e - The event to push onto the queue.
- * @return void
+ * @return false if the queue was full and the event was dropped.
  */
-void event_queue_push_event(event_t* e);
+bool event_queue_push_event(event_t* e);
 
 /**
  * @brief Pushes an event into the event queue.
+ * @details Safe to call from ISRs.
  * @param callback - The callback of the event.
  * @param arg - The callback argument of the event.
  * @param priority - The event priority.
- * @return void
+ * @return false if the queue was full and the event was dropped.
  */
-void event_queue_push_callback(event_callback_t callback,
+bool event_queue_push_callback(event_callback_t callback,
                       int32_t arg,
                       event_priority_t priority);
 
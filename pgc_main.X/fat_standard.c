@@ -1,4 +1,5 @@
 #include <ctype.h>
+#include <string.h>
 
 #include "fat_standard.h"
 
@@ -39,6 +40,56 @@ bool fat_isDirectoryEntryEmpty(fatDirectoryEntry_t *entry)
     return (unsigned char) entry->filename[0] == FAT_DELETED_FILE_MARKER;
 }
 
+bool fat_isDirectoryEntryLongName(fatDirectoryEntry_t *entry)
+{
+    return (entry->attrib & (FAT_FILE_ATTRIBUTE_LONG_NAME | FAT_FILE_ATTRIBUTE_DIRECTORY | FAT_FILE_ATTRIBUTE_ARCHIVE))
+        == FAT_FILE_ATTRIBUTE_LONG_NAME;
+}
+
+/**
+ * The checksum of a short filename (FAT_FILENAME_LENGTH bytes, as stored on disk) which is stored in each of its long
+ * filename entries, to tell whether they still belong to it.
+ */
+uint8_t fat_shortFilenameChecksum(const uint8_t *fatFilename)
+{
+    uint8_t checksum = 0;
+    int i;
+
+    for (i = 0; i < FAT_FILENAME_LENGTH; i++) {
+        checksum = ((checksum & 1) << 7) + (checksum >> 1) + fatFilename[i];
+    }
+
+    return checksum;
+}
+
+/**
+ * Returns true if the given filename can be stored as a "prefix.ext" short filename by fat_convertFilenameToFATStyle()
+ * without losing anything but its case.
+ */
+bool fat_isShortFilename(const char *filename)
+{
+    int length = 0;
+    int maxLength = 8;
+    bool extension = false;
+
+    for (; *filename != '\0'; filename++) {
+        unsigned char c = (unsigned char) *filename;
+
+        if (c == '.') {
+            if (extension || length == 0) {
+                return false;
+            }
+            extension = true;
+            length = 0;
+            maxLength = 3;
+        } else if (c < 0x20 || strchr(" \"*+,/:;<=>?[\\]|", c) != NULL || ++length > maxLength) {
+            return false;
+        }
+    }
+
+    return length > 0;
+}
+
 /**
  * Convert the given "prefix.ext" style filename to the FAT format to be stored on disk.
  *
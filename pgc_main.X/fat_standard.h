@@ -27,9 +27,19 @@
 #define FAT_FILE_ATTRIBUTE_DIRECTORY 0x10
 #define FAT_FILE_ATTRIBUTE_ARCHIVE   0x20
 
+// Attributes of a VFAT long filename entry, no regular file can have all of these
+#define FAT_FILE_ATTRIBUTE_LONG_NAME  (FAT_FILE_ATTRIBUTE_READ_ONLY | FAT_FILE_ATTRIBUTE_HIDDEN | FAT_FILE_ATTRIBUTE_SYSTEM | FAT_FILE_ATTRIBUTE_VOLUME_ID)
+
 #define FAT_FILENAME_LENGTH 11
 #define FAT_DELETED_FILE_MARKER 0xE5
 
+#define FAT_LONG_NAME_MAX_LENGTH      255
+#define FAT_LONG_NAME_CHARS_PER_ENTRY 13
+#define FAT_LONG_NAME_MAX_ENTRIES     20
+// Set in the order of the long filename entry which holds the end of the name (and comes first in the directory)
+#define FAT_LONG_NAME_LAST_ENTRY      0x40
+#define FAT_LONG_NAME_ORDER_MASK      0x1F
+
 #define FAT_MAKE_DATE(year, month, day)     (day | (month << 5) | ((year - 1980) << 9))
 #define FAT_MAKE_TIME(hour, minute, second) ((second / 2) | (minute << 5) | (hour << 11))
 
@@ -110,6 +120,21 @@ typedef struct fatDirectoryEntry_t {
     uint32_t fileSize;
 } __attribute__((packed)) fatDirectoryEntry_t;
 
+/*
+ * One part of a long filename. The parts precede the short directory entry of the file, last part first, and hold
+ * FAT_LONG_NAME_CHARS_PER_ENTRY UCS-2 characters each.
+ */
+typedef struct fatLongNameEntry_t {
+    uint8_t order;
+    uint16_t name1[5];
+    uint8_t attrib;
+    uint8_t type;
+    uint8_t checksum; // Of the filename in the short directory entry
+    uint16_t name2[6];
+    uint16_t firstClusterLow;
+    uint16_t name3[2];
+} __attribute__((packed)) fatLongNameEntry_t;
+
 uint32_t fat32_decodeClusterNumber(uint32_t clusterNumber);
 
 bool fat32_isEndOfChainMarker(uint32_t clusterNumber);
@@ -119,5 +144,9 @@ bool fat_isFreeSpace(uint32_t clusterNumber);
 
 bool fat_isDirectoryEntryTerminator(fatDirectoryEntry_t *entry);
 bool fat_isDirectoryEntryEmpty(fatDirectoryEntry_t *entry);
+bool fat_isDirectoryEntryLongName(fatDirectoryEntry_t *entry);
+
+uint8_t fat_shortFilenameChecksum(const uint8_t *fatFilename);
 
+bool fat_isShortFilename(const char *filename);
 void fat_convertFilenameToFATStyle(const char *filename, uint8_t *fatFilename);
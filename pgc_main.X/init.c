@@ -7,6 +7,11 @@
 #include "uart.h"
 #include "mcu.h"
 #include "spi.h"
+#include "spi_bus.h"
+#include "sdcard_mount.h"
+#include "dsp_link.h"
+#include "dsp_events.h"
+#include "event_queue.h"
 
 // =============================================================================
 // Private type definitions
@@ -36,9 +41,13 @@ void init_system(void)
 {
     gpio_init();
     mcu_init();
+    event_queue_init();
     uart_init();
     spi_init(SPI_DEVICE_DSP);
-    sdcard_init();
+    dsp_link_init();
+    dsp_events_init();
+    spi_bus_init();
+    sdcard_mount_init();
 }
 
 // =============================================================================
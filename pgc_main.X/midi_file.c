@@ -9,6 +9,7 @@
 #include "midi_file.h"
 #include "uart.h"
 #include "debug_util.h"
+#include "ring_buffer.h"
 
 // =============================================================================
 // Private type definitions
@@ -22,9 +23,7 @@
 typedef struct midi_file_buffer_t
 {
     uint8_t buffer[MIDI_FILE_BUFFER_SIZE];
-    size_t first;
-    size_t last;
-    size_t size;
+    ring_buffer_u8_t ring;
     size_t file_pos;
 } midi_file_buffer_t;
 
@@ -88,6 +87,9 @@ void midi_file_open(char* file_name)
 
     // TODO Load midi file from SD card
     memset(&file_buffer, 0x00, sizeof(file_buffer));
+    ring_buffer_u8_init(&file_buffer.ring,
+                        file_buffer.buffer,
+                        MIDI_FILE_BUFFER_SIZE);
     load_test_file(midi_test_file, sizeof(midi_test_file));
 }
 
@@ -95,7 +97,7 @@ bool midi_file_append(uint8_t data)
 {
     bool overflow = false;
 
-    if (file_buffer.size >= MIDI_FILE_BUFFER_SIZE)
+    if (!ring_buffer_u8_push(&file_buffer.ring, data))
     {
         uart_write_string("midi file buffer overflow in midi_file_append");
         uart_write_string(NEWLINE);
@@ -103,16 +105,6 @@ bool midi_file_append(uint8_t data)
     }
     else
     {
-        if (0 != file_buffer.size)
-        {
-            if (++file_buffer.last == MIDI_FILE_BUFFER_SIZE)
-            {
-                file_buffer.last = 0;
-            }
-        }
-
-        file_buffer.buffer[file_buffer.last] = data;
-        file_buffer.size++;
         file_buffer.file_pos++;
     }
 
@@ -122,9 +114,8 @@ bool midi_file_append(uint8_t data)
 bool midi_file_append_chunk(uint8_t data_array[], size_t number_of_bytes)
 {
     bool overflow  = false;
-    size_t new_last_index;
 
-    if (MIDI_FILE_BUFFER_SIZE - file_buffer.size >= number_of_bytes)
+    if (ring_buffer_free(&file_buffer.ring.ring) < number_of_bytes)
     {
         uart_write_string("midi file buffer overflow in midi_file_append_chunk");
         uart_write_string(NEWLINE);
@@ -132,85 +123,9 @@ bool midi_file_append_chunk(uint8_t data_array[], size_t number_of_bytes)
     }
     else
     {
-        //
-        // Place the first bytes in the buffer at
-        // indicies [last, MIDI_FILE_BUFFER_SIZE - 1].
-        // Then place the last byte from index 0 and forth
-        //
-        // Example where 6 bytes are added to a size 10 buffer.
-        // Before:
-        //                first    last
-        // [0,  1,  2,  3,  4,  5,  6,  7,  8,  9]
-        //
-        // After:
-        //         last   first
-        // [0,  1,  2,  3,  4,  5,  6,  7,  8,  9]
-        //  <------->                   <------->
-        // second chunk                first chunk
-        //
-
-        //
-        // Chunk to place in file_buffer at [last, MIDI_FILE_BUFFER_SIZE - 1]
-        //
-        size_t first_chunk_size = MIDI_FILE_BUFFER_SIZE - file_buffer.last - 1;
-        size_t first_chunk_first_index;
-        bool second_chunk_needed;
-
-        if (0 != file_buffer.size)
-        {
-            if (MIDI_FILE_BUFFER_SIZE - file_buffer.last - 1 < number_of_bytes)
-            {
-                first_chunk_size = MIDI_FILE_BUFFER_SIZE - file_buffer.last - 1;
-                new_last_index = MIDI_FILE_BUFFER_SIZE - 1;
-                second_chunk_needed = true;
-            }
-            else
-            {
-                first_chunk_size = number_of_bytes;
-                new_last_index = file_buffer.last + first_chunk_size;
-                second_chunk_needed = false;
-            }
-            
-            first_chunk_first_index = file_buffer.last + 1;
-        }
-        else
-        {
-            if (MIDI_FILE_BUFFER_SIZE - file_buffer.last < number_of_bytes)
-            {
-                first_chunk_size = MIDI_FILE_BUFFER_SIZE - file_buffer.last;
-                new_last_index = MIDI_FILE_BUFFER_SIZE - 1;
-                second_chunk_needed = true;
-            }
-            else
-            {
-                first_chunk_size = number_of_bytes;
-                new_last_index = file_buffer.last + first_chunk_size - 1;
-                second_chunk_needed = false;
-            }
-
-            first_chunk_first_index = file_buffer.last;
-        }
-
-        memcpy(&file_buffer.buffer[first_chunk_first_index],
-               &data_array[0],
-               first_chunk_size);
-
-        if (second_chunk_needed)
-        {
-            //
-            // Chunk to place in file_buffer from index 0 and forth
-            //
-            size_t second_chunk_size = number_of_bytes - first_chunk_size;
-
-            memcpy(&file_buffer.buffer[0],
-                   &data_array[first_chunk_size],
-                   second_chunk_size);
-
-            new_last_index = second_chunk_size - 1;
-        }
-
-        file_buffer.last = new_last_index;
-        file_buffer.size += number_of_bytes;
+        ring_buffer_u8_push_bulk(&file_buffer.ring,
+                                 data_array,
+                                 number_of_bytes);
         file_buffer.file_pos += number_of_bytes;
     }
 
@@ -221,29 +136,19 @@ uint8_t midi_file_get(void)
 {
     uint8_t byte_to_return = 0xFF;
 
-    if (midi_file_has_next())
-    {
-        byte_to_return = file_buffer.buffer[file_buffer.first++];
-
-        if (file_buffer.first == MIDI_FILE_BUFFER_SIZE)
-        {
-            file_buffer.first = 0;
-        }
-
-        file_buffer.size--;
-    }
+    (void)ring_buffer_u8_pop(&file_buffer.ring, &byte_to_return);
 
     return byte_to_return;
 }
 
 uint8_t midi_file_peek(void)
 {
-    return file_buffer.buffer[file_buffer.first];
+    return ring_buffer_u8_peek(&file_buffer.ring, 0);
 }
 
 bool  midi_file_has_next(void)
 {
-    return (0 != file_buffer.size);
+    return !ring_buffer_is_empty(&file_buffer.ring.ring);
 }
 
 // =============================================================================
@@ -252,8 +157,6 @@ bool  midi_file_has_next(void)
 
 static void load_test_file(const uint8_t test_file[], size_t test_file_size)
 {
-    size_t i;
-
     if (test_file_size > MIDI_FILE_BUFFER_SIZE)
     {
         test_file_size = MIDI_FILE_BUFFER_SIZE;
@@ -262,14 +165,9 @@ static void load_test_file(const uint8_t test_file[], size_t test_file_size)
     }
     else
     {
-        for (i = 0; i != test_file_size; ++i)
-        {
-            file_buffer.buffer[i] = test_file[i];
-        }
+        ring_buffer_clear(&file_buffer.ring.ring);
+        ring_buffer_u8_push_bulk(&file_buffer.ring, test_file, test_file_size);
 
-        file_buffer.first = 0;
-        file_buffer.last = test_file_size - 1;
-        file_buffer.size = test_file_size;
         file_buffer.file_pos = test_file_size - 1;
     }
-}
\ No newline at end of file
+}
@@ -45,17 +45,17 @@ OBJECTDIR=build/${CND_CONF}/${IMAGE_TYPE}
 DISTDIR=dist/${CND_CONF}/${IMAGE_TYPE}
 
 # Source Files Quoted if spaced
-SOURCEFILES_QUOTED_IF_SPACED=mcu.c gpio.c configuration_bits.c spi.c wait_timer.c uart.c terminal.c debug_util.c terminal_help.c event_queue.c midi_parser.c midi_timer.c midi_file.c midi_io.c asyncfatfs.c fat_standard.c sdcard.c source_template.c main.c init.c
+SOURCEFILES_QUOTED_IF_SPACED=mcu.c gpio.c configuration_bits.c spi.c spi_bus.c dsp_link.c dsp_events.c wait_timer.c ring_buffer.c crc.c uart.c terminal.c debug_util.c tunables.c bench.c terminal_help.c event_queue.c midi_parser.c midi_timer.c midi_file.c midi_io.c asyncfatfs.c fat_standard.c sdcard.c sdcard_profiler.c sdcard_mount.c source_template.c main.c init.c
 
 # Object Files Quoted if spaced
-OBJECTFILES_QUOTED_IF_SPACED=${OBJECTDIR}/mcu.o ${OBJECTDIR}/gpio.o ${OBJECTDIR}/configuration_bits.o ${OBJECTDIR}/spi.o ${OBJECTDIR}/wait_timer.o ${OBJECTDIR}/uart.o ${OBJECTDIR}/terminal.o ${OBJECTDIR}/debug_util.o ${OBJECTDIR}/terminal_help.o ${OBJECTDIR}/event_queue.o ${OBJECTDIR}/midi_parser.o ${OBJECTDIR}/midi_timer.o ${OBJECTDIR}/midi_file.o ${OBJECTDIR}/midi_io.o ${OBJECTDIR}/asyncfatfs.o ${OBJECTDIR}/fat_standard.o ${OBJECTDIR}/sdcard.o ${OBJECTDIR}/source_template.o ${OBJECTDIR}/main.o ${OBJECTDIR}/init.o
-POSSIBLE_DEPFILES=${OBJECTDIR}/mcu.o.d ${OBJECTDIR}/gpio.o.d ${OBJECTDIR}/configuration_bits.o.d ${OBJECTDIR}/spi.o.d ${OBJECTDIR}/wait_timer.o.d ${OBJECTDIR}/uart.o.d ${OBJECTDIR}/terminal.o.d ${OBJECTDIR}/debug_util.o.d ${OBJECTDIR}/terminal_help.o.d ${OBJECTDIR}/event_queue.o.d ${OBJECTDIR}/midi_parser.o.d ${OBJECTDIR}/midi_timer.o.d ${OBJECTDIR}/midi_file.o.d ${OBJECTDIR}/midi_io.o.d ${OBJECTDIR}/asyncfatfs.o.d ${OBJECTDIR}/fat_standard.o.d ${OBJECTDIR}/sdcard.o.d ${OBJECTDIR}/source_template.o.d ${OBJECTDIR}/main.o.d ${OBJECTDIR}/init.o.d
+OBJECTFILES_QUOTED_IF_SPACED=${OBJECTDIR}/mcu.o ${OBJECTDIR}/gpio.o ${OBJECTDIR}/configuration_bits.o ${OBJECTDIR}/spi.o ${OBJECTDIR}/spi_bus.o ${OBJECTDIR}/dsp_link.o ${OBJECTDIR}/dsp_events.o ${OBJECTDIR}/wait_timer.o ${OBJECTDIR}/ring_buffer.o ${OBJECTDIR}/crc.o ${OBJECTDIR}/uart.o ${OBJECTDIR}/terminal.o ${OBJECTDIR}/debug_util.o ${OBJECTDIR}/tunables.o ${OBJECTDIR}/bench.o ${OBJECTDIR}/terminal_help.o ${OBJECTDIR}/event_queue.o ${OBJECTDIR}/midi_parser.o ${OBJECTDIR}/midi_timer.o ${OBJECTDIR}/midi_file.o ${OBJECTDIR}/midi_io.o ${OBJECTDIR}/asyncfatfs.o ${OBJECTDIR}/fat_standard.o ${OBJECTDIR}/sdcard.o ${OBJECTDIR}/sdcard_profiler.o ${OBJECTDIR}/sdcard_mount.o ${OBJECTDIR}/source_template.o ${OBJECTDIR}/main.o ${OBJECTDIR}/init.o
+POSSIBLE_DEPFILES=${OBJECTDIR}/mcu.o.d ${OBJECTDIR}/gpio.o.d ${OBJECTDIR}/configuration_bits.o.d ${OBJECTDIR}/spi.o.d ${OBJECTDIR}/spi_bus.o.d ${OBJECTDIR}/dsp_link.o.d ${OBJECTDIR}/dsp_events.o.d ${OBJECTDIR}/wait_timer.o.d ${OBJECTDIR}/ring_buffer.o.d ${OBJECTDIR}/crc.o.d ${OBJECTDIR}/uart.o.d ${OBJECTDIR}/terminal.o.d ${OBJECTDIR}/debug_util.o.d ${OBJECTDIR}/tunables.o.d ${OBJECTDIR}/bench.o.d ${OBJECTDIR}/terminal_help.o.d ${OBJECTDIR}/event_queue.o.d ${OBJECTDIR}/midi_parser.o.d ${OBJECTDIR}/midi_timer.o.d ${OBJECTDIR}/midi_file.o.d ${OBJECTDIR}/midi_io.o.d ${OBJECTDIR}/asyncfatfs.o.d ${OBJECTDIR}/fat_standard.o.d ${OBJECTDIR}/sdcard.o.d ${OBJECTDIR}/sdcard_profiler.o.d ${OBJECTDIR}/sdcard_mount.o.d ${OBJECTDIR}/source_template.o.d ${OBJECTDIR}/main.o.d ${OBJECTDIR}/init.o.d
 
 # Object Files
-OBJECTFILES=${OBJECTDIR}/mcu.o ${OBJECTDIR}/gpio.o ${OBJECTDIR}/configuration_bits.o ${OBJECTDIR}/spi.o ${OBJECTDIR}/wait_timer.o ${OBJECTDIR}/uart.o ${OBJECTDIR}/terminal.o ${OBJECTDIR}/debug_util.o ${OBJECTDIR}/terminal_help.o ${OBJECTDIR}/event_queue.o ${OBJECTDIR}/midi_parser.o ${OBJECTDIR}/midi_timer.o ${OBJECTDIR}/midi_file.o ${OBJECTDIR}/midi_io.o ${OBJECTDIR}/asyncfatfs.o ${OBJECTDIR}/fat_standard.o ${OBJECTDIR}/sdcard.o ${OBJECTDIR}/source_template.o ${OBJECTDIR}/main.o ${OBJECTDIR}/init.o
+OBJECTFILES=${OBJECTDIR}/mcu.o ${OBJECTDIR}/gpio.o ${OBJECTDIR}/configuration_bits.o ${OBJECTDIR}/spi.o ${OBJECTDIR}/spi_bus.o ${OBJECTDIR}/dsp_link.o ${OBJECTDIR}/dsp_events.o ${OBJECTDIR}/wait_timer.o ${OBJECTDIR}/ring_buffer.o ${OBJECTDIR}/crc.o ${OBJECTDIR}/uart.o ${OBJECTDIR}/terminal.o ${OBJECTDIR}/debug_util.o ${OBJECTDIR}/tunables.o ${OBJECTDIR}/bench.o ${OBJECTDIR}/terminal_help.o ${OBJECTDIR}/event_queue.o ${OBJECTDIR}/midi_parser.o ${OBJECTDIR}/midi_timer.o ${OBJECTDIR}/midi_file.o ${OBJECTDIR}/midi_io.o ${OBJECTDIR}/asyncfatfs.o ${OBJECTDIR}/fat_standard.o ${OBJECTDIR}/sdcard.o ${OBJECTDIR}/sdcard_profiler.o ${OBJECTDIR}/sdcard_mount.o ${OBJECTDIR}/source_template.o ${OBJECTDIR}/main.o ${OBJECTDIR}/init.o
 
 # Source Files
-SOURCEFILES=mcu.c gpio.c configuration_bits.c spi.c wait_timer.c uart.c terminal.c debug_util.c terminal_help.c event_queue.c midi_parser.c midi_timer.c midi_file.c midi_io.c asyncfatfs.c fat_standard.c sdcard.c source_template.c main.c init.c
+SOURCEFILES=mcu.c gpio.c configuration_bits.c spi.c spi_bus.c dsp_link.c dsp_events.c wait_timer.c ring_buffer.c crc.c uart.c terminal.c debug_util.c tunables.c bench.c terminal_help.c event_queue.c midi_parser.c midi_timer.c midi_file.c midi_io.c asyncfatfs.c fat_standard.c sdcard.c sdcard_profiler.c sdcard_mount.c source_template.c main.c init.c
 
 
 CFLAGS=
@@ -131,12 +131,42 @@ ${OBJECTDIR}/spi.o: spi.c  nbproject/Makefile-${CND_CONF}.mk
 	@${RM} ${OBJECTDIR}/spi.o 
 	@${FIXDEPS} "${OBJECTDIR}/spi.o.d" $(SILENT) -rsi ${MP_CC_DIR}../  -c ${MP_CC}  $(MP_EXTRA_CC_PRE) -g -D__DEBUG -D__MPLAB_DEBUGGER_PK3=1 -fframe-base-loclist  -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -MMD -MF "${OBJECTDIR}/spi.o.d" -o ${OBJECTDIR}/spi.o spi.c   
 	
+${OBJECTDIR}/spi_bus.o: spi_bus.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/spi_bus.o.d 
+	@${RM} ${OBJECTDIR}/spi_bus.o 
+	@${FIXDEPS} "${OBJECTDIR}/spi_bus.o.d" $(SILENT) -rsi ${MP_CC_DIR}../  -c ${MP_CC}  $(MP_EXTRA_CC_PRE) -g -D__DEBUG -D__MPLAB_DEBUGGER_PK3=1 -fframe-base-loclist  -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -MMD -MF "${OBJECTDIR}/spi_bus.o.d" -o ${OBJECTDIR}/spi_bus.o spi_bus.c   
+	
+${OBJECTDIR}/dsp_link.o: dsp_link.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/dsp_link.o.d 
+	@${RM} ${OBJECTDIR}/dsp_link.o 
+	@${FIXDEPS} "${OBJECTDIR}/dsp_link.o.d" $(SILENT) -rsi ${MP_CC_DIR}../  -c ${MP_CC}  $(MP_EXTRA_CC_PRE) -g -D__DEBUG -D__MPLAB_DEBUGGER_PK3=1 -fframe-base-loclist  -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -MMD -MF "${OBJECTDIR}/dsp_link.o.d" -o ${OBJECTDIR}/dsp_link.o dsp_link.c   
+	
+${OBJECTDIR}/dsp_events.o: dsp_events.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/dsp_events.o.d 
+	@${RM} ${OBJECTDIR}/dsp_events.o 
+	@${FIXDEPS} "${OBJECTDIR}/dsp_events.o.d" $(SILENT) -rsi ${MP_CC_DIR}../  -c ${MP_CC}  $(MP_EXTRA_CC_PRE) -g -D__DEBUG -D__MPLAB_DEBUGGER_PK3=1 -fframe-base-loclist  -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -MMD -MF "${OBJECTDIR}/dsp_events.o.d" -o ${OBJECTDIR}/dsp_events.o dsp_events.c   
+	
 ${OBJECTDIR}/wait_timer.o: wait_timer.c  nbproject/Makefile-${CND_CONF}.mk
 	@${MKDIR} "${OBJECTDIR}" 
 	@${RM} ${OBJECTDIR}/wait_timer.o.d 
 	@${RM} ${OBJECTDIR}/wait_timer.o 
 	@${FIXDEPS} "${OBJECTDIR}/wait_timer.o.d" $(SILENT) -rsi ${MP_CC_DIR}../  -c ${MP_CC}  $(MP_EXTRA_CC_PRE) -g -D__DEBUG -D__MPLAB_DEBUGGER_PK3=1 -fframe-base-loclist  -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -MMD -MF "${OBJECTDIR}/wait_timer.o.d" -o ${OBJECTDIR}/wait_timer.o wait_timer.c   
 	
+${OBJECTDIR}/ring_buffer.o: ring_buffer.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/ring_buffer.o.d 
+	@${RM} ${OBJECTDIR}/ring_buffer.o 
+	@${FIXDEPS} "${OBJECTDIR}/ring_buffer.o.d" $(SILENT) -rsi ${MP_CC_DIR}../  -c ${MP_CC}  $(MP_EXTRA_CC_PRE) -g -D__DEBUG -D__MPLAB_DEBUGGER_PK3=1 -fframe-base-loclist  -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -MMD -MF "${OBJECTDIR}/ring_buffer.o.d" -o ${OBJECTDIR}/ring_buffer.o ring_buffer.c   
+	
+${OBJECTDIR}/crc.o: crc.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/crc.o.d 
+	@${RM} ${OBJECTDIR}/crc.o 
+	@${FIXDEPS} "${OBJECTDIR}/crc.o.d" $(SILENT) -rsi ${MP_CC_DIR}../  -c ${MP_CC}  $(MP_EXTRA_CC_PRE) -g -D__DEBUG -D__MPLAB_DEBUGGER_PK3=1 -fframe-base-loclist  -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -MMD -MF "${OBJECTDIR}/crc.o.d" -o ${OBJECTDIR}/crc.o crc.c   
+	
 ${OBJECTDIR}/uart.o: uart.c  nbproject/Makefile-${CND_CONF}.mk
 	@${MKDIR} "${OBJECTDIR}" 
 	@${RM} ${OBJECTDIR}/uart.o.d 
@@ -155,6 +185,18 @@ ${OBJECTDIR}/debug_util.o: debug_util.c  nbproject/Makefile-${CND_CONF}.mk
 	@${RM} ${OBJECTDIR}/debug_util.o 
 	@${FIXDEPS} "${OBJECTDIR}/debug_util.o.d" $(SILENT) -rsi ${MP_CC_DIR}../  -c ${MP_CC}  $(MP_EXTRA_CC_PRE) -g -D__DEBUG -D__MPLAB_DEBUGGER_PK3=1 -fframe-base-loclist  -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -MMD -MF "${OBJECTDIR}/debug_util.o.d" -o ${OBJECTDIR}/debug_util.o debug_util.c   
 	
+${OBJECTDIR}/tunables.o: tunables.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/tunables.o.d 
+	@${RM} ${OBJECTDIR}/tunables.o 
+	@${FIXDEPS} "${OBJECTDIR}/tunables.o.d" $(SILENT) -rsi ${MP_CC_DIR}../  -c ${MP_CC}  $(MP_EXTRA_CC_PRE) -g -D__DEBUG -D__MPLAB_DEBUGGER_PK3=1 -fframe-base-loclist  -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -MMD -MF "${OBJECTDIR}/tunables.o.d" -o ${OBJECTDIR}/tunables.o tunables.c   
+	
+${OBJECTDIR}/bench.o: bench.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/bench.o.d 
+	@${RM} ${OBJECTDIR}/bench.o 
+	@${FIXDEPS} "${OBJECTDIR}/bench.o.d" $(SILENT) -rsi ${MP_CC_DIR}../  -c ${MP_CC}  $(MP_EXTRA_CC_PRE) -g -D__DEBUG -D__MPLAB_DEBUGGER_PK3=1 -fframe-base-loclist  -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -MMD -MF "${OBJECTDIR}/bench.o.d" -o ${OBJECTDIR}/bench.o bench.c   
+	
 ${OBJECTDIR}/terminal_help.o: terminal_help.c  nbproject/Makefile-${CND_CONF}.mk
 	@${MKDIR} "${OBJECTDIR}" 
 	@${RM} ${OBJECTDIR}/terminal_help.o.d 
@@ -209,6 +251,18 @@ ${OBJECTDIR}/sdcard.o: sdcard.c  nbproject/Makefile-${CND_CONF}.mk
 	@${RM} ${OBJECTDIR}/sdcard.o 
 	@${FIXDEPS} "${OBJECTDIR}/sdcard.o.d" $(SILENT) -rsi ${MP_CC_DIR}../  -c ${MP_CC}  $(MP_EXTRA_CC_PRE) -g -D__DEBUG -D__MPLAB_DEBUGGER_PK3=1 -fframe-base-loclist  -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -MMD -MF "${OBJECTDIR}/sdcard.o.d" -o ${OBJECTDIR}/sdcard.o sdcard.c   
 	
+${OBJECTDIR}/sdcard_profiler.o: sdcard_profiler.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/sdcard_profiler.o.d 
+	@${RM} ${OBJECTDIR}/sdcard_profiler.o 
+	@${FIXDEPS} "${OBJECTDIR}/sdcard_profiler.o.d" $(SILENT) -rsi ${MP_CC_DIR}../  -c ${MP_CC}  $(MP_EXTRA_CC_PRE) -g -D__DEBUG -D__MPLAB_DEBUGGER_PK3=1 -fframe-base-loclist  -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -MMD -MF "${OBJECTDIR}/sdcard_profiler.o.d" -o ${OBJECTDIR}/sdcard_profiler.o sdcard_profiler.c   
+	
+${OBJECTDIR}/sdcard_mount.o: sdcard_mount.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/sdcard_mount.o.d 
+	@${RM} ${OBJECTDIR}/sdcard_mount.o 
+	@${FIXDEPS} "${OBJECTDIR}/sdcard_mount.o.d" $(SILENT) -rsi ${MP_CC_DIR}../  -c ${MP_CC}  $(MP_EXTRA_CC_PRE) -g -D__DEBUG -D__MPLAB_DEBUGGER_PK3=1 -fframe-base-loclist  -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -MMD -MF "${OBJECTDIR}/sdcard_mount.o.d" -o ${OBJECTDIR}/sdcard_mount.o sdcard_mount.c   
+	
 ${OBJECTDIR}/source_template.o: source_template.c  nbproject/Makefile-${CND_CONF}.mk
 	@${MKDIR} "${OBJECTDIR}" 
 	@${RM} ${OBJECTDIR}/source_template.o.d 
@@ -252,12 +306,42 @@ ${OBJECTDIR}/spi.o: spi.c  nbproject/Makefile-${CND_CONF}.mk
 	@${RM} ${OBJECTDIR}/spi.o 
 	@${FIXDEPS} "${OBJECTDIR}/spi.o.d" $(SILENT) -rsi ${MP_CC_DIR}../  -c ${MP_CC}  $(MP_EXTRA_CC_PRE)  -g -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -MMD -MF "${OBJECTDIR}/spi.o.d" -o ${OBJECTDIR}/spi.o spi.c   
 	
+${OBJECTDIR}/spi_bus.o: spi_bus.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/spi_bus.o.d 
+	@${RM} ${OBJECTDIR}/spi_bus.o 
+	@${FIXDEPS} "${OBJECTDIR}/spi_bus.o.d" $(SILENT) -rsi ${MP_CC_DIR}../  -c ${MP_CC}  $(MP_EXTRA_CC_PRE)  -g -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -MMD -MF "${OBJECTDIR}/spi_bus.o.d" -o ${OBJECTDIR}/spi_bus.o spi_bus.c   
+	
+${OBJECTDIR}/dsp_link.o: dsp_link.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/dsp_link.o.d 
+	@${RM} ${OBJECTDIR}/dsp_link.o 
+	@${FIXDEPS} "${OBJECTDIR}/dsp_link.o.d" $(SILENT) -rsi ${MP_CC_DIR}../  -c ${MP_CC}  $(MP_EXTRA_CC_PRE)  -g -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -MMD -MF "${OBJECTDIR}/dsp_link.o.d" -o ${OBJECTDIR}/dsp_link.o dsp_link.c   
+	
+${OBJECTDIR}/dsp_events.o: dsp_events.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/dsp_events.o.d 
+	@${RM} ${OBJECTDIR}/dsp_events.o 
+	@${FIXDEPS} "${OBJECTDIR}/dsp_events.o.d" $(SILENT) -rsi ${MP_CC_DIR}../  -c ${MP_CC}  $(MP_EXTRA_CC_PRE)  -g -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -MMD -MF "${OBJECTDIR}/dsp_events.o.d" -o ${OBJECTDIR}/dsp_events.o dsp_events.c   
+	
 ${OBJECTDIR}/wait_timer.o: wait_timer.c  nbproject/Makefile-${CND_CONF}.mk
 	@${MKDIR} "${OBJECTDIR}" 
 	@${RM} ${OBJECTDIR}/wait_timer.o.d 
 	@${RM} ${OBJECTDIR}/wait_timer.o 
 	@${FIXDEPS} "${OBJECTDIR}/wait_timer.o.d" $(SILENT) -rsi ${MP_CC_DIR}../  -c ${MP_CC}  $(MP_EXTRA_CC_PRE)  -g -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -MMD -MF "${OBJECTDIR}/wait_timer.o.d" -o ${OBJECTDIR}/wait_timer.o wait_timer.c   
 	
+${OBJECTDIR}/ring_buffer.o: ring_buffer.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/ring_buffer.o.d 
+	@${RM} ${OBJECTDIR}/ring_buffer.o 
+	@${FIXDEPS} "${OBJECTDIR}/ring_buffer.o.d" $(SILENT) -rsi ${MP_CC_DIR}../  -c ${MP_CC}  $(MP_EXTRA_CC_PRE)  -g -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -MMD -MF "${OBJECTDIR}/ring_buffer.o.d" -o ${OBJECTDIR}/ring_buffer.o ring_buffer.c   
+	
+${OBJECTDIR}/crc.o: crc.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/crc.o.d 
+	@${RM} ${OBJECTDIR}/crc.o 
+	@${FIXDEPS} "${OBJECTDIR}/crc.o.d" $(SILENT) -rsi ${MP_CC_DIR}../  -c ${MP_CC}  $(MP_EXTRA_CC_PRE)  -g -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -MMD -MF "${OBJECTDIR}/crc.o.d" -o ${OBJECTDIR}/crc.o crc.c   
+	
 ${OBJECTDIR}/uart.o: uart.c  nbproject/Makefile-${CND_CONF}.mk
 	@${MKDIR} "${OBJECTDIR}" 
 	@${RM} ${OBJECTDIR}/uart.o.d 
@@ -276,6 +360,18 @@ ${OBJECTDIR}/debug_util.o: debug_util.c  nbproject/Makefile-${CND_CONF}.mk
 	@${RM} ${OBJECTDIR}/debug_util.o 
 	@${FIXDEPS} "${OBJECTDIR}/debug_util.o.d" $(SILENT) -rsi ${MP_CC_DIR}../  -c ${MP_CC}  $(MP_EXTRA_CC_PRE)  -g -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -MMD -MF "${OBJECTDIR}/debug_util.o.d" -o ${OBJECTDIR}/debug_util.o debug_util.c   
 	
+${OBJECTDIR}/tunables.o: tunables.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/tunables.o.d 
+	@${RM} ${OBJECTDIR}/tunables.o 
+	@${FIXDEPS} "${OBJECTDIR}/tunables.o.d" $(SILENT) -rsi ${MP_CC_DIR}../  -c ${MP_CC}  $(MP_EXTRA_CC_PRE)  -g -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -MMD -MF "${OBJECTDIR}/tunables.o.d" -o ${OBJECTDIR}/tunables.o tunables.c   
+	
+${OBJECTDIR}/bench.o: bench.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/bench.o.d 
+	@${RM} ${OBJECTDIR}/bench.o 
+	@${FIXDEPS} "${OBJECTDIR}/bench.o.d" $(SILENT) -rsi ${MP_CC_DIR}../  -c ${MP_CC}  $(MP_EXTRA_CC_PRE)  -g -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -MMD -MF "${OBJECTDIR}/bench.o.d" -o ${OBJECTDIR}/bench.o bench.c   
+	
 ${OBJECTDIR}/terminal_help.o: terminal_help.c  nbproject/Makefile-${CND_CONF}.mk
 	@${MKDIR} "${OBJECTDIR}" 
 	@${RM} ${OBJECTDIR}/terminal_help.o.d 
@@ -330,6 +426,18 @@ ${OBJECTDIR}/sdcard.o: sdcard.c  nbproject/Makefile-${CND_CONF}.mk
 	@${RM} ${OBJECTDIR}/sdcard.o 
 	@${FIXDEPS} "${OBJECTDIR}/sdcard.o.d" $(SILENT) -rsi ${MP_CC_DIR}../  -c ${MP_CC}  $(MP_EXTRA_CC_PRE)  -g -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -MMD -MF "${OBJECTDIR}/sdcard.o.d" -o ${OBJECTDIR}/sdcard.o sdcard.c   
 	
+${OBJECTDIR}/sdcard_profiler.o: sdcard_profiler.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/sdcard_profiler.o.d 
+	@${RM} ${OBJECTDIR}/sdcard_profiler.o 
+	@${FIXDEPS} "${OBJECTDIR}/sdcard_profiler.o.d" $(SILENT) -rsi ${MP_CC_DIR}../  -c ${MP_CC}  $(MP_EXTRA_CC_PRE)  -g -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -MMD -MF "${OBJECTDIR}/sdcard_profiler.o.d" -o ${OBJECTDIR}/sdcard_profiler.o sdcard_profiler.c   
+	
+${OBJECTDIR}/sdcard_mount.o: sdcard_mount.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/sdcard_mount.o.d 
+	@${RM} ${OBJECTDIR}/sdcard_mount.o 
+	@${FIXDEPS} "${OBJECTDIR}/sdcard_mount.o.d" $(SILENT) -rsi ${MP_CC_DIR}../  -c ${MP_CC}  $(MP_EXTRA_CC_PRE)  -g -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -MMD -MF "${OBJECTDIR}/sdcard_mount.o.d" -o ${OBJECTDIR}/sdcard_mount.o sdcard_mount.c   
+	
 ${OBJECTDIR}/source_template.o: source_template.c  nbproject/Makefile-${CND_CONF}.mk
 	@${MKDIR} "${OBJECTDIR}" 
 	@${RM} ${OBJECTDIR}/source_template.o.d 
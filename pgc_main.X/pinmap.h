@@ -440,6 +440,10 @@ typedef enum pps_input_source4_t
 
 #define SD_CARD_DETECT_PIN           PORTDbits.RD5
 #define SD_CARD_DETECT_PIN_DIRECTION TRISDbits.TRISD5
+#define SD_CARD_DETECT_PULL_UP       CNPUDbits.CNPUD5
+#define SD_CARD_DETECT_CN_ENABLE     CNENDbits.CNIED5
+// The switch of the socket connects the pin to ground when a card is inserted
+#define SD_CARD_INSERTED             (0 == SD_CARD_DETECT_PIN)
 
 //
 // LCD interface
@@ -472,9 +476,13 @@ typedef enum pps_input_source4_t
 
 #define GPU_MISO_PIN                PORTGbits.G7
 #define GPU_MISO_PIN_DIRECTION      TRISGbits.TRISG7
+#define GPU_MISO_PPS_REGISTER       SDI2R
+#define GPU_MISO_PPS_VALUE          PPS_IN_SRC2_RPG7
 
 #define GPU_MOSI_PIN                LATGbits.LATG8
 #define GPU_MOSI_PIN_DIRECTION      TRISGbits.TRISG8
+#define GPU_MOSI_PPS_REGISTER       RPG8R
+#define GPU_MOSI_PPS_VALUE          PPS_OUT_SRC1_SDO2
 
 #define GPU_CLK_PIN                 LATGbits.LATG6
 #define GPU_CLK_PIN_DIRECTION       TRISGbits.TRISG6
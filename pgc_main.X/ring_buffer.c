@@ -0,0 +1,339 @@
+
+// =============================================================================
+// Include statements
+// =============================================================================
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "ring_buffer.h"
+
+// =============================================================================
+// Private type definitions
+// =============================================================================
+
+// =============================================================================
+// Global variables
+// =============================================================================
+
+// =============================================================================
+// Private constants
+// =============================================================================
+
+//
+// Keeps the compiler from moving buffer accesses past an index update.
+// The PIC32MZ has a single core, so no hardware barrier is needed.
+//
+#define RING_BUFFER_BARRIER()   __asm__ __volatile__("" ::: "memory")
+
+// =============================================================================
+// Private variables
+// =============================================================================
+
+// =============================================================================
+// Private function declarations
+// =============================================================================
+
+/**
+ * @brief Copies elements into the ring buffer and publishes them.
+ * @param ring - the ring buffer.
+ * @param storage - the element array of the ring buffer.
+ * @param element_size - size of one element in bytes.
+ * @param data - the elements to copy.
+ * @param count - number of elements in data.
+ * @return Number of elements pushed.
+ */
+static uint32_t push_bulk(ring_buffer_t* ring,
+                          void* storage,
+                          size_t element_size,
+                          const void* data,
+                          uint32_t count);
+
+/**
+ * @brief Copies elements out of the ring buffer and releases them.
+ * @param ring - the ring buffer.
+ * @param storage - the element array of the ring buffer.
+ * @param element_size - size of one element in bytes.
+ * @param data - where to store the elements.
+ * @param count - maximum number of elements to pop.
+ * @return Number of elements popped.
+ */
+static uint32_t pop_bulk(ring_buffer_t* ring,
+                         const void* storage,
+                         size_t element_size,
+                         void* data,
+                         uint32_t count);
+
+// =============================================================================
+// Public function definitions
+// =============================================================================
+
+bool ring_buffer_init(ring_buffer_t* ring, uint32_t capacity)
+{
+    bool capacity_ok = ((0 != capacity) && (0 == (capacity & (capacity - 1))));
+
+    ring->head = 0;
+    ring->tail = 0;
+    ring->mask = capacity_ok ? (capacity - 1) : 0;
+
+    return capacity_ok;
+}
+
+uint32_t ring_buffer_write_span(const ring_buffer_t* ring, uint32_t* index)
+{
+    uint32_t free_elements = ring_buffer_free(ring);
+    uint32_t until_wrap;
+
+    *index = ring_buffer_tail_index(ring);
+    until_wrap = ring_buffer_capacity(ring) - *index;
+
+    return (free_elements < until_wrap) ? free_elements : until_wrap;
+}
+
+uint32_t ring_buffer_read_span(const ring_buffer_t* ring, uint32_t* index)
+{
+    uint32_t stored_elements = ring_buffer_size(ring);
+    uint32_t until_wrap;
+
+    *index = ring_buffer_head_index(ring);
+    until_wrap = ring_buffer_capacity(ring) - *index;
+
+    return (stored_elements < until_wrap) ? stored_elements : until_wrap;
+}
+
+void ring_buffer_produce(ring_buffer_t* ring, uint32_t count)
+{
+    RING_BUFFER_BARRIER();
+    ring->tail += count;
+}
+
+void ring_buffer_consume(ring_buffer_t* ring, uint32_t count)
+{
+    RING_BUFFER_BARRIER();
+    ring->head += count;
+}
+
+void ring_buffer_retract(ring_buffer_t* ring, uint32_t count)
+{
+    ring->tail -= count;
+}
+
+void ring_buffer_clear(ring_buffer_t* ring)
+{
+    ring->head = ring->tail;
+}
+
+bool ring_buffer_u8_init(ring_buffer_u8_t* rb,
+                         uint8_t* storage,
+                         uint32_t capacity)
+{
+    rb->buffer = storage;
+
+    return ring_buffer_init(&rb->ring, capacity);
+}
+
+bool ring_buffer_u8_push(ring_buffer_u8_t* rb, uint8_t data)
+{
+    bool pushed = false;
+
+    if (!ring_buffer_is_full(&rb->ring))
+    {
+        rb->buffer[ring_buffer_tail_index(&rb->ring)] = data;
+        ring_buffer_produce(&rb->ring, 1);
+        pushed = true;
+    }
+
+    return pushed;
+}
+
+bool ring_buffer_u8_pop(ring_buffer_u8_t* rb, uint8_t* data)
+{
+    bool popped = false;
+
+    if (!ring_buffer_is_empty(&rb->ring))
+    {
+        *data = rb->buffer[ring_buffer_head_index(&rb->ring)];
+        ring_buffer_consume(&rb->ring, 1);
+        popped = true;
+    }
+
+    return popped;
+}
+
+uint8_t ring_buffer_u8_peek(const ring_buffer_u8_t* rb, uint32_t offset)
+{
+    return rb->buffer[(rb->ring.head + offset) & rb->ring.mask];
+}
+
+uint32_t ring_buffer_u8_push_bulk(ring_buffer_u8_t* rb,
+                                  const uint8_t* data,
+                                  uint32_t number_of_bytes)
+{
+    return push_bulk(&rb->ring,
+                     rb->buffer,
+                     sizeof(uint8_t),
+                     data,
+                     number_of_bytes);
+}
+
+uint32_t ring_buffer_u8_pop_bulk(ring_buffer_u8_t* rb,
+                                 uint8_t* data,
+                                 uint32_t number_of_bytes)
+{
+    return pop_bulk(&rb->ring,
+                    rb->buffer,
+                    sizeof(uint8_t),
+                    data,
+                    number_of_bytes);
+}
+
+bool ring_buffer_u32_init(ring_buffer_u32_t* rb,
+                          uint32_t* storage,
+                          uint32_t capacity)
+{
+    rb->buffer = storage;
+
+    return ring_buffer_init(&rb->ring, capacity);
+}
+
+bool ring_buffer_u32_push(ring_buffer_u32_t* rb, uint32_t data)
+{
+    bool pushed = false;
+
+    if (!ring_buffer_is_full(&rb->ring))
+    {
+        rb->buffer[ring_buffer_tail_index(&rb->ring)] = data;
+        ring_buffer_produce(&rb->ring, 1);
+        pushed = true;
+    }
+
+    return pushed;
+}
+
+bool ring_buffer_u32_pop(ring_buffer_u32_t* rb, uint32_t* data)
+{
+    bool popped = false;
+
+    if (!ring_buffer_is_empty(&rb->ring))
+    {
+        *data = rb->buffer[ring_buffer_head_index(&rb->ring)];
+        ring_buffer_consume(&rb->ring, 1);
+        popped = true;
+    }
+
+    return popped;
+}
+
+uint32_t ring_buffer_u32_peek(const ring_buffer_u32_t* rb, uint32_t offset)
+{
+    return rb->buffer[(rb->ring.head + offset) & rb->ring.mask];
+}
+
+uint32_t ring_buffer_u32_push_bulk(ring_buffer_u32_t* rb,
+                                   const uint32_t* data,
+                                   uint32_t number_of_words)
+{
+    return push_bulk(&rb->ring,
+                     rb->buffer,
+                     sizeof(uint32_t),
+                     data,
+                     number_of_words);
+}
+
+uint32_t ring_buffer_u32_pop_bulk(ring_buffer_u32_t* rb,
+                                  uint32_t* data,
+                                  uint32_t number_of_words)
+{
+    return pop_bulk(&rb->ring,
+                    rb->buffer,
+                    sizeof(uint32_t),
+                    data,
+                    number_of_words);
+}
+
+// =============================================================================
+// Private function definitions
+// =============================================================================
+
+static uint32_t push_bulk(ring_buffer_t* ring,
+                          void* storage,
+                          size_t element_size,
+                          const void* data,
+                          uint32_t count)
+{
+    uint32_t index;
+    uint32_t first_chunk_size;
+    uint32_t free_elements = ring_buffer_free(ring);
+    const uint8_t* src = (const uint8_t*)data;
+    uint8_t* dst = (uint8_t*)storage;
+
+    if (count > free_elements)
+    {
+        count = free_elements;
+    }
+
+    //
+    // First chunk from the tail index up to the end of the buffer,
+    // second chunk (if any) from index 0 and forth.
+    //
+    index = ring_buffer_tail_index(ring);
+    first_chunk_size = ring_buffer_capacity(ring) - index;
+
+    if (first_chunk_size > count)
+    {
+        first_chunk_size = count;
+    }
+
+    memcpy(&dst[index * element_size], src, first_chunk_size * element_size);
+
+    if (first_chunk_size != count)
+    {
+        memcpy(dst,
+               &src[first_chunk_size * element_size],
+               (count - first_chunk_size) * element_size);
+    }
+
+    ring_buffer_produce(ring, count);
+
+    return count;
+}
+
+static uint32_t pop_bulk(ring_buffer_t* ring,
+                         const void* storage,
+                         size_t element_size,
+                         void* data,
+                         uint32_t count)
+{
+    uint32_t index;
+    uint32_t first_chunk_size;
+    uint32_t stored_elements = ring_buffer_size(ring);
+    const uint8_t* src = (const uint8_t*)storage;
+    uint8_t* dst = (uint8_t*)data;
+
+    if (count > stored_elements)
+    {
+        count = stored_elements;
+    }
+
+    index = ring_buffer_head_index(ring);
+    first_chunk_size = ring_buffer_capacity(ring) - index;
+
+    if (first_chunk_size > count)
+    {
+        first_chunk_size = count;
+    }
+
+    memcpy(dst, &src[index * element_size], first_chunk_size * element_size);
+
+    if (first_chunk_size != count)
+    {
+        memcpy(&dst[first_chunk_size * element_size],
+               src,
+               (count - first_chunk_size) * element_size);
+    }
+
+    ring_buffer_consume(ring, count);
+
+    return count;
+}
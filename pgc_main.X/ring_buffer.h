@@ -0,0 +1,292 @@
+/*
+ * Single producer, single consumer ring buffers.
+ *
+ * The head index is only written by the consumer and the tail index is only
+ * written by the producer. Both are free running and masked on access, so the
+ * number of stored elements is always tail - head and every slot in the
+ * buffer can be used. The capacity must be a power of two.
+ *
+ * With one producer and one consumer, for example an ISR and the main loop,
+ * no interrupt masking is needed. Buffers with more than one producer or
+ * consumer must serialize the calls on that side themselves.
+ */
+
+#ifndef RING_BUFFER_H
+#define	RING_BUFFER_H
+
+#ifdef	__cplusplus
+//extern "C" {
+#endif
+
+// =============================================================================
+// Include statements
+// =============================================================================
+#include <stdint.h>
+#include <stdbool.h>
+
+// =============================================================================
+// Public type definitions
+// =============================================================================
+
+/*
+ * Index bookkeeping shared by all ring buffer variants. It can also be used on
+ * its own together with an array of any element type, using the head and tail
+ * index functions together with ring_buffer_produce/ring_buffer_consume.
+ */
+typedef struct ring_buffer_t
+{
+    volatile uint32_t head;     // Next element to read, owned by the consumer
+    volatile uint32_t tail;     // Next element to write, owned by the producer
+    uint32_t mask;              // Capacity - 1
+} ring_buffer_t;
+
+typedef struct ring_buffer_u8_t
+{
+    ring_buffer_t ring;
+    uint8_t* buffer;
+} ring_buffer_u8_t;
+
+typedef struct ring_buffer_u32_t
+{
+    ring_buffer_t ring;
+    uint32_t* buffer;
+} ring_buffer_u32_t;
+
+// =============================================================================
+// Global constatants
+// =============================================================================
+
+// =============================================================================
+// Global variable declarations
+// =============================================================================
+
+// =============================================================================
+// Public function declarations
+// =============================================================================
+
+/**
+ * @brief Initializes the index bookkeeping of a ring buffer.
+ * @param ring - the ring buffer to initialize.
+ * @param capacity - number of elements, must be a power of two.
+ * @return false if the capacity is not a power of two.
+ */
+bool ring_buffer_init(ring_buffer_t* ring, uint32_t capacity);
+
+/**
+ * @brief Gets the number of elements stored in the ring buffer.
+ */
+static inline uint32_t ring_buffer_size(const ring_buffer_t* ring)
+{
+    return ring->tail - ring->head;
+}
+
+/**
+ * @brief Gets the maximum number of elements the ring buffer can hold.
+ */
+static inline uint32_t ring_buffer_capacity(const ring_buffer_t* ring)
+{
+    return ring->mask + 1;
+}
+
+/**
+ * @brief Gets the number of elements which can be produced right now.
+ */
+static inline uint32_t ring_buffer_free(const ring_buffer_t* ring)
+{
+    return ring_buffer_capacity(ring) - ring_buffer_size(ring);
+}
+
+/**
+ * @brief Checks if the ring buffer is empty.
+ */
+static inline bool ring_buffer_is_empty(const ring_buffer_t* ring)
+{
+    return (ring->tail == ring->head);
+}
+
+/**
+ * @brief Checks if the ring buffer is full.
+ */
+static inline bool ring_buffer_is_full(const ring_buffer_t* ring)
+{
+    return (0 == ring_buffer_free(ring));
+}
+
+/**
+ * @brief Gets the array index of the oldest element (the next to consume).
+ */
+static inline uint32_t ring_buffer_head_index(const ring_buffer_t* ring)
+{
+    return ring->head & ring->mask;
+}
+
+/**
+ * @brief Gets the array index of the next element to produce.
+ */
+static inline uint32_t ring_buffer_tail_index(const ring_buffer_t* ring)
+{
+    return ring->tail & ring->mask;
+}
+
+/**
+ * @brief Gets the contiguous free area starting at the tail index.
+ * @details Producer side. Fill the area and publish it with
+ *          ring_buffer_produce(). A second call after producing returns the
+ *          area after the wrap point.
+ * @param ring - the ring buffer.
+ * @param index - set to the array index of the first free element.
+ * @return Number of contiguous free elements starting at index.
+ */
+uint32_t ring_buffer_write_span(const ring_buffer_t* ring, uint32_t* index);
+
+/**
+ * @brief Gets the contiguous stored area starting at the head index.
+ * @details Consumer side. Release the area with ring_buffer_consume().
+ * @param ring - the ring buffer.
+ * @param index - set to the array index of the oldest element.
+ * @return Number of contiguous stored elements starting at index.
+ */
+uint32_t ring_buffer_read_span(const ring_buffer_t* ring, uint32_t* index);
+
+/**
+ * @brief Publishes elements written at the tail to the consumer.
+ * @details Producer side. The elements must already be in the buffer.
+ * @param ring - the ring buffer.
+ * @param count - number of elements to publish, at most ring_buffer_free().
+ */
+void ring_buffer_produce(ring_buffer_t* ring, uint32_t count);
+
+/**
+ * @brief Releases elements at the head back to the producer.
+ * @details Consumer side.
+ * @param ring - the ring buffer.
+ * @param count - number of elements to release, at most ring_buffer_size().
+ */
+void ring_buffer_consume(ring_buffer_t* ring, uint32_t count);
+
+/**
+ * @brief Takes back the most recently produced elements.
+ * @details Producer side. Only safe while the consumer can not run, e.g. from
+ *          an ISR when the consumer is the main loop.
+ * @param ring - the ring buffer.
+ * @param count - number of elements to take back, at most ring_buffer_size().
+ */
+void ring_buffer_retract(ring_buffer_t* ring, uint32_t count);
+
+/**
+ * @brief Discards all stored elements.
+ * @details Consumer side.
+ * @param ring - the ring buffer.
+ */
+void ring_buffer_clear(ring_buffer_t* ring);
+
+/**
+ * @brief Initializes a byte ring buffer.
+ * @param rb - the ring buffer to initialize.
+ * @param storage - array of capacity bytes used to store the data.
+ * @param capacity - number of bytes in storage, must be a power of two.
+ * @return false if the capacity is not a power of two.
+ */
+bool ring_buffer_u8_init(ring_buffer_u8_t* rb,
+                         uint8_t* storage,
+                         uint32_t capacity);
+
+/**
+ * @brief Pushes one byte.
+ * @return false if the ring buffer was full.
+ */
+bool ring_buffer_u8_push(ring_buffer_u8_t* rb, uint8_t data);
+
+/**
+ * @brief Pops one byte.
+ * @param data - where to store the popped byte.
+ * @return false if the ring buffer was empty.
+ */
+bool ring_buffer_u8_pop(ring_buffer_u8_t* rb, uint8_t* data);
+
+/**
+ * @brief Gets a stored byte without removing it.
+ * @param offset - offset from the oldest byte, less than the size.
+ * @return The byte.
+ */
+uint8_t ring_buffer_u8_peek(const ring_buffer_u8_t* rb, uint32_t offset);
+
+/**
+ * @brief Pushes as many bytes as there is room for.
+ * @details Copies with at most two memcpy calls and publishes once.
+ * @param data - the bytes to push.
+ * @param number_of_bytes - number of bytes in data.
+ * @return Number of bytes pushed.
+ */
+uint32_t ring_buffer_u8_push_bulk(ring_buffer_u8_t* rb,
+                                  const uint8_t* data,
+                                  uint32_t number_of_bytes);
+
+/**
+ * @brief Pops up to the given number of bytes.
+ * @details Copies with at most two memcpy calls and releases once.
+ * @param data - where to store the popped bytes.
+ * @param number_of_bytes - maximum number of bytes to pop.
+ * @return Number of bytes popped.
+ */
+uint32_t ring_buffer_u8_pop_bulk(ring_buffer_u8_t* rb,
+                                 uint8_t* data,
+                                 uint32_t number_of_bytes);
+
+/**
+ * @brief Initializes a 32 bit word ring buffer.
+ * @param rb - the ring buffer to initialize.
+ * @param storage - array of capacity words used to store the data.
+ * @param capacity - number of words in storage, must be a power of two.
+ * @return false if the capacity is not a power of two.
+ */
+bool ring_buffer_u32_init(ring_buffer_u32_t* rb,
+                          uint32_t* storage,
+                          uint32_t capacity);
+
+/**
+ * @brief Pushes one word.
+ * @return false if the ring buffer was full.
+ */
+bool ring_buffer_u32_push(ring_buffer_u32_t* rb, uint32_t data);
+
+/**
+ * @brief Pops one word.
+ * @param data - where to store the popped word.
+ * @return false if the ring buffer was empty.
+ */
+bool ring_buffer_u32_pop(ring_buffer_u32_t* rb, uint32_t* data);
+
+/**
+ * @brief Gets a stored word without removing it.
+ * @param offset - offset from the oldest word, less than the size.
+ * @return The word.
+ */
+uint32_t ring_buffer_u32_peek(const ring_buffer_u32_t* rb, uint32_t offset);
+
+/**
+ * @brief Pushes as many words as there is room for.
+ * @param data - the words to push.
+ * @param number_of_words - number of words in data.
+ * @return Number of words pushed.
+ */
+uint32_t ring_buffer_u32_push_bulk(ring_buffer_u32_t* rb,
+                                   const uint32_t* data,
+                                   uint32_t number_of_words);
+
+/**
+ * @brief Pops up to the given number of words.
+ * @param data - where to store the popped words.
+ * @param number_of_words - maximum number of words to pop.
+ * @return Number of words popped.
+ */
+uint32_t ring_buffer_u32_pop_bulk(ring_buffer_u32_t* rb,
+                                  uint32_t* data,
+                                  uint32_t number_of_words);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* RING_BUFFER_H */
+
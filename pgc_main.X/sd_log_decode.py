@@ -0,0 +1,101 @@
+# This script decodes the SD card operation log ASYNCFAT.LOG which asyncfatfs
+# writes when built with AFATFS_USE_INTROSPECTIVE_LOGGING.
+#
+# The log is a series of 16 byte little endian records:
+#
+#   byte 0      operation, 0 read, 1 write, 2 erase
+#   bytes 1-3   reserved
+#   bytes 4-7   block index
+#   bytes 8-11  duration in microseconds
+#   bytes 12-15 reserved
+#
+# Usage: python sd_log_decode.py ASYNCFAT.LOG [--records]
+#
+# Prints the same statistics and log-scale histograms as the "get sd profile"
+# terminal command, and every record with --records.
+
+import struct
+import sys
+
+RECORD_SIZE = 16
+NBR_OF_BUCKETS = 20
+MAX_BAR_LENGTH = 40
+OPERATION_NAMES = ["read", "write", "erase"]
+
+class Operation_statistics:
+
+    # @brief Creates empty statistics of one operation type
+    def __init__(self):
+        self.durations = []
+        self.buckets = [0] * NBR_OF_BUCKETS
+
+    # @brief Adds one operation
+    # @param us - The duration of the operation in microseconds
+    def add(self, us):
+        self.durations.append(us)
+        bucket = 0 if us < 2 else us.bit_length() - 1
+        self.buckets[min(bucket, NBR_OF_BUCKETS - 1)] += 1
+
+    # @brief Prints the statistics and the histogram
+    # @param name - The name of the operation type
+    def print_summary(self, name):
+        if not self.durations:
+            print("%s: 0 ok" % name)
+            return
+
+        ordered = sorted(self.durations)
+        print("%s: %u ok, min %u us, mean %u us, median %u us, 99%% %u us, max %u us" % (
+            name,
+            len(ordered),
+            ordered[0],
+            sum(ordered) // len(ordered),
+            ordered[len(ordered) // 2],
+            ordered[min(len(ordered) - 1, (len(ordered) * 99) // 100)],
+            ordered[-1]))
+
+        fullest = max(self.buckets)
+        for i, count in enumerate(self.buckets):
+            if count == 0:
+                continue
+            bar = "#" * max(1, (count * MAX_BAR_LENGTH) // fullest)
+            low = 0 if i == 0 else (1 << i)
+            high = "" if i == NBR_OF_BUCKETS - 1 else "%7u" % ((2 << i) - 1)
+            print("    %7u us - %7s : %8u %s" % (low, high, count, bar))
+
+# @brief Reads the records of a log file
+# @param filename - The log file
+# @return A list of (operation, block index, duration) tuples
+def read_records(filename):
+    records = []
+    with open(filename, "rb") as f:
+        data = f.read()
+
+    for offset in range(0, len(data) - RECORD_SIZE + 1, RECORD_SIZE):
+        operation, block_index, duration = struct.unpack_from("<B3xII", data, offset)
+        records.append((operation, block_index, duration))
+
+    return records
+
+# ===============================================================================
+# Main
+# ===============================================================================
+
+if __name__ == "__main__":
+    if len(sys.argv) < 2:
+        print("Usage: python sd_log_decode.py ASYNCFAT.LOG [--records]")
+        sys.exit(1)
+
+    records = read_records(sys.argv[1])
+    statistics = [Operation_statistics() for name in OPERATION_NAMES]
+
+    for operation, block_index, duration in records:
+        if "--records" in sys.argv:
+            name = OPERATION_NAMES[operation] if operation < len(OPERATION_NAMES) else str(operation)
+            print("%-5s block %10u %8u us" % (name, block_index, duration))
+
+        if operation < len(OPERATION_NAMES):
+            statistics[operation].add(duration)
+
+    print("%u records" % len(records))
+    for name, operation_statistics in zip(OPERATION_NAMES, statistics):
+        operation_statistics.print_summary(name)
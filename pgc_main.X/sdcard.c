@@ -14,9 +14,19 @@
 // =============================================================================
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <xc.h>
 
 #include "sdcard.h"
 #include "spi.h"
+#include "spi_bus.h"
+#include "crc.h"
+#include "sdcard_profiler.h"
+#include "mcu.h"
+#include "tunables.h"
 #include "uart.h"
 #include "debug_util.h"
 #include "pinmap.h"
@@ -105,6 +115,30 @@ typedef enum response_type_t
     R7
 } response_type_t;
 
+typedef enum sdcard_state_t
+{
+    SDCARD_STATE_NOT_READY,         // Not initialized or no card
+    SDCARD_STATE_READY,             // Idle, ready for a new operation
+    SDCARD_STATE_WAITING_FOR_DATA,  // Read sent, waiting for the start token
+    SDCARD_STATE_RECEIVING,         // DMA receiving a block
+    SDCARD_STATE_SENDING,           // DMA sending a block
+    SDCARD_STATE_PROGRAMMING,       // Block sent, waiting while the card is busy
+    SDCARD_STATE_STOPPING           // Stream stopped, waiting while the card is busy
+} sdcard_state_t;
+
+// The block operation in progress
+typedef struct block_operation_t
+{
+    sdcardBlockOperation_e operation;
+    uint32_t block_index;
+    uint8_t* buffer;
+    sdcard_operationCompleteCallback_c callback;
+    uint32_t callback_data;
+    uint32_t start_count;           // Core timer when the operation started
+    uint32_t state_count;           // Core timer when the state was entered
+    uint32_t retries;               // Reads repeated after CRC errors
+} block_operation_t;
+
 // =============================================================================
 // Global variables
 // =============================================================================
@@ -143,13 +177,209 @@ typedef enum command_t
     CMD_READ_OCR               = 58,
     CMD_CRC_ON_OFF             = 59,
     ACMD_SD_STATUS             = 13,
+    ACMD_SET_WR_BLK_ERASE_COUNT = 23,
     ACMD_SD_SEND_OP_COND       = 41
 } command_t;
 
+// The core timer is incremented every other system clock cycle
+#define CORE_TIMER_FREQ_HZ          (SYSCLK_FREQ_HZ / 2)
+#define CORE_TIMER_TICKS_PER_US     (CORE_TIMER_FREQ_HZ / 1000000u)
+
+#define BLOCK_SIZE                  (512u)
+
+// SPI clock while the card is initialized, 100 to 400 kHz
+#define SD_INIT_CLOCK_HZ            (200000u)
+
+// The SPI baud rate generator can divide the peripheral bus clock by 2 at most
+#define SPI_FASTEST_CLOCK_HZ        (PBCLK_FREQ_HZ / 2)
+
+// Cards which do not report a TRAN_SPEED are run at the default speed
+#define DEFAULT_SPEED_CLOCK_HZ      (25000000u)
+
+#define DEFAULT_MAX_CLOCK_HZ        (50000000u)
+
+// Block operations without errors before a lowered clock is raised a step
+#define DEFAULT_CLOCK_RECOVERY      (1000u)
+
+#define DATA_START_TOKEN            (0xFE)
+
+// Tokens of a CMD25 multiple block write
+#define WRITE_MULTIPLE_TOKEN        (0xFC)
+#define STOP_TRAN_TOKEN             (0xFD)
+
+// ACMD23 takes a 23 bit block count
+#define MAX_PRE_ERASE_BLOCKS        (0x7FFFFFu)
+
+// A read error token has the upper four bits cleared
+#define DATA_ERROR_TOKEN_MASK       (0xF0)
+
+// The card answers a data block with xxx0sss1, sss = 010 when accepted
+#define DATA_RESPONSE_MASK          (0x1F)
+#define DATA_RESPONSE_ACCEPTED      (0x05)
+#define DATA_RESPONSE_CRC_ERROR     (0x0B)
+
+// The card received a command with a bad CRC
+#define R1_COM_CRC_ERROR            (0x08)
+
+// Times a block with a bad CRC is read again before the read fails
+#define MAX_READ_RETRIES            (2u)
+
+// Bytes clocked per sdcard_poll() while waiting for a token or the card
+#define POLL_BYTES                  (8u)
+
+// Longest a card may take, from the SD specification part 1, 4.6.2
+#define READ_TIMEOUT_TICKS          (CORE_TIMER_FREQ_HZ / 10)
+#define WRITE_TIMEOUT_TICKS         (CORE_TIMER_FREQ_HZ / 2)
+
+// Longest a card may take to leave the idle state after the first ACMD41,
+// from the SD specification part 1, 4.2.3
+#define IDLE_TIMEOUT_TICKS          (CORE_TIMER_FREQ_HZ)
+
+// No block follows the last one read
+#define NO_BLOCK                    (0xFFFFFFFFu)
+
+// CMD8 argument echo, voltage range 2.7-3.6 V and the check pattern
+#define IF_COND_VOLTAGE_OK          (0x01)
+#define IF_COND_CHECK_PATTERN       (0xAA)
+
+// OCR bits, HCS in the ACMD41 argument is the same bit as CCS
+#define OCR_POWER_UP_DONE           (0x80000000u)
+#define OCR_CCS                     (0x40000000u)
+#define OCR_HCS                     (0x40000000u)
+
+#define CID_SIZE                    (16u)
+
+// Bytes to clock while waiting for a data start token
+#define DATA_TOKEN_TIMEOUT          (10000)
+
+#define CSD_SIZE                    (16u)
+#define SWITCH_STATUS_SIZE          (64u)
+
+// CMD6 arguments, check or switch function group 1 to function 1, high speed
+#define SWITCH_CHECK_HIGH_SPEED     (0x00FFFFF1u)
+#define SWITCH_SET_HIGH_SPEED       (0x80FFFFF1u)
+
 // =============================================================================
 // Private variables
 // =============================================================================
 
+// Clock of the SPI bus to the card right now
+static uint32_t sd_clock_hz = SD_INIT_CLOCK_HZ;
+
+// Clock the card supports according to its CSD register
+static uint32_t card_max_clock_hz = 0;
+
+// Fastest clock allowed by the card and sd.max_clock
+static uint32_t clock_limit_hz = SD_INIT_CLOCK_HZ;
+
+static bool high_speed_enabled = false;
+static uint32_t nbr_of_clock_step_downs = 0;
+static uint32_t nbr_of_clock_step_ups = 0;
+
+// Block operations since the last CRC error
+static uint32_t nbr_of_clean_operations = 0;
+
+// Standard capacity cards are addressed in bytes instead of blocks
+static bool high_capacity = false;
+
+static sdcardMetadata_t metadata;
+
+static sdcard_state_t state = SDCARD_STATE_NOT_READY;
+static block_operation_t current_operation;
+
+// Set by the DMA ISR when the data block has been exchanged
+static volatile bool block_transfer_done = false;
+
+// CRC of the block being written
+static uint16_t write_crc;
+
+static sdcard_profilerCallback_c profiler_callback = NULL;
+
+static uint32_t nbr_of_failed_operations = 0;
+static uint32_t nbr_of_crc_errors = 0;
+static uint32_t nbr_of_read_retries = 0;
+
+// Read again once the card has stopped streaming
+static bool retry_read_pending = false;
+
+// A CMD18 read is open and the card is streaming from next_read_block
+static bool read_stream_open = false;
+
+// Block after the last block read, a read of it continues the sequence
+static uint32_t next_read_block = NO_BLOCK;
+
+static uint32_t nbr_of_read_streams = 0;
+static uint32_t nbr_of_streamed_blocks = 0;
+
+// A CMD25 write is open and the card expects next_write_block
+static bool write_stream_open = false;
+static uint32_t next_write_block = NO_BLOCK;
+
+static uint32_t nbr_of_write_streams = 0;
+static uint32_t nbr_of_streamed_writes = 0;
+
+// Tunables
+static uint32_t max_clock_hz = DEFAULT_MAX_CLOCK_HZ;
+static uint32_t use_high_speed = true;
+static uint32_t stream_reads = true;
+static uint32_t check_crc = true;
+static uint32_t clock_recovery = DEFAULT_CLOCK_RECOVERY;
+
+static const tunable_t max_clock_tunable =
+{
+    "sd.max_clock",
+    TUNABLE_TYPE_UINT32,
+    &max_clock_hz,
+    SD_INIT_CLOCK_HZ,
+    SPI_FASTEST_CLOCK_HZ,
+    NULL,
+    NULL
+};
+
+static const tunable_t high_speed_tunable =
+{
+    "sd.high_speed",
+    TUNABLE_TYPE_BOOL,
+    &use_high_speed,
+    0,
+    1,
+    NULL,
+    NULL
+};
+
+static const tunable_t crc_tunable =
+{
+    "sd.crc",
+    TUNABLE_TYPE_BOOL,
+    &check_crc,
+    0,
+    1,
+    NULL,
+    NULL
+};
+
+static const tunable_t stream_reads_tunable =
+{
+    "sd.stream_reads",
+    TUNABLE_TYPE_BOOL,
+    &stream_reads,
+    0,
+    1,
+    NULL,
+    NULL
+};
+
+static const tunable_t clock_recovery_tunable =
+{
+    "sd.clock_recovery",
+    TUNABLE_TYPE_UINT32,
+    &clock_recovery,
+    1,
+    1000000,
+    NULL,
+    NULL
+};
+
 // =============================================================================
 // Private function declarations
 // =============================================================================
@@ -165,6 +395,179 @@ typedef enum command_t
 static response_type_t send_command_blocking(uint8_t cmd_number,
                                              uint32_t arg,
                                              response_t* response);
+
+/**
+ * @brief Sends the six bytes of a command frame.
+ * @details The card must be selected.
+ */
+static void send_command_frame(uint8_t cmd_number, uint32_t arg);
+
+/**
+ * @brief Clocks the bus until the card sends the first byte of a response.
+ * @param first_byte - where to store the first byte of the response.
+ * @return false on timeout.
+ */
+static bool wait_for_response(uint8_t* first_byte);
+
+/**
+ * @brief Sends a command which is answered with a data block and reads it.
+ * @details This is a blocking operation. Checks the CRC of the data block.
+ * @param cmd_number - The command number.
+ * @param arg - The command argument.
+ * @param data - Where to store the data block.
+ * @param number_of_bytes - Size of the data block.
+ * @return false if the card did not answer or the data was corrupt.
+ */
+static bool read_data_blocking(uint8_t cmd_number,
+                               uint32_t arg,
+                               uint8_t data[],
+                               uint32_t number_of_bytes);
+
+/**
+ * @brief Selects the card and sends a command of a block operation.
+ * @details Deselects the card again if the command fails.
+ * @return true if the card accepted the command.
+ */
+static bool start_block_command(uint8_t cmd_number, uint32_t block_index);
+
+/**
+ * @brief Advances a block read, see sdcard_poll.
+ */
+static void continue_read(void);
+
+/**
+ * @brief Advances a block write, see sdcard_poll.
+ */
+static void continue_write(void);
+
+/**
+ * @brief Sends CMD12 to end the open CMD18 read.
+ * @details sdcard_poll waits for the card to finish and deselects it.
+ */
+static void stop_read_stream(void);
+
+/**
+ * @brief Ends the open CMD25 write.
+ * @details sdcard_poll waits for the card to finish and deselects it.
+ * @param after_error - true to stop with CMD12 after a rejected block, false
+ *        to stop with the Stop Tran token.
+ */
+static void stop_write_stream(bool after_error);
+
+/**
+ * @brief Waits for the card to leave the busy state after a stream has been
+ *        stopped, see sdcard_poll.
+ */
+static void continue_stop(void);
+
+/**
+ * @brief Tells the card how many blocks to pre-erase with ACMD23.
+ * @return true if the card accepted the command.
+ */
+static bool set_pre_erase_count(uint32_t nbr_of_blocks);
+
+/**
+ * @brief Reads the block of the operation in progress again.
+ * @details Ends an open stream first and reads the block with CMD17.
+ */
+static void retry_read(void);
+
+/**
+ * @brief Sends CMD17 for the block of the operation in progress.
+ */
+static void restart_read(void);
+
+/**
+ * @brief Ends the operation in progress and calls its callbacks.
+ * @param success - false if the operation failed.
+ */
+static void finish_operation(bool success);
+
+/**
+ * @brief Called from the DMA ISR when a data block has been exchanged.
+ */
+static void block_transfer_complete(int32_t arg);
+
+/**
+ * @brief Queues the exchange of one data block with the card.
+ * @details The card stays selected when the block is done, for the CRC
+ *          and the response that follow. block_transfer_done is set from
+ *          the DMA ISR when the block has been exchanged.
+ * @param tx_data - the block to send, or NULL to send 0xFF.
+ * @param rx_data - where to store the received block, or NULL.
+ * @return false if the transfer could not be queued.
+ */
+static bool start_block_transfer(const uint8_t* tx_data, uint8_t* rx_data);
+
+/**
+ * @brief Asserts the chip select and holds the SPI bus for the card.
+ */
+static void select_card(void);
+
+/**
+ * @brief Releases the chip select and the SPI bus.
+ */
+static void deselect_card(void);
+
+/**
+ * @brief Enters a new state of the operation in progress.
+ */
+static void enter_state(sdcard_state_t new_state);
+
+/**
+ * @brief Checks if the current state has lasted longer than timeout_ticks.
+ */
+static bool state_timed_out(uint32_t timeout_ticks);
+
+/**
+ * @brief Reads the card speed from the CSD register and switches to high
+ *        speed mode if possible, then sets the fastest clock allowed.
+ */
+static void select_clock(void);
+
+/**
+ * @brief Reads the CID and CSD registers into the card metadata.
+ * @return false if a register could not be read.
+ */
+static bool read_card_registers(void);
+
+/**
+ * @brief Gets the capacity in 512 byte blocks from the CSD register.
+ * @return The number of blocks, or 0 for an unknown CSD structure.
+ */
+static uint32_t decode_capacity(const uint8_t csd[]);
+
+/**
+ * @brief Decodes the TRAN_SPEED field of the CSD register.
+ * @return The maximum clock in Hz, or 0 if the field is invalid.
+ */
+static uint32_t decode_tran_speed(uint8_t tran_speed);
+
+/**
+ * @brief Finds the fastest clock the baud rate generator can make.
+ * @param limit_hz - the clock must not be faster than this.
+ */
+static uint32_t fastest_clock_at_most(uint32_t limit_hz);
+
+/**
+ * @brief Sets the clock of the SPI bus to the card.
+ */
+static void set_clock(uint32_t clock_hz);
+
+/**
+ * @brief Checks that a block buffer meets SDCARD_BUFFER_ALIGNMENT.
+ * @details Prints an error if it doesn't, DMA into it would corrupt the
+ *          variables sharing its first and last cache lines.
+ */
+static bool buffer_is_aligned(const uint8_t* buffer);
+
+/**
+ * @brief Counts a block operation without errors.
+ * @details Raises a lowered clock by one step of the baud rate generator
+ *          after sd.clock_recovery of them.
+ */
+static void count_clean_operation(void);
+
 // =============================================================================
 // Public function definitions
 // =============================================================================
@@ -175,11 +578,21 @@ static response_type_t send_command_blocking(uint8_t cmd_number,
  * 1.   11x8 clock pulses with CS high
  * 2.   Send CMD0
  * 3.   Send CMD8
- * 4.   Send ACMD41 until in idle state
+ * 4.   Send ACMD41 until in idle state, with HCS set if the card answered
+ *      CMD8 and so is a version 2.00 or later card
+ * 5.   Send CMD59 to turn CRC checking on or off
+ * 6.   Read the OCR with CMD58, the CCS bit tells if the card is high
+ *      capacity (SDHC/SDXC) and addressed in blocks
+ * 7.   Set the block length of standard capacity cards to 512 bytes
+ * 8.   Select the clock, then read the CID and CSD registers
  */
 bool sdcard_init(void)
 {
     uint32_t i;
+    uint32_t ocr;
+    uint32_t start_count;
+    bool version_2_card;
+    bool usable = true;
     response_t response;
     memset(&response, 0xFF, sizeof(response_t));
 
@@ -188,45 +601,248 @@ bool sdcard_init(void)
 
     spi_init(SPI_DEVICE_SDCARD);
 
+    tunables_register(&max_clock_tunable);
+    tunables_register(&high_speed_tunable);
+    tunables_register(&stream_reads_tunable);
+    tunables_register(&crc_tunable);
+    tunables_register(&clock_recovery_tunable);
+
+    high_speed_enabled = false;
+    clock_limit_hz = SD_INIT_CLOCK_HZ;
+    set_clock(SD_INIT_CLOCK_HZ);
+
     for (i = 0; i != 10; ++i)
     {
-        SD_CARD_SS_OFF;
+        deselect_card();
         spi_byte_tranceive_blocking(SPI_DEVICE_SDCARD, 0xFF);
     }
 
+    state = SDCARD_STATE_NOT_READY;
+    read_stream_open = false;
+    next_read_block = NO_BLOCK;
+    write_stream_open = false;
+    next_write_block = NO_BLOCK;
+    memset(&metadata, 0, sizeof(metadata));
+
     (void)send_command_blocking(CMD_GO_IDLE_STATE, 0,&response);
 
-    (void)send_command_blocking(CMD_SEND_IF_COND, 0x000001AA, &response);
+    // 2.7-3.6 V and the check pattern 0xAA
+    memset(&response, 0xFF, sizeof(response_t));
+    version_2_card =
+        (R7 == send_command_blocking(CMD_SEND_IF_COND, 0x000001AA, &response)) &&
+        !response.r1.illegal_command;
 
+    if (version_2_card &&
+        ((IF_COND_VOLTAGE_OK != (response.r7.byte_4 & 0x0F)) ||
+         (IF_COND_CHECK_PATTERN != response.r7.byte_5)))
+    {
+        sprintf(g_debug_util_char_buffer,
+                "%s - SD card rejected the supply voltage%s",
+                ERROR_TAG, NEWLINE);
+        uart_write_string(g_debug_util_char_buffer);
+        usable = false;
+    }
 
-    i = 0;
-    while (response.r1.in_idle_state && (50 != i++))
+    start_count = _CP0_GET_COUNT();
+    while (usable && response.r1.in_idle_state &&
+           ((_CP0_GET_COUNT() - start_count) < IDLE_TIMEOUT_TICKS))
     {
         memset(&response, 0xFF, sizeof(response_t));
         (void)send_command_blocking(CMD_APP_CMD, 0, &response);
 
         memset(&response, 0xFF, sizeof(response_t));
         (void)send_command_blocking(ACMD_SD_SEND_OP_COND,
-                                    0x40000000, // Supports SDHC and SDXC
+                                    version_2_card ? OCR_HCS : 0,
                                     &response);
         wait_timer_us(1000);
     }
 
-    if (response.r1.in_idle_state)
+    if (usable && response.r1.in_idle_state)
     {
-        // No SD card of v2.0 or later found.
         sprintf(g_debug_util_char_buffer,
-                "%s - SD card could not enter idle state%s",
+                "%s - SD card could not leave idle state%s",
                 ERROR_TAG, NEWLINE);
         uart_write_string(g_debug_util_char_buffer);
+        usable = false;
+    }
+
+    if (usable)
+    {
+        // The card checks the CRC of commands and written blocks in SPI mode
+        // only when enabled. Read blocks are checked here under the same
+        // tunable.
+        memset(&response, 0xFF, sizeof(response_t));
+        (void)send_command_blocking(CMD_CRC_ON_OFF,
+                                    check_crc ? 1 : 0,
+                                    &response);
+
+        high_capacity = false;
+
+        if (version_2_card)
+        {
+            memset(&response, 0xFF, sizeof(response_t));
+            usable = (R3 == send_command_blocking(CMD_READ_OCR, 0, &response)) &&
+                     (0 == response.r1.r1);
+
+            ocr = ((uint32_t)response.r7.byte_2 << 24) |
+                  ((uint32_t)response.r7.byte_3 << 16) |
+                  ((uint32_t)response.r7.byte_4 << 8) |
+                  response.r7.byte_5;
+
+            // CCS is only valid once the card has powered up
+            high_capacity = usable &&
+                            (0 != (ocr & OCR_POWER_UP_DONE)) &&
+                            (0 != (ocr & OCR_CCS));
+        }
+
+        if (usable && !high_capacity)
+        {
+            memset(&response, 0xFF, sizeof(response_t));
+            usable = (R1 == send_command_blocking(CMD_SET_BLOCKLEN,
+                                                  BLOCK_SIZE,
+                                                  &response)) &&
+                     (0 == response.r1.r1);
+        }
+
+        if (!usable)
+        {
+            sprintf(g_debug_util_char_buffer,
+                    "%s - SD card did not accept its setup%s",
+                    ERROR_TAG, NEWLINE);
+            uart_write_string(g_debug_util_char_buffer);
+        }
+    }
+
+    if (usable)
+    {
+        select_clock();
+
+        if (read_card_registers())
+        {
+            state = SDCARD_STATE_READY;
+        }
+    }
+
+    return (SDCARD_STATE_READY == state);
+}
+
+void sdcard_card_removed(void)
+{
+    // A DMA transfer in progress runs to its end on its own, its data and
+    // the callback of the operation are dropped.
+    state = SDCARD_STATE_NOT_READY;
+    current_operation.callback = NULL;
+    retry_read_pending = false;
+    read_stream_open = false;
+    next_read_block = NO_BLOCK;
+    write_stream_open = false;
+    next_write_block = NO_BLOCK;
+    memset(&metadata, 0, sizeof(metadata));
+
+    deselect_card();
+}
+
+void sdcard_clock_step_down(void)
+{
+    uint32_t slower_clock_hz = fastest_clock_at_most(sd_clock_hz - 1);
+
+    nbr_of_clean_operations = 0;
+
+    if (slower_clock_hz >= SD_INIT_CLOCK_HZ)
+    {
+        set_clock(slower_clock_hz);
+        ++nbr_of_clock_step_downs;
+
+        sprintf(g_debug_util_char_buffer,
+                "%s - SD card errors, clock lowered to %u Hz%s",
+                WARNING_TAG,
+                (unsigned int)sd_clock_hz,
+                NEWLINE);
+        uart_write_string(g_debug_util_char_buffer);
     }
+}
+
+const sdcardMetadata_t* sdcard_getMetadata(void)
+{
+    return &metadata;
+}
+
+uint32_t sdcard_get_clock(void)
+{
+    return sd_clock_hz;
+}
+
+void sdcard_print_status(void)
+{
+    sprintf(g_debug_util_char_buffer,
+            "\tCard %.5s rev %u.%u, manufacturer 0x%02X, OEM 0x%04X, "
+            "serial 0x%08X, made %u-%02u%s",
+            metadata.productName,
+            (unsigned int)metadata.productRevisionMajor,
+            (unsigned int)metadata.productRevisionMinor,
+            (unsigned int)metadata.manufacturerID,
+            (unsigned int)metadata.oemID,
+            (unsigned int)metadata.productSerial,
+            (unsigned int)metadata.productionYear,
+            (unsigned int)metadata.productionMonth,
+            NEWLINE);
+    uart_write_string(g_debug_util_char_buffer);
+
+    sprintf(g_debug_util_char_buffer,
+            "\t%u blocks (%u MB), %s addressing%s",
+            (unsigned int)metadata.numBlocks,
+            (unsigned int)(metadata.numBlocks / 2048),
+            high_capacity ? "block" : "byte",
+            NEWLINE);
+    uart_write_string(g_debug_util_char_buffer);
+
+    sprintf(g_debug_util_char_buffer,
+            "\tSD clock %u Hz, card maximum %u Hz, high speed %s%s",
+            (unsigned int)sd_clock_hz,
+            (unsigned int)card_max_clock_hz,
+            high_speed_enabled ? "on" : "off",
+            NEWLINE);
+    uart_write_string(g_debug_util_char_buffer);
 
-    return (0 != response.r1.in_idle_state);
+    sprintf(g_debug_util_char_buffer,
+            "\tClock step downs after errors %u, step ups %u, "
+            "failed operations %u%s",
+            (unsigned int)nbr_of_clock_step_downs,
+            (unsigned int)nbr_of_clock_step_ups,
+            (unsigned int)nbr_of_failed_operations,
+            NEWLINE);
+    uart_write_string(g_debug_util_char_buffer);
+
+    sprintf(g_debug_util_char_buffer,
+            "\tCRC checks %s, CRC errors %u, read retries %u%s",
+            check_crc ? "on" : "off",
+            (unsigned int)nbr_of_crc_errors,
+            (unsigned int)nbr_of_read_retries,
+            NEWLINE);
+    uart_write_string(g_debug_util_char_buffer);
+
+    sprintf(g_debug_util_char_buffer,
+            "\tRead streams %u, blocks read from streams %u, stream %s%s",
+            (unsigned int)nbr_of_read_streams,
+            (unsigned int)nbr_of_streamed_blocks,
+            read_stream_open ? "open" : "closed",
+            NEWLINE);
+    uart_write_string(g_debug_util_char_buffer);
+
+    sprintf(g_debug_util_char_buffer,
+            "\tWrite streams %u, blocks written to streams %u, stream %s%s",
+            (unsigned int)nbr_of_write_streams,
+            (unsigned int)nbr_of_streamed_writes,
+            write_stream_open ? "open" : "closed",
+            NEWLINE);
+    uart_write_string(g_debug_util_char_buffer);
 }
 
 /**
  * Read the 512-byte block with the given index into the given 512-byte buffer.
  *
+ * The buffer must be aligned to SDCARD_BUFFER_ALIGNMENT bytes, an unaligned buffer is refused.
+ *
  * When the read completes, your callback will be called. If the read was successful, the buffer pointer will be the
  * same buffer you originally passed in, otherwise the buffer will be set to NULL.
  *
@@ -234,25 +850,81 @@ bool sdcard_init(void)
  *
  * Returns:
  *     true - The operation was successfully queued for later completion, your callback will be called later
- *     false - The operation could not be started due to the card being busy (try again later).
+ *     false - The operation could not be started due to the card being busy (try again later), or the buffer is not
+ *             aligned.
  */
 bool sdcard_readBlock(uint32_t blockIndex,
                       uint8_t *buffer,
                       sdcard_operationCompleteCallback_c callback,
                       uint32_t callbackData)
 {
-    ;// TODO implement error_occurredsdcard_readBlock
-    bool error = false;
-    r7_response_t r7_response;
-    memset(&r7_response, 0xFF, sizeof(r7_response));
-    
-    //send_command(CMD_READ_SINGLE_BLOCK, blockIndex, &r7_response);
-    error |= (0 != r7_response.byte_1);
+    bool started = false;
+
+    if (!buffer_is_aligned(buffer))
+    {
+        // Refused
+    }
+    else if (SDCARD_STATE_READY == state)
+    {
+        if (write_stream_open)
+        {
+            // Try again once the card has finished writing
+            stop_write_stream(false);
+        }
+        else if (read_stream_open)
+        {
+            if (blockIndex == next_read_block)
+            {
+                // The card is already sending this block
+                started = true;
+                ++nbr_of_streamed_blocks;
+            }
+            else
+            {
+                // Try again once the card has stopped streaming
+                stop_read_stream();
+            }
+        }
+        else if (stream_reads && (blockIndex == next_read_block))
+        {
+            // The second block of a sequence starts a stream
+            started = start_block_command(CMD_READ_MULTIPLE_BLOCK,
+                                          blockIndex);
+            read_stream_open = started;
+
+            if (started)
+            {
+                ++nbr_of_read_streams;
+                ++nbr_of_streamed_blocks;
+            }
+        }
+        else
+        {
+            started = start_block_command(CMD_READ_SINGLE_BLOCK, blockIndex);
+        }
+    }
+
+    if (started)
+    {
+        current_operation.operation = SDCARD_BLOCK_OPERATION_READ;
+        current_operation.block_index = blockIndex;
+        current_operation.buffer = buffer;
+        current_operation.callback = callback;
+        current_operation.callback_data = callbackData;
+        current_operation.start_count = _CP0_GET_COUNT();
+        current_operation.retries = 0;
+
+        enter_state(SDCARD_STATE_WAITING_FOR_DATA);
+    }
+
+    return started;
 }
 
 /**
  * Write the 512-byte block from the given buffer into the block with the given index.
  *
+ * The buffer must be aligned to SDCARD_BUFFER_ALIGNMENT bytes, an unaligned buffer is refused.
+ *
  * If the write does not complete immediately, your callback will be called later. If the write was successful, the
  * buffer pointer will be the same buffer you originally passed in, otherwise the buffer will be set to NULL.
  *
@@ -262,14 +934,90 @@ bool sdcard_readBlock(uint32_t blockIndex,
  *                                    that time.
  *     SDCARD_OPERATION_SUCCESS     - Your buffer has been transmitted to the card now.
  *     SDCARD_OPERATION_BUSY        - The card is already busy and cannot accept your write
- *     SDCARD_OPERATION_FAILURE     - Your write was rejected by the card, card will be reset
+ *     SDCARD_OPERATION_FAILURE     - Your write was rejected by the card, card will be reset, or the buffer is not
+ *                                    aligned
  */
 sdcardOperationStatus_e sdcard_writeBlock(uint32_t blockIndex,
                                           uint8_t *buffer,
                                           sdcard_operationCompleteCallback_c callback,
                                           uint32_t callbackData)
 {
-    ;// TODO implement sdcard_writeBlock
+    sdcardOperationStatus_e status = SDCARD_OPERATION_BUSY;
+    uint8_t start_token = DATA_START_TOKEN;
+    bool started;
+
+    if (!buffer_is_aligned(buffer))
+    {
+        status = SDCARD_OPERATION_FAILURE;
+    }
+    else if ((SDCARD_STATE_READY == state) && read_stream_open)
+    {
+        stop_read_stream();
+    }
+    else if ((SDCARD_STATE_READY == state) &&
+             write_stream_open &&
+             (blockIndex != next_write_block))
+    {
+        // Not the next block of the stream, try again once it has stopped
+        stop_write_stream(false);
+    }
+    else if (SDCARD_STATE_READY == state)
+    {
+        status = SDCARD_OPERATION_FAILURE;
+        next_read_block = NO_BLOCK;
+
+        if (write_stream_open)
+        {
+            start_token = WRITE_MULTIPLE_TOKEN;
+            started = true;
+            ++nbr_of_streamed_writes;
+        }
+        else
+        {
+            started = start_block_command(CMD_WRITE_BLOCK, blockIndex);
+        }
+
+        if (started)
+        {
+            current_operation.operation = SDCARD_BLOCK_OPERATION_WRITE;
+            current_operation.block_index = blockIndex;
+            current_operation.buffer = buffer;
+            current_operation.callback = callback;
+            current_operation.callback_data = callbackData;
+            current_operation.start_count = _CP0_GET_COUNT();
+            current_operation.retries = 0;
+
+            // One byte gap before the start token
+            (void)spi_byte_tranceive_blocking(SPI_DEVICE_SDCARD, 0xFF);
+            (void)spi_byte_tranceive_blocking(SPI_DEVICE_SDCARD, start_token);
+
+            block_transfer_done = false;
+            enter_state(SDCARD_STATE_SENDING);
+
+            if (start_block_transfer(buffer, NULL))
+            {
+                // The SD card data CRC is CRC-16/CCITT with initial value 0.
+                // Calculated while the block is sent, it goes out after it.
+                write_crc = crc16_ccitt_update(0, buffer, BLOCK_SIZE);
+
+                status = SDCARD_OPERATION_IN_PROGRESS;
+            }
+            else if (write_stream_open)
+            {
+                ++nbr_of_failed_operations;
+                stop_write_stream(true);
+            }
+            else
+            {
+                // Leaves the card waiting for data, it is reset on failure
+                deselect_card();
+                state = SDCARD_STATE_READY;
+                ++nbr_of_failed_operations;
+            }
+        }
+    }
+
+    return status;
 }
 
 /**
@@ -279,7 +1027,27 @@ sdcardOperationStatus_e sdcard_writeBlock(uint32_t blockIndex,
  */
 bool sdcard_poll()
 {
-    ; // TODO impement sdcard_poll
+    switch (state)
+    {
+    case SDCARD_STATE_WAITING_FOR_DATA:
+    case SDCARD_STATE_RECEIVING:
+        continue_read();
+        break;
+
+    case SDCARD_STATE_SENDING:
+    case SDCARD_STATE_PROGRAMMING:
+        continue_write();
+        break;
+
+    case SDCARD_STATE_STOPPING:
+        continue_stop();
+        break;
+
+    default:
+        break;
+    }
+
+    return (SDCARD_STATE_READY == state);
 }
 
 /**
@@ -299,7 +1067,59 @@ bool sdcard_poll()
 sdcardOperationStatus_e sdcard_beginWriteBlocks(uint32_t blockIndex,
                                                 uint32_t blockCount)
 {
-    ; // TODO implement sdcard_beginWriteBlocks
+    sdcardOperationStatus_e status = SDCARD_OPERATION_BUSY;
+    uint32_t start_count;
+    uint32_t ticks;
+    bool pre_erased;
+
+    if (SDCARD_STATE_READY == state)
+    {
+        if (read_stream_open)
+        {
+            stop_read_stream();
+        }
+        else if (write_stream_open && (blockIndex == next_write_block))
+        {
+            // Already streaming to these blocks
+            status = SDCARD_OPERATION_SUCCESS;
+        }
+        else if (write_stream_open)
+        {
+            stop_write_stream(false);
+        }
+        else
+        {
+            status = SDCARD_OPERATION_FAILURE;
+            next_read_block = NO_BLOCK;
+
+            // The writes are faster with the blocks pre-erased, not required
+            start_count = _CP0_GET_COUNT();
+            pre_erased = set_pre_erase_count(blockCount);
+            ticks = _CP0_GET_COUNT() - start_count;
+
+            sdcard_profiler_record(SDCARD_BLOCK_OPERATION_ERASE,
+                                   ticks,
+                                   pre_erased);
+
+            if (NULL != profiler_callback)
+            {
+                profiler_callback(SDCARD_BLOCK_OPERATION_ERASE,
+                                  blockIndex,
+                                  ticks / CORE_TIMER_TICKS_PER_US);
+            }
+
+            if (start_block_command(CMD_WRITE_MULTIPLE_BLOCK, blockIndex))
+            {
+                write_stream_open = true;
+                next_write_block = blockIndex;
+                ++nbr_of_write_streams;
+
+                status = SDCARD_OPERATION_SUCCESS;
+            }
+        }
+    }
+
+    return status;
 }
 
 /**
@@ -311,77 +1131,74 @@ sdcardOperationStatus_e sdcard_beginWriteBlocks(uint32_t blockIndex,
  */
 sdcardOperationStatus_e sdcard_endWriteBlocks()
 {
-    ;// TODO implement sdcard_endWriteBlocks
+    sdcardOperationStatus_e status = SDCARD_OPERATION_SUCCESS;
+
+    if (write_stream_open)
+    {
+        status = SDCARD_OPERATION_BUSY;
+
+        if (SDCARD_STATE_READY == state)
+        {
+            stop_write_stream(false);
+            status = SDCARD_OPERATION_SUCCESS;
+        }
+    }
+
+    return status;
 }
 
-void sdcard_setProfilerCallback(sdcard_profilerCallback_c callback)
+sdcardOperationStatus_e sdcard_endReadBlocks(void)
 {
-    ; // TODO implement sdcard_setProfilerCallback
-}
+    sdcardOperationStatus_e status = SDCARD_OPERATION_SUCCESS;
 
-// =============================================================================
-// Private function definitions
-// =============================================================================
+    if (read_stream_open)
+    {
+        status = SDCARD_OPERATION_BUSY;
 
-static response_type_t send_command_blocking(uint8_t cmd_number,
+        if (SDCARD_STATE_READY == state)
+        {
+            stop_read_stream();
+            status = SDCARD_OPERATION_SUCCESS;
+        }
+    }
+
+    return status;
+}
+
+void sdcard_setProfilerCallback(sdcard_profilerCallback_c callback)
+{
+    profiler_callback = callback;
+}
+
+// =============================================================================
+// Private function definitions
+// =============================================================================
+
+static response_type_t send_command_blocking(uint8_t cmd_number,
                                              uint32_t arg,
                                              response_t* response)
 {
-    // Start bit is active low
-    const uint8_t START_BIT_MASK = 0x80;
-    // Transmission bit is active high
-    const uint8_t TRANSMISSION_BIT_MASK = 0x40;
-    const uint8_t NBR_OF_BYTES = 6;
-    const int RESPONSE_TIMEOUT = 10;
-
-    int i;
-    bool response_found;
     uint8_t first_byte_in_response;
     response_type_t response_type_returned = NO_RESPONSE;
 
-    SD_CARD_SS_ON;
+    select_card();
 
-    uint8_t data_to_send[NBR_OF_BYTES];
-    data_to_send[0] = (TRANSMISSION_BIT_MASK | cmd_number) & ~START_BIT_MASK;
-    data_to_send[1] = arg >> (3 * 8);
-    data_to_send[2] = arg >> (2 * 8);
-    data_to_send[3] = arg >> (1 * 8);
-    data_to_send[4] = arg;
-    // CRC, only used for CMD0 and CMD8, so hard code it.
-    if (CMD_GO_IDLE_STATE == cmd_number)
-    {
-        data_to_send[5] = 0x95;
-    }
-    else
-    {
-        // CMD 8
-        data_to_send[5] = 0x87;
-    }
-
-    for (i = 0; i != NBR_OF_BYTES; ++i)
-    {
-        spi_byte_tranceive_blocking(SPI_DEVICE_SDCARD, data_to_send[i]);
-    }
+    send_command_frame(cmd_number, arg);
 
-    // Wait for the response
-    i = 0;
-    response_found = false;
-    while ((false == response_found) && (++i != RESPONSE_TIMEOUT))
-    {
-        first_byte_in_response = spi_byte_tranceive_blocking(SPI_DEVICE_SDCARD,
-                                                             0xFF);
-        response_found = (0 == (first_byte_in_response & START_BIT_MASK));
-    }
-
-    if (i == RESPONSE_TIMEOUT)
+    if (!wait_for_response(&first_byte_in_response))
     {
         sprintf(g_debug_util_char_buffer, "%s - SD card response timeout%s",
                 ERROR_TAG, NEWLINE);
         uart_write_string(g_debug_util_char_buffer);
-        SD_CARD_SS_OFF;
+        deselect_card();
         return NO_RESPONSE;
     }
 
+    if (0 != (first_byte_in_response & R1_COM_CRC_ERROR))
+    {
+        sdcard_clock_step_down();
+    }
+
     switch (cmd_number)
     {
     case CMD_GO_IDLE_STATE:
@@ -402,13 +1219,16 @@ static response_type_t send_command_blocking(uint8_t cmd_number,
     case CMD_APP_CMD:
     case CMD_GEN_CMD:
     case CMD_CRC_ON_OFF:
+    case ACMD_SET_WR_BLK_ERASE_COUNT:
     case ACMD_SD_SEND_OP_COND:
         response_type_returned = R1;
         response->r1.r1 = first_byte_in_response;
         break;
 
     case CMD_SEND_IF_COND:
-        response_type_returned = R7;
+    case CMD_READ_OCR:
+        // R3 has the same layout as R7, the OCR follows the R1 byte
+        response_type_returned = (CMD_READ_OCR == cmd_number) ? R3 : R7;
         response->r7.byte_1 = first_byte_in_response;
         response->r7.byte_2 = spi_byte_tranceive_blocking(SPI_DEVICE_SDCARD,
                                                           0xFF);
@@ -425,5 +1245,760 @@ static response_type_t send_command_blocking(uint8_t cmd_number,
         break;
     }
 
-    SD_CARD_SS_OFF;
+    deselect_card();
+
+    return response_type_returned;
+}
+
+static bool start_block_command(uint8_t cmd_number, uint32_t block_index)
+{
+    uint8_t r1 = 0xFF;
+    uint32_t address = high_capacity ? block_index : block_index * BLOCK_SIZE;
+    bool accepted;
+
+    select_card();
+
+    send_command_frame(cmd_number, address);
+
+    accepted = wait_for_response(&r1) && (0 == r1);
+
+    if (!accepted)
+    {
+        deselect_card();
+        (void)spi_byte_tranceive_blocking(SPI_DEVICE_SDCARD, 0xFF);
+
+        sprintf(g_debug_util_char_buffer,
+                "%s - SD card CMD%u block %u, R1 0x%02X%s",
+                ERROR_TAG,
+                (unsigned int)cmd_number,
+                (unsigned int)block_index,
+                (unsigned int)r1,
+                NEWLINE);
+        uart_write_string(g_debug_util_char_buffer);
+
+        ++nbr_of_failed_operations;
+
+        if (0 != (r1 & R1_COM_CRC_ERROR))
+        {
+            sdcard_clock_step_down();
+        }
+    }
+
+    return accepted;
+}
+
+static void continue_read(void)
+{
+    uint8_t token = 0xFF;
+    uint16_t received_crc;
+    uint32_t i;
+
+    if (SDCARD_STATE_WAITING_FOR_DATA == state)
+    {
+        // Clock a few bytes per call, the card may take up to 100 ms
+        for (i = 0; (0xFF == token) && (i != POLL_BYTES); ++i)
+        {
+            token = spi_byte_tranceive_blocking(SPI_DEVICE_SDCARD, 0xFF);
+        }
+
+        if (DATA_START_TOKEN == token)
+        {
+            block_transfer_done = false;
+            enter_state(SDCARD_STATE_RECEIVING);
+
+            if (!start_block_transfer(NULL, current_operation.buffer))
+            {
+                finish_operation(false);
+            }
+        }
+        else if ((0 == (token & DATA_ERROR_TOKEN_MASK)) ||
+                 state_timed_out(READ_TIMEOUT_TICKS))
+        {
+            finish_operation(false);
+        }
+    }
+    else if (block_transfer_done)
+    {
+        received_crc = spi_byte_tranceive_blocking(SPI_DEVICE_SDCARD, 0xFF);
+        received_crc <<= 8;
+        received_crc |= spi_byte_tranceive_blocking(SPI_DEVICE_SDCARD, 0xFF);
+
+        // The CRC bytes are clocked out even when they are not checked
+        if (!check_crc ||
+            (received_crc == crc16_ccitt_update(0,
+                                                current_operation.buffer,
+                                                BLOCK_SIZE)))
+        {
+            finish_operation(true);
+        }
+        else
+        {
+            ++nbr_of_crc_errors;
+            sdcard_clock_step_down();
+
+            if (current_operation.retries < MAX_READ_RETRIES)
+            {
+                ++current_operation.retries;
+                ++nbr_of_read_retries;
+
+                retry_read();
+            }
+            else
+            {
+                finish_operation(false);
+            }
+        }
+    }
+}
+
+static void continue_write(void)
+{
+    uint8_t data_response;
+    uint8_t busy = 0x00;
+    uint32_t i;
+
+    if (SDCARD_STATE_SENDING == state)
+    {
+        if (block_transfer_done)
+        {
+            (void)spi_byte_tranceive_blocking(SPI_DEVICE_SDCARD,
+                                              (uint8_t)(write_crc >> 8));
+            (void)spi_byte_tranceive_blocking(SPI_DEVICE_SDCARD,
+                                              (uint8_t)write_crc);
+
+            data_response = spi_byte_tranceive_blocking(SPI_DEVICE_SDCARD,
+                                                        0xFF);
+
+            if (DATA_RESPONSE_ACCEPTED ==
+                (data_response & DATA_RESPONSE_MASK))
+            {
+                enter_state(SDCARD_STATE_PROGRAMMING);
+            }
+            else
+            {
+                if (DATA_RESPONSE_CRC_ERROR ==
+                    (data_response & DATA_RESPONSE_MASK))
+                {
+                    ++nbr_of_crc_errors;
+                    sdcard_clock_step_down();
+                }
+
+                finish_operation(false);
+            }
+        }
+    }
+    else
+    {
+        // The card holds MISO low while it programs the block
+        for (i = 0; (0xFF != busy) && (i != POLL_BYTES); ++i)
+        {
+            busy = spi_byte_tranceive_blocking(SPI_DEVICE_SDCARD, 0xFF);
+        }
+
+        if (0xFF == busy)
+        {
+            finish_operation(true);
+        }
+        else if (state_timed_out(WRITE_TIMEOUT_TICKS))
+        {
+            finish_operation(false);
+        }
+    }
+}
+
+static void finish_operation(bool success)
+{
+    const uint32_t ticks = _CP0_GET_COUNT() - current_operation.start_count;
+
+    if (success && (read_stream_open || write_stream_open))
+    {
+        // Keep the card selected for the next block of the stream
+        state = SDCARD_STATE_READY;
+    }
+    else if (read_stream_open)
+    {
+        stop_read_stream();
+    }
+    else if (write_stream_open)
+    {
+        // A rejected block of a multiple block write is stopped with CMD12
+        stop_write_stream(true);
+    }
+    else
+    {
+        deselect_card();
+        (void)spi_byte_tranceive_blocking(SPI_DEVICE_SDCARD, 0xFF);
+
+        state = SDCARD_STATE_READY;
+    }
+
+    if ((SDCARD_BLOCK_OPERATION_READ == current_operation.operation) &&
+        success)
+    {
+        next_read_block = current_operation.block_index + 1;
+    }
+    else
+    {
+        next_read_block = NO_BLOCK;
+    }
+
+    if (write_stream_open)
+    {
+        next_write_block = current_operation.block_index + 1;
+    }
+
+    if (!success)
+    {
+        sprintf(g_debug_util_char_buffer,
+                "%s - SD card %s of block %u failed%s",
+                ERROR_TAG,
+                (SDCARD_BLOCK_OPERATION_READ == current_operation.operation) ?
+                    "read" : "write",
+                (unsigned int)current_operation.block_index,
+                NEWLINE);
+        uart_write_string(g_debug_util_char_buffer);
+
+        ++nbr_of_failed_operations;
+        nbr_of_clean_operations = 0;
+    }
+    else
+    {
+        count_clean_operation();
+    }
+
+    sdcard_profiler_record(current_operation.operation, ticks, success);
+
+    if (NULL != profiler_callback)
+    {
+        profiler_callback(current_operation.operation,
+                          current_operation.block_index,
+                          ticks / CORE_TIMER_TICKS_PER_US);
+    }
+
+    // The callback may start the next operation
+    if (NULL != current_operation.callback)
+    {
+        current_operation.callback(current_operation.operation,
+                                   current_operation.block_index,
+                                   success ? current_operation.buffer : NULL,
+                                   current_operation.callback_data);
+    }
+}
+
+static void stop_read_stream(void)
+{
+    uint8_t r1;
+
+    send_command_frame(CMD_STOP_TRANSMISSION, 0);
+
+    // The byte after the command is a stuff byte, it may be data
+    (void)spi_byte_tranceive_blocking(SPI_DEVICE_SDCARD, 0xFF);
+    (void)wait_for_response(&r1);
+
+    read_stream_open = false;
+    next_read_block = NO_BLOCK;
+
+    enter_state(SDCARD_STATE_STOPPING);
+}
+
+static void stop_write_stream(bool after_error)
+{
+    uint8_t r1;
+
+    if (after_error)
+    {
+        send_command_frame(CMD_STOP_TRANSMISSION, 0);
+        (void)spi_byte_tranceive_blocking(SPI_DEVICE_SDCARD, 0xFF);
+        (void)wait_for_response(&r1);
+    }
+    else
+    {
+        (void)spi_byte_tranceive_blocking(SPI_DEVICE_SDCARD, STOP_TRAN_TOKEN);
+
+        // The card starts signalling busy one byte after the token
+        (void)spi_byte_tranceive_blocking(SPI_DEVICE_SDCARD, 0xFF);
+    }
+
+    write_stream_open = false;
+    next_write_block = NO_BLOCK;
+
+    enter_state(SDCARD_STATE_STOPPING);
+}
+
+static bool set_pre_erase_count(uint32_t nbr_of_blocks)
+{
+    response_t response;
+    bool accepted = false;
+
+    if (nbr_of_blocks > MAX_PRE_ERASE_BLOCKS)
+    {
+        nbr_of_blocks = MAX_PRE_ERASE_BLOCKS;
+    }
+
+    memset(&response, 0xFF, sizeof(response_t));
+
+    if ((R1 == send_command_blocking(CMD_APP_CMD, 0, &response)) &&
+        (0 == response.r1.r1))
+    {
+        memset(&response, 0xFF, sizeof(response_t));
+
+        accepted =
+            (R1 == send_command_blocking(ACMD_SET_WR_BLK_ERASE_COUNT,
+                                         nbr_of_blocks,
+                                         &response)) &&
+            (0 == response.r1.r1);
+    }
+
+    return accepted;
+}
+
+static void continue_stop(void)
+{
+    uint8_t busy = 0x00;
+    uint32_t i;
+
+    for (i = 0; (0xFF != busy) && (i != POLL_BYTES); ++i)
+    {
+        busy = spi_byte_tranceive_blocking(SPI_DEVICE_SDCARD, 0xFF);
+    }
+
+    // Stopping a write stream may program the last block first
+    if ((0xFF == busy) || state_timed_out(WRITE_TIMEOUT_TICKS))
+    {
+        if (0xFF != busy)
+        {
+            ++nbr_of_failed_operations;
+        }
+
+        deselect_card();
+        (void)spi_byte_tranceive_blocking(SPI_DEVICE_SDCARD, 0xFF);
+
+        state = SDCARD_STATE_READY;
+
+        if (retry_read_pending)
+        {
+            retry_read_pending = false;
+            restart_read();
+        }
+    }
+}
+
+static void retry_read(void)
+{
+    if (read_stream_open)
+    {
+        retry_read_pending = true;
+        stop_read_stream();
+    }
+    else
+    {
+        deselect_card();
+        (void)spi_byte_tranceive_blocking(SPI_DEVICE_SDCARD, 0xFF);
+
+        restart_read();
+    }
+}
+
+static void restart_read(void)
+{
+    if (start_block_command(CMD_READ_SINGLE_BLOCK,
+                            current_operation.block_index))
+    {
+        enter_state(SDCARD_STATE_WAITING_FOR_DATA);
+    }
+    else
+    {
+        finish_operation(false);
+    }
+}
+
+static void block_transfer_complete(int32_t arg)
+{
+    block_transfer_done = true;
+}
+
+static bool start_block_transfer(const uint8_t* tx_data, uint8_t* rx_data)
+{
+    spi_transaction_t transaction;
+
+    transaction.tx_data = tx_data;
+    transaction.rx_data = rx_data;
+    transaction.number_of_bytes = BLOCK_SIZE;
+    transaction.keep_selected = true;
+    transaction.callback = &block_transfer_complete;
+    transaction.arg = 0;
+
+    return spi_bus_submit(SPI_DEVICE_SDCARD, &transaction);
+}
+
+static void select_card(void)
+{
+    while (!spi_bus_select(SPI_DEVICE_SDCARD))
+    {
+        ;   // The card is alone on its bus, only its own block can be running
+    }
+}
+
+static void deselect_card(void)
+{
+    spi_bus_deselect(SPI_DEVICE_SDCARD);
+}
+
+static void enter_state(sdcard_state_t new_state)
+{
+    state = new_state;
+    current_operation.state_count = _CP0_GET_COUNT();
+}
+
+static bool state_timed_out(uint32_t timeout_ticks)
+{
+    return (_CP0_GET_COUNT() - current_operation.state_count) > timeout_ticks;
+}
+
+static void send_command_frame(uint8_t cmd_number, uint32_t arg)
+{
+    // Start bit is active low
+    const uint8_t START_BIT_MASK = 0x80;
+    // Transmission bit is active high
+    const uint8_t TRANSMISSION_BIT_MASK = 0x40;
+    const uint8_t NBR_OF_BYTES = 6;
+
+    int i;
+    uint8_t data_to_send[NBR_OF_BYTES];
+
+    data_to_send[0] = (TRANSMISSION_BIT_MASK | cmd_number) & ~START_BIT_MASK;
+    data_to_send[1] = arg >> (3 * 8);
+    data_to_send[2] = arg >> (2 * 8);
+    data_to_send[3] = arg >> (1 * 8);
+    data_to_send[4] = arg;
+    // CRC-7 and the end bit
+    data_to_send[5] = (uint8_t)(crc7_update(0, data_to_send, 5) << 1) | 0x01;
+
+    for (i = 0; i != NBR_OF_BYTES; ++i)
+    {
+        spi_byte_tranceive_blocking(SPI_DEVICE_SDCARD, data_to_send[i]);
+    }
+}
+
+static bool wait_for_response(uint8_t* first_byte)
+{
+    // Start bit is active low
+    const uint8_t START_BIT_MASK = 0x80;
+    const int RESPONSE_TIMEOUT = 10;
+
+    int i = 0;
+    bool response_found = false;
+
+    while ((false == response_found) && (++i != RESPONSE_TIMEOUT))
+    {
+        *first_byte = spi_byte_tranceive_blocking(SPI_DEVICE_SDCARD, 0xFF);
+        response_found = (0 == (*first_byte & START_BIT_MASK));
+    }
+
+    return response_found;
+}
+
+static bool read_data_blocking(uint8_t cmd_number,
+                               uint32_t arg,
+                               uint8_t data[],
+                               uint32_t number_of_bytes)
+{
+    uint8_t r1 = 0xFF;
+    uint8_t token = 0xFF;
+    uint16_t received_crc;
+    uint32_t i;
+    bool crc_error = false;
+    bool ok;
+
+    select_card();
+
+    send_command_frame(cmd_number, arg);
+
+    ok = wait_for_response(&r1) && (0 == r1);
+    crc_error = (0 != (r1 & R1_COM_CRC_ERROR));
+
+    for (i = 0; ok && (DATA_START_TOKEN != token); ++i)
+    {
+        token = spi_byte_tranceive_blocking(SPI_DEVICE_SDCARD, 0xFF);
+        ok = (DATA_TOKEN_TIMEOUT != i);
+    }
+
+    if (ok)
+    {
+        spi_block_tranceive_blocking(SPI_DEVICE_SDCARD,
+                                     NULL,
+                                     data,
+                                     number_of_bytes);
+
+        received_crc = spi_byte_tranceive_blocking(SPI_DEVICE_SDCARD, 0xFF);
+        received_crc <<= 8;
+        received_crc |= spi_byte_tranceive_blocking(SPI_DEVICE_SDCARD, 0xFF);
+
+        // The SD card data CRC is CRC-16/CCITT with initial value 0
+        ok = (received_crc == crc16_ccitt_update(0, data, number_of_bytes));
+        crc_error = !ok;
+    }
+
+    deselect_card();
+    spi_byte_tranceive_blocking(SPI_DEVICE_SDCARD, 0xFF);
+
+    if (!ok)
+    {
+        sprintf(g_debug_util_char_buffer,
+                "%s - SD card CMD%u data error, R1 0x%02X%s",
+                ERROR_TAG,
+                (unsigned int)cmd_number,
+                (unsigned int)r1,
+                NEWLINE);
+        uart_write_string(g_debug_util_char_buffer);
+    }
+
+    if (crc_error)
+    {
+        sdcard_clock_step_down();
+    }
+
+    return ok;
+}
+
+/*
+ * 1. Read the CSD register for the default speed of the card.
+ * 2. If the card supports the switch function command class and high speed
+ *    mode, switch to it with CMD6 and read the new speed from the CSD.
+ * 3. Use the fastest clock allowed by the card and the sd.max_clock tunable.
+ */
+static void select_clock(void)
+{
+    uint8_t csd[CSD_SIZE];
+    uint8_t switch_status[SWITCH_STATUS_SIZE];
+
+    card_max_clock_hz = DEFAULT_SPEED_CLOCK_HZ;
+
+    if (read_data_blocking(CMD_SEND_CSD, 0, csd, sizeof(csd)))
+    {
+        // TRAN_SPEED is CSD bits 103:96
+        card_max_clock_hz = decode_tran_speed(csd[3]);
+
+        // Command class 10, switch function, is CCC bit 10 at CSD bit 94
+        if (use_high_speed && (0 != (csd[4] & 0x40)) &&
+            read_data_blocking(CMD_SWITCH_FUNC,
+                               SWITCH_CHECK_HIGH_SPEED,
+                               switch_status,
+                               sizeof(switch_status)) &&
+            // Function 1 of group 1 supported, status bit 401
+            (0 != (switch_status[13] & 0x02)) &&
+            read_data_blocking(CMD_SWITCH_FUNC,
+                               SWITCH_SET_HIGH_SPEED,
+                               switch_status,
+                               sizeof(switch_status)))
+        {
+            // Function selected in group 1, status bits 379:376
+            high_speed_enabled = (0x01 == (switch_status[16] & 0x0F));
+
+            // The card updates TRAN_SPEED after the switch
+            if (high_speed_enabled &&
+                read_data_blocking(CMD_SEND_CSD, 0, csd, sizeof(csd)))
+            {
+                card_max_clock_hz = decode_tran_speed(csd[3]);
+            }
+        }
+
+        if (0 == card_max_clock_hz)
+        {
+            card_max_clock_hz = DEFAULT_SPEED_CLOCK_HZ;
+        }
+    }
+
+    clock_limit_hz = (card_max_clock_hz < max_clock_hz) ?
+                     card_max_clock_hz : max_clock_hz;
+
+    set_clock(fastest_clock_at_most(clock_limit_hz));
+
+    sprintf(g_debug_util_char_buffer,
+            "SD card clock %u Hz, high speed %s%s",
+            (unsigned int)sd_clock_hz,
+            high_speed_enabled ? "on" : "off",
+            NEWLINE);
+    uart_write_string(g_debug_util_char_buffer);
+}
+
+/*
+ * Register fields, byte 0 holds the most significant bits:
+ * CID  MID [127:120], OID [119:104], PNM [103:64], PRV [63:56], PSN [55:24],
+ *      MDT [19:8] with the year since 2000 in [19:12] and the month in [11:8]
+ * CSD  CSD_STRUCTURE [127:126], see decode_capacity
+ */
+static bool read_card_registers(void)
+{
+    uint8_t cid[CID_SIZE];
+    uint8_t csd[CSD_SIZE];
+    bool ok;
+
+    ok = read_data_blocking(CMD_SEND_CID, 0, cid, sizeof(cid)) &&
+         read_data_blocking(CMD_SEND_CSD, 0, csd, sizeof(csd));
+
+    if (ok)
+    {
+        metadata.manufacturerID = cid[0];
+        metadata.oemID = ((uint16_t)cid[1] << 8) | cid[2];
+        memcpy(metadata.productName, &cid[3], sizeof(metadata.productName));
+        metadata.productRevisionMajor = cid[8] >> 4;
+        metadata.productRevisionMinor = cid[8] & 0x0F;
+        metadata.productSerial = ((uint32_t)cid[9] << 24) |
+                                 ((uint32_t)cid[10] << 16) |
+                                 ((uint32_t)cid[11] << 8) |
+                                 cid[12];
+        metadata.productionYear =
+            2000 + (((cid[13] & 0x0F) << 4) | (cid[14] >> 4));
+        metadata.productionMonth = cid[14] & 0x0F;
+
+        metadata.numBlocks = decode_capacity(csd);
+
+        sprintf(g_debug_util_char_buffer,
+                "SD card %.5s rev %u.%u, %s, %u MB%s",
+                metadata.productName,
+                (unsigned int)metadata.productRevisionMajor,
+                (unsigned int)metadata.productRevisionMinor,
+                high_capacity ? "SDHC/SDXC" : "SDSC",
+                (unsigned int)(metadata.numBlocks / 2048),
+                NEWLINE);
+        uart_write_string(g_debug_util_char_buffer);
+    }
+
+    return ok;
+}
+
+/*
+ * CSD version 2.0, high capacity cards:
+ *   C_SIZE [69:48], capacity = (C_SIZE + 1) * 512 kB
+ * CSD version 1.0, standard capacity cards:
+ *   READ_BL_LEN [83:80], C_SIZE [73:62], C_SIZE_MULT [49:47],
+ *   capacity = (C_SIZE + 1) * 2^(C_SIZE_MULT + 2) * 2^READ_BL_LEN bytes
+ */
+static uint32_t decode_capacity(const uint8_t csd[])
+{
+    uint32_t nbr_of_blocks = 0;
+    uint32_t c_size;
+    uint32_t c_size_mult;
+    uint32_t read_bl_len;
+
+    switch (csd[0] >> 6)
+    {
+    case 0:
+        read_bl_len = csd[5] & 0x0F;
+        c_size = ((uint32_t)(csd[6] & 0x03) << 10) |
+                 ((uint32_t)csd[7] << 2) |
+                 (csd[8] >> 6);
+        c_size_mult = ((csd[9] & 0x03) << 1) | (csd[10] >> 7);
+
+        // Block length is 2^9 bytes
+        nbr_of_blocks = (c_size + 1) << (c_size_mult + 2 + read_bl_len - 9);
+        break;
+
+    case 1:
+        c_size = ((uint32_t)(csd[7] & 0x3F) << 16) |
+                 ((uint32_t)csd[8] << 8) |
+                 csd[9];
+        nbr_of_blocks = (c_size + 1) * 1024;
+        break;
+
+    default:
+        break;
+    }
+
+    return nbr_of_blocks;
+}
+
+static uint32_t decode_tran_speed(uint8_t tran_speed)
+{
+    // Time values 1.0 to 8.0, times 10
+    static const uint8_t TIME_VALUES_X10[16] =
+    {
+        0, 10, 12, 13, 15, 20, 25, 30, 35, 40, 45, 50, 55, 60, 70, 80
+    };
+    // Transfer rate units 100 kbit/s to 100 Mbit/s, divided by 10
+    static const uint32_t RATE_UNITS_DIV10[4] =
+    {
+        10000u, 100000u, 1000000u, 10000000u
+    };
+
+    uint32_t clock_hz = 0;
+    uint8_t unit = tran_speed & 0x07;
+
+    if (unit < 4)
+    {
+        clock_hz = TIME_VALUES_X10[(tran_speed >> 3) & 0x0F] *
+                   RATE_UNITS_DIV10[unit];
+    }
+
+    return clock_hz;
+}
+
+static uint32_t fastest_clock_at_most(uint32_t limit_hz)
+{
+    uint32_t divider;
+
+    // Clock = PBCLK / (2 * (SPIxBRG + 1))
+    divider = (PBCLK_FREQ_HZ + 2 * limit_hz - 1) / (2 * limit_hz);
+
+    return PBCLK_FREQ_HZ / (2 * divider);
+}
+
+static void set_clock(uint32_t clock_hz)
+{
+    sd_clock_hz = clock_hz;
+
+    // Applied at once, the clock is only changed between block transfers
+    spi_bus_configure_device(SPI_DEVICE_SDCARD, clock_hz, SPI_BUS_MODE_KEEP);
+}
+
+static bool buffer_is_aligned(const uint8_t* buffer)
+{
+    const bool aligned =
+        (0 == ((uint32_t)buffer & (SDCARD_BUFFER_ALIGNMENT - 1)));
+
+    if (!aligned)
+    {
+        sprintf(g_debug_util_char_buffer,
+                "%s - SD card block buffer 0x%08X is not aligned%s",
+                ERROR_TAG,
+                (unsigned int)(uint32_t)buffer,
+                NEWLINE);
+        uart_write_string(g_debug_util_char_buffer);
+    }
+
+    return aligned;
+}
+
+static void count_clean_operation(void)
+{
+    uint32_t divider;
+    uint32_t faster_clock_hz;
+
+    ++nbr_of_clean_operations;
+
+    if (nbr_of_clean_operations >= clock_recovery)
+    {
+        nbr_of_clean_operations = 0;
+
+        // Clock = PBCLK / (2 * (SPIxBRG + 1))
+        divider = PBCLK_FREQ_HZ / (2 * sd_clock_hz);
+
+        if (divider > 1)
+        {
+            faster_clock_hz = PBCLK_FREQ_HZ / (2 * (divider - 1));
+
+            if (faster_clock_hz <= clock_limit_hz)
+            {
+                set_clock(faster_clock_hz);
+                ++nbr_of_clock_step_ups;
+
+                sprintf(g_debug_util_char_buffer,
+                        "SD card clock raised to %u Hz%s",
+                        (unsigned int)sd_clock_hz,
+                        NEWLINE);
+                uart_write_string(g_debug_util_char_buffer);
+            }
+        }
+    }
 }
\ No newline at end of file
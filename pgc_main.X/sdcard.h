@@ -53,6 +53,10 @@ typedef void(*sdcard_profilerCallback_c)(sdcardBlockOperation_e operation, uint3
 // Global constatants
 // =============================================================================
 
+// Block buffers are moved with DMA and the data cache lines of a read buffer
+// are discarded, so the buffers must start on a cache line
+#define SDCARD_BUFFER_ALIGNMENT     (16u)
+
 // =============================================================================
 // Global variable declarations
 // =============================================================================
@@ -67,9 +71,43 @@ typedef void(*sdcard_profilerCallback_c)(sdcardBlockOperation_e operation, uint3
  */
 bool sdcard_init(void);
 
+/**
+ * @brief Forgets the card after it has been pulled out of the slot.
+ * @details The operation in progress is abandoned without calling its
+ *          callback. sdcard_init() must be called for the next card.
+ */
+void sdcard_card_removed(void);
+
+/**
+ * @brief Lowers the SD card clock by one step of the baud rate generator.
+ * @details Called once for every data CRC error and every R1 response which
+ *          reports a command CRC error. The clock is not lowered below the
+ *          initialization clock and is raised a step again after
+ *          sd.clock_recovery block operations without errors.
+ */
+void sdcard_clock_step_down(void);
+
+/**
+ * @brief Gets the identification and capacity of the card, read from its
+ *        CID and CSD registers by sdcard_init().
+ */
+const sdcardMetadata_t* sdcard_getMetadata(void);
+
+/**
+ * @brief Gets the clock of the SPI bus to the SD card in Hz.
+ */
+uint32_t sdcard_get_clock(void);
+
+/**
+ * @brief Prints the SD card clock settings over the uart.
+ */
+void sdcard_print_status(void);
+
 /**
  * Read the 512-byte block with the given index into the given 512-byte buffer.
  *
+ * The buffer must be aligned to SDCARD_BUFFER_ALIGNMENT bytes, an unaligned buffer is refused.
+ *
  * When the read completes, your callback will be called. If the read was successful, the buffer pointer will be the
  * same buffer you originally passed in, otherwise the buffer will be set to NULL.
  *
@@ -77,13 +115,16 @@ bool sdcard_init(void);
  *
  * Returns:
  *     true - The operation was successfully queued for later completion, your callback will be called later
- *     false - The operation could not be started due to the card being busy (try again later).
+ *     false - The operation could not be started due to the card being busy (try again later), or the buffer is not
+ *             aligned.
  */
 bool sdcard_readBlock(uint32_t blockIndex, uint8_t *buffer, sdcard_operationCompleteCallback_c callback, uint32_t callbackData);
 
 /**
  * Write the 512-byte block from the given buffer into the block with the given index.
  *
+ * The buffer must be aligned to SDCARD_BUFFER_ALIGNMENT bytes, an unaligned buffer is refused.
+ *
  * If the write does not complete immediately, your callback will be called later. If the write was successful, the
  * buffer pointer will be the same buffer you originally passed in, otherwise the buffer will be set to NULL.
  *
@@ -93,7 +134,8 @@ bool sdcard_readBlock(uint32_t blockIndex, uint8_t *buffer, sdcard_operationComp
  *                                    that time.
  *     SDCARD_OPERATION_SUCCESS     - Your buffer has been transmitted to the card now.
  *     SDCARD_OPERATION_BUSY        - The card is already busy and cannot accept your write
- *     SDCARD_OPERATION_FAILURE     - Your write was rejected by the card, card will be reset
+ *     SDCARD_OPERATION_FAILURE     - Your write was rejected by the card, card will be reset, or the buffer is not
+ *                                    aligned
  */
 sdcardOperationStatus_e sdcard_writeBlock(uint32_t blockIndex, uint8_t *buffer, sdcard_operationCompleteCallback_c callback, uint32_t callbackData);
 
@@ -129,6 +171,18 @@ sdcardOperationStatus_e sdcard_beginWriteBlocks(uint32_t blockIndex, uint32_t bl
  */
 sdcardOperationStatus_e sdcard_endWriteBlocks();
 
+/**
+ * End a multiple-block read early, sending CMD12 to the card.
+ *
+ * Reads of consecutive blocks are streamed from the card with CMD18, the stream is kept open until a read of another
+ * block, a write, or a call to this function.
+ *
+ * Returns:
+ *     SDCARD_OPERATION_SUCCESS     - The stream is being stopped, or no stream was open.
+ *     SDCARD_OPERATION_BUSY        - A block of the stream is being read, try again later.
+ */
+sdcardOperationStatus_e sdcard_endReadBlocks(void);
+
 void sdcard_setProfilerCallback(sdcard_profilerCallback_c callback);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,269 @@
+// =============================================================================
+// Include statements
+// =============================================================================
+#include <xc.h>
+#include <sys/attribs.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "sdcard_mount.h"
+#include "sdcard.h"
+#include "asyncfatfs.h"
+#include "event_queue.h"
+#include "pinmap.h"
+#include "mcu.h"
+#include "uart.h"
+#include "debug_util.h"
+
+// =============================================================================
+// Private type definitions
+// =============================================================================
+
+// =============================================================================
+// Global variables
+// =============================================================================
+
+// =============================================================================
+// Private constants
+// =============================================================================
+
+// The core timer is incremented every other system clock cycle
+#define CORE_TIMER_FREQ_HZ      (SYSCLK_FREQ_HZ / 2)
+#define TICKS_PER_MS            (CORE_TIMER_FREQ_HZ / 1000u)
+
+#define DEBOUNCE_TICKS          (SDCARD_MOUNT_DEBOUNCE_MS * TICKS_PER_MS)
+
+static const char* const STATE_NAMES[] =
+{
+    "no card",
+    "mounting",
+    "mounted",
+    "failed"
+};
+
+// =============================================================================
+// Private variables
+// =============================================================================
+
+static sdcard_mount_state_t state = SDCARD_MOUNT_NO_CARD;
+
+// Core timer at the last change of the card detect pin
+static volatile uint32_t last_change_count = 0;
+
+// mount_poll is in the event queue
+static volatile bool poll_scheduled = false;
+
+static uint32_t mount_start_count = 0;
+static uint32_t last_mount_ms = 0;
+static bool last_mount_fast = false;
+
+static uint32_t nbr_of_mounts = 0;
+static uint32_t nbr_of_fast_mounts = 0;
+static uint32_t nbr_of_removals = 0;
+static uint32_t nbr_of_failed_mounts = 0;
+
+// =============================================================================
+// Private function declarations
+// =============================================================================
+
+/**
+ * @brief Puts mount_poll in the event queue unless it already is there.
+ * @details May be called from interrupt context.
+ */
+static void schedule_poll(void);
+
+/**
+ * @brief Debounces the card detect switch and runs the mount.
+ * @details Reschedules itself while there is work to do.
+ */
+static int32_t mount_poll(int32_t arg);
+
+/**
+ * @brief Initializes the card and starts mounting its filesystem.
+ */
+static void start_mount(void);
+
+/**
+ * @brief Drops the filesystem and the card after the card was pulled out.
+ */
+static void unmount(void);
+
+// =============================================================================
+// Public function definitions
+// =============================================================================
+
+void sdcard_mount_init(void)
+{
+    SD_CARD_DETECT_PIN_DIRECTION = DIRECTION_INPUT;
+    SD_CARD_DETECT_PULL_UP = 1;
+
+    // Change notice on the detect pin, the mismatch is cleared by reading
+    // the port
+    CNCONDbits.ON = 1;
+    SD_CARD_DETECT_CN_ENABLE = 1;
+    (void)PORTD;
+
+    IPC30bits.CNDIP = 2;    // Interrupt priority
+    IFS3CLR = _IFS3_CNDIF_MASK;
+    IEC3bits.CNDIE = 1;
+
+    // Also lets the pull-up settle before the pin is read
+    last_change_count = _CP0_GET_COUNT();
+    schedule_poll();
+}
+
+sdcard_mount_state_t sdcard_mount_get_state(void)
+{
+    return state;
+}
+
+void sdcard_mount_print_status(void)
+{
+    sprintf(g_debug_util_char_buffer,
+            "\tSlot: %s, card detect %s%s",
+            STATE_NAMES[state],
+            SD_CARD_INSERTED ? "closed" : "open",
+            NEWLINE);
+    uart_write_string(g_debug_util_char_buffer);
+
+    sprintf(g_debug_util_char_buffer,
+            "\t%u mounts (%u from cached geometry), %u failed, %u removals, "
+            "last mount %u ms%s%s",
+            (unsigned int)nbr_of_mounts,
+            (unsigned int)nbr_of_fast_mounts,
+            (unsigned int)nbr_of_failed_mounts,
+            (unsigned int)nbr_of_removals,
+            (unsigned int)last_mount_ms,
+            last_mount_fast ? " (cached)" : "",
+            NEWLINE);
+    uart_write_string(g_debug_util_char_buffer);
+}
+
+// =============================================================================
+// Private function definitions
+// =============================================================================
+
+void __ISR(_CHANGE_NOTICE_D_VECTOR, ipl2) sdcard_detect_isr(void)
+{
+    (void)PORTD;
+    IFS3CLR = _IFS3_CNDIF_MASK;
+
+    last_change_count = _CP0_GET_COUNT();
+    schedule_poll();
+}
+
+static void schedule_poll(void)
+{
+    uint32_t int_status = __builtin_disable_interrupts();
+
+    if (!poll_scheduled)
+    {
+        // A dropped event is scheduled again by the next card detect change
+        poll_scheduled = event_queue_push_callback(&mount_poll,
+                                                   EVENT_QUEUE_NO_ARG,
+                                                   EVENT_PRIO_LOW);
+    }
+
+    __builtin_mtc0(_CP0_STATUS, _CP0_STATUS_SELECT, int_status);
+}
+
+static int32_t mount_poll(int32_t arg)
+{
+    const bool inserted = SD_CARD_INSERTED;
+    const bool stable =
+        (_CP0_GET_COUNT() - last_change_count) >= DEBOUNCE_TICKS;
+    bool busy = false;
+
+    poll_scheduled = false;
+
+    if (!stable)
+    {
+        busy = true;
+    }
+    else if (!inserted && (SDCARD_MOUNT_NO_CARD != state))
+    {
+        unmount();
+    }
+    else if (inserted && (SDCARD_MOUNT_NO_CARD == state))
+    {
+        start_mount();
+        busy = (SDCARD_MOUNT_MOUNTING == state);
+    }
+    else if (SDCARD_MOUNT_MOUNTING == state)
+    {
+        afatfs_poll();
+
+        switch (afatfs_getFilesystemState())
+        {
+        case AFATFS_FILESYSTEM_STATE_READY:
+            last_mount_ms = (_CP0_GET_COUNT() - mount_start_count) /
+                            TICKS_PER_MS;
+            last_mount_fast = afatfs_isFastMount();
+            ++nbr_of_mounts;
+            nbr_of_fast_mounts += last_mount_fast ? 1 : 0;
+            state = SDCARD_MOUNT_MOUNTED;
+
+            sprintf(g_debug_util_char_buffer,
+                    "SD card mounted in %u ms%s%s",
+                    (unsigned int)last_mount_ms,
+                    last_mount_fast ? " from cached geometry" : "",
+                    NEWLINE);
+            uart_write_string(g_debug_util_char_buffer);
+            break;
+
+        case AFATFS_FILESYSTEM_STATE_FATAL:
+            ++nbr_of_failed_mounts;
+            state = SDCARD_MOUNT_FAILED;
+
+            sprintf(g_debug_util_char_buffer,
+                    "%s - SD card filesystem could not be mounted, error %u%s",
+                    ERROR_TAG,
+                    (unsigned int)afatfs_getLastError(),
+                    NEWLINE);
+            uart_write_string(g_debug_util_char_buffer);
+            break;
+
+        default:
+            busy = true;
+            break;
+        }
+    }
+
+    if (busy)
+    {
+        schedule_poll();
+    }
+
+    return 0;
+}
+
+static void start_mount(void)
+{
+    mount_start_count = _CP0_GET_COUNT();
+
+    if (sdcard_init())
+    {
+        afatfs_init();
+        state = SDCARD_MOUNT_MOUNTING;
+    }
+    else
+    {
+        ++nbr_of_failed_mounts;
+        state = SDCARD_MOUNT_FAILED;
+    }
+}
+
+static void unmount(void)
+{
+    // The card is gone, so nothing can be flushed
+    (void)afatfs_destroy(true);
+    sdcard_card_removed();
+
+    ++nbr_of_removals;
+    state = SDCARD_MOUNT_NO_CARD;
+
+    sprintf(g_debug_util_char_buffer, "SD card removed%s", NEWLINE);
+    uart_write_string(g_debug_util_char_buffer);
+}
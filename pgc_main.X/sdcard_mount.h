@@ -0,0 +1,75 @@
+/*
+ * Mounting of the SD card filesystem, following the card detect switch.
+ *
+ * A change notice interrupt on the card detect pin schedules the mount poll
+ * on the event queue. When the switch has been stable for
+ * SDCARD_MOUNT_DEBOUNCE_MS a removed card is forgotten, asyncfatfs is torn
+ * down without flushing since the card is gone, and an inserted card is
+ * initialized and mounted. asyncfatfs remembers the geometry of the last
+ * few cards, so putting one of them back is quick.
+ */
+
+#ifndef SDCARD_MOUNT_H
+#define	SDCARD_MOUNT_H
+
+#ifdef	__cplusplus
+//extern "C" {
+#endif
+
+// =============================================================================
+// Include statements
+// =============================================================================
+#include <stdint.h>
+#include <stdbool.h>
+
+// =============================================================================
+// Public type definitions
+// =============================================================================
+
+typedef enum sdcard_mount_state_t
+{
+    SDCARD_MOUNT_NO_CARD,
+    SDCARD_MOUNT_MOUNTING,          // The filesystem is being initialized
+    SDCARD_MOUNT_MOUNTED,
+    SDCARD_MOUNT_FAILED             // Unusable card, waiting for it to go
+} sdcard_mount_state_t;
+
+// =============================================================================
+// Global constatants
+// =============================================================================
+
+// The card detect switch must be stable this long before it is acted on
+#define SDCARD_MOUNT_DEBOUNCE_MS    (50u)
+
+// =============================================================================
+// Global variable declarations
+// =============================================================================
+
+// =============================================================================
+// Public function declarations
+// =============================================================================
+
+/**
+ * @brief Enables the card detect interrupt and mounts the card if there is
+ *        one in the slot.
+ * @details Must be called after the event queue and spi bus are initialized.
+ */
+void sdcard_mount_init(void);
+
+/**
+ * @brief Gets the state of the card in the slot.
+ */
+sdcard_mount_state_t sdcard_mount_get_state(void);
+
+/**
+ * @brief Prints the state of the slot and the mount statistics over the
+ *        uart.
+ */
+void sdcard_mount_print_status(void);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* SDCARD_MOUNT_H */
+
@@ -0,0 +1,218 @@
+
+// =============================================================================
+// Include statements
+// =============================================================================
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "sdcard_profiler.h"
+#include "mcu.h"
+#include "uart.h"
+#include "debug_util.h"
+
+// =============================================================================
+// Private type definitions
+// =============================================================================
+
+typedef struct operation_statistics_t
+{
+    uint32_t count;             // Successful operations
+    uint32_t failures;
+    uint32_t min_ticks;
+    uint32_t max_ticks;
+    uint64_t total_ticks;
+    uint32_t buckets[SDCARD_PROFILER_NBR_OF_BUCKETS];
+} operation_statistics_t;
+
+// =============================================================================
+// Global variables
+// =============================================================================
+
+// =============================================================================
+// Private constants
+// =============================================================================
+
+// The core timer is incremented every other system clock cycle
+#define CORE_TIMER_FREQ_HZ      (SYSCLK_FREQ_HZ / 2)
+#define TICKS_PER_US            (CORE_TIMER_FREQ_HZ / 1000000u)
+
+#define NBR_OF_OPERATIONS       (3u)
+
+// Width of the histogram bar of the fullest bucket
+#define MAX_BAR_LENGTH          (40u)
+
+static const char* const OPERATION_NAMES[NBR_OF_OPERATIONS] =
+{
+    "read",
+    "write",
+    "erase"
+};
+
+// =============================================================================
+// Private variables
+// =============================================================================
+
+static operation_statistics_t statistics[NBR_OF_OPERATIONS];
+
+// =============================================================================
+// Private function declarations
+// =============================================================================
+
+/**
+ * @brief Gets the histogram bucket of a duration.
+ * @param us - the duration in microseconds.
+ */
+static uint32_t bucket_of(uint32_t us);
+
+/**
+ * @brief Prints the statistics of one operation type.
+ */
+static void print_operation(const char* name,
+                            const operation_statistics_t* operation);
+
+// =============================================================================
+// Public function definitions
+// =============================================================================
+
+void sdcard_profiler_record(sdcardBlockOperation_e operation,
+                            uint32_t ticks,
+                            bool success)
+{
+    operation_statistics_t* operation_statistics;
+
+    if ((uint32_t)operation < NBR_OF_OPERATIONS)
+    {
+        operation_statistics = &statistics[operation];
+
+        if (success)
+        {
+            if ((0 == operation_statistics->count) ||
+                (ticks < operation_statistics->min_ticks))
+            {
+                operation_statistics->min_ticks = ticks;
+            }
+
+            if (ticks > operation_statistics->max_ticks)
+            {
+                operation_statistics->max_ticks = ticks;
+            }
+
+            operation_statistics->total_ticks += ticks;
+            ++operation_statistics->count;
+            ++operation_statistics->buckets[bucket_of(ticks / TICKS_PER_US)];
+        }
+        else
+        {
+            ++operation_statistics->failures;
+        }
+    }
+}
+
+void sdcard_profiler_reset(void)
+{
+    memset(statistics, 0, sizeof(statistics));
+}
+
+void sdcard_profiler_print(void)
+{
+    uint32_t i;
+
+    for (i = 0; i != NBR_OF_OPERATIONS; ++i)
+    {
+        print_operation(OPERATION_NAMES[i], &statistics[i]);
+    }
+}
+
+// =============================================================================
+// Private function definitions
+// =============================================================================
+
+static uint32_t bucket_of(uint32_t us)
+{
+    uint32_t bucket = 0;
+
+    if (us >= 2)
+    {
+        // Index of the highest set bit
+        bucket = 31 - __builtin_clz(us);
+    }
+
+    if (bucket >= SDCARD_PROFILER_NBR_OF_BUCKETS)
+    {
+        bucket = SDCARD_PROFILER_NBR_OF_BUCKETS - 1;
+    }
+
+    return bucket;
+}
+
+static void print_operation(const char* name,
+                            const operation_statistics_t* operation)
+{
+    char bar[MAX_BAR_LENGTH + 1];
+    uint32_t fullest = 0;
+    uint32_t bar_length;
+    uint32_t low_us;
+    uint32_t i;
+
+    sprintf(g_debug_util_char_buffer,
+            "\t%s: %u ok, %u failed, min %u us, mean %u us, max %u us%s",
+            name,
+            (unsigned int)operation->count,
+            (unsigned int)operation->failures,
+            (unsigned int)(operation->min_ticks / TICKS_PER_US),
+            (0 != operation->count) ?
+                (unsigned int)((operation->total_ticks / operation->count) /
+                               TICKS_PER_US) :
+                0u,
+            (unsigned int)(operation->max_ticks / TICKS_PER_US),
+            NEWLINE);
+    uart_write_string(g_debug_util_char_buffer);
+
+    for (i = 0; i != SDCARD_PROFILER_NBR_OF_BUCKETS; ++i)
+    {
+        if (operation->buckets[i] > fullest)
+        {
+            fullest = operation->buckets[i];
+        }
+    }
+
+    for (i = 0; i != SDCARD_PROFILER_NBR_OF_BUCKETS; ++i)
+    {
+        if (0 != operation->buckets[i])
+        {
+            bar_length = (operation->buckets[i] * MAX_BAR_LENGTH) / fullest;
+            if (0 == bar_length)
+            {
+                bar_length = 1;
+            }
+
+            memset(bar, '#', bar_length);
+            bar[bar_length] = '\0';
+
+            low_us = (0 == i) ? 0 : (1u << i);
+
+            if ((SDCARD_PROFILER_NBR_OF_BUCKETS - 1) == i)
+            {
+                sprintf(g_debug_util_char_buffer,
+                        "\t\t%7u us -         : %8u %s%s",
+                        (unsigned int)low_us,
+                        (unsigned int)operation->buckets[i],
+                        bar,
+                        NEWLINE);
+            }
+            else
+            {
+                sprintf(g_debug_util_char_buffer,
+                        "\t\t%7u us - %7u : %8u %s%s",
+                        (unsigned int)low_us,
+                        (unsigned int)((2u << i) - 1),
+                        (unsigned int)operation->buckets[i],
+                        bar,
+                        NEWLINE);
+            }
+            uart_write_string(g_debug_util_char_buffer);
+        }
+    }
+}
@@ -0,0 +1,77 @@
+/*
+ * Latency statistics of the SD card block operations.
+ *
+ * The SD card driver times every read, write and erase with the core timer,
+ * from the start of the command until the card has finished, and records it
+ * here. Each operation type has a histogram with log-scale buckets: bucket 0
+ * counts operations shorter than 2 us, bucket n those from 2^n us up to
+ * 2^(n+1) us, and the last bucket everything longer.
+ *
+ * The same durations are passed to the profiler callback of the driver,
+ * which asyncfatfs writes to ASYNCFAT.LOG when built with
+ * AFATFS_USE_INTROSPECTIVE_LOGGING. sd_log_decode.py decodes that file.
+ */
+
+#ifndef SDCARD_PROFILER_H
+#define	SDCARD_PROFILER_H
+
+#ifdef	__cplusplus
+//extern "C" {
+#endif
+
+// =============================================================================
+// Include statements
+// =============================================================================
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "sdcard.h"
+
+// =============================================================================
+// Public type definitions
+// =============================================================================
+
+// =============================================================================
+// Global constatants
+// =============================================================================
+
+// The last bucket counts operations of 2^19 us, about half a second, or more
+#define SDCARD_PROFILER_NBR_OF_BUCKETS  (20u)
+
+// =============================================================================
+// Global variable declarations
+// =============================================================================
+
+// =============================================================================
+// Public function declarations
+// =============================================================================
+
+/**
+ * @brief Records the duration of one block operation.
+ * @param operation - the type of operation.
+ * @param ticks - core timer ticks the operation took.
+ * @param success - false if the operation failed.
+ */
+void sdcard_profiler_record(sdcardBlockOperation_e operation,
+                            uint32_t ticks,
+                            bool success);
+
+/**
+ * @brief Clears all statistics.
+ * @details The statistics are kept when cards are changed, they are only
+ *          cleared by this.
+ */
+void sdcard_profiler_reset(void);
+
+/**
+ * @brief Prints the statistics and histograms of every operation type over
+ *        the uart.
+ */
+void sdcard_profiler_print(void);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* SDCARD_PROFILER_H */
+
@@ -9,6 +9,13 @@
  * - SPI2 by the GPU
  * - SPI3 by the audio DSP interface
  * - SPI4 by the SD card
+ *
+ * Used DMA channels:
+ * - DMA0 by the SPI3 transmitter
+ * - DMA1 by the SPI4 receiver
+ * - DMA2 by the SPI4 transmitter
+ * - DMA3 by the SPI2 receiver
+ * - DMA4 by the SPI2 transmitter
  */
 
 
@@ -18,6 +25,8 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
 
 #include <xc.h>
 #include <sys/attribs.h>
@@ -27,20 +36,31 @@
 #include "pinmap.h"
 #include "uart.h"
 #include "debug_util.h"
+#include "ring_buffer.h"
+#include "tunables.h"
 
 // =============================================================================
 // Private type definitions
 // =============================================================================
 
-#define SPI_WRITE_BUFFER_SIZE (64u)
-
-typedef struct transmit_fifo_t
+// One buffer to stream to SPI3BUF with DMA
+typedef struct spi3_dma_descriptor_t
 {
-    uint32_t buffer[SPI_WRITE_BUFFER_SIZE];
-    uint32_t first;
-    uint32_t last;
-    uint32_t size;
-} transmit_fifo_t;
+    const uint32_t* data;
+    uint32_t nbr_of_words;
+    spi_transfer_complete_t callback;
+    int32_t arg;
+} spi3_dma_descriptor_t;
+
+// A block transfer on a SPI module with a receive and a transmit DMA channel
+typedef struct spi_block_transfer_t
+{
+    volatile bool busy;
+    uint8_t* rx_data;
+    uint32_t nbr_of_bytes;
+    spi_transfer_complete_t callback;
+    int32_t arg;
+} spi_block_transfer_t;
 
 // =============================================================================
 // Global variables
@@ -49,24 +69,131 @@ typedef struct transmit_fifo_t
 // =============================================================================
 // Private constants
 // =============================================================================
-static const uint32_t SPI3_BAUD = 1000000;
+// Words, for data copied by spi_write_dword/spi_write_dword_vect
+#define SPI3_STAGING_BUFFER_SIZE    (256u)
+
+// Number of buffers which can be queued for the SPI3 DMA channel
+#define SPI3_DMA_QUEUE_SIZE         (16u)
+
+// The DMA source size register is 16 bits wide
+#define SPI3_DMA_MAX_WORDS          (0xFFFFu / sizeof(uint32_t))
+
+// Bytes, for spi_block_transfer_async
+#define BLOCK_TRANSFER_MAX_BYTES    (SPI_MAX_BLOCK_TRANSFER_SIZE)
+
+// Data cache line size of the PIC32MZ
+#define DCACHE_LINE_SIZE            (16u)
+
+// Depth of the 128 bit enhanced buffer FIFOs in 32 bit mode
+#define SPI_FIFO_WORDS              (4u)
+
+// The FT801 accepts at most 11 MHz until its clock has been set up
+#define SPI2_DEFAULT_BAUD   (10000000u)
+
+#define SPI3_DEFAULT_BAUD   (1000000u)
 
 // Use a lower baud when initializing the SD card
-static const uint32_t SPI4_BAUD = 200000;
+#define SPI4_DEFAULT_BAUD   (200000u)
+
+// Limits of the baud rate generator with the 100 MHz peripheral bus clock
+#define SPI_MIN_BAUD        (100000u)
+#define SPI_MAX_BAUD        (25000000u)
 
 // =============================================================================
 // Private variables
 // =============================================================================
+static bool spi2_initialized = false;
 static bool spi3_initialized = false;
 static bool spi4_initialized = false;
 
-// Circular FIFO write buffer
-transmit_fifo_t spi3_transmit_fifo;
+static uint32_t spi2_baud = SPI2_DEFAULT_BAUD;
+static uint32_t spi3_baud = SPI3_DEFAULT_BAUD;
+static uint32_t spi4_baud = SPI4_DEFAULT_BAUD;
+
+// Copies of the data written with spi3_write_vector. Produced by
+// spi3_write_vector and released by the DMA ISR once the data has been sent.
+// Not cached, so the DMA controller always sees what the CPU wrote.
+static uint32_t __attribute__((coherent))
+    spi3_staging_buffer[SPI3_STAGING_BUFFER_SIZE];
+static ring_buffer_u32_t spi3_staging_fifo =
+{
+    {0, 0, SPI3_STAGING_BUFFER_SIZE - 1},
+    spi3_staging_buffer
+};
+
+// Buffers waiting to be sent, the head is the one DMA0 is sending.
+// Produced by the main loop and consumed by the DMA ISR.
+static spi3_dma_descriptor_t spi3_dma_queue[SPI3_DMA_QUEUE_SIZE];
+static ring_buffer_t spi3_dma_ring = {0, 0, SPI3_DMA_QUEUE_SIZE - 1};
+static volatile bool spi3_dma_busy = false;
+
+// Sent by the transmit DMA channels when there is no data to send. A channel
+// moves a block of max(source size, destination size) bytes, so a single
+// 0xFF byte would only give one byte per block.
+static const uint8_t block_fill_bytes[BLOCK_TRANSFER_MAX_BYTES] =
+{
+    [0 ... BLOCK_TRANSFER_MAX_BYTES - 1] = 0xFF
+};
+
+// Written by the receive DMA channels when the received data is not wanted
+static uint8_t __attribute__((coherent))
+    block_sink_bytes[BLOCK_TRANSFER_MAX_BYTES];
+
+// The block transfers in progress
+static spi_block_transfer_t spi2_block_transfer;
+static spi_block_transfer_t spi4_block_transfer;
 
 // =============================================================================
 // Private function declarations
 // =============================================================================
 
+/**
+ * @brief Initializes the SPI2 module for the FT801 graphics controller.
+ */
+static void spi2_initialize(void);
+
+/**
+ * @brief Sends and recieves one byte over the spi2 interface.
+ * @param data_to_send - the byte to send.
+ * @return The byte received from the spi transaction.
+ */
+static uint8_t spi2_tranceive_blocking(uint8_t data_to_send);
+
+/**
+ * @brief Starts a block transfer on SPI2 with DMA3 and DMA4.
+ * @details Same as spi4_dma_transfer.
+ */
+static bool spi2_dma_transfer(const uint8_t* tx_data,
+                              uint8_t* rx_data,
+                              uint32_t nbr_of_bytes,
+                              spi_transfer_complete_t callback,
+                              int32_t arg);
+
+/**
+ * @brief Writes the spi2_baud tunable to the baud rate generator.
+ */
+static void spi2_update_baud(void);
+
+/**
+ * @brief Claims a block transfer and prepares its buffers for DMA.
+ * @details Replaces missing buffers with the fill and sink buffers.
+ * @param transfer - the block transfer state of the SPI module.
+ * @param tx_data - the bytes to send, replaced if NULL.
+ * @param rx_data - where to store the received bytes, replaced if NULL.
+ * @return false if a block transfer is already in progress.
+ */
+static bool block_transfer_begin(spi_block_transfer_t* transfer,
+                                 const uint8_t** tx_data,
+                                 uint8_t** rx_data,
+                                 uint32_t nbr_of_bytes,
+                                 spi_transfer_complete_t callback,
+                                 int32_t arg);
+
+/**
+ * @brief Finishes a block transfer, called from the receive DMA ISR.
+ */
+static void block_transfer_end(spi_block_transfer_t* transfer);
+
 /**
  * @brief Initializes the SPI3 module and sets it up for communicating
  *        with the audio DSP.
@@ -84,33 +211,82 @@ static void spi3_write(uint32_t data);
 
 /**
  * @brief Sends several 32 bit values using the spi3 module
+ * @details The values are copied to the staging buffer, so v can be reused
+ *          as soon as the function returns. Blocks while the staging buffer
+ *          or the DMA queue is full.
  * @param v - array with the values to send.
  * @param number_of_elements - number of elements to send.
  */
-static void spi3_write_vector(uint32_t* v, uint32_t number_of_elements);
+static void spi3_write_vector(const uint32_t* v, uint32_t number_of_elements);
 
 /**
- * @brief Starts the transmission of the SPI3 tx FIFO buffer.
- * @return void
+ * @brief Sends and receives one word over the spi3 interface.
+ * @details Waits for the DMA channel to finish first, so the word is written
+ *          to SPI3BUF directly.
+ * @param data_to_send - the word to send.
+ * @return The word received from the spi transaction.
+ */
+static uint32_t spi3_tranceive_blocking(uint32_t data_to_send);
+
+/**
+ * @brief Queues a buffer for the SPI3 DMA channel.
+ * @param data - the words to send, must stay valid until the callback.
+ * @param nbr_of_words - number of words, at most SPI3_DMA_MAX_WORDS.
+ * @param callback - called from the DMA ISR when sent, or NULL.
+ * @param arg - passed to the callback.
+ * @return false if the DMA queue is full.
  */
-static void spi3_start_tx(void);
+static bool spi3_dma_enqueue(const uint32_t* data,
+                             uint32_t nbr_of_words,
+                             spi_transfer_complete_t callback,
+                             int32_t arg);
 
 /**
- * @brief Masks out the spi3 tx interrupt.
+ * @brief Starts DMA0 on the buffer at the head of the DMA queue.
+ * @details Must be called with the DMA0 interrupt masked or from its ISR.
+ *          Marks the channel as idle if the queue is empty.
  */
-static inline void spi3_disable_tx_interrupt(void)
+static void spi3_dma_start_next(void);
+
+/**
+ * @brief Releases staging buffer words sent by the DMA channel.
+ * @param arg - number of words to release.
+ */
+static void spi3_staging_release(int32_t arg);
+
+/**
+ * @brief Masks out the DMA0 interrupt.
+ */
+static inline void spi3_disable_dma_interrupt(void)
 {
-    IEC4bits.SPI3TXIE = 0;
+    IEC4bits.DMA0IE = 0;
 }
 
 /**
- * @brief Enables the spi3 tx interrupt.
+ * @brief Enables the DMA0 interrupt.
  */
-static inline void spi3_enable_tx_interrupt(void)
+static inline void spi3_enable_dma_interrupt(void)
 {
-    IEC4bits.SPI3TXIE = 1;
+    IEC4bits.DMA0IE = 1;
 }
 
+/**
+ * @brief Writes back the data cache lines of a buffer to memory.
+ * @details Needed before the DMA controller reads a buffer in cached memory.
+ * @param data - start of the buffer.
+ * @param size - size of the buffer in bytes.
+ */
+static void dcache_writeback(const void* data, uint32_t size);
+
+/**
+ * @brief Discards the data cache lines of a buffer.
+ * @details Needed before the CPU reads a buffer the DMA controller has
+ *          written to. Lines partly outside the buffer are discarded too.
+ * @param data - start of the buffer.
+ * @param size - size of the buffer in bytes.
+ */
+static void dcache_invalidate(const void* data, uint32_t size);
+
 /**
  * @brief Initializes the spi4 module for the SD card inteface.
  */
@@ -123,6 +299,68 @@ static void spi4_initialize();
  */
 uint8_t spi4_tranceive_blocking(uint8_t data_to_send);
 
+/**
+ * @brief Exchanges a block of bytes over the spi4 interface without DMA.
+ * @details Whole 32 bit words are shifted in 32 bit mode, keeping the FIFO
+ *          full, the remaining bytes in 8 bit mode.
+ * @param tx_data - the bytes to send, or NULL to send 0xFF.
+ * @param rx_data - where to store the received bytes, or NULL.
+ * @param nbr_of_bytes - number of bytes.
+ */
+static void spi4_block_tranceive_blocking(const uint8_t* tx_data,
+                                          uint8_t* rx_data,
+                                          uint32_t nbr_of_bytes);
+
+/**
+ * @brief Switches SPI4 between 8 bit and 32 bit transmissions.
+ * @details The module must be idle with an empty receive FIFO.
+ * @param use_32_bit - true for 32 bit mode, false for 8 bit mode.
+ */
+static void spi4_set_32_bit_mode(bool use_32_bit);
+
+/**
+ * @brief Starts a block transfer on SPI4 with DMA1 and DMA2.
+ * @param tx_data - the bytes to send, or NULL to send 0xFF.
+ * @param rx_data - where to store the received bytes, or NULL.
+ * @param nbr_of_bytes - number of bytes, at most BLOCK_TRANSFER_MAX_BYTES.
+ * @param callback - called from the DMA1 ISR when done, or NULL.
+ * @param arg - passed to the callback.
+ * @return false if a block transfer is already in progress.
+ */
+static bool spi4_dma_transfer(const uint8_t* tx_data,
+                              uint8_t* rx_data,
+                              uint32_t nbr_of_bytes,
+                              spi_transfer_complete_t callback,
+                              int32_t arg);
+
+/**
+ * @brief Writes the spi3_baud tunable to the baud rate generator.
+ * @details Waits for the tx FIFO to empty before the module is turned off.
+ */
+static void spi3_update_baud(void);
+
+static const tunable_t spi2_baud_tunable =
+{
+    "spi2.baud",
+    TUNABLE_TYPE_UINT32,
+    &spi2_baud,
+    SPI_MIN_BAUD,
+    SPI_MAX_BAUD,
+    NULL,
+    &spi2_update_baud
+};
+
+static const tunable_t spi3_baud_tunable =
+{
+    "spi3.baud",
+    TUNABLE_TYPE_UINT32,
+    &spi3_baud,
+    SPI_MIN_BAUD,
+    SPI_MAX_BAUD,
+    NULL,
+    &spi3_update_baud
+};
+
 // =============================================================================
 // Public function definitions
 // =============================================================================
@@ -131,6 +369,10 @@ void spi_init(spi_device_t spi_device)
 {
     switch (spi_device)
     {
+    case SPI_DEVICE_FT801:
+        spi2_initialize();
+        break;
+
     case SPI_DEVICE_DSP:
         spi3_initialize();
         break;
@@ -150,6 +392,10 @@ uint8_t spi_byte_tranceive_blocking(spi_device_t spi_device,
 
     switch (spi_device)
     {
+    case SPI_DEVICE_FT801:
+        returned_byte = spi2_tranceive_blocking(data_to_send);
+        break;
+
     case SPI_DEVICE_SDCARD:
         returned_byte = spi4_tranceive_blocking(data_to_send);
 
@@ -160,6 +406,24 @@ uint8_t spi_byte_tranceive_blocking(spi_device_t spi_device,
     return returned_byte;
 }
 
+uint32_t spi_dword_tranceive_blocking(spi_device_t spi_device,
+                                      uint32_t data_to_send)
+{
+    uint32_t returned_dword = 0x00000000;
+
+    switch (spi_device)
+    {
+    case SPI_DEVICE_DSP:
+        returned_dword = spi3_tranceive_blocking(data_to_send);
+        break;
+
+    default:
+        break;
+    }
+
+    return returned_dword;
+}
+
 void spi_write_dword(spi_device_t spi_device, uint32_t data)
 {
     switch (spi_device)
@@ -188,6 +452,205 @@ void spi_write_dword_vect(spi_device_t spi_device,
     }
 }
 
+bool spi_write_dword_vect_async(spi_device_t spi_device,
+                                const uint32_t data[],
+                                uint32_t number_of_elements,
+                                spi_transfer_complete_t callback,
+                                int32_t arg)
+{
+    bool queued = false;
+
+    switch (spi_device)
+    {
+    case SPI_DEVICE_DSP:
+        if ((0 != number_of_elements) &&
+            (number_of_elements <= SPI3_DMA_MAX_WORDS))
+        {
+            dcache_writeback(data, number_of_elements * sizeof(uint32_t));
+            queued = spi3_dma_enqueue(data, number_of_elements, callback, arg);
+        }
+        break;
+
+    default:
+        break;
+    }
+
+    return queued;
+}
+
+bool spi_block_transfer_async(spi_device_t spi_device,
+                              const uint8_t tx_data[],
+                              uint8_t rx_data[],
+                              uint32_t number_of_bytes,
+                              spi_transfer_complete_t callback,
+                              int32_t arg)
+{
+    bool started = false;
+
+    if ((0 != number_of_bytes) &&
+        (number_of_bytes <= BLOCK_TRANSFER_MAX_BYTES))
+    {
+        switch (spi_device)
+        {
+        case SPI_DEVICE_FT801:
+            started = spi2_dma_transfer(tx_data,
+                                        rx_data,
+                                        number_of_bytes,
+                                        callback,
+                                        arg);
+            break;
+
+        case SPI_DEVICE_SDCARD:
+            started = spi4_dma_transfer(tx_data,
+                                        rx_data,
+                                        number_of_bytes,
+                                        callback,
+                                        arg);
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    return started;
+}
+
+void spi_block_tranceive_blocking(spi_device_t spi_device,
+                                  const uint8_t tx_data[],
+                                  uint8_t rx_data[],
+                                  uint32_t number_of_bytes)
+{
+    uint8_t received;
+    uint32_t i;
+
+    switch (spi_device)
+    {
+    case SPI_DEVICE_SDCARD:
+        spi4_block_tranceive_blocking(tx_data, rx_data, number_of_bytes);
+        break;
+
+    default:
+        for (i = 0; i != number_of_bytes; ++i)
+        {
+            received = spi_byte_tranceive_blocking(
+                spi_device,
+                (NULL != tx_data) ? tx_data[i] : 0xFF);
+
+            if (NULL != rx_data)
+            {
+                rx_data[i] = received;
+            }
+        }
+        break;
+    }
+}
+
+bool spi_block_transfer_busy(spi_device_t spi_device)
+{
+    bool busy = false;
+
+    switch (spi_device)
+    {
+    case SPI_DEVICE_FT801:
+        busy = spi2_block_transfer.busy;
+        break;
+
+    case SPI_DEVICE_SDCARD:
+        busy = spi4_block_transfer.busy;
+        break;
+
+    default:
+        break;
+    }
+
+    return busy;
+}
+
+void spi_flush(spi_device_t spi_device)
+{
+    switch (spi_device)
+    {
+    case SPI_DEVICE_DSP:
+        while (spi3_dma_busy ||
+               !SPI3STATbits.SPITBE ||
+               SPI3STATbits.SPIBUSY)
+        {
+            ;   // Let the DMA channel send what is already queued
+        }
+        break;
+
+    case SPI_DEVICE_SDCARD:
+        while (spi4_block_transfer.busy || SPI4STATbits.SPIBUSY)
+        {
+            ;
+        }
+        break;
+
+    case SPI_DEVICE_FT801:
+        while (spi2_block_transfer.busy || SPI2STATbits.SPIBUSY)
+        {
+            ;
+        }
+        break;
+
+    default:
+        break;
+    }
+}
+
+void spi_set_clock(spi_device_t spi_device, uint32_t clock_hz)
+{
+    switch (spi_device)
+    {
+    case SPI_DEVICE_FT801:
+        spi2_baud = clock_hz;
+        spi2_update_baud();
+        break;
+
+    case SPI_DEVICE_DSP:
+        spi3_baud = clock_hz;
+        spi3_update_baud();
+        break;
+
+    case SPI_DEVICE_SDCARD:
+        spi_update_sd_card_baud(clock_hz);
+        break;
+
+    default:
+        break;
+    }
+}
+
+void spi_set_mode(spi_device_t spi_device, uint8_t mode)
+{
+    // SPI mode 0 and 2 shift out data on the active to idle clock edge
+    const uint8_t clock_polarity = (mode >> 1) & 0x01;
+    const uint8_t clock_edge = (0 == (mode & 0x01)) ? 1 : 0;
+
+    switch (spi_device)
+    {
+    case SPI_DEVICE_FT801:
+        spi_flush(SPI_DEVICE_FT801);
+        SPI2CONbits.ON = 0;
+        SPI2CONbits.CKP = clock_polarity;
+        SPI2CONbits.CKE = clock_edge;
+        SPI2CONbits.ON = 1;
+        break;
+
+    case SPI_DEVICE_SDCARD:
+        spi_flush(SPI_DEVICE_SDCARD);
+        SPI4CONbits.ON = 0;
+        SPI4CONbits.CKP = clock_polarity;
+        SPI4CONbits.CKE = clock_edge;
+        SPI4CONbits.ON = 1;
+        break;
+
+    default:
+        break;
+    }
+}
+
 void spi_update_sd_card_baud(uint32_t new_baud)
 {
     while (SPI4STATbits.SPIBUSY)
@@ -197,7 +660,8 @@ void spi_update_sd_card_baud(uint32_t new_baud)
     SPI4CONbits.ON = 0;
 
     // Set the baud rate
-    SPI4BRG = (PBCLK_FREQ_HZ / new_baud) / 2 - 1;
+    spi4_baud = new_baud;
+    SPI4BRG = (PBCLK_FREQ_HZ / spi4_baud) / 2 - 1;
 
     SPI4CONbits.ON = 1;
 }
@@ -206,6 +670,24 @@ void spi_print_debug_status(spi_device_t spi_device)
 {
     switch (spi_device)
     {
+    case SPI_DEVICE_FT801:
+        sprintf(g_debug_util_char_buffer, "\tSPI2CON: %X", SPI2CON);
+        uart_write_string(g_debug_util_char_buffer);
+        uart_write_string(NEWLINE);
+
+        sprintf(g_debug_util_char_buffer, "\tSPI2CON2: %X", SPI2CON2);
+        uart_write_string(g_debug_util_char_buffer);
+        uart_write_string(NEWLINE);
+
+        sprintf(g_debug_util_char_buffer, "\tSPI2STAT: %X", SPI2STAT);
+        uart_write_string(g_debug_util_char_buffer);
+        uart_write_string(NEWLINE);
+
+        sprintf(g_debug_util_char_buffer, "\tSPI2BRG: %X", SPI2BRG);
+        uart_write_string(g_debug_util_char_buffer);
+        uart_write_string(NEWLINE);
+        break;
+
     case SPI_DEVICE_DSP:
         sprintf(g_debug_util_char_buffer, "\tSPI3CON: %X", SPI3CON);
         uart_write_string(g_debug_util_char_buffer);
@@ -251,34 +733,54 @@ void spi_print_debug_status(spi_device_t spi_device)
 // Private function definitions
 // =============================================================================
 
-void __ISR(_SPI3_TX_VECTOR, ipl4) spi3_isr(void)
+void __ISR(_DMA0_VECTOR, ipl4) spi3_dma_isr(void)
 {
-    volatile uint32_t dummy;
+    spi3_dma_descriptor_t finished;
+    bool block_done = DCH0INTbits.CHBCIF;
 
-    IFS4bits.SPI3TXIF = 0;
-    dummy = SPI3BUF;
+    // Clear the channel flags before the interrupt flag, as it is persistent
+    DCH0INTCLR = _DCH0INT_CHBCIF_MASK | _DCH0INT_CHERIF_MASK;
+    IFS4CLR = _IFS4_DMA0IF_MASK;
 
-    if (0 != spi3_transmit_fifo.size)
+    if (block_done)
     {
-        while ((!SPI3STATbits.SPITBF) && (0 != spi3_transmit_fifo.size))
-        {
-            SPI3BUF = spi3_transmit_fifo.buffer[spi3_transmit_fifo.first];
-            spi3_transmit_fifo.size--;
+        finished = spi3_dma_queue[ring_buffer_head_index(&spi3_dma_ring)];
+        ring_buffer_consume(&spi3_dma_ring, 1);
 
-            if (0 != spi3_transmit_fifo.size)
-            {
-                spi3_transmit_fifo.first++;
+        spi3_dma_start_next();
 
-                if (SPI_WRITE_BUFFER_SIZE == spi3_transmit_fifo.first)
-                {
-                    spi3_transmit_fifo.first = 0;
-                }
-            }
+        if (NULL != finished.callback)
+        {
+            finished.callback(finished.arg);
         }
     }
-    else
+}
+
+void __ISR(_DMA1_VECTOR, ipl4) spi4_dma_isr(void)
+{
+    bool block_done = DCH1INTbits.CHBCIF;
+
+    // Clear the channel flags before the interrupt flag, as it is persistent
+    DCH1INTCLR = _DCH1INT_CHBCIF_MASK | _DCH1INT_CHERIF_MASK;
+    IFS4CLR = _IFS4_DMA1IF_MASK;
+
+    // The receiver finishes last, so the whole block has been exchanged
+    if (block_done)
+    {
+        block_transfer_end(&spi4_block_transfer);
+    }
+}
+
+void __ISR(_DMA3_VECTOR, ipl4) spi2_dma_isr(void)
+{
+    bool block_done = DCH3INTbits.CHBCIF;
+
+    DCH3INTCLR = _DCH3INT_CHBCIF_MASK | _DCH3INT_CHERIF_MASK;
+    IFS4CLR = _IFS4_DMA3IF_MASK;
+
+    if (block_done)
     {
-        spi3_disable_tx_interrupt();
+        block_transfer_end(&spi2_block_transfer);
     }
 }
 
@@ -308,7 +810,11 @@ static void spi3_initialize(void)
 
     if (false == spi3_initialized)
     {
-        memset(&spi3_transmit_fifo, 0, sizeof(transmit_fifo_t));
+        ring_buffer_u32_init(&spi3_staging_fifo,
+                             spi3_staging_buffer,
+                             SPI3_STAGING_BUFFER_SIZE);
+        ring_buffer_init(&spi3_dma_ring, SPI3_DMA_QUEUE_SIZE);
+        spi3_dma_busy = false;
 
         //
         // IO ports
@@ -352,17 +858,14 @@ static void spi3_initialize(void)
         // Use the hardware RX and TX FIFO in the SPI3 module
         SPI3CONbits.ENHBUF = 1;
 
-        // Use the TX interrupt
+        // Use the TX interrupt flag as a DMA trigger
         IFS4bits.SPI3TXIF = 0;  // Clear interrupt flag
-        IPC39bits.SPI3TXIP = 4; // Interrup priority
-        IEC4bits.SPI3TXIE = 1;  // Enable the interrupt
 
-        // SPIxTXIF is set when the last transfer is shifted out of SPISR and
-        // transmit operations are complete.
-        SPI3CONbits.STXISEL = 0;
+        // SPIxTXIF is set while the transmit buffer is not full
+        SPI3CONbits.STXISEL = 3;
 
         // Set the baud rate
-        SPI3BRG = (PBCLK_FREQ_HZ / SPI3_BAUD) / 2 - 1;
+        SPI3BRG = (PBCLK_FREQ_HZ / spi3_baud) / 2 - 1;
 
         SPI3STATbits.SPIROV = 0;
 
@@ -380,6 +883,33 @@ static void spi3_initialize(void)
 
         SPI3CONbits.ON = 1;
 
+        //
+        // DMA0, moves one word to SPI3BUF each time SPI3TXIF is set
+        //
+        DMACONbits.ON = 1;
+
+        IEC4bits.DMA0IE = 0;
+        IFS4bits.DMA0IF = 0;
+
+        DCH0CON = 0x00000000;
+        DCH0CONbits.CHPRI = 3;              // Highest channel priority
+
+        DCH0ECON = 0x00000000;
+        DCH0ECONbits.CHSIRQ = _SPI3_TX_VECTOR;
+        DCH0ECONbits.SIRQEN = 1;            // Start a cell transfer on CHSIRQ
+
+        DCH0DSA = KVA_TO_PA(&SPI3BUF);
+        DCH0DSIZ = sizeof(uint32_t);
+        DCH0CSIZ = sizeof(uint32_t);        // One word per SPI3TXIF event
+
+        DCH0INTCLR = 0x00FF00FF;            // Clear all flags and enables
+        DCH0INTbits.CHBCIE = 1;             // Interrupt when a block is done
+
+        IPC33bits.DMA0IP = 4;
+        IEC4bits.DMA0IE = 1;
+
+        tunables_register(&spi3_baud_tunable);
+
         spi3_initialized = true;
     }
 }
@@ -389,58 +919,165 @@ static void spi3_write(uint32_t data)
     spi3_write_vector(&data, 1);
 }
 
-static void spi3_write_vector(uint32_t v[], uint32_t number_of_elements)
+static void spi3_write_vector(const uint32_t v[], uint32_t number_of_elements)
 {
-    uint32_t i;
-    bool tx_isr_was_enabled = IEC4bits.SPI3TXIE;
+    uint32_t index;
+    uint32_t chunk;
 
-    spi3_disable_tx_interrupt();
-
-    for (i = 0; i != number_of_elements; ++i)
+    while (0 != number_of_elements)
     {
-        if (0 != spi3_transmit_fifo.size)
+        // The DMA ISR frees up space concurrently.
+        chunk = ring_buffer_write_span(&spi3_staging_fifo.ring, &index);
+
+        if (chunk > number_of_elements)
         {
-            spi3_transmit_fifo.last++;
+            chunk = number_of_elements;
         }
 
-        if (SPI_WRITE_BUFFER_SIZE == spi3_transmit_fifo.last)
+        if (0 != chunk)
         {
-            spi3_transmit_fifo.last = 0;
+            memcpy(&spi3_staging_buffer[index], v, chunk * sizeof(uint32_t));
+            ring_buffer_produce(&spi3_staging_fifo.ring, chunk);
+
+            while (!spi3_dma_enqueue(&spi3_staging_buffer[index],
+                                     chunk,
+                                     &spi3_staging_release,
+                                     (int32_t)chunk))
+            {
+                ;   // Wait for the DMA queue
+            }
+
+            v += chunk;
+            number_of_elements -= chunk;
         }
+    }
+}
+
+static uint32_t spi3_tranceive_blocking(uint32_t data_to_send)
+{
+    volatile uint32_t received = 0;
+
+    spi_flush(SPI_DEVICE_DSP);
 
-        spi3_transmit_fifo.buffer[spi3_transmit_fifo.last] = v[i];
-        spi3_transmit_fifo.size++;
+    // Discard what was received while the DMA channel was sending
+    while (!SPI3STATbits.SPIRBE)
+    {
+        received = SPI3BUF;
     }
 
-    if (tx_isr_was_enabled)
+    SPI3BUF = data_to_send;
+
+    while (SPI3STATbits.SPIRBE)
     {
-        spi3_enable_tx_interrupt();
+        ;   // Wait for the transaction to complete
     }
 
-    spi3_start_tx();
+    received = SPI3BUF;
+
+    return received;
 }
 
-static void spi3_start_tx(void)
+static bool spi3_dma_enqueue(const uint32_t* data,
+                             uint32_t nbr_of_words,
+                             spi_transfer_complete_t callback,
+                             int32_t arg)
 {
-    spi3_disable_tx_interrupt();
+    spi3_dma_descriptor_t* descriptor;
+    bool queued = false;
+
+    spi3_disable_dma_interrupt();
 
-    while ((!SPI3STATbits.SPITBF) && (0 != spi3_transmit_fifo.size))
+    if (!ring_buffer_is_full(&spi3_dma_ring))
     {
-        SPI3BUF = spi3_transmit_fifo.buffer[spi3_transmit_fifo.first];
-        spi3_transmit_fifo.size--;
+        descriptor = &spi3_dma_queue[ring_buffer_tail_index(&spi3_dma_ring)];
+        descriptor->data = data;
+        descriptor->nbr_of_words = nbr_of_words;
+        descriptor->callback = callback;
+        descriptor->arg = arg;
+        ring_buffer_produce(&spi3_dma_ring, 1);
+
+        if (!spi3_dma_busy)
+        {
+            spi3_dma_start_next();
+        }
 
-        if (0 != spi3_transmit_fifo.size)
+        queued = true;
+    }
+
+    spi3_enable_dma_interrupt();
+
+    return queued;
+}
+
+static void spi3_dma_start_next(void)
+{
+    const spi3_dma_descriptor_t* descriptor;
+
+    if (!ring_buffer_is_empty(&spi3_dma_ring))
+    {
+        descriptor = &spi3_dma_queue[ring_buffer_head_index(&spi3_dma_ring)];
+
+        DCH0SSA = KVA_TO_PA(descriptor->data);
+        DCH0SSIZ = descriptor->nbr_of_words * sizeof(uint32_t);
+        DCH0INTCLR = 0x000000FF;
+        DCH0CONbits.CHEN = 1;
+
+        spi3_dma_busy = true;
+    }
+    else
+    {
+        spi3_dma_busy = false;
+    }
+}
+
+static void spi3_staging_release(int32_t arg)
+{
+    ring_buffer_consume(&spi3_staging_fifo.ring, (uint32_t)arg);
+}
+
+static void dcache_writeback(const void* data, uint32_t size)
+{
+    uint32_t address = (uint32_t)data & ~(DCACHE_LINE_SIZE - 1);
+    uint32_t end = (uint32_t)data + size;
+
+    // Only KSEG0 is cached, KSEG1 addresses go straight to memory.
+    if ((address >= 0x80000000u) && (address < 0xA0000000u))
+    {
+        for (; address < end; address += DCACHE_LINE_SIZE)
         {
-            spi3_transmit_fifo.first++;
+            // Hit_Writeback_Inv_D
+            __asm__ __volatile__("cache 0x15, 0(%0)" : : "r"(address));
+        }
 
-            if (SPI_WRITE_BUFFER_SIZE == spi3_transmit_fifo.first)
-            {
-                spi3_transmit_fifo.first = 0;
-            }
+        __asm__ __volatile__("sync" : : : "memory");
+    }
+}
+
+static void dcache_invalidate(const void* data, uint32_t size)
+{
+    uint32_t address = (uint32_t)data & ~(DCACHE_LINE_SIZE - 1);
+    uint32_t end = (uint32_t)data + size;
+
+    if ((address >= 0x80000000u) && (address < 0xA0000000u))
+    {
+        for (; address < end; address += DCACHE_LINE_SIZE)
+        {
+            // Hit_Invalidate_D
+            __asm__ __volatile__("cache 0x11, 0(%0)" : : "r"(address));
         }
+
+        __asm__ __volatile__("sync" : : : "memory");
     }
+}
+
+static void spi3_update_baud(void)
+{
+    spi_flush(SPI_DEVICE_DSP);
+    SPI3CONbits.ON = 0;
+
+    SPI3BRG = (PBCLK_FREQ_HZ / spi3_baud) / 2 - 1;
 
-    spi3_enable_tx_interrupt();
+    SPI3CONbits.ON = 1;
 }
 
 static void spi4_initialize()
@@ -495,14 +1132,18 @@ static void spi4_initialize()
         // Use the hardware RX and TX FIFO in the SPI4 module
         SPI4CONbits.ENHBUF = 1;
 
-        // Use the TX interrupt flag as a DMA trigger
+        // Use the TX and RX interrupt flags as DMA triggers
         IFS5bits.SPI4TXIF = 0;  // Clear interrupt flag
+        IFS5bits.SPI4RXIF = 0;
 
-        // SPIxTXIF is set when the buffer is empty by one-half or more
-        SPI4CONbits.STXISEL = 2;
+        // SPIxTXIF is set while the transmit buffer is not full
+        SPI4CONbits.STXISEL = 3;
+
+        // SPIxRXIF is set while the receive buffer is not empty
+        SPI4CONbits.SRXISEL = 1;
 
         // Set the baud rate
-        SPI4BRG = (PBCLK_FREQ_HZ / SPI4_BAUD) / 2 - 1;
+        SPI4BRG = (PBCLK_FREQ_HZ / spi4_baud) / 2 - 1;
 
         SPI4STATbits.SPIROV = 0;
 
@@ -522,6 +1163,47 @@ static void spi4_initialize()
 
         SPI4CONbits.ON = 1;
 
+        //
+        // DMA1 moves one byte from SPI4BUF each time SPI4RXIF is set,
+        // DMA2 moves one byte to SPI4BUF each time SPI4TXIF is set.
+        //
+        DMACONbits.ON = 1;
+
+        IEC4bits.DMA1IE = 0;
+        IFS4bits.DMA1IF = 0;
+        IEC4bits.DMA2IE = 0;
+        IFS4bits.DMA2IF = 0;
+
+        DCH1CON = 0x00000000;
+        DCH1CONbits.CHPRI = 3;              // Drain the receiver first
+
+        DCH1ECON = 0x00000000;
+        DCH1ECONbits.CHSIRQ = _SPI4_RX_VECTOR;
+        DCH1ECONbits.SIRQEN = 1;            // Start a cell transfer on CHSIRQ
+
+        DCH1SSA = KVA_TO_PA(&SPI4BUF);
+        DCH1SSIZ = sizeof(uint8_t);
+        DCH1CSIZ = sizeof(uint8_t);         // One byte per SPI4RXIF event
+
+        DCH1INTCLR = 0x00FF00FF;            // Clear all flags and enables
+        DCH1INTbits.CHBCIE = 1;             // Interrupt when a block is done
+
+        DCH2CON = 0x00000000;
+        DCH2CONbits.CHPRI = 2;
+
+        DCH2ECON = 0x00000000;
+        DCH2ECONbits.CHSIRQ = _SPI4_TX_VECTOR;
+        DCH2ECONbits.SIRQEN = 1;
+
+        DCH2DSA = KVA_TO_PA(&SPI4BUF);
+        DCH2DSIZ = sizeof(uint8_t);
+        DCH2CSIZ = sizeof(uint8_t);         // One byte per SPI4TXIF event
+
+        DCH2INTCLR = 0x00FF00FF;
+
+        IPC33bits.DMA1IP = 4;
+        IEC4bits.DMA1IE = 1;
+
         spi4_initialized = true;
     }
 }
@@ -532,6 +1214,11 @@ uint8_t spi4_tranceive_blocking(uint8_t data_to_send)
 
     spi4_initialize();
 
+    while (spi4_block_transfer.busy)
+    {
+        ;   // Wait for the block transfer to complete
+    }
+
     // Make sure that the receive FIFO is empty
     while (0 != SPI4STATbits.RXBUFELM)
     {
@@ -548,4 +1235,389 @@ uint8_t spi4_tranceive_blocking(uint8_t data_to_send)
     received = SPI4BUF;
 
     return received;
-}
\ No newline at end of file
+}
+
+static bool spi4_dma_transfer(const uint8_t* tx_data,
+                              uint8_t* rx_data,
+                              uint32_t nbr_of_bytes,
+                              spi_transfer_complete_t callback,
+                              int32_t arg)
+{
+    bool started;
+
+    spi4_initialize();
+
+    started = block_transfer_begin(&spi4_block_transfer,
+                                   &tx_data,
+                                   &rx_data,
+                                   nbr_of_bytes,
+                                   callback,
+                                   arg);
+
+    if (started)
+    {
+        // Make sure that the receive FIFO is empty
+        while (0 != SPI4STATbits.RXBUFELM)
+        {
+            (void)SPI4BUF;
+        }
+
+        DCH2SSA = KVA_TO_PA(tx_data);
+        DCH2SSIZ = nbr_of_bytes;
+
+        DCH1DSA = KVA_TO_PA(rx_data);
+        DCH1DSIZ = nbr_of_bytes;
+
+        DCH1INTCLR = 0x000000FF;
+        DCH2INTCLR = 0x000000FF;
+
+        // The receiver must be ready before the first byte is clocked out
+        DCH1CONbits.CHEN = 1;
+        DCH2CONbits.CHEN = 1;
+    }
+
+    return started;
+}
+
+static void spi4_block_tranceive_blocking(const uint8_t* tx_data,
+                                          uint8_t* rx_data,
+                                          uint32_t nbr_of_bytes)
+{
+    const uint32_t nbr_of_words = nbr_of_bytes / sizeof(uint32_t);
+    uint32_t sent = 0;
+    uint32_t received = 0;
+    uint32_t word;
+    uint32_t i;
+
+    spi4_initialize();
+
+    while (spi4_block_transfer.busy)
+    {
+        ;   // Wait for the block transfer to complete
+    }
+
+    if (0 != nbr_of_words)
+    {
+        spi_flush(SPI_DEVICE_SDCARD);
+
+        // Make sure that the receive FIFO is empty
+        while (0 != SPI4STATbits.RXBUFELM)
+        {
+            word = SPI4BUF;
+        }
+
+        spi4_set_32_bit_mode(true);
+
+        while (received != nbr_of_words)
+        {
+            // Never have more words in flight than the receive FIFO holds
+            if ((sent != nbr_of_words) &&
+                ((sent - received) < SPI_FIFO_WORDS))
+            {
+                word = 0xFFFFFFFF;
+
+                // The most significant byte is shifted out first
+                if (NULL != tx_data)
+                {
+                    memcpy(&word, &tx_data[sent * sizeof(uint32_t)],
+                           sizeof(uint32_t));
+                    word = __builtin_bswap32(word);
+                }
+
+                SPI4BUF = word;
+                ++sent;
+            }
+
+            if (!SPI4STATbits.SPIRBE)
+            {
+                word = SPI4BUF;
+
+                if (NULL != rx_data)
+                {
+                    word = __builtin_bswap32(word);
+                    memcpy(&rx_data[received * sizeof(uint32_t)], &word,
+                           sizeof(uint32_t));
+                }
+
+                ++received;
+            }
+        }
+
+        spi4_set_32_bit_mode(false);
+    }
+
+    for (i = nbr_of_words * sizeof(uint32_t); i != nbr_of_bytes; ++i)
+    {
+        word = spi4_tranceive_blocking((NULL != tx_data) ? tx_data[i] : 0xFF);
+
+        if (NULL != rx_data)
+        {
+            rx_data[i] = (uint8_t)word;
+        }
+    }
+}
+
+static void spi4_set_32_bit_mode(bool use_32_bit)
+{
+    while (SPI4STATbits.SPIBUSY)
+    {
+        ;   // Wait for the last word to be shifted out
+    }
+
+    // The data width may only be changed while the module is off
+    SPI4CONbits.ON = 0;
+    SPI4CONbits.MODE32 = use_32_bit ? 1 : 0;
+    SPI4CONbits.ON = 1;
+}
+
+static void spi2_initialize(void)
+{
+    if (false == spi2_initialized)
+    {
+        //
+        // IO ports, set up by gpio_init
+        //
+
+        // Unlock the Peripheral Pin Select registers
+        // For reference, see document DS60001250A - page 42-26
+
+        SYSKEY = 0x0;
+        SYSKEY = 0xAA996655;
+        SYSKEY = 0x556699AA;
+        CFGCONbits.IOLOCK = 0;
+
+        GPU_MISO_PPS_REGISTER = GPU_MISO_PPS_VALUE;
+        GPU_MOSI_PPS_REGISTER = GPU_MOSI_PPS_VALUE;
+        // There is no PPS for the clock pin
+
+        // Lock the Peripheral Pin Select registers
+        CFGCONbits.IOLOCK = 1;
+        SYSKEY = 0x0;
+
+        IEC4bits.SPI2EIE = 0;
+        IFS4bits.SPI2EIF = 0;
+        IEC4bits.SPI2RXIE = 0;
+        IFS4bits.SPI2RXIF = 0;
+        IEC4bits.SPI2TXIE = 0;
+        IFS4bits.SPI2TXIF = 0;
+
+        SPI2CON  = 0x00000000;
+        SPI2CON2 = 0x00000000;
+
+        // Clear the receive buffer
+        while (!SPI2STATbits.SPIRBE)
+        {
+            (void)SPI2BUF;
+        }
+
+        // Use the hardware RX and TX FIFO in the SPI2 module
+        SPI2CONbits.ENHBUF = 1;
+
+        // Use the TX and RX interrupt flags as DMA triggers
+        // SPIxTXIF is set while the transmit buffer is not full
+        SPI2CONbits.STXISEL = 3;
+
+        // SPIxRXIF is set while the receive buffer is not empty
+        SPI2CONbits.SRXISEL = 1;
+
+        // Set the baud rate
+        SPI2BRG = (PBCLK_FREQ_HZ / spi2_baud) / 2 - 1;
+
+        SPI2STATbits.SPIROV = 0;
+
+        // SPI mode 0, as used by the FT801
+        SPI2CONbits.MODE16 = 0;     // Use 8 bit transmissions
+        SPI2CONbits.MODE32 = 0;
+        SPI2CONbits.SMP = 0;        // Input data sampled at middle of data output time
+        SPI2CONbits.CKE = 1;        // Serial output data changes on transition from
+                                    // active clock state to idle clock state
+        SPI2CONbits.CKP = 0;        // Idle state for clock is a low level
+
+        SPI2CONbits.MSTEN = 1;      // Master mode
+
+        SPI2CON2bits.IGNROV = 1;    // Ignore Receive Overflow bit
+        SPI2CON2bits.IGNTUR = 1;    // Ignore Transmit Underrun bit
+
+        SPI2CONbits.ON = 1;
+
+        //
+        // DMA3 moves one byte from SPI2BUF each time SPI2RXIF is set,
+        // DMA4 moves one byte to SPI2BUF each time SPI2TXIF is set.
+        //
+        DMACONbits.ON = 1;
+
+        IEC4bits.DMA3IE = 0;
+        IFS4bits.DMA3IF = 0;
+        IEC4bits.DMA4IE = 0;
+        IFS4bits.DMA4IF = 0;
+
+        DCH3CON = 0x00000000;
+        DCH3CONbits.CHPRI = 1;              // Below the audio and SD channels
+
+        DCH3ECON = 0x00000000;
+        DCH3ECONbits.CHSIRQ = _SPI2_RX_VECTOR;
+        DCH3ECONbits.SIRQEN = 1;
+
+        DCH3SSA = KVA_TO_PA(&SPI2BUF);
+        DCH3SSIZ = sizeof(uint8_t);
+        DCH3CSIZ = sizeof(uint8_t);
+
+        DCH3INTCLR = 0x00FF00FF;
+        DCH3INTbits.CHBCIE = 1;
+
+        DCH4CON = 0x00000000;
+        DCH4CONbits.CHPRI = 0;
+
+        DCH4ECON = 0x00000000;
+        DCH4ECONbits.CHSIRQ = _SPI2_TX_VECTOR;
+        DCH4ECONbits.SIRQEN = 1;
+
+        DCH4DSA = KVA_TO_PA(&SPI2BUF);
+        DCH4DSIZ = sizeof(uint8_t);
+        DCH4CSIZ = sizeof(uint8_t);
+
+        DCH4INTCLR = 0x00FF00FF;
+
+        IPC34bits.DMA3IP = 4;
+        IEC4bits.DMA3IE = 1;
+
+        tunables_register(&spi2_baud_tunable);
+
+        spi2_initialized = true;
+    }
+}
+
+static uint8_t spi2_tranceive_blocking(uint8_t data_to_send)
+{
+    volatile uint8_t received = 0;
+
+    spi2_initialize();
+
+    while (spi2_block_transfer.busy)
+    {
+        ;   // Wait for the block transfer to complete
+    }
+
+    // Make sure that the receive FIFO is empty
+    while (0 != SPI2STATbits.RXBUFELM)
+    {
+        received = SPI2BUF;
+    }
+
+    SPI2BUF = data_to_send;
+
+    while (0 == SPI2STATbits.RXBUFELM)
+    {
+        ;   // Wait for the transaction to complete
+    }
+
+    received = SPI2BUF;
+
+    return received;
+}
+
+static bool spi2_dma_transfer(const uint8_t* tx_data,
+                              uint8_t* rx_data,
+                              uint32_t nbr_of_bytes,
+                              spi_transfer_complete_t callback,
+                              int32_t arg)
+{
+    bool started;
+
+    spi2_initialize();
+
+    started = block_transfer_begin(&spi2_block_transfer,
+                                   &tx_data,
+                                   &rx_data,
+                                   nbr_of_bytes,
+                                   callback,
+                                   arg);
+
+    if (started)
+    {
+        while (0 != SPI2STATbits.RXBUFELM)
+        {
+            (void)SPI2BUF;
+        }
+
+        DCH4SSA = KVA_TO_PA(tx_data);
+        DCH4SSIZ = nbr_of_bytes;
+
+        DCH3DSA = KVA_TO_PA(rx_data);
+        DCH3DSIZ = nbr_of_bytes;
+
+        DCH3INTCLR = 0x000000FF;
+        DCH4INTCLR = 0x000000FF;
+
+        DCH3CONbits.CHEN = 1;
+        DCH4CONbits.CHEN = 1;
+    }
+
+    return started;
+}
+
+static void spi2_update_baud(void)
+{
+    spi_flush(SPI_DEVICE_FT801);
+    SPI2CONbits.ON = 0;
+
+    SPI2BRG = (PBCLK_FREQ_HZ / spi2_baud) / 2 - 1;
+
+    SPI2CONbits.ON = 1;
+}
+
+static bool block_transfer_begin(spi_block_transfer_t* transfer,
+                                 const uint8_t** tx_data,
+                                 uint8_t** rx_data,
+                                 uint32_t nbr_of_bytes,
+                                 spi_transfer_complete_t callback,
+                                 int32_t arg)
+{
+    bool started = !transfer->busy;
+
+    if (started)
+    {
+        if (NULL != *tx_data)
+        {
+            dcache_writeback(*tx_data, nbr_of_bytes);
+        }
+        else
+        {
+            *tx_data = block_fill_bytes;
+        }
+
+        transfer->rx_data = *rx_data;
+
+        if (NULL != *rx_data)
+        {
+            // No dirty line may be written back over the received data
+            dcache_writeback(*rx_data, nbr_of_bytes);
+        }
+        else
+        {
+            *rx_data = block_sink_bytes;
+        }
+
+        transfer->nbr_of_bytes = nbr_of_bytes;
+        transfer->callback = callback;
+        transfer->arg = arg;
+        transfer->busy = true;
+    }
+
+    return started;
+}
+
+static void block_transfer_end(spi_block_transfer_t* transfer)
+{
+    if (NULL != transfer->rx_data)
+    {
+        dcache_invalidate(transfer->rx_data, transfer->nbr_of_bytes);
+    }
+
+    transfer->busy = false;
+
+    if (NULL != transfer->callback)
+    {
+        transfer->callback(transfer->arg);
+    }
+}
@@ -8,6 +8,8 @@
 // =============================================================================
 // Include statements
 // =============================================================================
+#include <stdint.h>
+#include <stdbool.h>
 
 // =============================================================================
 // Public type definitions
@@ -20,10 +22,18 @@ typedef enum spi_device_t
     SPI_DEVICE_DSP
 } spi_device_t;
 
+/*
+ * Called from interrupt context when an asynchronous transfer is done.
+ */
+typedef void (*spi_transfer_complete_t)(int32_t arg);
+
 // =============================================================================
 // Global constatants
 // =============================================================================
 
+// Largest number of bytes spi_block_transfer_async can move at once
+#define SPI_MAX_BLOCK_TRANSFER_SIZE     (512u)
+
 // =============================================================================
 // Global variable declarations
 // =============================================================================
@@ -47,6 +57,18 @@ void spi_init(spi_device_t spi_device);
 uint8_t spi_byte_tranceive_blocking(spi_device_t spi_device,
                                     uint8_t data_to_send);
 
+/**
+ * @brief Sends and receives a 32 bit double word.
+ * @details Waits for all queued data to be sent first and discards any
+ *          words received while that data was sent. Only supported by
+ *          SPI_DEVICE_DSP.
+ * @param spi_device - the spi interface to use.
+ * @param data_to_send - the double word to send.
+ * @return The double word received while data_to_send was sent.
+ */
+uint32_t spi_dword_tranceive_blocking(spi_device_t spi_device,
+                                      uint32_t data_to_send);
+
 /**
  * @brief Sends a 32 bit double word over the spi interface.
  * @details This is an asynchronous operation.
@@ -65,6 +87,95 @@ void spi_write_dword_vect(spi_device_t spi_device,
                           uint32_t data[],
                           uint32_t number_of_elements);
 
+/**
+ * @brief Queues a series of 32 bit dwords to be sent without copying them.
+ * @details The data is streamed from the buffer by DMA, in the order the
+ *          buffers were queued and after any data written before. The buffer
+ *          must not be modified until the callback has been called.
+ *          Only supported by SPI_DEVICE_DSP.
+ * @param spi_device - the spi interface to use.
+ * @param data - the data to send.
+ * @param number_of_elements - the number of uint32_t elements in data,
+ *        at most 16383.
+ * @param callback - called from the DMA interrupt when the data has been
+ *        sent, or NULL.
+ * @param arg - passed to the callback.
+ * @return false if the transfer could not be queued, try again later.
+ */
+bool spi_write_dword_vect_async(spi_device_t spi_device,
+                                const uint32_t data[],
+                                uint32_t number_of_elements,
+                                spi_transfer_complete_t callback,
+                                int32_t arg);
+
+/**
+ * @brief Exchanges a block of bytes using DMA.
+ * @details Returns at once, the transfer runs in the background and is
+ *          bus-limited. Not supported by SPI_DEVICE_DSP. The buffers must
+ *          stay valid until the callback has been called. The cache lines
+ *          of rx_data are discarded when the transfer is done, so it should
+ *          be aligned to 16 bytes and a multiple of 16 bytes long.
+ * @param spi_device - the spi interface to use.
+ * @param tx_data - the bytes to send, or NULL to send 0xFF.
+ * @param rx_data - where to store the received bytes, or NULL to discard them.
+ * @param number_of_bytes - at most SPI_MAX_BLOCK_TRANSFER_SIZE.
+ * @param callback - called from the DMA interrupt when the last byte has been
+ *        received, or NULL.
+ * @param arg - passed to the callback.
+ * @return false if a block transfer is already in progress.
+ */
+bool spi_block_transfer_async(spi_device_t spi_device,
+                              const uint8_t tx_data[],
+                              uint8_t rx_data[],
+                              uint32_t number_of_bytes,
+                              spi_transfer_complete_t callback,
+                              int32_t arg);
+
+/**
+ * @brief Exchanges a block of bytes without DMA.
+ * @details SPI_DEVICE_SDCARD shifts whole 32 bit words in 32 bit mode, which
+ *          needs one FIFO access per four bytes, and goes back to 8 bit mode
+ *          before returning. The bytes are sent and stored in memory order.
+ *          Other devices use spi_byte_tranceive_blocking for every byte.
+ * @param spi_device - the spi interface to use.
+ * @param tx_data - the bytes to send, or NULL to send 0xFF.
+ * @param rx_data - where to store the received bytes, or NULL to discard them.
+ * @param number_of_bytes - the number of bytes to exchange.
+ */
+void spi_block_tranceive_blocking(spi_device_t spi_device,
+                                  const uint8_t tx_data[],
+                                  uint8_t rx_data[],
+                                  uint32_t number_of_bytes);
+
+/**
+ * @brief Checks if a block transfer is in progress.
+ * @param spi_device - the spi interface to check.
+ */
+bool spi_block_transfer_busy(spi_device_t spi_device);
+
+/**
+ * @brief Blocks until all queued data has been shifted out.
+ * @param spi_device - the spi interface to wait for.
+ */
+void spi_flush(spi_device_t spi_device);
+
+/**
+ * @brief Sets the clock of a spi interface.
+ * @details Waits for queued data to be sent first.
+ * @param spi_device - the spi interface to change.
+ * @param clock_hz - the new clock.
+ */
+void spi_set_clock(spi_device_t spi_device, uint32_t clock_hz);
+
+/**
+ * @brief Sets the clock polarity and phase of a spi interface.
+ * @details Waits for queued data to be sent first. Only supported by
+ *          SPI_DEVICE_FT801 and SPI_DEVICE_SDCARD.
+ * @param spi_device - the spi interface to change.
+ * @param mode - SPI mode 0 to 3, CPOL in bit 1 and CPHA in bit 0.
+ */
+void spi_set_mode(spi_device_t spi_device, uint8_t mode);
+
 /**
  * @brief Updates the baud rate of the spi bus for the SD card.
  * @param new_baud - the baud rate to change to.
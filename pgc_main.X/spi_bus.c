@@ -0,0 +1,613 @@
+
+// =============================================================================
+// Include statements
+// =============================================================================
+#include <xc.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#include "spi_bus.h"
+#include "spi.h"
+#include "ring_buffer.h"
+#include "event_queue.h"
+#include "pinmap.h"
+#include "uart.h"
+#include "debug_util.h"
+
+// =============================================================================
+// Private type definitions
+// =============================================================================
+
+typedef struct bus_device_t
+{
+    const char* name;
+    spi_device_t spi_device;
+    uint8_t bus;                    // Index in buses
+    void (*select)(bool selected);  // Drives the chip select
+
+    uint32_t clock_hz;
+    uint8_t mode;
+    bool config_changed;
+
+    spi_transaction_t queue[SPI_BUS_QUEUE_SIZE];
+    ring_buffer_t ring;
+
+    // Statistics
+    uint32_t transactions;
+    uint32_t bytes;
+    uint32_t busy_cycles;
+    uint32_t reconfigurations;
+} bus_device_t;
+
+typedef struct bus_t
+{
+    spi_device_t hardware;          // The spi interface driving the bus
+    int8_t active;                  // Device of the transaction in progress
+    int8_t locked;                  // Device which keeps the bus selected
+    int8_t configured;              // Device the clock and mode are set for
+    uint8_t next;                   // First device the arbiter looks at
+    uint32_t start_count;           // Core timer at the start of a transaction
+    bool reconfiguring;             // Clock or mode being changed, no starts
+    bool service_pending;           // service_bus is in the event queue
+} bus_t;
+
+// =============================================================================
+// Global variables
+// =============================================================================
+
+// =============================================================================
+// Private constants
+// =============================================================================
+#define NO_DEVICE           (-1)
+
+#define BUS_SPI2            (0u)
+#define BUS_SPI4            (1u)
+#define NBR_OF_BUSES        (2u)
+
+// =============================================================================
+// Private variables
+// =============================================================================
+
+// Start of the statistics period
+static uint32_t statistics_start = 0;
+
+// =============================================================================
+// Private function declarations
+// =============================================================================
+
+static void ft801_select(bool selected);
+static void sdcard_select(bool selected);
+
+/**
+ * @brief Finds the bus device of a spi device.
+ * @return The device index, or NO_DEVICE.
+ */
+static int8_t find_device(spi_device_t spi_device);
+
+/**
+ * @brief Picks the device whose transaction shall run next on a bus.
+ * @details Must be called with interrupts disabled or from a DMA ISR.
+ * @param bus_index - the bus.
+ * @return The device index, or NO_DEVICE if the bus is busy or there is
+ *         nothing to run.
+ */
+static int8_t pick_next(uint8_t bus_index);
+
+/**
+ * @brief Checks if the clock or mode must be changed for a device.
+ */
+static bool needs_configuration(const bus_t* bus, int8_t index);
+
+/**
+ * @brief Sets the clock and mode of the bus for a device.
+ * @details Waits for the spi interface to finish, so it must be called from
+ *          the main loop with interrupts enabled. The caller must hold the
+ *          bus with bus_t.reconfiguring so no transaction is started.
+ * @param bus_index - the bus.
+ * @param index - the device.
+ */
+static void configure(uint8_t bus_index, int8_t index);
+
+/**
+ * @brief Starts the next transaction on a bus if it is idle.
+ * @details Must be called with interrupts disabled or from a DMA ISR. A
+ *          transaction which needs the clock or mode changed, or which the
+ *          spi driver could not start, is left to service_bus.
+ * @param bus_index - the bus.
+ */
+static void start_next(uint8_t bus_index);
+
+/**
+ * @brief Queues service_bus for a bus, unless it is already queued.
+ * @details Must be called with interrupts disabled or from a DMA ISR.
+ */
+static void schedule_service(uint8_t bus_index);
+
+/**
+ * @brief Event which reconfigures a bus and starts its next transaction.
+ * @details Runs from the main loop, so the spi interface can be waited for
+ *          with interrupts enabled. Queues itself again as long as the spi
+ *          driver refuses to start the transaction.
+ * @param arg - the bus index.
+ */
+static int32_t service_bus(int32_t arg);
+
+/**
+ * @brief Finishes the transaction in progress on a bus.
+ * @details Called from the DMA ISR when the transaction is done.
+ * @param arg - the bus index.
+ */
+static void transaction_done(int32_t arg);
+
+// The buses and the devices on them, bus_device_t.bus is the index in buses
+static bus_t buses[NBR_OF_BUSES] =
+{
+    {SPI_DEVICE_FT801, NO_DEVICE, NO_DEVICE, NO_DEVICE, 0, 0, false, false},
+    {SPI_DEVICE_SDCARD, NO_DEVICE, NO_DEVICE, NO_DEVICE, 0, 0, false, false}
+};
+
+static bus_device_t devices[] =
+{
+    {"ft801",   SPI_DEVICE_FT801,   BUS_SPI2,   &ft801_select},
+    {"sdcard",  SPI_DEVICE_SDCARD,  BUS_SPI4,   &sdcard_select}
+};
+
+#define NBR_OF_DEVICES (sizeof(devices) / sizeof(devices[0]))
+
+// =============================================================================
+// Public function definitions
+// =============================================================================
+
+void spi_bus_init(void)
+{
+    uint32_t i;
+
+    for (i = 0; i != NBR_OF_DEVICES; ++i)
+    {
+        ring_buffer_init(&devices[i].ring, SPI_BUS_QUEUE_SIZE);
+        devices[i].clock_hz = SPI_BUS_CLOCK_KEEP;
+        devices[i].mode = SPI_BUS_MODE_KEEP;
+        devices[i].config_changed = false;
+    }
+
+    statistics_start = _CP0_GET_COUNT();
+}
+
+void spi_bus_configure_device(spi_device_t spi_device,
+                              uint32_t clock_hz,
+                              uint8_t mode)
+{
+    int8_t index = find_device(spi_device);
+    bus_t* bus;
+    uint32_t int_status;
+    bool apply_now = false;
+
+    if (NO_DEVICE != index)
+    {
+        bus = &buses[devices[index].bus];
+
+        int_status = __builtin_disable_interrupts();
+
+        devices[index].clock_hz = clock_hz;
+        devices[index].mode = mode;
+        devices[index].config_changed = true;
+
+        // Apply at once if the bus is idle or held by this device, so the
+        // device driver can use the new setting right away
+        if ((NO_DEVICE == bus->active) &&
+            !bus->reconfiguring &&
+            ((NO_DEVICE == bus->locked) || (index == bus->locked)))
+        {
+            bus->reconfiguring = true;
+            apply_now = true;
+        }
+
+        __builtin_mtc0(_CP0_STATUS, _CP0_STATUS_SELECT, int_status);
+
+        if (apply_now)
+        {
+            configure(devices[index].bus, index);
+
+            int_status = __builtin_disable_interrupts();
+
+            bus->reconfiguring = false;
+            start_next(devices[index].bus);
+
+            __builtin_mtc0(_CP0_STATUS, _CP0_STATUS_SELECT, int_status);
+        }
+    }
+}
+
+bool spi_bus_select(spi_device_t spi_device)
+{
+    int8_t index = find_device(spi_device);
+    bus_t* bus;
+    uint32_t int_status;
+    bool selected = false;
+    bool reconfigure = false;
+
+    if (NO_DEVICE != index)
+    {
+        bus = &buses[devices[index].bus];
+
+        int_status = __builtin_disable_interrupts();
+
+        if ((NO_DEVICE == bus->active) &&
+            !bus->reconfiguring &&
+            ((NO_DEVICE == bus->locked) || (index == bus->locked)))
+        {
+            bus->locked = index;
+            selected = true;
+
+            if (needs_configuration(bus, index))
+            {
+                bus->reconfiguring = true;
+                reconfigure = true;
+            }
+        }
+
+        __builtin_mtc0(_CP0_STATUS, _CP0_STATUS_SELECT, int_status);
+
+        if (selected)
+        {
+            devices[index].select(true);
+        }
+
+        if (reconfigure)
+        {
+            configure(devices[index].bus, index);
+
+            int_status = __builtin_disable_interrupts();
+
+            bus->reconfiguring = false;
+            start_next(devices[index].bus);
+
+            __builtin_mtc0(_CP0_STATUS, _CP0_STATUS_SELECT, int_status);
+        }
+    }
+
+    return selected;
+}
+
+void spi_bus_deselect(spi_device_t spi_device)
+{
+    int8_t index = find_device(spi_device);
+    bus_t* bus;
+    uint32_t int_status;
+
+    if (NO_DEVICE != index)
+    {
+        bus = &buses[devices[index].bus];
+
+        int_status = __builtin_disable_interrupts();
+
+        devices[index].select(false);
+
+        if (index == bus->locked)
+        {
+            bus->locked = NO_DEVICE;
+            start_next(devices[index].bus);
+        }
+
+        __builtin_mtc0(_CP0_STATUS, _CP0_STATUS_SELECT, int_status);
+    }
+}
+
+bool spi_bus_submit(spi_device_t spi_device,
+                    const spi_transaction_t* transaction)
+{
+    int8_t index = find_device(spi_device);
+    bus_device_t* device;
+    uint32_t int_status;
+    bool queued = false;
+
+    if ((NO_DEVICE != index) &&
+        (0 != transaction->number_of_bytes) &&
+        (transaction->number_of_bytes <= SPI_MAX_BLOCK_TRANSFER_SIZE))
+    {
+        device = &devices[index];
+
+        // Transactions complete and are submitted from the DMA ISRs
+        int_status = __builtin_disable_interrupts();
+
+        if (!ring_buffer_is_full(&device->ring))
+        {
+            device->queue[ring_buffer_tail_index(&device->ring)] = *transaction;
+            ring_buffer_produce(&device->ring, 1);
+
+            start_next(device->bus);
+
+            queued = true;
+        }
+
+        __builtin_mtc0(_CP0_STATUS, _CP0_STATUS_SELECT, int_status);
+    }
+
+    return queued;
+}
+
+uint32_t spi_bus_pending(spi_device_t spi_device)
+{
+    int8_t index = find_device(spi_device);
+    uint32_t pending = 0;
+
+    if (NO_DEVICE != index)
+    {
+        pending = ring_buffer_size(&devices[index].ring);
+    }
+
+    return pending;
+}
+
+void spi_bus_print_status(void)
+{
+    uint32_t now = _CP0_GET_COUNT();
+    uint32_t elapsed = now - statistics_start;
+    uint32_t int_status;
+    bus_device_t snapshot;
+    uint32_t i;
+
+    // Utilisation in per mille of the elapsed time
+    elapsed = (elapsed / 1000) + 1;
+
+    for (i = 0; i != NBR_OF_DEVICES; ++i)
+    {
+        int_status = __builtin_disable_interrupts();
+
+        snapshot = devices[i];
+        devices[i].transactions = 0;
+        devices[i].bytes = 0;
+        devices[i].busy_cycles = 0;
+        devices[i].reconfigurations = 0;
+
+        __builtin_mtc0(_CP0_STATUS, _CP0_STATUS_SELECT, int_status);
+
+        sprintf(g_debug_util_char_buffer,
+                "\t%s: %u transactions, %u bytes, busy %u.%u %%, "
+                "%u reconfigurations, %u pending%s",
+                snapshot.name,
+                (unsigned int)snapshot.transactions,
+                (unsigned int)snapshot.bytes,
+                (unsigned int)((snapshot.busy_cycles / elapsed) / 10),
+                (unsigned int)((snapshot.busy_cycles / elapsed) % 10),
+                (unsigned int)snapshot.reconfigurations,
+                (unsigned int)ring_buffer_size(&snapshot.ring),
+                NEWLINE);
+        uart_write_string(g_debug_util_char_buffer);
+    }
+
+    statistics_start = now;
+}
+
+// =============================================================================
+// Private function definitions
+// =============================================================================
+
+static void ft801_select(bool selected)
+{
+    if (selected)
+    {
+        GPU_SS_ON;
+    }
+    else
+    {
+        GPU_SS_OFF;
+    }
+}
+
+static void sdcard_select(bool selected)
+{
+    if (selected)
+    {
+        SD_CARD_SS_ON;
+    }
+    else
+    {
+        SD_CARD_SS_OFF;
+    }
+}
+
+static int8_t find_device(spi_device_t spi_device)
+{
+    int8_t index = NO_DEVICE;
+    uint32_t i;
+
+    for (i = 0; (NO_DEVICE == index) && (i != NBR_OF_DEVICES); ++i)
+    {
+        if (spi_device == devices[i].spi_device)
+        {
+            index = (int8_t)i;
+        }
+    }
+
+    return index;
+}
+
+static int8_t pick_next(uint8_t bus_index)
+{
+    const bus_t* bus = &buses[bus_index];
+    int8_t index = NO_DEVICE;
+    uint32_t candidate;
+    uint32_t i;
+
+    if ((NO_DEVICE == bus->active) && !bus->reconfiguring)
+    {
+        if (NO_DEVICE != bus->locked)
+        {
+            // Only the device holding the bus may continue
+            if (!ring_buffer_is_empty(&devices[bus->locked].ring))
+            {
+                index = bus->locked;
+            }
+        }
+        else
+        {
+            for (i = 0; (NO_DEVICE == index) && (i != NBR_OF_DEVICES); ++i)
+            {
+                candidate = (bus->next + i) % NBR_OF_DEVICES;
+
+                if ((bus_index == devices[candidate].bus) &&
+                    !ring_buffer_is_empty(&devices[candidate].ring))
+                {
+                    index = (int8_t)candidate;
+                }
+            }
+        }
+    }
+
+    return index;
+}
+
+static bool needs_configuration(const bus_t* bus, int8_t index)
+{
+    return (index != bus->configured) || devices[index].config_changed;
+}
+
+static void configure(uint8_t bus_index, int8_t index)
+{
+    bus_t* bus = &buses[bus_index];
+    bus_device_t* device = &devices[index];
+
+    if (SPI_BUS_CLOCK_KEEP != device->clock_hz)
+    {
+        spi_set_clock(bus->hardware, device->clock_hz);
+    }
+
+    if (SPI_BUS_MODE_KEEP != device->mode)
+    {
+        spi_set_mode(bus->hardware, device->mode);
+    }
+
+    bus->configured = index;
+    device->config_changed = false;
+    ++device->reconfigurations;
+}
+
+static void start_next(uint8_t bus_index)
+{
+    bus_t* bus = &buses[bus_index];
+    bus_device_t* device;
+    const spi_transaction_t* transaction;
+    int8_t index = pick_next(bus_index);
+
+    if (NO_DEVICE == index)
+    {
+        return;
+    }
+
+    if (needs_configuration(bus, index))
+    {
+        // Changing the clock or mode waits for the spi interface, which must
+        // not be done in interrupt context
+        schedule_service(bus_index);
+        return;
+    }
+
+    device = &devices[index];
+    transaction = &device->queue[ring_buffer_head_index(&device->ring)];
+
+    device->select(true);
+
+    bus->active = index;
+    bus->start_count = _CP0_GET_COUNT();
+
+    if (!spi_block_transfer_async(bus->hardware,
+                                  transaction->tx_data,
+                                  transaction->rx_data,
+                                  transaction->number_of_bytes,
+                                  &transaction_done,
+                                  (int32_t)bus_index))
+    {
+        // A driver is using the module directly, try again from the main loop
+        bus->active = NO_DEVICE;
+
+        if (NO_DEVICE == bus->locked)
+        {
+            device->select(false);
+        }
+
+        schedule_service(bus_index);
+    }
+}
+
+static void schedule_service(uint8_t bus_index)
+{
+    if (!buses[bus_index].service_pending)
+    {
+        // A dropped event is scheduled again by the next start_next
+        buses[bus_index].service_pending =
+            event_queue_push_callback(&service_bus,
+                                      (int32_t)bus_index,
+                                      EVENT_PRIO_LOW);
+    }
+}
+
+static int32_t service_bus(int32_t arg)
+{
+    uint8_t bus_index = (uint8_t)arg;
+    bus_t* bus = &buses[bus_index];
+    uint32_t int_status;
+    int8_t index;
+
+    int_status = __builtin_disable_interrupts();
+
+    bus->service_pending = false;
+    index = pick_next(bus_index);
+
+    if ((NO_DEVICE != index) && needs_configuration(bus, index))
+    {
+        bus->reconfiguring = true;
+
+        __builtin_mtc0(_CP0_STATUS, _CP0_STATUS_SELECT, int_status);
+
+        configure(bus_index, index);
+
+        int_status = __builtin_disable_interrupts();
+
+        bus->reconfiguring = false;
+    }
+
+    start_next(bus_index);
+
+    __builtin_mtc0(_CP0_STATUS, _CP0_STATUS_SELECT, int_status);
+
+    return 0;
+}
+
+static void transaction_done(int32_t arg)
+{
+    bus_t* bus = &buses[arg];
+    bus_device_t* device = &devices[bus->active];
+    spi_transaction_t finished =
+        device->queue[ring_buffer_head_index(&device->ring)];
+
+    ring_buffer_consume(&device->ring, 1);
+
+    device->busy_cycles += _CP0_GET_COUNT() - bus->start_count;
+    device->bytes += finished.number_of_bytes;
+    ++device->transactions;
+
+    if (finished.keep_selected)
+    {
+        bus->locked = bus->active;
+    }
+    else
+    {
+        device->select(false);
+        bus->locked = NO_DEVICE;
+    }
+
+    // Let the other devices go first next time
+    bus->next = (uint8_t)((bus->active + 1) % NBR_OF_DEVICES);
+    bus->active = NO_DEVICE;
+
+    if (NULL != finished.callback)
+    {
+        finished.callback(finished.arg);
+    }
+
+    start_next((uint8_t)arg);
+}
@@ -0,0 +1,137 @@
+/*
+ * Transaction queues for the devices on the spi buses.
+ *
+ * Every device has a queue of transactions. The arbiter of a bus runs the
+ * queued transactions of its devices back to back with DMA, taking turns
+ * between the devices, and handles the chip selects. The clock and mode of a
+ * bus are only changed when it switches to another device, and never from
+ * interrupt context.
+ *
+ * Drivers which also exchange single bytes with their device, like the SD
+ * card driver does for commands, hold the bus with spi_bus_select while
+ * they do so.
+ *
+ * The audio DSP is not managed here, it streams on its own SPI module and
+ * DMA channel so no other traffic can delay it.
+ */
+
+#ifndef SPI_BUS_H
+#define	SPI_BUS_H
+
+#ifdef	__cplusplus
+//extern "C" {
+#endif
+
+// =============================================================================
+// Include statements
+// =============================================================================
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "spi.h"
+
+// =============================================================================
+// Public type definitions
+// =============================================================================
+
+typedef struct spi_transaction_t
+{
+    const uint8_t* tx_data;             // NULL to send 0xFF
+    uint8_t* rx_data;                   // NULL to discard the received bytes
+    uint32_t number_of_bytes;           // 1 to SPI_MAX_BLOCK_TRANSFER_SIZE
+    bool keep_selected;                 // Keep the chip select asserted and
+                                        // the bus for the next transaction
+    spi_transfer_complete_t callback;   // Called from interrupt context
+    int32_t arg;                        // Passed to the callback
+} spi_transaction_t;
+
+// =============================================================================
+// Global constatants
+// =============================================================================
+
+// Number of transactions which can be queued per device
+#define SPI_BUS_QUEUE_SIZE  (8u)
+
+// Leave the clock or the mode as set by the device driver
+#define SPI_BUS_CLOCK_KEEP  (0u)
+#define SPI_BUS_MODE_KEEP   (0xFFu)
+
+// =============================================================================
+// Global variable declarations
+// =============================================================================
+
+// =============================================================================
+// Public function declarations
+// =============================================================================
+
+/**
+ * @brief Initializes the transaction queues.
+ */
+void spi_bus_init(void);
+
+/**
+ * @brief Sets the clock and the mode the bus shall use for a device.
+ * @details Applied at once if the bus is idle or held by the device,
+ *          otherwise before the next transaction of the device. Waits for
+ *          the spi interface, so it must not be called from an ISR.
+ * @param spi_device - the device.
+ * @param clock_hz - the clock, or SPI_BUS_CLOCK_KEEP.
+ * @param mode - SPI mode 0 to 3, or SPI_BUS_MODE_KEEP.
+ */
+void spi_bus_configure_device(spi_device_t spi_device,
+                              uint32_t clock_hz,
+                              uint8_t mode);
+
+/**
+ * @brief Asserts the chip select of a device and holds the bus for it.
+ * @details For device drivers which also use the spi driver directly, e.g.
+ *          for command bytes. Until spi_bus_deselect is called only the
+ *          transactions of this device are run on the bus. Applies the
+ *          clock and mode of the device first if needed, so it must not be
+ *          called from an ISR.
+ * @param spi_device - the device.
+ * @return false if a transaction of another device is in progress or holds
+ *         the bus, try again later.
+ */
+bool spi_bus_select(spi_device_t spi_device);
+
+/**
+ * @brief Releases the chip select of a device and the bus.
+ * @details The queued transactions of the other devices on the bus may
+ *          start at once.
+ * @param spi_device - the device.
+ */
+void spi_bus_deselect(spi_device_t spi_device);
+
+/**
+ * @brief Queues a transaction.
+ * @details The transaction descriptor is copied, the buffers must stay
+ *          valid until the callback has been called. May be called from
+ *          a transaction callback.
+ * @param spi_device - the device to talk to.
+ * @param transaction - the transaction.
+ * @return false if the queue is full or the device is not on a managed bus.
+ */
+bool spi_bus_submit(spi_device_t spi_device,
+                    const spi_transaction_t* transaction);
+
+/**
+ * @brief Gets the number of queued transactions of a device, including the
+ *        one in progress.
+ */
+uint32_t spi_bus_pending(spi_device_t spi_device);
+
+/**
+ * @brief Prints the utilisation of every device since the previous call
+ *        over the uart, and restarts the statistics.
+ * @details The core timer wraps after 42 seconds, longer periods between
+ *          calls give wrong numbers.
+ */
+void spi_bus_print_status(void);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* SPI_BUS_H */
+
@@ -16,11 +16,33 @@
 #include "uart.h"
 #include "event_queue.h"
 #include "spi.h"
+#include "spi_bus.h"
+#include "sdcard.h"
+#include "sdcard_profiler.h"
+#include "sdcard_mount.h"
+#include "tunables.h"
+#include "asyncfatfs.h"
+#include "bench.h"
+#include "dsp_link.h"
+#include "dsp_events.h"
 
 // =============================================================================
 // Private type definitions
 // =============================================================================
 
+/*
+ * Handles one terminal command.
+ * argc and argv hold the words following the command.
+ * Returns false if the arguments were invalid.
+ */
+typedef bool (*terminal_command_handler_t)(int argc, char* argv[]);
+
+typedef struct terminal_command_t
+{
+    const char* command;
+    terminal_command_handler_t handler;
+} terminal_command_t;
+
 // =============================================================================
 // Global variables
 // =============================================================================
@@ -38,14 +60,21 @@ static const char COMMAND_TERMINATION_CHARACTER = '\n';
 static const char TERMINAL_OPEN[]   = "\tTerminal is now open.\r\n";
 static const char COMMAND_ENTER[]   = "Command: ";
 static const char SYNTAX_ERROR[]    = "\t[Syntax error]\r\n";
-static const char CMD_HELP[]        = "help";
 
-static const char SET[]             = "set ";
-static const char GET[]             = "get ";
+#define MAX_NBR_OF_TOKENS (16)
 
 //
 // Commands
 //
+// The command table and the help texts are generated from the documentation
+// blocks below by terminal_doc_gen.py.
+//
+
+/*
+ Lists the availible commands, or shows the help text of one command.
+ Parameters: [command]
+ */
+static const char CMD_HELP[]            = "help";
 
 /*
  Closes down the terminal.
@@ -55,7 +84,7 @@ static const char CMD_EXIT[]            = "exit";
 /*
  Forces a software reset.
  */
-static const char CMD_SYSTEM_RESET[]    = "system reset\r\n";
+static const char CMD_SYSTEM_RESET[]    = "system reset";
 
 /*
  Runs the spi3 initialization code.
@@ -68,6 +97,35 @@ static const char CMD_INIT_SPI3[]       = "spi3 init";
  */
 static const char CMD_SEND_SPI3_DWORD[]   = "spi3 send dword";
 
+//
+// DSP link commands
+//
+
+/*
+ Polls the DSP over the framed link and displays its status
+ and the link statistics.
+ */
+static const char CMD_DSP_STATUS[]        = "dsp status";
+
+/*
+ Sends one framed message to the DSP.
+ Parameters: <message type (in hex)> [payload dwords (in hex)]
+ */
+static const char CMD_DSP_SEND[]          = "dsp send";
+
+/*
+ Displays the sample time and the statistics of the
+ timestamped note events sent to the DSP.
+ */
+static const char CMD_DSP_EVENTS[]        = "dsp events";
+
+/*
+ Schedules a midi event to be applied by the DSP a number
+ of samples from now.
+ Parameters: <delay in samples> <status (in hex)> <data 1 (in hex)> [data 2 (in hex)]
+ */
+static const char CMD_DSP_EVENT[]         = "dsp event";
+
 //
 // Get commands
 //
@@ -82,13 +140,97 @@ static const char GET_SPI3_STATUS[]       = "get spi3 status";
  */
 static const char GET_SPI4_STATUS[]       = "get spi4 status";
 
+/*
+ Displays if there is a card in the slot and how it was
+ mounted, the clock of the SD card bus, the maximum clock
+ the card supports and if high speed mode is used.
+ */
+static const char GET_SD_STATUS[]         = "get sd status";
+
+/*
+ Displays the number of transactions, the bytes moved and the
+ bus utilisation of every device on the shared spi buses
+ since the previous call.
+ */
+static const char GET_SPI_BUS_STATUS[]    = "get spi bus status";
+
+/*
+ Displays the number, the min, mean and max duration and a
+ log-scale latency histogram of the SD card reads, writes
+ and erases.
+ */
+static const char GET_SD_PROFILE[]        = "get sd profile";
+
+/*
+ Clears the SD card latency statistics.
+ */
+static const char CMD_SD_PROFILE_RESET[]  = "sd profile reset";
+
+/*
+ Displays the size of the filesystem sector cache and the
+ number of hits, misses and evictions since the last reset,
+ and how well the file read-ahead kept up with the readers.
+ */
+static const char GET_FS_CACHE[]          = "get fs cache";
+
+/*
+ Clears the filesystem sector cache and read-ahead
+ statistics.
+ */
+static const char CMD_FS_CACHE_RESET[]    = "fs cache reset";
+
+//
+// Tunables
+//
+
+/*
+ Displays the value and the valid range of a runtime tunable,
+ or of all tunables if no name is given.
+ Parameters: [tunable name]
+ */
+static const char CMD_GET[]               = "get";
+
+/*
+ Sets a runtime tunable.
+ Parameters: <tunable name> <value>
+ */
+static const char CMD_SET[]               = "set";
+
+/*
+ Saves all runtime tunables to SETTINGS.TXT on the SD card.
+ */
+static const char CMD_SETTINGS_SAVE[]     = "settings save";
+
+/*
+ Loads the runtime tunables from SETTINGS.TXT on the SD card.
+ */
+static const char CMD_SETTINGS_LOAD[]     = "settings load";
+
+//
+// Benchmarks
+//
+
+/*
+ Runs an on-device benchmark and prints the result as a
+ "BENCH name=<name> key=value ..." line. "all" runs every
+ benchmark which does not use the SD card. The SD card
+ benchmarks use 8 blocks from the first block, by default the
+ last 8 blocks of the card. The write benchmarks rewrite the
+ blocks with their own contents, they refuse block 0 and a
+ card with a mounted filesystem. Lists the benchmarks if no
+ name is given.
+ Parameters: [benchmark|all] [iterations] [first SD block]
+ */
+static const char CMD_BENCH[]             = "bench";
+
+#include "terminal_commands.h"
+
 // =============================================================================
 // Private variables
 // =============================================================================
 
 static bool command_received_event = false;
 static bool terminal_open = false;
-static char* reply_buff;
 
 // =============================================================================
 // Private function declarations
@@ -101,14 +243,39 @@ static char* reply_buff;
  */
 int execute_command(int arg);
 
-/* **********************************************
- *  Commands
- ***********************************************/
-// Get commands
+/**
+ * @brief Splits a string into white space separated words.
+ * @details The string is modified in place.
+ * @param str - the string to split.
+ * @param tokens - where to store pointers to the words.
+ * @param max_tokens - maximum number of words to store.
+ * @return The number of words found.
+ */
+static int tokenize(char* str, char* tokens[], int max_tokens);
+
+/**
+ * @brief Finds the command with the longest match on the leading words.
+ * @param tokens - the words of the command line.
+ * @param nbr_of_tokens - number of words in tokens.
+ * @param nbr_of_command_tokens - set to the number of words in the command.
+ * @return The matching command, or NULL if no command matched.
+ */
+static const terminal_command_t* find_command(char* tokens[],
+                                              int nbr_of_tokens,
+                                              int* nbr_of_command_tokens);
 
-// Set commands
+/**
+ * @brief Compares a command string with a command table entry for bsearch.
+ */
+static int compare_commands(const void* key, const void* command);
 
-// Commands
+/**
+ * @brief Joins words with single spaces.
+ * @param dest - where to store the result, CMD_BUFFER_SIZE characters.
+ * @param tokens - the words to join.
+ * @param nbr_of_tokens - number of words to join.
+ */
+static void join_tokens(char* dest, char* tokens[], int nbr_of_tokens);
 
 // =============================================================================
 // Public function definitions
@@ -199,99 +366,448 @@ int terminal_handle_uart_event(int arg)
 int execute_command(int arg)
 {
     bool syntax_error = false;
-    char reply_buffer[128];
-    reply_buff = reply_buffer;
+    char* tokens[MAX_NBR_OF_TOKENS];
+    int nbr_of_tokens;
+    int nbr_of_command_tokens;
+    const terminal_command_t* command;
+
+    nbr_of_tokens = tokenize(cmd_buffer, tokens, MAX_NBR_OF_TOKENS);
 
-    if (NULL != strstr(cmd_buffer, GET))
+    if (0 != nbr_of_tokens)
     {
-        //
-        // GET
-        //
-        if (NULL != strstr(cmd_buffer, GET_SPI3_STATUS))
-        {
-            spi_print_debug_status(SPI_DEVICE_DSP);
-        }
-        else if (NULL != strstr(cmd_buffer, GET_SPI4_STATUS))
+        command = find_command(tokens, nbr_of_tokens, &nbr_of_command_tokens);
+
+        if (NULL != command)
         {
-            spi_print_debug_status(SPI_DEVICE_SDCARD);
+            syntax_error =
+                !command->handler(nbr_of_tokens - nbr_of_command_tokens,
+                                  &tokens[nbr_of_command_tokens]);
         }
         else
         {
             syntax_error = true;
         }
     }
-    else if (NULL != strstr(cmd_buffer, SET))
+
+    if (syntax_error)
     {
-        //
-        // SET
-        //
-        syntax_error = true;
+        uart_clear_receive_buffer();
+        uart_write_string(SYNTAX_ERROR);
     }
-    else
+
+    if (terminal_open)
     {
-        //
-        // CMD
-        //
-        if (NULL != strstr(cmd_buffer, CMD_HELP))
+        uart_clear_receive_buffer();
+        uart_write_string(COMMAND_ENTER);
+    }
+
+    return 0;
+}
+
+static int tokenize(char* str, char* tokens[], int max_tokens)
+{
+    int nbr_of_tokens = 0;
+    char* token = strtok(str, " \t\r\n");
+
+    while ((NULL != token) && (nbr_of_tokens != max_tokens))
+    {
+        tokens[nbr_of_tokens++] = token;
+        token = strtok(NULL, " \t\r\n");
+    }
+
+    return nbr_of_tokens;
+}
+
+static int compare_commands(const void* key, const void* command)
+{
+    return strcmp((const char*)key,
+                  ((const terminal_command_t*)command)->command);
+}
+
+static const terminal_command_t* find_command(char* tokens[],
+                                              int nbr_of_tokens,
+                                              int* nbr_of_command_tokens)
+{
+    char key[CMD_BUFFER_SIZE];
+    const terminal_command_t* command = NULL;
+    int words = nbr_of_tokens;
+
+    // Try the longest candidate first so "get spi3 status" wins over "get".
+    while ((NULL == command) && (0 != words))
+    {
+        join_tokens(key, tokens, words);
+
+        command = bsearch(key,
+                          terminal_commands,
+                          NBR_OF_TERMINAL_COMMANDS,
+                          sizeof(terminal_command_t),
+                          &compare_commands);
+
+        if (NULL == command)
         {
-            terminal_help(cmd_buffer);
+            --words;
         }
-        else if (NULL != strstr(cmd_buffer, CMD_EXIT))
-        {
-            terminal_open = false;
+    }
 
-            uart_write_string("\tTerminal closed.");
-            uart_write_string(NEWLINE);
-        }
-        else if (NULL != strstr(cmd_buffer, CMD_SYSTEM_RESET))
+    *nbr_of_command_tokens = words;
+
+    return command;
+}
+
+static void join_tokens(char* dest, char* tokens[], int nbr_of_tokens)
+{
+    int i;
+
+    dest[0] = 0;
+
+    // The tokens come from cmd_buffer so the result always fits.
+    for (i = 0; i != nbr_of_tokens; ++i)
+    {
+        if (0 != i)
         {
-            // assume interrupts are disabled
-            // assume the DMA controller is suspended
-            // assume the device is locked
-            // perform a system unlock sequence
-            // starting critical sequence
-            SYSKEY = 0x00000000; //write invalid key to force lock
-            SYSKEY = 0xAA996655; //write key1 to SYSKEY
-            SYSKEY = 0x556699AA; //write key2 to SYSKEY
-            // OSCCON is now unlocked
-            // set SWRST bit to arm reset
-            RSWRSTSET = 1;
-            // read RSWRST register to trigger reset
-            volatile uint32_t dummy;
-            dummy = RSWRST;
-            // prevent any unwanted code execution until reset occurs
-            while(1);
+            strcat(dest, " ");
         }
-        else if (NULL != strstr(cmd_buffer, CMD_SEND_SPI3_DWORD))
+
+        strcat(dest, tokens[i]);
+    }
+}
+
+/* *******************************************************
+ * Command handlers
+ *********************************************************/
+
+static bool cmd_help(int argc, char* argv[])
+{
+    char command[CMD_BUFFER_SIZE];
+
+    join_tokens(command, argv, argc);
+    terminal_help(command);
+
+    return true;
+}
+
+static bool cmd_exit(int argc, char* argv[])
+{
+    terminal_open = false;
+
+    uart_write_string("\tTerminal closed.");
+    uart_write_string(NEWLINE);
+
+    return true;
+}
+
+static bool cmd_system_reset(int argc, char* argv[])
+{
+    // assume interrupts are disabled
+    // assume the DMA controller is suspended
+    // assume the device is locked
+    // perform a system unlock sequence
+    // starting critical sequence
+    SYSKEY = 0x00000000; //write invalid key to force lock
+    SYSKEY = 0xAA996655; //write key1 to SYSKEY
+    SYSKEY = 0x556699AA; //write key2 to SYSKEY
+    // OSCCON is now unlocked
+    // set SWRST bit to arm reset
+    RSWRSTSET = 1;
+    // read RSWRST register to trigger reset
+    volatile uint32_t dummy;
+    dummy = RSWRST;
+    // prevent any unwanted code execution until reset occurs
+    while(1);
+
+    return true;
+}
+
+static bool cmd_init_spi3(int argc, char* argv[])
+{
+    spi_init(SPI_DEVICE_DSP);
+
+    return true;
+}
+
+static bool cmd_send_spi3_dword(int argc, char* argv[])
+{
+    bool args_ok = (1 == argc);
+    char* end;
+    uint32_t dword;
+
+    if (args_ok)
+    {
+        dword = strtoul(argv[0], &end, 16);
+        args_ok = (0 == *end);
+    }
+
+    if (args_ok)
+    {
+        spi_write_dword(SPI_DEVICE_DSP, dword);
+    }
+
+    return args_ok;
+}
+
+static bool cmd_dsp_status(int argc, char* argv[])
+{
+    if (!dsp_link_poll_status(NULL))
+    {
+        sprintf(g_debug_util_char_buffer,
+                "\t%sNo valid status reply from the DSP%s",
+                WARNING_TAG,
+                NEWLINE);
+        uart_write_string(g_debug_util_char_buffer);
+    }
+
+    dsp_link_print_status();
+
+    return true;
+}
+
+static bool cmd_dsp_send(int argc, char* argv[])
+{
+    bool args_ok = (argc >= 1);
+    uint32_t payload[MAX_NBR_OF_TOKENS];
+    uint32_t type = 0;
+    char* end;
+    int i;
+
+    if (args_ok)
+    {
+        type = strtoul(argv[0], &end, 16);
+        args_ok = (0 == *end) && (type <= 0xFF);
+    }
+
+    for (i = 1; args_ok && (i < argc); ++i)
+    {
+        payload[i - 1] = strtoul(argv[i], &end, 16);
+        args_ok = (0 == *end);
+    }
+
+    if (args_ok)
+    {
+        if (DSP_LINK_OK != dsp_link_send((dsp_msg_type_t)type,
+                                         payload,
+                                         argc - 1))
         {
-            // TODO implement CMD_SEND_SPI3_DWORD func
-            spi_write_dword(SPI_DEVICE_DSP, 0x50505050);
+            sprintf(g_debug_util_char_buffer,
+                    "\t%sThe DSP is busy, the message was not sent%s",
+                    WARNING_TAG,
+                    NEWLINE);
+            uart_write_string(g_debug_util_char_buffer);
         }
-        else if (NULL != strstr(cmd_buffer, CMD_INIT_SPI3))
+    }
+
+    return args_ok;
+}
+
+static bool cmd_dsp_events(int argc, char* argv[])
+{
+    dsp_events_print_status();
+
+    return true;
+}
+
+static bool cmd_dsp_event(int argc, char* argv[])
+{
+    bool args_ok = (3 == argc) || (4 == argc);
+    uint32_t values[4] = {0, 0, 0, 0};
+    char* end;
+    int i;
+
+    for (i = 0; args_ok && (i < argc); ++i)
+    {
+        values[i] = strtoul(argv[i], &end, (0 == i) ? 0 : 16);
+        args_ok = (0 == *end) && ((0 == i) || (values[i] <= 0xFF));
+    }
+
+    if (args_ok)
+    {
+        if (!dsp_events_schedule(dsp_events_now() + values[0],
+                                 (uint8_t)values[1],
+                                 (uint8_t)values[2],
+                                 (uint8_t)values[3]))
         {
-            spi_init(SPI_DEVICE_DSP);
+            sprintf(g_debug_util_char_buffer,
+                    "\t%sThe event queue is full, the event was dropped%s",
+                    WARNING_TAG,
+                    NEWLINE);
+            uart_write_string(g_debug_util_char_buffer);
         }
-        else
+    }
+
+    return args_ok;
+}
+
+static bool get_spi3_status(int argc, char* argv[])
+{
+    spi_print_debug_status(SPI_DEVICE_DSP);
+
+    return true;
+}
+
+static bool get_spi4_status(int argc, char* argv[])
+{
+    spi_print_debug_status(SPI_DEVICE_SDCARD);
+
+    return true;
+}
+
+static bool get_sd_status(int argc, char* argv[])
+{
+    sdcard_mount_print_status();
+    sdcard_print_status();
+
+    return true;
+}
+
+static bool get_sd_profile(int argc, char* argv[])
+{
+    sdcard_profiler_print();
+
+    return true;
+}
+
+static bool cmd_sd_profile_reset(int argc, char* argv[])
+{
+    sdcard_profiler_reset();
+
+    return true;
+}
+
+static bool get_fs_cache(int argc, char* argv[])
+{
+    afatfsCacheStatistics_t statistics;
+    afatfsReadAheadStatistics_t read_ahead;
+    uint32_t lookups;
+
+    afatfs_getCacheStatistics(&statistics);
+    afatfs_getReadAheadStatistics(&read_ahead);
+    lookups = statistics.hits + statistics.misses;
+
+    sprintf(g_debug_util_char_buffer,
+            "\t%u sectors, %u hits, %u misses, %u evictions, %u stalls%s",
+            (unsigned int)statistics.sectors,
+            (unsigned int)statistics.hits,
+            (unsigned int)statistics.misses,
+            (unsigned int)statistics.evictions,
+            (unsigned int)statistics.stalls,
+            NEWLINE);
+    uart_write_string(g_debug_util_char_buffer);
+
+    if (0 != lookups)
+    {
+        sprintf(g_debug_util_char_buffer,
+                "\tHit rate %u.%u %%%s",
+                (unsigned int)((1000ull * statistics.hits / lookups) / 10),
+                (unsigned int)((1000ull * statistics.hits / lookups) % 10),
+                NEWLINE);
+        uart_write_string(g_debug_util_char_buffer);
+    }
+
+    sprintf(g_debug_util_char_buffer,
+            "\tRead-ahead: %u prefetched, %u hits, %u late, %u wasted%s",
+            (unsigned int)read_ahead.prefetched,
+            (unsigned int)read_ahead.hits,
+            (unsigned int)read_ahead.late,
+            (unsigned int)read_ahead.wasted,
+            NEWLINE);
+    uart_write_string(g_debug_util_char_buffer);
+
+    return true;
+}
+
+static bool cmd_fs_cache_reset(int argc, char* argv[])
+{
+    afatfs_resetCacheStatistics();
+
+    return true;
+}
+
+static bool get_spi_bus_status(int argc, char* argv[])
+{
+    spi_bus_print_status();
+
+    return true;
+}
+
+static bool cmd_get(int argc, char* argv[])
+{
+    bool args_ok = (argc <= 1);
+
+    if (args_ok)
+    {
+        args_ok = tunables_print((0 == argc) ? NULL : argv[0]);
+    }
+
+    return args_ok;
+}
+
+static bool cmd_set(int argc, char* argv[])
+{
+    bool args_ok = (2 == argc) && (NULL != tunables_find(argv[0]));
+
+    if (args_ok)
+    {
+        if (!tunables_set(argv[0], argv[1]))
         {
-            syntax_error = true;
+            uart_write_string("\t[Invalid value]\r\n");
         }
+
+        tunables_print(argv[0]);
     }
 
-    if (syntax_error)
+    return args_ok;
+}
+
+static bool cmd_settings_save(int argc, char* argv[])
+{
+    if (!tunables_save())
     {
-        uart_clear_receive_buffer();
-        uart_write_string(SYNTAX_ERROR);
+        uart_write_string("\t[File system busy or not ready]\r\n");
     }
 
-    if (terminal_open)
+    return true;
+}
+
+static bool cmd_settings_load(int argc, char* argv[])
+{
+    if (!tunables_load())
     {
-        uart_clear_receive_buffer();
-        uart_write_string(COMMAND_ENTER);
+        uart_write_string("\t[File system busy or not ready]\r\n");
     }
 
-    return 0;
+    return true;
 }
 
-/* *******************************************************
- * Command help functions
- *********************************************************/
+static bool cmd_bench(int argc, char* argv[])
+{
+    bool args_ok = (argc <= 3);
+    uint32_t iterations = BENCH_DEFAULT_ITERATIONS;
+    uint32_t first_block = BENCH_SCRATCH_BLOCK;
+    char* end;
+
+    if (args_ok && (argc >= 2))
+    {
+        iterations = strtoul(argv[1], &end, 0);
+        args_ok = (0 == *end);
+    }
+
+    if (args_ok && (argc >= 3))
+    {
+        // Block 0 holds the MBR
+        first_block = strtoul(argv[2], &end, 0);
+        args_ok = (0 == *end) && (0 != first_block);
+    }
+
+    if (args_ok)
+    {
+        if (0 == argc)
+        {
+            bench_list();
+        }
+        else
+        {
+            args_ok = bench_run(argv[0], iterations, first_block);
+        }
+    }
+
+    return args_ok;
+}
@@ -0,0 +1,63 @@
+/*
+This file is an auto generated file.
+Do not modify its contents manually!
+
+It is included once by terminal.c, after the command strings.
+*/
+#ifndef TERMINAL_COMMANDS_H
+#define TERMINAL_COMMANDS_H
+
+static bool cmd_bench(int argc, char* argv[]);
+static bool cmd_dsp_event(int argc, char* argv[]);
+static bool cmd_dsp_events(int argc, char* argv[]);
+static bool cmd_dsp_send(int argc, char* argv[]);
+static bool cmd_dsp_status(int argc, char* argv[]);
+static bool cmd_exit(int argc, char* argv[]);
+static bool cmd_fs_cache_reset(int argc, char* argv[]);
+static bool cmd_get(int argc, char* argv[]);
+static bool get_fs_cache(int argc, char* argv[]);
+static bool get_sd_profile(int argc, char* argv[]);
+static bool get_sd_status(int argc, char* argv[]);
+static bool get_spi_bus_status(int argc, char* argv[]);
+static bool get_spi3_status(int argc, char* argv[]);
+static bool get_spi4_status(int argc, char* argv[]);
+static bool cmd_help(int argc, char* argv[]);
+static bool cmd_sd_profile_reset(int argc, char* argv[]);
+static bool cmd_set(int argc, char* argv[]);
+static bool cmd_settings_load(int argc, char* argv[]);
+static bool cmd_settings_save(int argc, char* argv[]);
+static bool cmd_init_spi3(int argc, char* argv[]);
+static bool cmd_send_spi3_dword(int argc, char* argv[]);
+static bool cmd_system_reset(int argc, char* argv[]);
+
+// Sorted by command
+static const terminal_command_t terminal_commands[] =
+{
+    {CMD_BENCH, &cmd_bench},
+    {CMD_DSP_EVENT, &cmd_dsp_event},
+    {CMD_DSP_EVENTS, &cmd_dsp_events},
+    {CMD_DSP_SEND, &cmd_dsp_send},
+    {CMD_DSP_STATUS, &cmd_dsp_status},
+    {CMD_EXIT, &cmd_exit},
+    {CMD_FS_CACHE_RESET, &cmd_fs_cache_reset},
+    {CMD_GET, &cmd_get},
+    {GET_FS_CACHE, &get_fs_cache},
+    {GET_SD_PROFILE, &get_sd_profile},
+    {GET_SD_STATUS, &get_sd_status},
+    {GET_SPI_BUS_STATUS, &get_spi_bus_status},
+    {GET_SPI3_STATUS, &get_spi3_status},
+    {GET_SPI4_STATUS, &get_spi4_status},
+    {CMD_HELP, &cmd_help},
+    {CMD_SD_PROFILE_RESET, &cmd_sd_profile_reset},
+    {CMD_SET, &cmd_set},
+    {CMD_SETTINGS_LOAD, &cmd_settings_load},
+    {CMD_SETTINGS_SAVE, &cmd_settings_save},
+    {CMD_INIT_SPI3, &cmd_init_spi3},
+    {CMD_SEND_SPI3_DWORD, &cmd_send_spi3_dword},
+    {CMD_SYSTEM_RESET, &cmd_system_reset},
+};
+
+#define NBR_OF_TERMINAL_COMMANDS \
+    (sizeof(terminal_commands) / sizeof(terminal_commands[0]))
+
+#endif
@@ -1,4 +1,17 @@
-# This script generates documentation which can be seen in the dsp terminal.
+# This script generates the command table and the documentation which can be
+# seen in the dsp terminal.
+#
+# Every command in terminal.c is declared as a documentation block followed by
+# the command string constant:
+#
+#   /*§
+#    Documentation text.
+#    */
+#   static const char CMD_EXAMPLE[] = "example command";
+#
+# The handler of the command is the lower case name of the constant, in this
+# case "cmd_example", and must be defined in terminal.c as
+#   static bool cmd_example(int argc, char* argv[])
 
 class Command_doc:
     tag = ""
@@ -14,14 +27,18 @@ class Command_doc:
         self.cmd = command
         self.doc = documentation
 
+    # @brief Gets the name of the C function which handles the command
+    def handler(self):
+        return self.tag.lower()
+
 class Cmd_parser:
     commands = []
-    
+
     def parse_command_doc(self, filename = "terminal.c"):
         start_tag = "/*§"
         end_tag = "*/"
-        
-        with open(filename) as src_file:
+
+        with open(filename, encoding = "latin-1") as src_file:
             lines = src_file.readlines()
 
         parsing_doc = False
@@ -48,7 +65,11 @@ class Cmd_parser:
                 parsing_doc = False
                 parse_cmd = True
             elif parsing_doc:
-                doc += line.strip() + "\\n\\r\\t"
+                doc += line.strip().replace('"', '\\"') + "\\n\\r\\t"
+
+        # The dispatcher and the help function both binary search on the
+        # command string, so keep the tables in strcmp order.
+        self.commands.sort(key = lambda c: c.cmd)
 
     def create_help_function(self):
         with open("terminal_help.c", 'w') as f:
@@ -58,33 +79,50 @@ class Cmd_parser:
             print("*/", file=f)
             print("#include <string.h>", file=f)
             print("#include <stddef.h>", file=f)
+            print("#include <stdlib.h>", file=f)
             print("#include \"uart.h\"", file=f)
-
-            print("void terminal_help(char* in)", file=f)
+            print("#include \"terminal_help.h\"", file=f)
+            print("", file=f)
+            print("typedef struct help_entry_t", file=f)
+            print("{", file=f)
+            print("    const char* command;", file=f)
+            print("    const char* help;", file=f)
+            print("} help_entry_t;", file=f)
+            print("", file=f)
+            print("// Sorted by command", file=f)
+            print("static const help_entry_t help_entries[] =", file=f)
             print("{", file=f)
 
-            first = True
             for cmd in self.commands:
-                if first:
-                    first = False
-                    print("    if (NULL != strstr(in, \"" + cmd.cmd + "\"))", file=f)
-                else:
-                    print("    else if (NULL != strstr(in, \"" + cmd.cmd + "\"))", file=f)
-                print("    {", file=f)
-                print("        uart_write_string(\"\\t" + cmd.doc + "\\n\\r\");", file=f)
-                print("    }", file=f)
+                print("    {\"" + cmd.cmd + "\", \"\\t" + cmd.doc + "\\n\\r\"},", file=f)
 
+            print("};", file=f)
+            print("", file=f)
+            print("static int compare_help_entries(const void* key, const void* entry)", file=f)
+            print("{", file=f)
+            print("    return strcmp((const char*)key, ((const help_entry_t*)entry)->command);", file=f)
+            print("}", file=f)
+            print("", file=f)
+            print("void terminal_help(char* in)", file=f)
+            print("{", file=f)
+            print("    const help_entry_t* entry;", file=f)
+            print("", file=f)
+            print("    entry = bsearch(in,", file=f)
+            print("                    help_entries,", file=f)
+            print("                    sizeof(help_entries) / sizeof(help_entries[0]),", file=f)
+            print("                    sizeof(help_entry_t),", file=f)
+            print("                    &compare_help_entries);", file=f)
+            print("", file=f)
+            print("    if (NULL != entry)", file=f)
+            print("    {", file=f)
+            print("        uart_write_string(entry->help);", file=f)
+            print("    }", file=f)
             print("    else", file=f)
             print("    {", file=f)
 
-            commands_list = []
-            for cmd in self.commands:
-                commands_list.append(cmd.cmd + "\\n\\r\\t")
-            commands_list.sort()
-
             commands_string = '"\\t'
-            for line in commands_list:
-                commands_string += line
+            for cmd in self.commands:
+                commands_string += cmd.cmd + "\\n\\r\\t"
             commands_string += '"'
 
             print("        uart_write_string(\"\\tType \\\"help <command>\\\" for more info\\n\\r\");", file=f)
@@ -94,8 +132,38 @@ class Cmd_parser:
             print("        uart_write_string(\"\\n\\r\");", file=f)
             print("    }", file=f)
             print("}", file=f)
-            
-            
+
+    def create_command_table(self):
+        with open("terminal_commands.h", 'w') as f:
+            print("/*", file=f)
+            print("This file is an auto generated file.", file=f)
+            print("Do not modify its contents manually!", file=f)
+            print("", file=f)
+            print("It is included once by terminal.c, after the command strings.", file=f)
+            print("*/", file=f)
+            print("#ifndef TERMINAL_COMMANDS_H", file=f)
+            print("#define TERMINAL_COMMANDS_H", file=f)
+            print("", file=f)
+
+            for cmd in self.commands:
+                print("static bool " + cmd.handler() + "(int argc, char* argv[]);", file=f)
+
+            print("", file=f)
+            print("// Sorted by command", file=f)
+            print("static const terminal_command_t terminal_commands[] =", file=f)
+            print("{", file=f)
+
+            for cmd in self.commands:
+                print("    {" + cmd.tag + ", &" + cmd.handler() + "},", file=f)
+
+            print("};", file=f)
+            print("", file=f)
+            print("#define NBR_OF_TERMINAL_COMMANDS \\", file=f)
+            print("    (sizeof(terminal_commands) / sizeof(terminal_commands[0]))", file=f)
+            print("", file=f)
+            print("#endif", file=f)
+
+
 # ===============================================================================
 # Module test
 # ===============================================================================
@@ -105,5 +173,6 @@ if __name__ == "__main__":
     parser = Cmd_parser()
     parser.parse_command_doc()
     parser.create_help_function()
+    parser.create_command_table()
     print("Terminal doc gen complete")
-    
+
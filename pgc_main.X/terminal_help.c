@@ -4,39 +4,68 @@ Do not modify its contents manually!
 */
 #include <string.h>
 #include <stddef.h>
+#include <stdlib.h>
 #include "uart.h"
+#include "terminal_help.h"
+
+typedef struct help_entry_t
+{
+    const char* command;
+    const char* help;
+} help_entry_t;
+
+// Sorted by command
+static const help_entry_t help_entries[] =
+{
+    {"bench", "\tRuns an on-device benchmark and prints the result as a\n\r\t\"BENCH name=<name> key=value ...\" line. \"all\" runs every\n\r\tbenchmark which does not use the SD card. The SD card\n\r\tbenchmarks use 8 blocks from the first block, by default the\n\r\tlast 8 blocks of the card. The write benchmarks rewrite the\n\r\tblocks with their own contents, they refuse block 0 and a\n\r\tcard with a mounted filesystem. Lists the benchmarks if no\n\r\tname is given.\n\r\tParameters: [benchmark|all] [iterations] [first SD block]\n\r\t\n\r"},
+    {"dsp event", "\tSchedules a midi event to be applied by the DSP a number\n\r\tof samples from now.\n\r\tParameters: <delay in samples> <status (in hex)> <data 1 (in hex)> [data 2 (in hex)]\n\r\t\n\r"},
+    {"dsp events", "\tDisplays the sample time and the statistics of the\n\r\ttimestamped note events sent to the DSP.\n\r\t\n\r"},
+    {"dsp send", "\tSends one framed message to the DSP.\n\r\tParameters: <message type (in hex)> [payload dwords (in hex)]\n\r\t\n\r"},
+    {"dsp status", "\tPolls the DSP over the framed link and displays its status\n\r\tand the link statistics.\n\r\t\n\r"},
+    {"exit", "\tCloses down the terminal.\n\r\t\n\r"},
+    {"fs cache reset", "\tClears the filesystem sector cache and read-ahead\n\r\tstatistics.\n\r\t\n\r"},
+    {"get", "\tDisplays the value and the valid range of a runtime tunable,\n\r\tor of all tunables if no name is given.\n\r\tParameters: [tunable name]\n\r\t\n\r"},
+    {"get fs cache", "\tDisplays the size of the filesystem sector cache and the\n\r\tnumber of hits, misses and evictions since the last reset,\n\r\tand how well the file read-ahead kept up with the readers.\n\r\t\n\r"},
+    {"get sd profile", "\tDisplays the number, the min, mean and max duration and a\n\r\tlog-scale latency histogram of the SD card reads, writes\n\r\tand erases.\n\r\t\n\r"},
+    {"get sd status", "\tDisplays if there is a card in the slot and how it was\n\r\tmounted, the clock of the SD card bus, the maximum clock\n\r\tthe card supports and if high speed mode is used.\n\r\t\n\r"},
+    {"get spi bus status", "\tDisplays the number of transactions, the bytes moved and the\n\r\tbus utilisation of every device on the shared spi buses\n\r\tsince the previous call.\n\r\t\n\r"},
+    {"get spi3 status", "\tDisplays the registers values of the spi3 module.\n\r\t\n\r"},
+    {"get spi4 status", "\tDisplays the registers values of the spi4 module.\n\r\t\n\r"},
+    {"help", "\tLists the availible commands, or shows the help text of one command.\n\r\tParameters: [command]\n\r\t\n\r"},
+    {"sd profile reset", "\tClears the SD card latency statistics.\n\r\t\n\r"},
+    {"set", "\tSets a runtime tunable.\n\r\tParameters: <tunable name> <value>\n\r\t\n\r"},
+    {"settings load", "\tLoads the runtime tunables from SETTINGS.TXT on the SD card.\n\r\t\n\r"},
+    {"settings save", "\tSaves all runtime tunables to SETTINGS.TXT on the SD card.\n\r\t\n\r"},
+    {"spi3 init", "\tRuns the spi3 initialization code.\n\r\t\n\r"},
+    {"spi3 send dword", "\tSends a 32 bit value over the spi3 interface.\n\r\tParameters: <dword to send (in hex)>\n\r\t\n\r"},
+    {"system reset", "\tForces a software reset.\n\r\t\n\r"},
+};
+
+static int compare_help_entries(const void* key, const void* entry)
+{
+    return strcmp((const char*)key, ((const help_entry_t*)entry)->command);
+}
+
 void terminal_help(char* in)
 {
-    if (NULL != strstr(in, "exit"))
-    {
-        uart_write_string("\tCloses down the terminal.\n\r\t\n\r");
-    }
-    else if (NULL != strstr(in, "system reset\r\n"))
-    {
-        uart_write_string("\tForces a software reset.\n\r\t\n\r");
-    }
-    else if (NULL != strstr(in, "spi3 init"))
-    {
-        uart_write_string("\tRuns the spi3 initialization code.\n\r\t\n\r");
-    }
-    else if (NULL != strstr(in, "spi3 send dword"))
-    {
-        uart_write_string("\tSends a 32 bit value over the spi3 interface.\n\r\tParameters: <dword to send (in hex)>\n\r\t\n\r");
-    }
-    else if (NULL != strstr(in, "get spi3 status"))
-    {
-        uart_write_string("\tDisplays the registers values of the spi3 module.\n\r\t\n\r");
-    }
-    else if (NULL != strstr(in, "get spi4 status"))
+    const help_entry_t* entry;
+
+    entry = bsearch(in,
+                    help_entries,
+                    sizeof(help_entries) / sizeof(help_entries[0]),
+                    sizeof(help_entry_t),
+                    &compare_help_entries);
+
+    if (NULL != entry)
     {
-        uart_write_string("\tDisplays the registers values of the spi4 module.\n\r\t\n\r");
+        uart_write_string(entry->help);
     }
     else
     {
         uart_write_string("\tType \"help <command>\" for more info\n\r");
         uart_write_string("\tAvailible commands:\n\r");
         uart_write_string("\t------------------------------------\n\r");
-        uart_write_string("\texit\n\r\tget spi3 status\n\r\tget spi4 status\n\r\tspi3 init\n\r\tspi3 send dword\n\r\tsystem reset\r\n\n\r\t");
+        uart_write_string("\tbench\n\r\tdsp event\n\r\tdsp events\n\r\tdsp send\n\r\tdsp status\n\r\texit\n\r\tfs cache reset\n\r\tget\n\r\tget fs cache\n\r\tget sd profile\n\r\tget sd status\n\r\tget spi bus status\n\r\tget spi3 status\n\r\tget spi4 status\n\r\thelp\n\r\tsd profile reset\n\r\tset\n\r\tsettings load\n\r\tsettings save\n\r\tspi3 init\n\r\tspi3 send dword\n\r\tsystem reset\n\r\t");
         uart_write_string("\n\r");
     }
 }
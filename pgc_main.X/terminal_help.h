@@ -27,7 +27,9 @@
 
 /*
  * @brief Prints help information to the terminal given a command.
- * @param help_command - the command to give help for.
+ * @details Lists all commands if help_command is not a known command.
+ * @param help_command - the command to give help for, with the words
+ *                       separated by single spaces.
  */
 void terminal_help(char* help_command);
 
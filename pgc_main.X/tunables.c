@@ -0,0 +1,627 @@
+
+// =============================================================================
+// Include statements
+// =============================================================================
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+
+#include "tunables.h"
+#include "asyncfatfs.h"
+#include "event_queue.h"
+#include "uart.h"
+#include "debug_util.h"
+
+// =============================================================================
+// Private type definitions
+// =============================================================================
+
+typedef enum persist_state_t
+{
+    PERSIST_IDLE,
+    PERSIST_OPENING,
+    PERSIST_WRITING,
+    PERSIST_READING,
+    PERSIST_CLOSING
+} persist_state_t;
+
+// =============================================================================
+// Global variables
+// =============================================================================
+
+// =============================================================================
+// Private constants
+// =============================================================================
+#define SETTINGS_FILE_BUFFER_SIZE   (512u)
+
+// Large enough for any uint32_t in decimal and for the enum names
+#define VALUE_STRING_SIZE           (16u)
+
+static const char SETTINGS_FILE_NAME[] = "SETTINGS.TXT";
+
+// =============================================================================
+// Private variables
+// =============================================================================
+static const tunable_t* tunables[TUNABLES_MAX_NBR_OF_TUNABLES];
+static uint32_t nbr_of_tunables = 0;
+
+static persist_state_t persist_state = PERSIST_IDLE;
+static afatfsFilePtr_t settings_file = NULL;
+
+// Holds the whole settings file while it is written or read
+static char file_buffer[SETTINGS_FILE_BUFFER_SIZE];
+static uint32_t file_buffer_length = 0;
+static uint32_t file_buffer_pos = 0;
+
+// =============================================================================
+// Private function declarations
+// =============================================================================
+
+/**
+ * @brief Parses and validates a value for a tunable.
+ * @param tunable - the tunable the value is meant for.
+ * @param text - the value as text.
+ * @param value - where to store the parsed value.
+ * @return false if the text is not a valid value for the tunable.
+ */
+static bool parse_value(const tunable_t* tunable,
+                        const char* text,
+                        uint32_t* value);
+
+/**
+ * @brief Formats the current value of a tunable as text.
+ * @param tunable - the tunable.
+ * @param buffer - buffer of VALUE_STRING_SIZE bytes, may be unused.
+ * @return The value as a null terminated string.
+ */
+static const char* value_string(const tunable_t* tunable, char* buffer);
+
+/**
+ * @brief Prints the value and the valid range of one tunable.
+ */
+static void print_tunable(const tunable_t* tunable);
+
+/**
+ * @brief Writes all tunables as "name=value" lines to the file buffer.
+ */
+static void serialize_tunables(void);
+
+/**
+ * @brief Applies all "name=value" lines in the file buffer.
+ */
+static void apply_file_buffer(void);
+
+/**
+ * @brief Drives afatfs and the settings file transfer.
+ * @details Pushed to the event queue until the save or load is done.
+ */
+static int32_t persist_poll(int32_t arg);
+
+/**
+ * @brief Writes as much of the file buffer to the settings file as afatfs
+ *        accepts right now.
+ */
+static void write_step(void);
+
+/**
+ * @brief Reads as much of the settings file to the file buffer as afatfs
+ *        provides right now.
+ */
+static void read_step(void);
+
+/**
+ * @brief Called by afatfs when the settings file has been opened for writing.
+ */
+static void save_file_opened(afatfsFilePtr_t file);
+
+/**
+ * @brief Called by afatfs when the settings file has been closed after a save.
+ */
+static void save_file_closed(void);
+
+/**
+ * @brief Called by afatfs when the settings file has been opened for reading.
+ */
+static void load_file_opened(afatfsFilePtr_t file);
+
+/**
+ * @brief Called by afatfs when the settings file has been closed after a load.
+ */
+static void load_file_closed(void);
+
+// =============================================================================
+// Public function definitions
+// =============================================================================
+
+bool tunables_register(const tunable_t* tunable)
+{
+    const tunable_t* existing = tunables_find(tunable->name);
+    bool registered = false;
+
+    if (tunable == existing)
+    {
+        // Registered again by a module which is initialized more than once,
+        // e.g. the SD card driver on every card insertion.
+        registered = true;
+    }
+    else if ((TUNABLES_MAX_NBR_OF_TUNABLES != nbr_of_tunables) &&
+             (NULL == existing))
+    {
+        tunables[nbr_of_tunables] = tunable;
+        ++nbr_of_tunables;
+        registered = true;
+    }
+    else
+    {
+        sprintf(g_debug_util_char_buffer,
+                "%sTunable not registered, %s: %.32s",
+                WARNING_TAG,
+                (NULL != existing) ? "name taken" : "registry full",
+                tunable->name);
+        uart_write_string(g_debug_util_char_buffer);
+        uart_write_string(NEWLINE);
+    }
+
+    return registered;
+}
+
+const tunable_t* tunables_find(const char* name)
+{
+    const tunable_t* found = NULL;
+    uint32_t i;
+
+    for (i = 0; (i != nbr_of_tunables) && (NULL == found); ++i)
+    {
+        if (0 == strcmp(name, tunables[i]->name))
+        {
+            found = tunables[i];
+        }
+    }
+
+    return found;
+}
+
+bool tunables_set(const char* name, const char* value)
+{
+    const tunable_t* tunable = tunables_find(name);
+    uint32_t new_value;
+    bool value_ok = false;
+
+    if ((NULL != tunable) && parse_value(tunable, value, &new_value))
+    {
+        *tunable->value = new_value;
+
+        if (NULL != tunable->on_change)
+        {
+            tunable->on_change();
+        }
+
+        value_ok = true;
+    }
+
+    return value_ok;
+}
+
+bool tunables_print(const char* name)
+{
+    const tunable_t* tunable;
+    bool found = true;
+    uint32_t i;
+
+    if (NULL == name)
+    {
+        for (i = 0; i != nbr_of_tunables; ++i)
+        {
+            print_tunable(tunables[i]);
+        }
+    }
+    else
+    {
+        tunable = tunables_find(name);
+        found = (NULL != tunable);
+
+        if (found)
+        {
+            print_tunable(tunable);
+        }
+    }
+
+    return found;
+}
+
+bool tunables_save(void)
+{
+    bool started = false;
+
+    if ((PERSIST_IDLE == persist_state) &&
+        (AFATFS_FILESYSTEM_STATE_READY == afatfs_getFilesystemState()))
+    {
+        serialize_tunables();
+        persist_state = PERSIST_OPENING;
+        started = true;
+
+        // Truncates any previous settings file
+        if (afatfs_fopen(SETTINGS_FILE_NAME, "w", &save_file_opened))
+        {
+            event_queue_push_callback(&persist_poll,
+                                      EVENT_QUEUE_NO_ARG,
+                                      EVENT_PRIO_LOW);
+        }
+    }
+
+    return started;
+}
+
+bool tunables_load(void)
+{
+    bool started = false;
+
+    if ((PERSIST_IDLE == persist_state) &&
+        (AFATFS_FILESYSTEM_STATE_READY == afatfs_getFilesystemState()))
+    {
+        file_buffer_length = 0;
+        persist_state = PERSIST_OPENING;
+        started = true;
+
+        if (afatfs_fopen(SETTINGS_FILE_NAME, "r", &load_file_opened))
+        {
+            event_queue_push_callback(&persist_poll,
+                                      EVENT_QUEUE_NO_ARG,
+                                      EVENT_PRIO_LOW);
+        }
+    }
+
+    return started;
+}
+
+// =============================================================================
+// Private function definitions
+// =============================================================================
+
+static bool parse_value(const tunable_t* tunable,
+                        const char* text,
+                        uint32_t* value)
+{
+    bool value_ok = false;
+    unsigned long parsed;
+    char* end;
+    uint32_t i;
+
+    switch (tunable->type)
+    {
+    case TUNABLE_TYPE_UINT32:
+        // strtoul accepts a sign and leading white space, we do not.
+        if (isdigit((unsigned char)text[0]))
+        {
+            errno = 0;
+            parsed = strtoul(text, &end, 0);
+
+            value_ok = ('\0' == *end) &&
+                       (0 == errno) &&
+                       (parsed >= tunable->min) &&
+                       (parsed <= tunable->max);
+            *value = (uint32_t)parsed;
+        }
+        break;
+
+    case TUNABLE_TYPE_BOOL:
+        if ((0 == strcmp(text, "true")) ||
+            (0 == strcmp(text, "on")) ||
+            (0 == strcmp(text, "1")))
+        {
+            *value = 1;
+            value_ok = true;
+        }
+        else if ((0 == strcmp(text, "false")) ||
+                 (0 == strcmp(text, "off")) ||
+                 (0 == strcmp(text, "0")))
+        {
+            *value = 0;
+            value_ok = true;
+        }
+        break;
+
+    case TUNABLE_TYPE_ENUM:
+        for (i = 0; (NULL != tunable->enum_names[i]) && !value_ok; ++i)
+        {
+            if (0 == strcmp(text, tunable->enum_names[i]))
+            {
+                *value = i;
+                value_ok = true;
+            }
+        }
+        break;
+
+    default:
+        break;
+    }
+
+    return value_ok;
+}
+
+static const char* value_string(const tunable_t* tunable, char* buffer)
+{
+    const char* str = buffer;
+
+    switch (tunable->type)
+    {
+    case TUNABLE_TYPE_BOOL:
+        str = (0 != *tunable->value) ? "true" : "false";
+        break;
+
+    case TUNABLE_TYPE_ENUM:
+        str = tunable->enum_names[*tunable->value];
+        break;
+
+    case TUNABLE_TYPE_UINT32:
+    default:
+        sprintf(buffer, "%u", (unsigned int)*tunable->value);
+        break;
+    }
+
+    return str;
+}
+
+static void print_tunable(const tunable_t* tunable)
+{
+    char value_buffer[VALUE_STRING_SIZE];
+    uint32_t i;
+
+    sprintf(g_debug_util_char_buffer,
+            "\t%s = %s",
+            tunable->name,
+            value_string(tunable, value_buffer));
+    uart_write_string(g_debug_util_char_buffer);
+
+    switch (tunable->type)
+    {
+    case TUNABLE_TYPE_UINT32:
+        sprintf(g_debug_util_char_buffer,
+                " [%u, %u]",
+                (unsigned int)tunable->min,
+                (unsigned int)tunable->max);
+        uart_write_string(g_debug_util_char_buffer);
+        break;
+
+    case TUNABLE_TYPE_BOOL:
+        uart_write_string(" [true, false]");
+        break;
+
+    case TUNABLE_TYPE_ENUM:
+        uart_write_string(" [");
+
+        for (i = 0; NULL != tunable->enum_names[i]; ++i)
+        {
+            if (0 != i)
+            {
+                uart_write_string(", ");
+            }
+
+            uart_write_string(tunable->enum_names[i]);
+        }
+
+        uart_write_string("]");
+        break;
+
+    default:
+        break;
+    }
+
+    uart_write_string(NEWLINE);
+}
+
+static void serialize_tunables(void)
+{
+    char value_buffer[VALUE_STRING_SIZE];
+    int line_length;
+    uint32_t i;
+
+    file_buffer_length = 0;
+    file_buffer_pos = 0;
+
+    for (i = 0; i != nbr_of_tunables; ++i)
+    {
+        line_length = snprintf(&file_buffer[file_buffer_length],
+                               SETTINGS_FILE_BUFFER_SIZE - file_buffer_length,
+                               "%s=%s\r\n",
+                               tunables[i]->name,
+                               value_string(tunables[i], value_buffer));
+
+        if ((line_length < 0) ||
+            (file_buffer_length + line_length >= SETTINGS_FILE_BUFFER_SIZE))
+        {
+            // Never save a partial line
+            file_buffer[file_buffer_length] = '\0';
+            uart_write_string(WARNING_TAG);
+            uart_write_string("Settings file buffer full");
+            uart_write_string(NEWLINE);
+            break;
+        }
+
+        file_buffer_length += line_length;
+    }
+}
+
+static void apply_file_buffer(void)
+{
+    char* line;
+    char* next_line;
+    char* value;
+
+    file_buffer[file_buffer_length] = '\0';
+
+    for (line = file_buffer; NULL != line; line = next_line)
+    {
+        next_line = strpbrk(line, "\r\n");
+
+        if (NULL != next_line)
+        {
+            *next_line = '\0';
+            ++next_line;
+        }
+
+        // Skip empty lines and comments
+        if (('\0' == line[0]) || ('#' == line[0]))
+        {
+            continue;
+        }
+
+        value = strchr(line, '=');
+
+        if (NULL != value)
+        {
+            *value = '\0';
+            ++value;
+        }
+
+        if ((NULL == value) || !tunables_set(line, value))
+        {
+            sprintf(g_debug_util_char_buffer,
+                    "%sSkipped setting: %.32s",
+                    WARNING_TAG,
+                    line);
+            uart_write_string(g_debug_util_char_buffer);
+            uart_write_string(NEWLINE);
+        }
+    }
+}
+
+static int32_t persist_poll(int32_t arg)
+{
+    afatfs_poll();
+
+    switch (persist_state)
+    {
+    case PERSIST_WRITING:
+        write_step();
+        break;
+
+    case PERSIST_READING:
+        read_step();
+        break;
+
+    default:
+        break;
+    }
+
+    if (PERSIST_IDLE != persist_state)
+    {
+        event_queue_push_callback(&persist_poll,
+                                  EVENT_QUEUE_NO_ARG,
+                                  EVENT_PRIO_LOW);
+    }
+
+    return 0;
+}
+
+static void write_step(void)
+{
+    file_buffer_pos += afatfs_fwrite(settings_file,
+                                     (const uint8_t*)&file_buffer[file_buffer_pos],
+                                     file_buffer_length - file_buffer_pos);
+
+    if (file_buffer_pos == file_buffer_length)
+    {
+        persist_state = PERSIST_CLOSING;
+        afatfs_fclose(settings_file, &save_file_closed);
+    }
+    else if (afatfs_isFull())
+    {
+        uart_write_string(ERROR_TAG);
+        uart_write_string("SD card full");
+        uart_write_string(NEWLINE);
+
+        persist_state = PERSIST_CLOSING;
+        afatfs_fclose(settings_file, &save_file_closed);
+    }
+    else
+    {
+        ;   // The cache is busy, try again on the next poll.
+    }
+}
+
+static void read_step(void)
+{
+    // Leave room for the null terminator added when applying the values
+    file_buffer_length += afatfs_fread(
+                settings_file,
+                (uint8_t*)&file_buffer[file_buffer_length],
+                SETTINGS_FILE_BUFFER_SIZE - 1 - file_buffer_length);
+
+    if (afatfs_feof(settings_file))
+    {
+        persist_state = PERSIST_CLOSING;
+        afatfs_fclose(settings_file, &load_file_closed);
+    }
+    else if (SETTINGS_FILE_BUFFER_SIZE - 1 == file_buffer_length)
+    {
+        uart_write_string(WARNING_TAG);
+        uart_write_string("Settings file truncated");
+        uart_write_string(NEWLINE);
+
+        persist_state = PERSIST_CLOSING;
+        afatfs_fclose(settings_file, &load_file_closed);
+    }
+    else
+    {
+        ;   // The cache is busy, try again on the next poll.
+    }
+}
+
+static void save_file_opened(afatfsFilePtr_t file)
+{
+    settings_file = file;
+
+    if (NULL != file)
+    {
+        persist_state = PERSIST_WRITING;
+    }
+    else
+    {
+        persist_state = PERSIST_IDLE;
+        uart_write_string(ERROR_TAG);
+        uart_write_string("Could not open the settings file");
+        uart_write_string(NEWLINE);
+    }
+}
+
+static void save_file_closed(void)
+{
+    persist_state = PERSIST_IDLE;
+
+    if (file_buffer_pos == file_buffer_length)
+    {
+        uart_write_string("\tSettings saved");
+        uart_write_string(NEWLINE);
+    }
+}
+
+static void load_file_opened(afatfsFilePtr_t file)
+{
+    settings_file = file;
+
+    if (NULL != file)
+    {
+        persist_state = PERSIST_READING;
+    }
+    else
+    {
+        persist_state = PERSIST_IDLE;
+        uart_write_string(ERROR_TAG);
+        uart_write_string("Could not open the settings file");
+        uart_write_string(NEWLINE);
+    }
+}
+
+static void load_file_closed(void)
+{
+    persist_state = PERSIST_IDLE;
+    apply_file_buffer();
+    uart_write_string("\tSettings loaded");
+    uart_write_string(NEWLINE);
+}
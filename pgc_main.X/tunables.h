@@ -0,0 +1,123 @@
+/*
+ * Registry of named runtime parameters.
+ *
+ * Modules register their tunables when they are initialized. The terminal
+ * reads and writes them by name with the "get" and "set" commands, so a
+ * parameter can be tuned on a running unit without a rebuild.
+ *
+ * Each tunable is backed by a uint32_t variable owned by the module. Writes
+ * are validated against the type of the tunable before the variable is
+ * updated, and the module is notified through the on_change callback.
+ *
+ * The registry can be saved to and loaded from a settings file on the SD
+ * card, one "name=value" line per tunable.
+ */
+
+#ifndef TUNABLES_H
+#define	TUNABLES_H
+
+#ifdef	__cplusplus
+//extern "C" {
+#endif
+
+// =============================================================================
+// Include statements
+// =============================================================================
+#include <stdint.h>
+#include <stdbool.h>
+
+// =============================================================================
+// Public type definitions
+// =============================================================================
+
+typedef enum tunable_type_t
+{
+    TUNABLE_TYPE_UINT32,    // Decimal or 0x prefixed hex within [min, max]
+    TUNABLE_TYPE_BOOL,      // "true"/"false", "on"/"off" or "1"/"0"
+    TUNABLE_TYPE_ENUM       // One of enum_names, stored as the name index
+} tunable_type_t;
+
+typedef struct tunable_t
+{
+    const char* name;
+    tunable_type_t type;
+    uint32_t* value;
+    uint32_t min;                   // Only used by TUNABLE_TYPE_UINT32
+    uint32_t max;                   // Only used by TUNABLE_TYPE_UINT32
+    const char* const* enum_names;  // NULL terminated, TUNABLE_TYPE_ENUM only
+    void (*on_change)(void);        // Called after a successful write, or NULL
+} tunable_t;
+
+// =============================================================================
+// Global constatants
+// =============================================================================
+#define TUNABLES_MAX_NBR_OF_TUNABLES    (32u)
+
+// =============================================================================
+// Global variable declarations
+// =============================================================================
+
+// =============================================================================
+// Public function declarations
+// =============================================================================
+
+/**
+ * @brief Adds a tunable to the registry.
+ * @details The descriptor is not copied and must stay valid, so declare it
+ *          static const in the owning module. Registering the same
+ *          descriptor again is accepted and does nothing.
+ * @param tunable - the tunable to add.
+ * @return false if the registry is full or the name is already taken by
+ *         another descriptor. A warning is printed over the uart in that
+ *         case, so callers do not need to report it.
+ */
+bool tunables_register(const tunable_t* tunable);
+
+/**
+ * @brief Looks up a tunable by name.
+ * @param name - the name of the tunable.
+ * @return The tunable, or NULL if no tunable has that name.
+ */
+const tunable_t* tunables_find(const char* name);
+
+/**
+ * @brief Parses, validates and writes a new value to a tunable.
+ * @param name - the name of the tunable.
+ * @param value - the new value as text.
+ * @return false if there is no such tunable or the value is not valid for it,
+ *         in which case the tunable is left unchanged.
+ */
+bool tunables_set(const char* name, const char* value);
+
+/**
+ * @brief Prints the value and the valid range of a tunable over the uart.
+ * @param name - the name of the tunable, or NULL to print all tunables.
+ * @return false if there is no such tunable.
+ */
+bool tunables_print(const char* name);
+
+/**
+ * @brief Starts writing all tunables to the settings file.
+ * @details The write is carried out by the event queue and the result is
+ *          printed over the uart when done.
+ * @return false if the file system is not ready or a save or load is
+ *         already in progress.
+ */
+bool tunables_save(void);
+
+/**
+ * @brief Starts reading the settings file and applying its values.
+ * @details The read is carried out by the event queue and the result is
+ *          printed over the uart when done. Unknown names and invalid values
+ *          in the file are reported and skipped.
+ * @return false if the file system is not ready or a save or load is
+ *         already in progress.
+ */
+bool tunables_load(void);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* TUNABLES_H */
+
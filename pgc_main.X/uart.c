@@ -17,12 +17,15 @@
 #include <string.h>
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
 
 #include "uart.h"
 #include "mcu.h"
 #include "pinmap.h"
 #include "event_queue.h"
 #include "terminal.h"
+#include "ring_buffer.h"
+#include "tunables.h"
 
 // =============================================================================
 // Private type definitions
@@ -38,24 +41,27 @@
 #define BUFFER_SIZE     ((uint16_t)1024)
 #define BACKSPACE_CHAR  (0x08)
 
-static const uint32_t UART_BAUD = 9600;
+#define UART_DEFAULT_BAUD   (9600u)
+#define UART_MIN_BAUD       (1200u)
+#define UART_MAX_BAUD       (921600u)
 
 // =============================================================================
 // Private variables
 // =============================================================================
 static bool uart_initialized = false;
 
-// Implement the TX and RX buffers as circular buffers:
-static volatile uint8_t rx_buff[BUFFER_SIZE];
-static volatile uint8_t tx_buff[BUFFER_SIZE];
+static uint32_t uart_baud = UART_DEFAULT_BAUD;
 
-static volatile uint16_t rx_buff_first = 0;
-static volatile uint16_t rx_buff_last = 0;
-static volatile uint16_t tx_buff_first = 0;
-static volatile uint16_t tx_buff_last = 0;
+// Implement the TX and RX buffers as ring buffers:
+static uint8_t rx_buff[BUFFER_SIZE];
+static uint8_t tx_buff[BUFFER_SIZE];
 
-static volatile uint16_t rx_buff_size = 0;
-static volatile uint16_t tx_buff_size = 0;
+// Produced by the rx ISR, consumed by the terminal.
+static ring_buffer_u8_t rx_ring = {{0, 0, BUFFER_SIZE - 1}, rx_buff};
+
+// Produced by the uart_write functions (including the echo from the rx ISR),
+// consumed by the tx ISR.
+static ring_buffer_u8_t tx_ring = {{0, 0, BUFFER_SIZE - 1}, tx_buff};
 
 // =============================================================================
 // Private function declarations
@@ -68,6 +74,23 @@ static volatile uint16_t tx_buff_size = 0;
  */
 static void start_tx(void);
 
+/**
+ * @brief Writes the uart_baud tunable to the baud rate generator.
+ * @details Waits for all buffered data to be sent with the old baud rate.
+ */
+static void update_baud(void);
+
+static const tunable_t uart_baud_tunable =
+{
+    "uart.baud",
+    TUNABLE_TYPE_UINT32,
+    &uart_baud,
+    UART_MIN_BAUD,
+    UART_MAX_BAUD,
+    NULL,
+    &update_baud
+};
+
 // =============================================================================
 // Public function definitions
 // =============================================================================
@@ -81,13 +104,8 @@ void uart_init()
         //
         // Variables
         //
-        rx_buff_first = 0;
-        rx_buff_last = 0;
-        tx_buff_first = 0;
-        tx_buff_last = 0;
-
-        rx_buff_size = 0;
-        tx_buff_size = 0;
+        ring_buffer_u8_init(&rx_ring, rx_buff, BUFFER_SIZE);
+        ring_buffer_u8_init(&tx_ring, tx_buff, BUFFER_SIZE);
 
         //
         // IO ports
@@ -119,7 +137,7 @@ void uart_init()
         U1MODE = 0x00000000;
         U1STA = 0x00000000;
 
-        U1BRG = (PBCLK_FREQ_HZ / UART_BAUD) / 16 - 1;
+        U1BRG = (PBCLK_FREQ_HZ / uart_baud) / 16 - 1;
 
         U1MODEbits.PDSEL = 0; // 8 bit data, no parity
         U1MODEbits.STSEL = 0; // 1 Stop bit
@@ -144,140 +162,87 @@ void uart_init()
         U1STAbits.UTXEN = 1;
         U1STAbits.URXEN = 1;
 
-        for (wait_cnt = 0; wait_cnt != PBCLK_FREQ_HZ / UART_BAUD; ++wait_cnt)
+        for (wait_cnt = 0; wait_cnt != PBCLK_FREQ_HZ / uart_baud; ++wait_cnt)
         {
             ;
         }
 
         __builtin_enable_interrupts();
 
+        tunables_register(&uart_baud_tunable);
+
         uart_initialized = true;
     }
 }
 
 void uart_write(uint8_t data)
 {
-    if ((0 == tx_buff_size) && (0 == U1STAbits.UTXBF))
+    if (ring_buffer_is_empty(&tx_ring.ring) && (0 == U1STAbits.UTXBF))
     {
-        // hw transmit buffer not full but tx buffer is.
+        // hw transmit buffer not full and the tx buffer is empty.
         U1TXREG = data;
     }
-    else if (tx_buff_size < BUFFER_SIZE)
+    else if (ring_buffer_u8_push(&tx_ring, data))
     {
-        if (0 != tx_buff_size)
-        {
-            ++tx_buff_last;
-
-            if (tx_buff_last >= BUFFER_SIZE)
-            {
-                tx_buff_last = 0;
-            }
-        }
-
-        tx_buff[tx_buff_last] = data;
-
-        ++tx_buff_size;
-
         uart_enable_tx_interrupt();
     }
 }
 
-void uart_write_string(const char* data)
+uint16_t uart_write_string(const char* data)
 {
-    const uint8_t* p = (const uint8_t*)data;
+    size_t length = strlen(data);
 
-    // Update the tx buffer.
-    while (*p && (tx_buff_size < BUFFER_SIZE))
+    // Longer strings would not fit in the tx buffer anyway, but must not wrap
+    // around to a short length when passed on as a uint16_t.
+    if (length > UINT16_MAX)
     {
-        if (0 != tx_buff_size)
-        {
-            ++tx_buff_last;
-
-            if (tx_buff_last >= BUFFER_SIZE)
-            {
-                tx_buff_last = 0;
-            }
-        }
-
-        tx_buff[tx_buff_last] = *(p++);
-
-        ++tx_buff_size;
+        length = UINT16_MAX;
     }
 
-    start_tx();
+    return uart_write_array((uint16_t)length, (const uint8_t*)data);
 }
 
-void uart_write_array(uint16_t nbr_of_bytes, const uint8_t* data)
+uint16_t uart_write_array(uint16_t nbr_of_bytes, const uint8_t* data)
 {
-    uint16_t i;
-
-    // Update the tx buffer.
-    for (i = 0; i != nbr_of_bytes; ++i)
-    {
-        if (tx_buff_size < BUFFER_SIZE)
-        {
-            if (0 != tx_buff_size)
-            {
-                ++tx_buff_last;
+    uint16_t bytes_written;
 
-                if (tx_buff_last >= BUFFER_SIZE)
-                {
-                    tx_buff_last = 0;
-                }
-            }
-
-            tx_buff[tx_buff_last] = *(data++);
+    // The rx ISR also writes to the tx buffer when echoing.
+    uart_disable_tx_interrupt();
+    uart_disable_rx_interrupt();
 
-            if (tx_buff_size < BUFFER_SIZE)
-            {
-                ++tx_buff_size;
-            }
-        }
-    }
+    bytes_written = ring_buffer_u8_push_bulk(&tx_ring, data, nbr_of_bytes);
 
     start_tx();
+
+    return bytes_written;
 }
 
-uint8_t uart_get(uint16_t index)
+void uart_flush(void)
 {
-    uint16_t i;
-    uint8_t data;
-
-    uart_disable_rx_interrupt();
-
-    i = rx_buff_first + index;
-
-    if (i >= BUFFER_SIZE)
+    while (!ring_buffer_is_empty(&tx_ring.ring) || (0 == U1STAbits.TRMT))
     {
-        i -= BUFFER_SIZE;
+        ;   // Wait for the tx buffer and the shift register to empty
     }
+}
 
-    data = rx_buff[i];
-
-    uart_enable_rx_interrupt();
-
-    return data;
+uint8_t uart_get(uint16_t index)
+{
+    return ring_buffer_u8_peek(&rx_ring, index);
 }
 
 uint16_t uart_get_receive_buffer_size(void)
 {
-    return rx_buff_size;
+    return ring_buffer_size(&rx_ring.ring);
 }
 
 bool uart_is_receive_buffer_empty(void)
 {
-    return (0 == rx_buff_size);
+    return ring_buffer_is_empty(&rx_ring.ring);
 }
 
 void uart_clear_receive_buffer(void)
 {
-    uart_disable_rx_interrupt();
-
-    rx_buff_size = 0;
-    rx_buff_first = 0;
-    rx_buff_last = 0;
-
-    uart_enable_rx_interrupt();
+    ring_buffer_clear(&rx_ring.ring);
 }
 
 
@@ -307,41 +272,15 @@ void __ISR(_UART1_RX_VECTOR, ipl2) uart1_rx_isr(void)
 
             if (BACKSPACE_CHAR != received)
             {
-                if (0 != rx_buff_size)
+                if (ring_buffer_u8_push(&rx_ring, received))
                 {
-                    ++rx_buff_last;
-
-                    if (rx_buff_last >= BUFFER_SIZE)
-                    {
-                        rx_buff_last = 0;
-                    }
+                    uart_write(received);
                 }
-
-                rx_buff[rx_buff_last] = received;
-
-                ++rx_buff_size;
-                uart_write(received);
             }
-            else
+            else if (!ring_buffer_is_empty(&rx_ring.ring))
             {
-                if (1 < rx_buff_size)
-                {
-
-                    if (0 != rx_buff_last)
-                    {
-                        --rx_buff_last;
-                    }
-                    else
-                    {
-                        rx_buff_last = BUFFER_SIZE - 1;
-                    }
-                }
-
-                if (0 != rx_buff_size)
-                {
-                    --rx_buff_size;
-                    uart_write(received);
-                }
+                ring_buffer_retract(&rx_ring.ring, 1);
+                uart_write(received);
             }
         }
 
@@ -358,32 +297,20 @@ void __ISR(_UART1_RX_VECTOR, ipl2) uart1_rx_isr(void)
 
 void __ISR(_UART1_TX_VECTOR, ipl2) uart1_tx_isr(void)
 {
-    uint8_t received;
+    uint8_t data;
 
     //
     // TX
     //
     if (IFS3bits.U1TXIF)
     {
-        while ((0 == U1STAbits.UTXBF) && (0 != tx_buff_size))
+        // TX fifo not full and there are more things to send
+        while ((0 == U1STAbits.UTXBF) && ring_buffer_u8_pop(&tx_ring, &data))
         {
-            // TX fifo not full and there are more things to send
-            U1TXREG = tx_buff[tx_buff_first];
-
-            if (1 != tx_buff_size)
-            {
-                ++tx_buff_first;
-            }
-
-            if (tx_buff_first >= BUFFER_SIZE)
-            {
-                tx_buff_first = 0;
-            }
-
-            --tx_buff_size;
+            U1TXREG = data;
         }
 
-        if (0 == tx_buff_size)
+        if (ring_buffer_is_empty(&tx_ring.ring))
         {
             uart_disable_tx_interrupt();
         }
@@ -394,27 +321,27 @@ void __ISR(_UART1_TX_VECTOR, ipl2) uart1_tx_isr(void)
 
 static void start_tx(void)
 {
+    uint8_t data;
+
     uart_disable_tx_interrupt();
     uart_disable_rx_interrupt();
 
-    while ((0 != tx_buff_size) && (0 == U1STAbits.UTXBF))
+    while ((0 == U1STAbits.UTXBF) && ring_buffer_u8_pop(&tx_ring, &data))
     {
-        U1TXREG = tx_buff[tx_buff_first];
-
-        if (1 != tx_buff_size)
-        {
-            ++tx_buff_first;
-        }
-
-        if (tx_buff_first >= BUFFER_SIZE)
-        {
-            tx_buff_first = 0;
-        }
-
-        --tx_buff_size;
+        U1TXREG = data;
     }
 
     uart_enable_tx_interrupt();
     uart_enable_rx_interrupt();
 }
 
+static void update_baud(void)
+{
+    uart_flush();
+
+    U1MODEbits.UARTEN = 0;
+    U1BRG = (PBCLK_FREQ_HZ / uart_baud) / 16 - 1;
+    U1MODEbits.UARTEN = 1;
+    U1STAbits.UTXEN = 1;
+    U1STAbits.URXEN = 1;
+}
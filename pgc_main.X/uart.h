@@ -57,18 +57,28 @@ void uart_write(uint8_t data);
 
 /**
  * @brief Write a string over the uart interface.
+ * @details Bytes which do not fit in the transmit buffer are not sent.
  * @param data - The null terminated data to send.
- * @return void
+ * @return The number of bytes accepted into the transmit buffer.
  */
-void uart_write_string(const char* data);
+uint16_t uart_write_string(const char* data);
 
 /**
- * @brief Write a string over the uart interface.
- * @brief nbr_of_bytes - The number of bytes to send.
- * @param data - The null terminated data to send.
+ * @brief Write an array of bytes over the uart interface.
+ * @details Bytes which do not fit in the transmit buffer are not sent.
+ * @param nbr_of_bytes - The number of bytes to send.
+ * @param data - The data to send.
+ * @return The number of bytes accepted into the transmit buffer.
+ */
+uint16_t uart_write_array(uint16_t nbr_of_bytes, const uint8_t* data);
+
+/**
+ * @brief Blocks until everything in the transmit buffer has been sent.
+ * @details Must not be called with the tx interrupt disabled.
+ * @param void
  * @return void
  */
-void uart_write_array(uint16_t nbr_of_bytes, const uint8_t* data);
+void uart_flush(void);
 
 /**
  * @brief Gets a byte from the receive buffer.